@@ -5,6 +5,8 @@
 #ifndef CSCORE_NOTIFIER_H_
 #define CSCORE_NOTIFIER_H_
 
+#include <stdint.h>
+
 #include <functional>
 #include <utility>
 
@@ -47,6 +49,28 @@ class NotifierThread
                   const RawEvent& data) {
     callback(data);
   }
+
+  // Bounded pollers merge events that only report the latest state
+  bool GetCoalesceKey(const RawEvent& data, uint64_t* key) {
+    CS_Handle handle;
+    switch (data.kind) {
+      case RawEvent::kSourcePropertyValueUpdated:
+      case RawEvent::kSinkPropertyValueUpdated:
+        handle = data.propertyHandle;
+        break;
+      case RawEvent::kSourceVideoModeChanged:
+        handle = data.sourceHandle;
+        break;
+      case RawEvent::kTelemetryUpdated:
+        handle = 0;
+        break;
+      default:
+        return false;
+    }
+    *key = (static_cast<uint64_t>(data.listener) << 32) |
+           static_cast<uint32_t>(handle);
+    return true;
+  }
 };
 
 }  // namespace impl
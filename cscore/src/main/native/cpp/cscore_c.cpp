@@ -379,6 +379,11 @@ CS_ListenerPoller CS_CreateListenerPoller(void) {
   return cs::CreateListenerPoller();
 }
 
+CS_ListenerPoller CS_CreateBoundedListenerPoller(
+    int capacity, enum CS_PollerOverflow overflow) {
+  return cs::CreateListenerPoller(capacity > 0 ? capacity : 1, overflow);
+}
+
 void CS_DestroyListenerPoller(CS_ListenerPoller poller) {
   cs::DestroyListenerPoller(poller);
 }
@@ -404,6 +409,10 @@ void CS_CancelPollListener(CS_ListenerPoller poller) {
   cs::CancelPollListener(poller);
 }
 
+uint64_t CS_GetListenerPollerDropped(CS_ListenerPoller poller) {
+  return cs::GetListenerPollerDropped(poller);
+}
+
 void CS_FreeEvents(CS_Event* arr, int count) {
   // destroy vector saved at end of array
   using T = std::vector<cs::RawEvent>;
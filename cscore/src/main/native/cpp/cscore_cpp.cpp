@@ -753,6 +753,25 @@ CS_ListenerPoller CreateListenerPoller() {
   return Handle(inst.notifier.CreatePoller(), Handle::kListenerPoller);
 }
 
+CS_ListenerPoller CreateListenerPoller(size_t capacity,
+                                      CS_PollerOverflow overflow) {
+  wpi::PollerOverflow policy;
+  switch (overflow) {
+    case CS_POLLER_DROP_NEWEST:
+      policy = wpi::PollerOverflow::kDropNewest;
+      break;
+    case CS_POLLER_COALESCE:
+      policy = wpi::PollerOverflow::kCoalesce;
+      break;
+    default:
+      policy = wpi::PollerOverflow::kDropOldest;
+      break;
+  }
+  auto& inst = Instance::GetInstance();
+  return Handle(inst.notifier.CreatePoller(capacity, policy),
+                Handle::kListenerPoller);
+}
+
 void DestroyListenerPoller(CS_ListenerPoller poller) {
   int uid = Handle{poller}.GetTypedIndex(Handle::kListenerPoller);
   if (uid < 0) {
@@ -795,6 +814,18 @@ std::vector<RawEvent> PollListener(CS_ListenerPoller poller, double timeout,
   return Instance::GetInstance().notifier.Poll(id, timeout, timedOut);
 }
 
+size_t PollListener(CS_ListenerPoller poller, std::vector<RawEvent>* events,
+                    size_t maxEvents, double timeout, bool* timedOut) {
+  *timedOut = false;
+  Handle handle{poller};
+  int id = handle.GetTypedIndex(Handle::kListenerPoller);
+  if (id < 0) {
+    return 0;
+  }
+  return Instance::GetInstance().notifier.PollBatch(id, events, maxEvents,
+                                                    timeout, timedOut);
+}
+
 void CancelPollListener(CS_ListenerPoller poller) {
   Handle handle{poller};
   int id = handle.GetTypedIndex(Handle::kListenerPoller);
@@ -804,6 +835,15 @@ void CancelPollListener(CS_ListenerPoller poller) {
   return Instance::GetInstance().notifier.CancelPoll(id);
 }
 
+uint64_t GetListenerPollerDropped(CS_ListenerPoller poller) {
+  Handle handle{poller};
+  int id = handle.GetTypedIndex(Handle::kListenerPoller);
+  if (id < 0) {
+    return 0;
+  }
+  return Instance::GetInstance().notifier.GetPollerDropped(id);
+}
+
 bool NotifierDestroyed() {
   return false;
 }
@@ -203,6 +203,24 @@ enum CS_ConnectionStrategy {
   CS_CONNECTION_FORCE_CLOSE
 };
 
+/** Bounded listener poller overflow policy */
+enum CS_PollerOverflow {
+  /** Discard the oldest queued event */
+  CS_POLLER_DROP_OLDEST = 0,
+
+  /** Discard the new event */
+  CS_POLLER_DROP_NEWEST,
+
+  /**
+   * Once the queue is full, hold up to capacity further events until it is
+   * drained, merging property value, video mode, and telemetry events for
+   * the same listener and property or source.  Events already in the queue
+   * are never merged; once the held events are full too, new events are
+   * dropped like CS_POLLER_DROP_NEWEST.
+   */
+  CS_POLLER_COALESCE
+};
+
 /**
  * Listener event
  */
@@ -439,6 +457,8 @@ CS_Listener CS_AddListener(
 void CS_RemoveListener(CS_Listener handle, CS_Status* status);
 
 CS_ListenerPoller CS_CreateListenerPoller(void);
+CS_ListenerPoller CS_CreateBoundedListenerPoller(
+    int capacity, enum CS_PollerOverflow overflow);
 void CS_DestroyListenerPoller(CS_ListenerPoller poller);
 CS_Listener CS_AddPolledListener(CS_ListenerPoller poller, int eventMask,
                                  CS_Bool immediateNotify, CS_Status* status);
@@ -447,6 +467,7 @@ struct CS_Event* CS_PollListenerTimeout(CS_ListenerPoller poller, int* count,
                                         double timeout, CS_Bool* timedOut);
 void CS_FreeEvents(struct CS_Event* arr, int count);
 void CS_CancelPollListener(CS_ListenerPoller poller);
+uint64_t CS_GetListenerPollerDropped(CS_ListenerPoller poller);
 /** @} */
 
 int CS_NotifierDestroyed(void);
@@ -384,13 +384,18 @@ CS_Listener AddListener(std::function<void(const RawEvent& event)> callback,
 void RemoveListener(CS_Listener handle, CS_Status* status);
 
 CS_ListenerPoller CreateListenerPoller();
+CS_ListenerPoller CreateListenerPoller(size_t capacity,
+                                      CS_PollerOverflow overflow);
 void DestroyListenerPoller(CS_ListenerPoller poller);
 CS_Listener AddPolledListener(CS_ListenerPoller poller, int eventMask,
                               bool immediateNotify, CS_Status* status);
 std::vector<RawEvent> PollListener(CS_ListenerPoller poller);
 std::vector<RawEvent> PollListener(CS_ListenerPoller poller, double timeout,
                                    bool* timedOut);
+size_t PollListener(CS_ListenerPoller poller, std::vector<RawEvent>* events,
+                    size_t maxEvents, double timeout, bool* timedOut);
 void CancelPollListener(CS_ListenerPoller poller);
+uint64_t GetListenerPollerDropped(CS_ListenerPoller poller);
 /** @} */
 
 bool NotifierDestroyed();
@@ -0,0 +1,19 @@
+// Copyright (c) FIRST and other WPILib contributors.
+// Open Source Software; you can modify and/or share it under the terms of
+// the WPILib BSD license file in the root directory of this project.
+
+#ifndef NTCORE_DEV_BENCH_H_
+#define NTCORE_DEV_BENCH_H_
+
+// Benchmarks run by the dev executable; each takes the arguments following
+// the benchmark name and returns the process exit code.
+int ServerScalingBench(int argc, char* argv[]);
+int EntryListenerBench(int argc, char* argv[]);
+int StorageContentionBench(int argc, char* argv[]);
+int CompressionBench(int argc, char* argv[]);
+int LocalTransportBench(int argc, char* argv[]);
+int ValueMemoryBench(int argc, char* argv[]);
+int PathIndexBench(int argc, char* argv[]);
+int LoadGenBench(int argc, char* argv[]);
+
+#endif  // NTCORE_DEV_BENCH_H_
@@ -0,0 +1,223 @@
+// Copyright (c) FIRST and other WPILib contributors.
+// Open Source Software; you can modify and/or share it under the terms of
+// the WPILib BSD license file in the root directory of this project.
+
+// Measures LZ4 compression of NetworkTables traffic: the compression ratio
+// and compress/decompress throughput per write batch.  By default the
+// traffic is recorded by proxying a client connection to a local server
+// publishing a typical dashboard workload; each read from the server is
+// taken as one batch.  Alternatively a file of captured server to client
+// wire bytes can be given, which is split into fixed-size batches.
+
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <wpi/Logger.h>
+#include <wpi/Lz4.h>
+#include <wpi/NetworkStream.h>
+#include <wpi/SmallVector.h>
+#include <wpi/TCPAcceptor.h>
+#include <wpi/TCPConnector.h>
+
+#include "Bench.h"
+#include "ntcore.h"
+
+namespace {
+
+constexpr int kServerPort = 10030;
+constexpr int kProxyPort = 10031;
+constexpr auto kRecordTime = std::chrono::seconds(2);
+constexpr size_t kFileBatchSize = 1400;
+// Batches smaller than this are sent uncompressed (see NetworkConnection)
+constexpr size_t kMinCompressSize = 128;
+constexpr int kPasses = 20;
+
+// Forwards one direction of a connection, optionally recording each read
+void Forward(wpi::NetworkStream& from, wpi::NetworkStream& to,
+             std::vector<std::string>* batches) {
+  char buf[65536];
+  for (;;) {
+    wpi::NetworkStream::Error err;
+    size_t len = from.receive(buf, sizeof(buf), &err);
+    if (len == 0) {
+      break;
+    }
+    if (batches) {
+      batches->emplace_back(buf, len);
+    }
+    if (to.send(buf, len, &err) == 0) {
+      break;
+    }
+  }
+  from.close();
+  to.close();
+}
+
+std::vector<std::string> RecordTraffic() {
+  wpi::Logger logger;
+  wpi::TCPAcceptor acceptor{kProxyPort, "127.0.0.1", logger};
+  if (acceptor.start() != 0) {
+    std::fprintf(stderr, "could not listen on port %d\n", kProxyPort);
+    return {};
+  }
+
+  auto server = nt::CreateInstance();
+  auto client = nt::CreateInstance();
+  nt::SetUpdateRate(server, 0.02);
+  nt::StartServer(server, "", "127.0.0.1", kServerPort);
+
+  // a static trajectory, names, and robot state updated every 20 ms
+  std::vector<double> trajectory;
+  for (int i = 0; i < 300; ++i) {
+    trajectory.push_back(i * 0.05);
+  }
+  nt::SetEntryValue(nt::GetEntry(server, "/SmartDashboard/Field/Trajectory"),
+                    nt::Value::MakeDoubleArray(trajectory));
+  std::vector<std::string> names;
+  std::vector<NT_Entry> doubles;
+  std::vector<NT_Entry> booleans;
+  for (int i = 0; i < 40; ++i) {
+    names.emplace_back("Subsystem" + std::to_string(i / 8) + "/Motor" +
+                       std::to_string(i % 8));
+    doubles.push_back(
+        nt::GetEntry(server, "/SmartDashboard/" + names.back() + "/Output"));
+    if (i % 4 == 0) {
+      booleans.push_back(nt::GetEntry(
+          server, "/SmartDashboard/" + names.back() + "/Enabled"));
+    }
+  }
+  nt::SetEntryValue(nt::GetEntry(server, "/LiveWindow/.names"),
+                    nt::Value::MakeStringArray(names));
+  auto pose = nt::GetEntry(server, "/SmartDashboard/Field/Robot");
+  auto status = nt::GetEntry(server, "/SmartDashboard/Status/json");
+
+  std::vector<std::string> batches;
+  std::thread proxy([&] {
+    auto down = acceptor.accept();
+    if (!down) {
+      return;
+    }
+    auto up = wpi::TCPConnector::connect("127.0.0.1", kServerPort, logger, 1);
+    if (!up) {
+      down->close();
+      return;
+    }
+    std::thread upstream([&] { Forward(*down, *up, nullptr); });
+    Forward(*up, *down, &batches);
+    upstream.join();
+  });
+  nt::StartClient(client, "127.0.0.1", kProxyPort);
+
+  auto end = std::chrono::steady_clock::now() + kRecordTime;
+  for (int step = 0; std::chrono::steady_clock::now() < end; ++step) {
+    double t = step * 0.02;
+    for (size_t i = 0; i < doubles.size(); ++i) {
+      nt::SetEntryValue(doubles[i],
+                        nt::Value::MakeDouble(0.5 + 0.01 * ((step + i) % 50)));
+    }
+    for (size_t i = 0; i < booleans.size(); ++i) {
+      nt::SetEntryValue(booleans[i],
+                        nt::Value::MakeBoolean((step / 25 + i) % 2 == 0));
+    }
+    nt::SetEntryValue(pose, nt::Value::MakeDoubleArray({t, t * 0.5, 0.1 * t}));
+    if (step % 5 == 0) {
+      nt::SetEntryValue(
+          status,
+          nt::Value::MakeString(
+              "{\"mode\":\"teleop\",\"time\":" + std::to_string(t) +
+              ",\"battery\":12.3,\"faults\":[],\"arm\":{\"angle\":" +
+              std::to_string(step % 90) + ",\"extension\":0.25}}"));
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  }
+
+  nt::StopClient(client);
+  nt::StopServer(server);
+  acceptor.shutdown();
+  proxy.join();
+  nt::DestroyInstance(client);
+  nt::DestroyInstance(server);
+  return batches;
+}
+
+std::vector<std::string> ReadCapture(const char* filename) {
+  std::ifstream is(filename, std::ios::binary);
+  if (!is) {
+    std::fprintf(stderr, "could not open '%s'\n", filename);
+    return {};
+  }
+  std::string data{std::istreambuf_iterator<char>(is),
+                   std::istreambuf_iterator<char>()};
+  std::vector<std::string> batches;
+  for (size_t pos = 0; pos < data.size(); pos += kFileBatchSize) {
+    batches.emplace_back(data.substr(pos, kFileBatchSize));
+  }
+  return batches;
+}
+
+}  // namespace
+
+int CompressionBench(int argc, char* argv[]) {
+  auto batches = argc > 0 ? ReadCapture(argv[0]) : RecordTraffic();
+  if (batches.empty()) {
+    std::fprintf(stderr, "no traffic recorded\n");
+    return 1;
+  }
+
+  // compress each batch once to get the sizes
+  size_t raw = 0;
+  size_t compressed = 0;
+  size_t wire = 0;
+  std::vector<std::string> blocks;
+  for (auto&& batch : batches) {
+    wpi::SmallVector<char, 0> buf;
+    wpi::Lz4Compress(batch, buf);
+    raw += batch.size();
+    compressed += buf.size();
+    // the connection only sends the block when it is worthwhile
+    if (batch.size() >= kMinCompressSize && buf.size() + 16 < batch.size()) {
+      wire += buf.size() + 5;  // type and ULEB128 sizes
+    } else {
+      wire += batch.size();
+    }
+    blocks.emplace_back(buf.data(), buf.size());
+  }
+
+  // then time repeated passes over all of them
+  wpi::SmallVector<char, 0> buf;
+  auto start = std::chrono::steady_clock::now();
+  for (int pass = 0; pass < kPasses; ++pass) {
+    for (auto&& batch : batches) {
+      buf.clear();
+      wpi::Lz4Compress(batch, buf);
+    }
+  }
+  auto mid = std::chrono::steady_clock::now();
+  for (int pass = 0; pass < kPasses; ++pass) {
+    for (size_t i = 0; i < blocks.size(); ++i) {
+      buf.clear();
+      if (!wpi::Lz4Decompress(blocks[i], batches[i].size(), buf)) {
+        std::fprintf(stderr, "decompression failed\n");
+        return 1;
+      }
+    }
+  }
+  auto stop = std::chrono::steady_clock::now();
+
+  double mb = static_cast<double>(raw) * kPasses / 1e6;
+  std::printf("%8s %10s %10s %10s %7s %7s %10s %10s\n", "batches", "raw_bytes",
+              "lz4_bytes", "wire_bytes", "ratio", "wire", "comp_MBs",
+              "decomp_MBs");
+  std::printf("%8zu %10zu %10zu %10zu %7.2f %7.2f %10.1f %10.1f\n",
+              batches.size(), raw, compressed, wire,
+              static_cast<double>(raw) / compressed,
+              static_cast<double>(raw) / wire,
+              mb / std::chrono::duration<double>(mid - start).count(),
+              mb / std::chrono::duration<double>(stop - mid).count());
+  return 0;
+}
@@ -0,0 +1,101 @@
+// Copyright (c) FIRST and other WPILib contributors.
+// Open Source Software; you can modify and/or share it under the terms of
+// the WPILib BSD license file in the root directory of this project.
+
+// Measures entry listener dispatch latency (from SetEntryValue() to the
+// callback running) with a growing number of registered listeners that do
+// not match the updated entry.  With indexed dispatch the latency should
+// stay flat as the listener count grows.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Bench.h"
+#include "ntcore.h"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr int kIterations = 2000;
+
+void RunCase(int numListeners) {
+  auto inst = nt::CreateInstance();
+
+  // half prefix listeners on unrelated subtables, half on unrelated entries
+  const unsigned int flags = NT_NOTIFY_LOCAL | NT_NOTIFY_UPDATE;
+  for (int i = 0; i < numListeners; ++i) {
+    std::string name = "/bench/table" + std::to_string(i / 2);
+    if (i % 2 == 0) {
+      nt::AddEntryListener(
+          inst, name + "/", [](const nt::EntryNotification&) {}, flags);
+    } else {
+      nt::AddEntryListener(
+          nt::GetEntry(inst, name + "/value"),
+          [](const nt::EntryNotification&) {}, flags);
+    }
+  }
+
+  // the listener being timed
+  std::atomic<int64_t> received{0};
+  auto target = nt::GetEntry(inst, "/bench/target/value");
+  nt::SetEntryValue(target, nt::Value::MakeDouble(0));
+  nt::AddEntryListener(
+      inst, "/bench/target/",
+      [&](const nt::EntryNotification&) {
+        received = Clock::now().time_since_epoch().count();
+      },
+      flags);
+
+  std::vector<double> latencies;
+  latencies.reserve(kIterations);
+  std::clock_t cpuStart = std::clock();
+  for (int i = 1; i <= kIterations; ++i) {
+    received = 0;
+    auto start = Clock::now();
+    nt::SetEntryValue(target, nt::Value::MakeDouble(i));
+    int64_t end;
+    while ((end = received) == 0) {
+      std::this_thread::yield();
+    }
+    latencies.push_back(
+        std::chrono::duration<double, std::micro>(
+            Clock::duration(end) - start.time_since_epoch())
+            .count());
+  }
+  std::clock_t cpuEnd = std::clock();
+
+  std::sort(latencies.begin(), latencies.end());
+  std::printf("%9d %10.1f %10.1f %10.1f %10.1f\n", numListeners,
+              latencies[latencies.size() / 2],
+              latencies[latencies.size() * 99 / 100], latencies.back(),
+              1.0e6 * (cpuEnd - cpuStart) / CLOCKS_PER_SEC / kIterations);
+  std::fflush(stdout);
+
+  nt::DestroyInstance(inst);
+}
+
+}  // namespace
+
+int EntryListenerBench(int argc, char* argv[]) {
+  std::vector<int> counts;
+  for (int i = 0; i < argc; ++i) {
+    counts.push_back(std::atoi(argv[i]));
+  }
+  if (counts.empty()) {
+    counts = {0, 100, 1000, 10000};
+  }
+
+  std::printf("%9s %10s %10s %10s %10s\n", "listeners", "median_us", "p99_us",
+              "max_us", "cpu_us");
+  for (int count : counts) {
+    RunCase(count);
+  }
+  return 0;
+}
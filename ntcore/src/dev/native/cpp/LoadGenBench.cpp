@@ -0,0 +1,593 @@
+// Copyright (c) FIRST and other WPILib contributors.
+// Open Source Software; you can modify and/or share it under the terms of
+// the WPILib BSD license file in the root directory of this project.
+
+// Load generator for the server, dispatcher, and wire codecs.  An in-process
+// server publishes updates in rounds to clients connected over loopback, and
+// reports the end-to-end latency of each round (server SetEntryValue() to the
+// client's entry listener), process CPU use, and server bytes on the wire.
+//
+//   load-gen [clients=N] [entries=N] [rate=HZ] [type=T] [size=N] [seconds=S]
+//     Generates rounds that update every entry.  T is double, boolean,
+//     string, double-array, or raw; size is the string, array, or raw
+//     length.  Without type=, each type is run in turn.
+//   load-gen record FILE HOST PORT [seconds=S]
+//     Connects to a running server and captures the updates it sends as
+//     JSON lines ({"t": microseconds, "name", "type", "value"}).
+//   load-gen replay FILE [clients=N] [speed=X]
+//     Publishes a capture with its original timing (scaled by speed);
+//     updates less than 5 ms apart are sent as one round.
+//
+// Rounds closer together than the update rate (10 ms) are coalesced by the
+// connections, so only the rounds that arrive are counted as delivered.
+
+#include <stdint.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <ctime>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <wpi/Base64.h>
+#include <wpi/StringRef.h>
+#include <wpi/json.h>
+
+#include "Bench.h"
+#include "ntcore.h"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr unsigned int kBasePort = 10400;
+constexpr const char* kRoundName = "/.loadgen/round";
+constexpr int64_t kReplayGroupUs = 5000;
+constexpr auto kSettleTime = std::chrono::milliseconds(500);
+
+const char* const kTypes[] = {"double", "boolean", "string", "double-array",
+                              "raw"};
+
+struct Options {
+  int clients = 4;
+  int entries = 100;
+  double rate = 50;
+  std::string type;
+  int size = 16;
+  double seconds = 3;
+  double speed = 1;
+};
+
+// A captured update; time is from the start of the capture
+struct Update {
+  int64_t time_us;
+  std::string name;
+  std::shared_ptr<nt::Value> value;
+};
+
+// Only pass along warnings and errors so connect messages don't flood stdout
+void QuietLogging(NT_Inst inst) {
+  nt::AddLogger(
+      inst,
+      [](const nt::LogMessage& msg) {
+        std::fprintf(stderr, "NT: %s\n", msg.message.c_str());
+      },
+      NT_LOG_WARNING, NT_LOG_CRITICAL);
+}
+
+bool ParseOption(wpi::StringRef arg, Options* opts) {
+  auto [key, value] = arg.split('=');
+  std::string str = value.str();
+  if (key == "type" &&
+      std::find(std::begin(kTypes), std::end(kTypes), value) !=
+          std::end(kTypes)) {
+    opts->type = str;
+  } else if (key == "clients") {
+    opts->clients = std::atoi(str.c_str());
+  } else if (key == "entries") {
+    opts->entries = std::atoi(str.c_str());
+  } else if (key == "size") {
+    opts->size = std::atoi(str.c_str());
+  } else if (key == "rate") {
+    opts->rate = std::atof(str.c_str());
+  } else if (key == "seconds") {
+    opts->seconds = std::atof(str.c_str());
+  } else if (key == "speed") {
+    opts->speed = std::atof(str.c_str());
+  } else {
+    std::fprintf(stderr, "invalid option '%s'\n", arg.str().c_str());
+    return false;
+  }
+  return true;
+}
+
+std::shared_ptr<nt::Value> MakeValue(wpi::StringRef type, int size,
+                                     int64_t n) {
+  if (type == "boolean") {
+    return nt::Value::MakeBoolean(n % 2 == 0);
+  } else if (type == "string") {
+    std::string str = std::to_string(n);
+    str.resize(std::max<size_t>(size, str.size()), '.');
+    return nt::Value::MakeString(std::move(str));
+  } else if (type == "double-array") {
+    std::vector<double> arr(size);
+    for (int i = 0; i < size; ++i) {
+      arr[i] = n + 0.5 * i;
+    }
+    return nt::Value::MakeDoubleArray(arr);
+  } else if (type == "raw") {
+    std::string raw(size, '\0');
+    for (int i = 0; i < size; ++i) {
+      raw[i] = static_cast<char>(n + i);
+    }
+    return nt::Value::MakeRaw(std::move(raw));
+  }
+  return nt::Value::MakeDouble(n);
+}
+
+//
+// Capture file format
+//
+
+const char* TypeName(NT_Type type) {
+  switch (type) {
+    case NT_BOOLEAN:
+      return "boolean";
+    case NT_DOUBLE:
+      return "double";
+    case NT_STRING:
+      return "string";
+    case NT_RAW:
+      return "raw";
+    case NT_BOOLEAN_ARRAY:
+      return "boolean[]";
+    case NT_DOUBLE_ARRAY:
+      return "double[]";
+    case NT_STRING_ARRAY:
+      return "string[]";
+    default:
+      return nullptr;
+  }
+}
+
+wpi::json ToJson(const nt::Value& value) {
+  switch (value.type()) {
+    case NT_BOOLEAN:
+      return value.GetBoolean();
+    case NT_DOUBLE:
+      return value.GetDouble();
+    case NT_STRING:
+      return value.GetString().str();
+    case NT_RAW: {
+      std::string encoded;
+      wpi::Base64Encode(value.GetRaw(), &encoded);
+      return encoded;
+    }
+    case NT_BOOLEAN_ARRAY: {
+      auto j = wpi::json::array();
+      for (int b : value.GetBooleanArray()) {
+        j.push_back(b != 0);
+      }
+      return j;
+    }
+    case NT_DOUBLE_ARRAY: {
+      auto arr = value.GetDoubleArray();
+      return std::vector<double>(arr.begin(), arr.end());
+    }
+    case NT_STRING_ARRAY: {
+      auto arr = value.GetStringArray();
+      return std::vector<std::string>(arr.begin(), arr.end());
+    }
+    default:
+      return nullptr;
+  }
+}
+
+// Throws wpi::json::exception if the value doesn't match the type
+std::shared_ptr<nt::Value> FromJson(wpi::StringRef type,
+                                    const wpi::json& j) {
+  if (type == "boolean") {
+    return nt::Value::MakeBoolean(j.get<bool>());
+  } else if (type == "double") {
+    return nt::Value::MakeDouble(j.get<double>());
+  } else if (type == "string") {
+    return nt::Value::MakeString(j.get<std::string>());
+  } else if (type == "raw") {
+    std::string raw;
+    wpi::Base64Decode(j.get<std::string>(), &raw);
+    return nt::Value::MakeRaw(std::move(raw));
+  } else if (type == "boolean[]") {
+    std::vector<int> arr;
+    for (auto&& elem : j) {
+      arr.push_back(elem.get<bool>() ? 1 : 0);
+    }
+    return nt::Value::MakeBooleanArray(arr);
+  } else if (type == "double[]") {
+    return nt::Value::MakeDoubleArray(j.get<std::vector<double>>());
+  } else if (type == "string[]") {
+    return nt::Value::MakeStringArray(j.get<std::vector<std::string>>());
+  }
+  return nullptr;
+}
+
+std::vector<Update> ReadCapture(const char* filename) {
+  std::ifstream is(filename);
+  if (!is) {
+    std::fprintf(stderr, "could not open '%s'\n", filename);
+    return {};
+  }
+  std::vector<Update> updates;
+  std::string line;
+  for (int lineNum = 1; std::getline(is, line); ++lineNum) {
+    if (line.empty()) {
+      continue;
+    }
+    try {
+      auto j = wpi::json::parse(line);
+      auto value =
+          FromJson(j.at("type").get<std::string>(), j.at("value"));
+      if (!value) {
+        std::fprintf(stderr, "%s:%d: unknown type\n", filename, lineNum);
+        continue;
+      }
+      updates.push_back({j.at("t").get<int64_t>(),
+                         j.at("name").get<std::string>(), std::move(value)});
+    } catch (const wpi::json::exception& e) {
+      std::fprintf(stderr, "%s:%d: %s\n", filename, lineNum, e.what());
+    }
+  }
+  std::stable_sort(updates.begin(), updates.end(),
+                   [](const Update& a, const Update& b) {
+                     return a.time_us < b.time_us;
+                   });
+  return updates;
+}
+
+//
+// Server and clients
+//
+
+// An in-process server with clients connected over loopback.  Each round
+// ends by setting the round marker entry, and each client records when the
+// marker for every round arrives.
+class Harness {
+ public:
+  Harness(int numClients, size_t maxRounds);
+  ~Harness();
+
+  bool Connect(unsigned int port);
+  NT_Inst server() const { return m_server; }
+
+  // Starts the measurement
+  void Start();
+  // Marks the end of a round of updates and flushes them
+  void EndRound();
+  // Waits for the last rounds to arrive and prints a result line
+  void Report(const char* label);
+
+  static void PrintHeader();
+
+ private:
+  std::pair<uint64_t, uint64_t> ServerBytes() const;
+
+  NT_Inst m_server;
+  std::vector<NT_Inst> m_clients;
+  NT_Entry m_round;
+  size_t m_maxRounds;
+  size_t m_numRounds = 0;
+  std::vector<Clock::time_point> m_sent;
+  // per client, arrival time of each round (0 if not received)
+  std::vector<std::unique_ptr<std::atomic<int64_t>[]>> m_received;
+
+  Clock::time_point m_start;
+  std::clock_t m_cpuStart = 0;
+  std::pair<uint64_t, uint64_t> m_bytesStart;
+};
+
+Harness::Harness(int numClients, size_t maxRounds)
+    : m_server(nt::CreateInstance()), m_maxRounds(maxRounds) {
+  QuietLogging(m_server);
+  nt::SetUpdateRate(m_server, 0.01);
+  m_round = nt::GetEntry(m_server, kRoundName);
+  nt::SetEntryValue(m_round, nt::Value::MakeDouble(-1));
+  m_sent.reserve(maxRounds);
+
+  for (int i = 0; i < numClients; ++i) {
+    auto client = nt::CreateInstance();
+    QuietLogging(client);
+    nt::SetUpdateRate(client, 0.01);
+    m_clients.push_back(client);
+
+    auto& received = m_received.emplace_back(
+        std::make_unique<std::atomic<int64_t>[]>(maxRounds));
+    for (size_t j = 0; j < maxRounds; ++j) {
+      received[j] = 0;
+    }
+    nt::AddEntryListener(
+        nt::GetEntry(client, kRoundName),
+        [times = received.get(), maxRounds](const nt::EntryNotification& e) {
+          if (!e.value || !e.value->IsDouble()) {
+            return;
+          }
+          double round = e.value->GetDouble();
+          if (round >= 0 && round < maxRounds) {
+            times[static_cast<size_t>(round)] =
+                Clock::now().time_since_epoch().count();
+          }
+        },
+        NT_NOTIFY_NEW | NT_NOTIFY_UPDATE);
+  }
+}
+
+Harness::~Harness() {
+  for (auto client : m_clients) {
+    nt::DestroyInstance(client);
+  }
+  nt::DestroyInstance(m_server);
+}
+
+bool Harness::Connect(unsigned int port) {
+  nt::StartServer(m_server, "", "127.0.0.1", port);
+  for (auto client : m_clients) {
+    nt::StartClient(client, "127.0.0.1", port);
+  }
+
+  auto deadline = Clock::now() + std::chrono::seconds(30);
+  while (Clock::now() < deadline) {
+    if (nt::GetConnections(m_server).size() >= m_clients.size() &&
+        std::all_of(m_clients.begin(), m_clients.end(),
+                    [](NT_Inst client) { return nt::IsConnected(client); })) {
+      return true;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+  }
+  std::fprintf(stderr, "clients did not connect\n");
+  return false;
+}
+
+std::pair<uint64_t, uint64_t> Harness::ServerBytes() const {
+  std::pair<uint64_t, uint64_t> bytes{0, 0};
+  for (auto&& metrics : nt::GetConnectionMetrics(m_server)) {
+    bytes.first += metrics.bytes_sent;
+    bytes.second += metrics.bytes_received;
+  }
+  return bytes;
+}
+
+void Harness::Start() {
+  m_start = Clock::now();
+  m_cpuStart = std::clock();
+  m_bytesStart = ServerBytes();
+}
+
+void Harness::EndRound() {
+  if (m_numRounds >= m_maxRounds) {
+    return;
+  }
+  m_sent.push_back(Clock::now());
+  nt::SetEntryValue(m_round, nt::Value::MakeDouble(m_numRounds++));
+  nt::Flush(m_server);
+}
+
+void Harness::PrintHeader() {
+  std::printf("%-12s %7s %7s %7s %8s %8s %8s %8s %6s %9s %9s\n", "load",
+              "clients", "rounds", "deliv%", "p50_ms", "p90_ms", "p99_ms",
+              "max_ms", "cpu%", "tx_KBs", "rx_KBs");
+}
+
+void Harness::Report(const char* label) {
+  std::this_thread::sleep_for(kSettleTime);
+  double seconds =
+      std::chrono::duration<double>(Clock::now() - m_start).count();
+  double cpu = static_cast<double>(std::clock() - m_cpuStart) /
+               CLOCKS_PER_SEC;
+  auto bytes = ServerBytes();
+
+  std::vector<double> latencies;
+  for (auto&& received : m_received) {
+    for (size_t i = 0; i < m_numRounds; ++i) {
+      int64_t arrived = received[i];
+      if (arrived != 0) {
+        latencies.push_back(std::chrono::duration<double, std::milli>(
+                                Clock::duration(arrived) -
+                                m_sent[i].time_since_epoch())
+                                .count());
+      }
+    }
+  }
+  std::sort(latencies.begin(), latencies.end());
+  auto percentile = [&](double p) {
+    if (latencies.empty()) {
+      return 0.0;
+    }
+    return latencies[static_cast<size_t>(p * (latencies.size() - 1))];
+  };
+
+  size_t expected = m_numRounds * m_clients.size();
+  std::printf("%-12s %7zu %7zu %7.1f %8.2f %8.2f %8.2f %8.2f %6.1f %9.1f "
+              "%9.1f\n",
+              label, m_clients.size(), m_numRounds,
+              expected == 0 ? 0.0 : 100.0 * latencies.size() / expected,
+              percentile(0.5), percentile(0.9), percentile(0.99),
+              percentile(1.0), 100.0 * cpu / seconds,
+              (bytes.first - m_bytesStart.first) / 1000.0 / seconds,
+              (bytes.second - m_bytesStart.second) / 1000.0 / seconds);
+  std::fflush(stdout);
+}
+
+//
+// Modes
+//
+
+int RunGenerated(const Options& opts, const char* type, unsigned int port) {
+  size_t rounds = static_cast<size_t>(opts.rate * opts.seconds);
+  Harness harness(opts.clients, rounds);
+  std::vector<NT_Entry> entries;
+  for (int i = 0; i < opts.entries; ++i) {
+    entries.push_back(
+        nt::GetEntry(harness.server(), "/load/entry" + std::to_string(i)));
+  }
+  if (!harness.Connect(port)) {
+    return 1;
+  }
+
+  auto period = std::chrono::duration_cast<Clock::duration>(
+      std::chrono::duration<double>(1.0 / opts.rate));
+  harness.Start();
+  auto start = Clock::now();
+  for (size_t round = 0; round < rounds; ++round) {
+    std::this_thread::sleep_until(start + round * period);
+    for (size_t i = 0; i < entries.size(); ++i) {
+      nt::SetEntryValue(entries[i], MakeValue(type, opts.size, round + i));
+    }
+    harness.EndRound();
+  }
+  harness.Report(type);
+  return 0;
+}
+
+int Record(const char* filename, const char* host, unsigned int port,
+           const Options& opts) {
+  std::ofstream os(filename);
+  if (!os) {
+    std::fprintf(stderr, "could not open '%s'\n", filename);
+    return 1;
+  }
+
+  auto client = nt::CreateInstance();
+  QuietLogging(client);
+  nt::SetNetworkIdentity(client, "load-gen");
+  auto start = Clock::now();
+  size_t count = 0;
+  // callbacks run on the notifier thread, so os is not shared
+  nt::AddEntryListener(
+      client, "",
+      [&](const nt::EntryNotification& e) {
+        const char* type = e.value ? TypeName(e.value->type()) : nullptr;
+        if (!type || e.name == kRoundName) {
+          return;
+        }
+        int64_t t = std::chrono::duration_cast<std::chrono::microseconds>(
+                        Clock::now() - start)
+                        .count();
+        wpi::json j = {{"t", t},
+                       {"name", e.name},
+                       {"type", type},
+                       {"value", ToJson(*e.value)}};
+        os << j.dump() << '\n';
+        ++count;
+      },
+      NT_NOTIFY_IMMEDIATE | NT_NOTIFY_NEW | NT_NOTIFY_UPDATE);
+  nt::StartClient(client, host, port);
+  std::this_thread::sleep_for(std::chrono::duration<double>(opts.seconds));
+  nt::DestroyInstance(client);
+
+  std::printf("recorded %zu updates in %.1f s\n", count, opts.seconds);
+  return 0;
+}
+
+int Replay(const char* filename, const Options& opts) {
+  auto updates = ReadCapture(filename);
+  if (updates.empty()) {
+    std::fprintf(stderr, "no updates in capture\n");
+    return 1;
+  }
+
+  // group updates that are close together into rounds
+  std::vector<size_t> roundEnds;
+  int64_t roundStart = updates[0].time_us;
+  for (size_t i = 1; i < updates.size(); ++i) {
+    if (updates[i].time_us - roundStart >= kReplayGroupUs) {
+      roundEnds.push_back(i);
+      roundStart = updates[i].time_us;
+    }
+  }
+  roundEnds.push_back(updates.size());
+
+  Harness harness(opts.clients, roundEnds.size());
+  if (!harness.Connect(kBasePort)) {
+    return 1;
+  }
+
+  harness.Start();
+  auto start = Clock::now();
+  int64_t first = updates[0].time_us;
+  size_t i = 0;
+  for (size_t end : roundEnds) {
+    std::this_thread::sleep_until(
+        start + std::chrono::duration_cast<Clock::duration>(
+                    std::chrono::duration<double, std::micro>(
+                        (updates[i].time_us - first) / opts.speed)));
+    for (; i < end; ++i) {
+      nt::SetEntryTypeValue(nt::GetEntry(harness.server(), updates[i].name),
+                            updates[i].value);
+    }
+    harness.EndRound();
+  }
+  harness.Report("replay");
+  return 0;
+}
+
+}  // namespace
+
+int LoadGenBench(int argc, char* argv[]) {
+  Options opts;
+  wpi::StringRef mode = argc > 0 ? argv[0] : "";
+  if (mode == "record") {
+    if (argc < 4) {
+      std::fprintf(stderr, "usage: record FILE HOST PORT [seconds=S]\n");
+      return 1;
+    }
+    opts.seconds = 10;
+    for (int i = 4; i < argc; ++i) {
+      if (!ParseOption(argv[i], &opts)) {
+        return 1;
+      }
+    }
+    return Record(argv[1], argv[2], std::atoi(argv[3]), opts);
+  }
+
+  if (mode == "replay") {
+    if (argc < 2) {
+      std::fprintf(stderr, "usage: replay FILE [clients=N] [speed=X]\n");
+      return 1;
+    }
+    for (int i = 2; i < argc; ++i) {
+      if (!ParseOption(argv[i], &opts)) {
+        return 1;
+      }
+    }
+    Harness::PrintHeader();
+    return Replay(argv[1], opts);
+  }
+
+  for (int i = 0; i < argc; ++i) {
+    if (!ParseOption(argv[i], &opts)) {
+      return 1;
+    }
+  }
+  if (opts.clients < 1 || opts.entries < 1 || opts.rate <= 0 ||
+      opts.seconds <= 0 || opts.size < 0) {
+    std::fprintf(stderr, "invalid options\n");
+    return 1;
+  }
+  std::printf("%d entries at %.0f Hz, size %d\n", opts.entries, opts.rate,
+              opts.size);
+  Harness::PrintHeader();
+  if (!opts.type.empty()) {
+    return RunGenerated(opts, opts.type.c_str(), kBasePort);
+  }
+  unsigned int port = kBasePort;
+  for (const char* type : kTypes) {
+    if (int rv = RunGenerated(opts, type, port++); rv != 0) {
+      return rv;
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,191 @@
+// Copyright (c) FIRST and other WPILib contributors.
+// Open Source Software; you can modify and/or share it under the terms of
+// the WPILib BSD license file in the root directory of this project.
+
+// Compares the TCP loopback and shared memory transports for same-host
+// clients.  For each transport, measures raw stream ping-pong round trip
+// latency and bulk throughput, then the time for a NetworkTables client to
+// deliver a burst of entry updates to the server.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <wpi/Logger.h>
+#include <wpi/NetworkAcceptor.h>
+#include <wpi/NetworkStream.h>
+#include <wpi/SharedMemoryAcceptor.h>
+#include <wpi/SharedMemoryConnector.h>
+#include <wpi/TCPAcceptor.h>
+#include <wpi/TCPConnector.h>
+
+#include "Bench.h"
+#include "ntcore.h"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr int kStreamPort = 10032;
+constexpr int kServerPort = 10033;
+constexpr const char* kShmName = "ntcore-bench";
+constexpr int kPings = 20000;
+constexpr size_t kPingSize = 64;
+constexpr size_t kBulkBytes = 256 * 1024 * 1024;
+constexpr size_t kBulkChunk = 64 * 1024;
+constexpr int kUpdates = 20000;
+
+bool ReceiveAll(wpi::NetworkStream& stream, char* buf, size_t len) {
+  while (len > 0) {
+    wpi::NetworkStream::Error err;
+    size_t n = stream.receive(buf, len, &err);
+    if (n == 0) {
+      return false;
+    }
+    buf += n;
+    len -= n;
+  }
+  return true;
+}
+
+void RunStreams(const char* transport) {
+  wpi::Logger logger;
+  bool shm = std::string{transport} == "shm";
+  std::unique_ptr<wpi::NetworkAcceptor> acceptor;
+  if (shm) {
+    acceptor = std::make_unique<wpi::SharedMemoryAcceptor>(kShmName, logger);
+  } else {
+    acceptor =
+        std::make_unique<wpi::TCPAcceptor>(kStreamPort, "127.0.0.1", logger);
+  }
+  if (acceptor->start() != 0) {
+    std::fprintf(stderr, "could not start %s acceptor\n", transport);
+    return;
+  }
+
+  // the server echoes pings, then drains the bulk transfer
+  std::thread server([&] {
+    auto stream = acceptor->accept();
+    if (!stream) {
+      return;
+    }
+    stream->setNoDelay();
+    char buf[kBulkChunk];
+    wpi::NetworkStream::Error err;
+    for (int i = 0; i < kPings; ++i) {
+      if (!ReceiveAll(*stream, buf, kPingSize) ||
+          stream->send(buf, kPingSize, &err) != kPingSize) {
+        return;
+      }
+    }
+    for (size_t left = kBulkBytes; left > 0;) {
+      size_t n = stream->receive(buf, std::min(left, kBulkChunk), &err);
+      if (n == 0) {
+        return;
+      }
+      left -= n;
+    }
+    stream->send("k", 1, &err);
+  });
+
+  auto client =
+      shm ? wpi::SharedMemoryConnector::connect(kShmName, logger, 1)
+          : wpi::TCPConnector::connect("127.0.0.1", kStreamPort, logger, 1);
+  if (!client) {
+    std::fprintf(stderr, "could not connect over %s\n", transport);
+    acceptor->shutdown();
+    server.join();
+    return;
+  }
+  client->setNoDelay();
+
+  std::vector<double> rtts;
+  rtts.reserve(kPings);
+  char buf[kBulkChunk] = {};
+  wpi::NetworkStream::Error err;
+  for (int i = 0; i < kPings; ++i) {
+    auto start = Clock::now();
+    client->send(buf, kPingSize, &err);
+    ReceiveAll(*client, buf, kPingSize);
+    rtts.push_back(
+        std::chrono::duration<double, std::micro>(Clock::now() - start)
+            .count());
+  }
+
+  auto start = Clock::now();
+  for (size_t sent = 0; sent < kBulkBytes; sent += kBulkChunk) {
+    client->send(buf, kBulkChunk, &err);
+  }
+  ReceiveAll(*client, buf, 1);
+  double secs = std::chrono::duration<double>(Clock::now() - start).count();
+
+  server.join();
+  client->close();
+  acceptor->shutdown();
+
+  std::sort(rtts.begin(), rtts.end());
+  std::printf("%-9s %12.1f %12.1f %12.1f\n", transport, rtts[rtts.size() / 2],
+              rtts[rtts.size() * 99 / 100], kBulkBytes / 1e6 / secs);
+  std::fflush(stdout);
+}
+
+void RunUpdates(const char* transport) {
+  auto server = nt::CreateInstance();
+  auto client = nt::CreateInstance();
+  nt::SetUpdateRate(server, 0.01);
+  nt::SetUpdateRate(client, 0.01);
+  std::string listen = std::string{"shm:"} + kShmName;
+  nt::StartServer(server, "", listen.c_str(), kServerPort);
+  if (std::string{transport} == "shm") {
+    nt::StartClient(client, listen.c_str(), 0);
+  } else {
+    nt::StartClient(client, "127.0.0.1", kServerPort);
+  }
+  for (int i = 0; i < 200 && nt::GetConnections(server).empty(); ++i) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+
+  // each update creates a new entry, so none are coalesced
+  std::vector<NT_Entry> entries;
+  for (int i = 0; i < kUpdates; ++i) {
+    entries.push_back(
+        nt::GetEntry(client, "/bench/value" + std::to_string(i)));
+  }
+  auto last =
+      nt::GetEntry(server, "/bench/value" + std::to_string(kUpdates - 1));
+
+  auto start = Clock::now();
+  for (int i = 0; i < kUpdates; ++i) {
+    nt::SetEntryValue(entries[i], nt::Value::MakeDouble(i));
+  }
+  nt::Flush(client);
+  while (!nt::GetEntryValue(last)) {
+    std::this_thread::yield();
+  }
+  double secs = std::chrono::duration<double>(Clock::now() - start).count();
+
+  nt::StopClient(client);
+  nt::StopServer(server);
+  nt::DestroyInstance(client);
+  nt::DestroyInstance(server);
+
+  std::printf("%-9s %12.1f %12.0f\n", transport, secs * 1e3, kUpdates / secs);
+  std::fflush(stdout);
+}
+
+}  // namespace
+
+int LocalTransportBench(int, char*[]) {
+  std::printf("%-9s %12s %12s %12s\n", "transport", "rtt_p50_us",
+              "rtt_p99_us", "bulk_MBs");
+  RunStreams("tcp");
+  RunStreams("shm");
+  std::printf("\n%-9s %12s %12s\n", "transport", "updates_ms", "updates_s");
+  RunUpdates("tcp");
+  RunUpdates("shm");
+  return 0;
+}
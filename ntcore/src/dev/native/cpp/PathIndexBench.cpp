@@ -0,0 +1,88 @@
+// Copyright (c) FIRST and other WPILib contributors.
+// Open Source Software; you can modify and/or share it under the terms of
+// the WPILib BSD license file in the root directory of this project.
+
+// Measures prefix queries against a synthetic namespace of
+// /Robot/Group<g>/Subsystem<s>/Value<v> entries (20 values per subsystem,
+// 10 subsystems per group) as the total entry count grows.  The table,
+// subtable, and prefix queries return the same number of results at every
+// size, so their times should stay flat; the full listing is included for
+// scale.
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "Bench.h"
+#include "networktables/NetworkTableInstance.h"
+#include "ntcore.h"
+
+namespace {
+
+constexpr int kValuesPerSubsystem = 20;
+constexpr int kSubsystemsPerGroup = 10;
+constexpr int kIterations = 2000;
+
+// Average microseconds per call, and the result size of the last call
+double Time(const std::function<size_t()>& query, size_t* count) {
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < kIterations; ++i) {
+    *count = query();
+  }
+  auto stop = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::micro>(stop - start).count() /
+         kIterations;
+}
+
+void RunCase(int numEntries) {
+  auto inst = nt::NetworkTableInstance::Create();
+  for (int i = 0; i < numEntries; ++i) {
+    int subsystem = i / kValuesPerSubsystem;
+    std::string name = "/Robot/Group" +
+                       std::to_string(subsystem / kSubsystemsPerGroup) +
+                       "/Subsystem" +
+                       std::to_string(subsystem % kSubsystemsPerGroup) +
+                       "/Value" + std::to_string(i % kValuesPerSubsystem);
+    inst.GetEntry(name).SetDouble(i);
+  }
+
+  auto table = inst.GetTable("/Robot/Group0/Subsystem3");
+  auto group = inst.GetTable("/Robot/Group0");
+  size_t keys, subtables, prefix, all;
+  double keysUs = Time([&] { return table->GetKeys().size(); }, &keys);
+  double subtablesUs =
+      Time([&] { return group->GetSubTables().size(); }, &subtables);
+  double prefixUs = Time(
+      [&] { return inst.GetEntryInfo("/Robot/Group0/Subsystem3/", 0).size(); },
+      &prefix);
+  double allUs = Time([&] { return inst.GetEntries("", 0).size(); }, &all);
+
+  std::printf("%8d %8.2f (%3zu) %8.2f (%3zu) %8.2f (%3zu) %9.1f (%zu)\n",
+              numEntries, keysUs, keys, subtablesUs, subtables, prefixUs,
+              prefix, allUs, all);
+  std::fflush(stdout);
+
+  nt::NetworkTableInstance::Destroy(inst);
+}
+
+}  // namespace
+
+int PathIndexBench(int argc, char* argv[]) {
+  std::vector<int> counts;
+  for (int i = 0; i < argc; ++i) {
+    counts.push_back(std::atoi(argv[i]));
+  }
+  if (counts.empty()) {
+    counts = {1000, 5000, 20000, 50000};
+  }
+
+  std::printf("%8s %14s %14s %14s %15s\n", "entries", "keys_us",
+              "subtables_us", "prefix_us", "all_us");
+  for (int count : counts) {
+    RunCase(count);
+  }
+  return 0;
+}
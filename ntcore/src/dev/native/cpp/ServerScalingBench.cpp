@@ -0,0 +1,141 @@
+// Copyright (c) FIRST and other WPILib contributors.
+// Open Source Software; you can modify and/or share it under the terms of
+// the WPILib BSD license file in the root directory of this project.
+
+// Compares the thread-per-connection server with the event loop server as the
+// number of connected clients grows.  The clients run in this process too, so
+// absolute numbers include their cost; the difference between the two server
+// modes at the same client count is what matters.
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Bench.h"
+#include "ntcore.h"
+
+namespace {
+
+constexpr int kNumEntries = 10;
+constexpr int kUpdateHz = 100;
+constexpr auto kTrafficTime = std::chrono::seconds(2);
+
+int GetThreadCount() {
+  std::ifstream is("/proc/self/status");
+  std::string line;
+  while (std::getline(is, line)) {
+    if (line.compare(0, 8, "Threads:") == 0) {
+      return std::atoi(line.c_str() + 8);
+    }
+  }
+  return -1;
+}
+
+// Only pass along warnings and errors so connect messages don't flood stdout
+void QuietLogging(NT_Inst inst) {
+  nt::AddLogger(
+      inst,
+      [](const nt::LogMessage& msg) {
+        std::fprintf(stderr, "NT: %s\n", msg.message.c_str());
+      },
+      NT_LOG_WARNING, NT_LOG_CRITICAL);
+}
+
+void RunCase(bool eventLoop, int numClients, unsigned int port) {
+  using Clock = std::chrono::steady_clock;
+
+  auto server = nt::CreateInstance();
+  QuietLogging(server);
+  nt::SetServerEventLoop(server, eventLoop);
+  nt::SetUpdateRate(server, 0.01);
+  nt::StartServer(server, "", "127.0.0.1", port);
+
+  std::vector<NT_Inst> clients;
+  auto connectStart = Clock::now();
+  for (int i = 0; i < numClients; ++i) {
+    auto client = nt::CreateInstance();
+    QuietLogging(client);
+    nt::SetUpdateRate(client, 0.01);
+    nt::StartClient(client, "127.0.0.1", port);
+    clients.push_back(client);
+  }
+
+  // wait for all clients to connect
+  auto deadline = connectStart + std::chrono::seconds(30);
+  while (nt::GetConnections(server).size() <
+             static_cast<size_t>(numClients) &&
+         Clock::now() < deadline) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+  }
+  auto connected = nt::GetConnections(server).size();
+  auto connectMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+                       Clock::now() - connectStart)
+                       .count();
+  int threads = GetThreadCount();
+
+  // steady-state traffic from the server to all clients
+  std::vector<NT_Entry> entries;
+  for (int i = 0; i < kNumEntries; ++i) {
+    entries.push_back(
+        nt::GetEntry(server, "/bench/value" + std::to_string(i)));
+  }
+  std::clock_t cpuStart = std::clock();
+  auto trafficStart = Clock::now();
+  double value = 0;
+  while (Clock::now() - trafficStart < kTrafficTime) {
+    value += 1;
+    for (auto entry : entries) {
+      nt::SetEntryValue(entry, nt::Value::MakeDouble(value));
+    }
+    nt::Flush(server);
+    std::this_thread::sleep_for(std::chrono::milliseconds(1000 / kUpdateHz));
+  }
+  std::clock_t cpuEnd = std::clock();
+
+  // check that the final value made it everywhere
+  std::this_thread::sleep_for(std::chrono::milliseconds(200));
+  int received = 0;
+  for (auto client : clients) {
+    auto v = nt::GetEntryValue(nt::GetEntry(client, "/bench/value0"));
+    if (v && v->IsDouble() && v->GetDouble() == value) {
+      ++received;
+    }
+  }
+
+  std::printf("%-9s %8d %9zu %11lld %8d %10.1f %9d\n",
+              eventLoop ? "loop" : "threaded", numClients, connected,
+              static_cast<long long>(connectMs), threads,
+              1000.0 * (cpuEnd - cpuStart) / CLOCKS_PER_SEC, received);
+  std::fflush(stdout);
+
+  for (auto client : clients) {
+    nt::DestroyInstance(client);
+  }
+  nt::DestroyInstance(server);
+}
+
+}  // namespace
+
+int ServerScalingBench(int argc, char* argv[]) {
+  std::vector<int> counts;
+  for (int i = 0; i < argc; ++i) {
+    counts.push_back(std::atoi(argv[i]));
+  }
+  if (counts.empty()) {
+    counts = {1, 8, 32, 64};
+  }
+
+  std::printf("%-9s %8s %9s %11s %8s %10s %9s\n", "server", "clients",
+              "connected", "connect_ms", "threads", "cpu_ms", "received");
+  unsigned int port = 10300;
+  for (int count : counts) {
+    RunCase(false, count, port++);
+    RunCase(true, count, port++);
+  }
+  return 0;
+}
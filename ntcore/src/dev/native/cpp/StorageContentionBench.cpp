@@ -0,0 +1,107 @@
+// Copyright (c) FIRST and other WPILib contributors.
+// Open Source Software; you can modify and/or share it under the terms of
+// the WPILib BSD license file in the root directory of this project.
+
+// Measures local entry access throughput when several threads use the same
+// instance at once: writer threads setting values (like robot code) and
+// reader threads getting values by handle (like vision threads).
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Bench.h"
+#include "ntcore.h"
+
+namespace {
+
+constexpr int kNumEntries = 64;
+constexpr auto kRunTime = std::chrono::seconds(1);
+
+void RunCase(int numWriters, int numReaders) {
+  auto inst = nt::CreateInstance();
+  std::vector<NT_Entry> entries;
+  for (int i = 0; i < kNumEntries; ++i) {
+    entries.push_back(nt::GetEntry(inst, "/bench/value" + std::to_string(i)));
+    nt::SetEntryValue(entries.back(), nt::Value::MakeDouble(0));
+  }
+
+  std::atomic_bool start{false};
+  std::atomic_bool stop{false};
+  std::atomic<uint64_t> writes{0};
+  std::atomic<uint64_t> reads{0};
+  std::vector<std::thread> threads;
+
+  for (int t = 0; t < numWriters; ++t) {
+    threads.emplace_back([&, t] {
+      while (!start) {
+        std::this_thread::yield();
+      }
+      uint64_t count = 0;
+      double value = t;
+      while (!stop) {
+        value += 1;
+        nt::SetEntryValue(entries[count % kNumEntries],
+                          nt::Value::MakeDouble(value));
+        ++count;
+      }
+      writes += count;
+    });
+  }
+
+  for (int t = 0; t < numReaders; ++t) {
+    threads.emplace_back([&, t] {
+      while (!start) {
+        std::this_thread::yield();
+      }
+      uint64_t count = 0;
+      double sum = 0;
+      while (!stop) {
+        auto value = nt::GetEntryValue(entries[(count + t) % kNumEntries]);
+        if (value) {
+          sum += value->GetDouble();
+        }
+        ++count;
+      }
+      reads += count;
+      if (sum < 0) {
+        std::printf("unexpected sum\n");
+      }
+    });
+  }
+
+  start = true;
+  std::this_thread::sleep_for(kRunTime);
+  stop = true;
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  double secs = std::chrono::duration<double>(kRunTime).count();
+  std::printf("%7d %7d %14.0f %14.0f\n", numWriters, numReaders,
+              writes / secs, reads / secs);
+  std::fflush(stdout);
+
+  nt::DestroyInstance(inst);
+}
+
+}  // namespace
+
+int StorageContentionBench(int argc, char* argv[]) {
+  int maxReaders = argc > 0 ? std::atoi(argv[0]) : 4;
+
+  std::printf("%7s %7s %14s %14s\n", "writers", "readers", "writes_per_s",
+              "reads_per_s");
+  for (int writers = 0; writers <= 1; ++writers) {
+    for (int readers = 1; readers <= maxReaders; readers *= 2) {
+      RunCase(writers, readers);
+    }
+  }
+  RunCase(1, 0);
+  RunCase(2, 0);
+  return 0;
+}
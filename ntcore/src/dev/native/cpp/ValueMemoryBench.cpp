@@ -0,0 +1,131 @@
+// Copyright (c) FIRST and other WPILib contributors.
+// Open Source Software; you can modify and/or share it under the terms of
+// the WPILib BSD license file in the root directory of this project.
+
+// Measures the memory used by values and entries of each type, and the time
+// to make and set a changed value.  Heap use is taken from the allocator's
+// statistics before and after creating 10k values (alone, and as the values
+// of 10k entries in a fresh instance), so it includes allocator overhead.
+
+#include <stddef.h>
+
+#ifdef __linux__
+#include <malloc.h>
+#endif
+
+#include <chrono>
+#include <cstdio>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "Bench.h"
+#include "ntcore.h"
+
+namespace {
+
+constexpr int kNumEntries = 10000;
+constexpr int kPasses = 20;
+
+using MakeFunc = std::function<std::shared_ptr<nt::Value>(int)>;
+
+struct Case {
+  const char* name;
+  MakeFunc make;
+};
+
+// Bytes currently allocated from the heap, or 0 if unknown
+size_t HeapInUse() {
+#ifdef __GLIBC__
+  auto info = mallinfo2();
+  return info.uordblks + info.hblkhd;
+#else
+  return 0;
+#endif
+}
+
+double PerEntry(size_t before, size_t after) {
+  return static_cast<double>(after - before) / kNumEntries;
+}
+
+void RunCase(const Case& c) {
+  // values alone
+  std::vector<std::shared_ptr<nt::Value>> values;
+  values.reserve(kNumEntries);
+  size_t before = HeapInUse();
+  for (int i = 0; i < kNumEntries; ++i) {
+    values.emplace_back(c.make(i));
+  }
+  double valueBytes = PerEntry(before, HeapInUse());
+  values.clear();
+
+  // values in entries, including the name and storage bookkeeping
+  auto inst = nt::CreateInstance();
+  std::vector<NT_Entry> entries;
+  entries.reserve(kNumEntries);
+  before = HeapInUse();
+  for (int i = 0; i < kNumEntries; ++i) {
+    entries.push_back(
+        nt::GetEntry(inst, "/bench/entry" + std::to_string(i)));
+    nt::SetEntryValue(entries.back(), c.make(i));
+  }
+  double entryBytes = PerEntry(before, HeapInUse());
+
+  // make and set a changed value
+  auto start = std::chrono::steady_clock::now();
+  for (int pass = 1; pass <= kPasses; ++pass) {
+    for (int i = 0; i < kNumEntries; ++i) {
+      nt::SetEntryValue(entries[i], c.make(i + pass));
+    }
+  }
+  auto stop = std::chrono::steady_clock::now();
+  nt::DestroyInstance(inst);
+
+  double ns = std::chrono::duration<double, std::nano>(stop - start).count() /
+              (static_cast<double>(kNumEntries) * kPasses);
+  std::printf("%-14s %12.1f %12.1f %10.1f\n", c.name, valueBytes, entryBytes,
+              ns);
+}
+
+}  // namespace
+
+int ValueMemoryBench(int, char*[]) {
+  if (HeapInUse() == 0) {
+    std::fprintf(stderr, "heap statistics not available on this platform\n");
+  }
+
+  const Case cases[] = {
+      {"boolean", [](int i) { return nt::Value::MakeBoolean(i % 2 == 0); }},
+      {"double", [](int i) { return nt::Value::MakeDouble(i); }},
+      {"string-short",
+       [](int i) { return nt::Value::MakeString("s" + std::to_string(i)); }},
+      {"string-long",
+       [](int i) {
+         return nt::Value::MakeString("a much longer status string " +
+                                      std::to_string(i));
+       }},
+      {"double-array",
+       [](int i) {
+         return nt::Value::MakeDoubleArray({1.0 * i, 2.0, 3.0, 4.0, 5.0, 6.0});
+       }},
+      {"boolean-array",
+       [](int i) {
+         return nt::Value::MakeBooleanArray({i % 2 == 0, true, false, true});
+       }},
+      {"string-array",
+       [](int i) {
+         return nt::Value::MakeStringArray(
+             {"Auto" + std::to_string(i), "Teleop", "Test"});
+       }},
+  };
+
+  std::printf("%d entries; sizeof(nt::Value) = %zu\n", kNumEntries,
+              sizeof(nt::Value));
+  std::printf("%-14s %12s %12s %10s\n", "type", "value_bytes", "entry_bytes",
+              "set_ns");
+  for (auto&& c : cases) {
+    RunCase(c);
+  }
+  return 0;
+}
@@ -4,9 +4,46 @@
 
 #include <iostream>
 
+#include <wpi/StringRef.h>
+
+#include "Bench.h"
 #include "ntcore.h"
 
-int main() {
+int main(int argc, char* argv[]) {
+  if (argc > 1) {
+    wpi::StringRef name{argv[1]};
+    if (name == "server-scaling") {
+      return ServerScalingBench(argc - 2, argv + 2);
+    }
+    if (name == "entry-listener") {
+      return EntryListenerBench(argc - 2, argv + 2);
+    }
+    if (name == "storage-contention") {
+      return StorageContentionBench(argc - 2, argv + 2);
+    }
+    if (name == "compression") {
+      return CompressionBench(argc - 2, argv + 2);
+    }
+    if (name == "local-transport") {
+      return LocalTransportBench(argc - 2, argv + 2);
+    }
+    if (name == "value-memory") {
+      return ValueMemoryBench(argc - 2, argv + 2);
+    }
+    if (name == "path-index") {
+      return PathIndexBench(argc - 2, argv + 2);
+    }
+    if (name == "load-gen") {
+      return LoadGenBench(argc - 2, argv + 2);
+    }
+    std::cerr << "unknown benchmark '" << name.str() << "'\n"
+              << "available: server-scaling, entry-listener,\n"
+              << "           storage-contention, compression,\n"
+              << "           local-transport, value-memory,\n"
+              << "           path-index, load-gen\n";
+    return 1;
+  }
+
   auto myValue = nt::GetEntry(nt::GetDefaultInstance(), "MyValue");
 
   nt::SetEntryValue(myValue, nt::Value::MakeString("Hello World"));
@@ -12,6 +12,18 @@ public final class NetworkTableEntry {
   /** Flag values (as returned by {@link #getFlags()}). */
   public static final int kPersistent = 0x01;
 
+  /**
+   * Flag value: updates may be sent over the datagram channel, where they can be lost or
+   * superseded, if the connection has one.
+   */
+  public static final int kUnreliable = 0x02;
+
+  /**
+   * Flag value: every update (up to a bounded number between network updates) is sent, rather
+   * than only the latest one.
+   */
+  public static final int kHistory = 0x04;
+
   /**
    * Construct from native handle.
    *
@@ -215,6 +227,22 @@ public final class NetworkTableEntry {
         NetworkTablesJNI.getDoubleArray(m_handle, NetworkTableValue.toNative(defaultValue)));
   }
 
+  /**
+   * Gets the entry's value as a double array without allocating. The elements are copied into the
+   * direct buffer in native byte order (see {@link java.nio.ByteOrder#nativeOrder()}), as many as
+   * fit. If the returned length is larger than the buffer can hold, the value was truncated.
+   *
+   * @param dest the direct buffer to copy the value into
+   * @return the number of elements in the value, or -1 if the entry does not exist or is of
+   *     different type
+   */
+  public int getDoubleArray(ByteBuffer dest) {
+    if (!dest.isDirect()) {
+      throw new IllegalArgumentException("must be a direct buffer");
+    }
+    return NetworkTablesJNI.getDoubleArray(m_handle, dest);
+  }
+
   /**
    * Gets the entry's value as a double array. If the entry does not exist or is of different type,
    * it will return the default value.
@@ -569,6 +597,25 @@ public final class NetworkTableEntry {
     return NetworkTablesJNI.setDoubleArray(m_handle, 0, value, false);
   }
 
+  /**
+   * Sets the entry's value.
+   *
+   * @param value the value to set, as doubles in native byte order (see {@link
+   *     java.nio.ByteOrder#nativeOrder()})
+   * @param len the number of elements in the value
+   * @return False if the entry exists with a different type
+   */
+  public boolean setDoubleArray(ByteBuffer value, int len) {
+    if (!value.isDirect()) {
+      throw new IllegalArgumentException("must be a direct buffer");
+    }
+    if (value.capacity() < len * Double.BYTES) {
+      throw new IllegalArgumentException(
+          "buffer is too small, must be at least " + len * Double.BYTES);
+    }
+    return NetworkTablesJNI.setDoubleArray(m_handle, 0, value, len, false);
+  }
+
   /**
    * Sets the entry's value.
    *
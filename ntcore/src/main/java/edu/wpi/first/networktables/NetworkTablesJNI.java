@@ -86,6 +86,9 @@ public final class NetworkTablesJNI {
 
   public static native boolean setDoubleArray(int entry, long time, double[] value, boolean force);
 
+  public static native boolean setDoubleArray(
+      int entry, long time, ByteBuffer value, int len, boolean force);
+
   public static native boolean setStringArray(int entry, long time, String[] value, boolean force);
 
   public static native NetworkTableValue getValue(int entry);
@@ -102,6 +105,16 @@ public final class NetworkTablesJNI {
 
   public static native double[] getDoubleArray(int entry, double[] defaultValue);
 
+  public static native int getDoubleArray(int entry, ByteBuffer dest);
+
+  public static native int getDoubles(int[] entries, ByteBuffer dest, double defaultValue);
+
+  public static native int getBooleans(int[] entries, ByteBuffer dest, boolean defaultValue);
+
+  public static native boolean setDoubles(int[] entries, long time, ByteBuffer values);
+
+  public static native boolean setBooleans(int[] entries, long time, ByteBuffer values);
+
   public static native String[] getStringArray(int entry, String[] defaultValue);
 
   public static native boolean setDefaultBoolean(int entry, long time, boolean defaultValue);
@@ -133,6 +146,9 @@ public final class NetworkTablesJNI {
 
   public static native int createEntryListenerPoller(int inst);
 
+  public static native int createBoundedEntryListenerPoller(
+      int inst, int capacity, int overflow);
+
   public static native void destroyEntryListenerPoller(int poller);
 
   public static native int addPolledEntryListener(int poller, String prefix, int flags);
@@ -147,12 +163,17 @@ public final class NetworkTablesJNI {
 
   public static native void cancelPollEntryListener(int poller);
 
+  public static native long getEntryListenerPollerDropped(int poller);
+
   public static native void removeEntryListener(int entryListener);
 
   public static native boolean waitForEntryListenerQueue(int inst, double timeout);
 
   public static native int createConnectionListenerPoller(int inst);
 
+  public static native int createBoundedConnectionListenerPoller(
+      int inst, int capacity, int overflow);
+
   public static native void destroyConnectionListenerPoller(int poller);
 
   public static native int addPolledConnectionListener(int poller, boolean immediateNotify);
@@ -165,6 +186,8 @@ public final class NetworkTablesJNI {
 
   public static native void cancelPollConnectionListener(int poller);
 
+  public static native long getConnectionListenerPollerDropped(int poller);
+
   public static native void removeConnectionListener(int connListener);
 
   public static native boolean waitForConnectionListenerQueue(int inst, double timeout);
@@ -0,0 +1,74 @@
+// Copyright (c) FIRST and other WPILib contributors.
+// Open Source Software; you can modify and/or share it under the terms of
+// the WPILib BSD license file in the root directory of this project.
+
+#include "DatagramChannel.h"
+
+#include <stdint.h>
+
+#include <utility>
+#include <vector>
+
+#include <wpi/SmallString.h>
+
+#include "Log.h"
+
+using namespace nt;
+
+DatagramChannel::DatagramChannel(wpi::Logger& logger, ReceiveFunc on_receive)
+    : m_logger(logger), m_on_receive(std::move(on_receive)), m_udp(logger) {}
+
+DatagramChannel::~DatagramChannel() {
+  Stop();
+}
+
+bool DatagramChannel::Start() {
+  if (m_active) {
+    return true;
+  }
+  if (m_udp.start(0) != 0) {
+    WARNING("could not open datagram channel");
+    return false;
+  }
+  // wake up periodically to check for Stop()
+  m_udp.set_timeout(0.1);
+  m_active = true;
+  m_receive_thread = std::thread(&DatagramChannel::ReceiveThreadMain, this);
+  DEBUG0("datagram channel on port " << m_udp.port());
+  return true;
+}
+
+void DatagramChannel::Stop() {
+  m_active = false;
+  if (m_receive_thread.joinable()) {
+    m_receive_thread.join();
+  }
+}
+
+void DatagramChannel::Send(wpi::StringRef data, wpi::StringRef ip,
+                           unsigned int port) {
+  if (m_udp.port() == 0) {
+    return;
+  }
+  m_udp.send(data, ip, static_cast<int>(port));
+}
+
+void DatagramChannel::ReceiveThreadMain() {
+  std::vector<uint8_t> buf(64 * 1024);
+  wpi::SmallString<32> ip;
+  while (m_active) {
+    int port;
+    int len = m_udp.receive(buf.data(), static_cast<int>(buf.size()), &ip,
+                            &port);
+    if (len < 4 || !m_active) {
+      continue;  // timed out, or too short to have a token
+    }
+    unsigned int token = (static_cast<unsigned int>(buf[0]) << 24) |
+                         (static_cast<unsigned int>(buf[1]) << 16) |
+                         (static_cast<unsigned int>(buf[2]) << 8) | buf[3];
+    m_on_receive(token,
+                 {reinterpret_cast<const char*>(buf.data()) + 4,
+                  static_cast<size_t>(len) - 4},
+                 ip, static_cast<unsigned int>(port));
+  }
+}
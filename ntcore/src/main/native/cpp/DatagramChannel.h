@@ -0,0 +1,75 @@
+// Copyright (c) FIRST and other WPILib contributors.
+// Open Source Software; you can modify and/or share it under the terms of
+// the WPILib BSD license file in the root directory of this project.
+
+#ifndef NTCORE_DATAGRAMCHANNEL_H_
+#define NTCORE_DATAGRAMCHANNEL_H_
+
+#include <stddef.h>
+
+#include <atomic>
+#include <functional>
+#include <thread>
+
+#include <wpi/StringRef.h>
+#include <wpi/UDPClient.h>
+
+namespace wpi {
+class Logger;
+}  // namespace wpi
+
+namespace nt {
+
+/**
+ * UDP socket shared by the connections of a dispatcher for the value
+ * updates of entries flagged NT_UNRELIABLE.  Each datagram starts with the
+ * 32-bit token of the connection it belongs to, followed by entry update
+ * messages in the 3.0 wire format.  Datagrams may be lost, duplicated or
+ * reordered; receivers rely on the entry sequence numbers to keep only the
+ * latest value.
+ */
+class DatagramChannel {
+ public:
+  // Called on the receive thread with the contents of a datagram after the
+  // token, and the address it came from.
+  using ReceiveFunc =
+      std::function<void(unsigned int token, wpi::StringRef data,
+                         wpi::StringRef ip, unsigned int port)>;
+
+  // Largest datagram sent; fits in a typical path MTU so datagrams are not
+  // fragmented.  Larger updates are sent over the stream instead.
+  static constexpr size_t kMaxDatagramSize = 1200;
+
+  DatagramChannel(wpi::Logger& logger, ReceiveFunc on_receive);
+  ~DatagramChannel();
+
+  DatagramChannel(const DatagramChannel&) = delete;
+  DatagramChannel& operator=(const DatagramChannel&) = delete;
+
+  // Binds an ephemeral port and starts the receive thread.  Returns false
+  // if the socket could not be opened.
+  bool Start();
+
+  // Stops the receive thread.  The socket stays open (and sends keep
+  // working) until the channel is destroyed, as connections may still hold
+  // it.
+  void Stop();
+
+  unsigned int port() const { return m_udp.port(); }
+
+  // The ip must be a numeric IPv4 address.
+  void Send(wpi::StringRef data, wpi::StringRef ip, unsigned int port);
+
+ private:
+  void ReceiveThreadMain();
+
+  wpi::Logger& m_logger;
+  ReceiveFunc m_on_receive;
+  wpi::UDPClient m_udp;
+  std::thread m_receive_thread;
+  std::atomic_bool m_active{false};
+};
+
+}  // namespace nt
+
+#endif  // NTCORE_DATAGRAMCHANNEL_H_
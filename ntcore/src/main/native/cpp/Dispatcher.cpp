@@ -6,32 +6,63 @@
 
 #include <algorithm>
 #include <iterator>
+#include <random>
 
+#include <wpi/EventLoopRunner.h>
+#include <wpi/SharedMemoryAcceptor.h>
+#include <wpi/SharedMemoryConnector.h>
+#include <wpi/SmallString.h>
 #include <wpi/TCPAcceptor.h>
 #include <wpi/TCPConnector.h>
 #include <wpi/timestamp.h>
+#include <wpi/uv/Tcp.h>
+#include <wpi/uv/util.h>
 
+#include "DatagramChannel.h"
 #include "IConnectionNotifier.h"
 #include "IStorage.h"
 #include "Log.h"
 #include "NetworkConnection.h"
+#include "UvNetworkConnection.h"
 
 using namespace nt;
 
 void Dispatcher::StartServer(const wpi::Twine& persist_filename,
                              const char* listen_address, unsigned int port) {
   std::string listen_address_copy(wpi::StringRef(listen_address).trim());
+  std::unique_ptr<wpi::NetworkAcceptor> local_acceptor;
+  if (wpi::StringRef(listen_address_copy).startswith("shm:")) {
+    local_acceptor = std::make_unique<wpi::SharedMemoryAcceptor>(
+        wpi::StringRef(listen_address_copy).substr(4), m_logger);
+    listen_address_copy.clear();
+  }
+  if (m_server_event_loop) {
+    StartServerLoop(persist_filename, listen_address_copy, port,
+                    std::move(local_acceptor));
+    return;
+  }
   DispatcherBase::StartServer(
       persist_filename,
       std::unique_ptr<wpi::NetworkAcceptor>(new wpi::TCPAcceptor(
-          static_cast<int>(port), listen_address_copy.c_str(), m_logger)));
+          static_cast<int>(port), listen_address_copy.c_str(), m_logger)),
+      std::move(local_acceptor));
+}
+
+// Connects to a TCP server, or over shared memory for "shm:<name>"
+static std::unique_ptr<wpi::NetworkStream> ConnectServer(
+    const std::string& server_name, unsigned int port, wpi::Logger& logger) {
+  if (wpi::StringRef(server_name).startswith("shm:")) {
+    return wpi::SharedMemoryConnector::connect(server_name.c_str() + 4,
+                                               logger, 1);
+  }
+  return wpi::TCPConnector::connect(server_name.c_str(),
+                                    static_cast<int>(port), logger, 1);
 }
 
 void Dispatcher::SetServer(const char* server_name, unsigned int port) {
   std::string server_name_copy(wpi::StringRef(server_name).trim());
   SetConnector([=]() -> std::unique_ptr<wpi::NetworkStream> {
-    return wpi::TCPConnector::connect(server_name_copy.c_str(),
-                                      static_cast<int>(port), m_logger, 1);
+    return ConnectServer(server_name_copy, port, m_logger);
   });
 }
 
@@ -97,8 +128,7 @@ void Dispatcher::SetServerTeam(unsigned int team, unsigned int port) {
 void Dispatcher::SetServerOverride(const char* server_name, unsigned int port) {
   std::string server_name_copy(wpi::StringRef(server_name).trim());
   SetConnectorOverride([=]() -> std::unique_ptr<wpi::NetworkStream> {
-    return wpi::TCPConnector::connect(server_name_copy.c_str(),
-                                      static_cast<int>(port), m_logger, 1);
+    return ConnectServer(server_name_copy, port, m_logger);
   });
 }
 
@@ -130,22 +160,71 @@ void DispatcherBase::StartLocal() {
     m_active = true;
   }
   m_networkMode = NT_NET_MODE_LOCAL;
+  m_client_session_token = 0;
   m_storage.SetDispatcher(this, false);
 }
 
 void DispatcherBase::StartServer(
     const wpi::Twine& persist_filename,
+    std::unique_ptr<wpi::NetworkAcceptor> acceptor,
+    std::unique_ptr<wpi::NetworkAcceptor> local_acceptor) {
+  if (!StartServerCommon(persist_filename)) {
+    return;
+  }
+  m_server_acceptor = std::move(acceptor);
+
+  m_dispatch_thread = std::thread(&Dispatcher::DispatchThreadMain, this);
+  m_clientserver_thread = std::thread(&Dispatcher::ServerThreadMain, this);
+  StartLocalAcceptor(std::move(local_acceptor));
+}
+
+void DispatcherBase::StartServerLoop(
+    const wpi::Twine& persist_filename, const wpi::Twine& listen_address,
+    unsigned int port, std::unique_ptr<wpi::NetworkAcceptor> local_acceptor) {
+  if (!StartServerCommon(persist_filename)) {
+    return;
+  }
+
+  // All connections are serviced by a single event loop thread rather than
+  // a read and write thread per connection.
+  m_server_loop = std::make_unique<wpi::EventLoopRunner>();
+  m_server_loop->ExecAsync(
+      [this, address = listen_address.str(), port](wpi::uv::Loop& loop) {
+        ServerLoopListen(loop, address, port);
+      });
+
+  m_dispatch_thread = std::thread(&Dispatcher::DispatchThreadMain, this);
+  StartLocalAcceptor(std::move(local_acceptor));
+}
+
+void DispatcherBase::StartLocalAcceptor(
     std::unique_ptr<wpi::NetworkAcceptor> acceptor) {
+  if (!acceptor) {
+    return;
+  }
+  m_local_acceptor = std::move(acceptor);
+  m_local_thread = std::thread(&Dispatcher::LocalThreadMain, this);
+}
+
+bool DispatcherBase::StartServerCommon(const wpi::Twine& persist_filename) {
   {
     std::scoped_lock lock(m_user_mutex);
     if (m_active) {
-      return;
+      return false;
     }
     m_active = true;
   }
   m_networkMode = NT_NET_MODE_SERVER | NT_NET_MODE_STARTING;
   m_persist_filename = persist_filename.str();
-  m_server_acceptor = std::move(acceptor);
+
+  // entry ids are only meaningful to clients of this server instance
+  m_client_session_token = 0;
+  std::random_device rd;
+  unsigned int token;
+  do {
+    token = rd();
+  } while (token == 0);
+  m_server_session_token = token;
 
   // Load persistent file.  Ignore errors, but pass along warnings.
   if (!persist_filename.isTriviallyEmpty() &&
@@ -164,9 +243,8 @@ void DispatcherBase::StartServer(
   }
 
   m_storage.SetDispatcher(this, true);
-
-  m_dispatch_thread = std::thread(&Dispatcher::DispatchThreadMain, this);
-  m_clientserver_thread = std::thread(&Dispatcher::ServerThreadMain, this);
+  StartDatagramChannel();
+  return true;
 }
 
 void DispatcherBase::StartClient() {
@@ -179,12 +257,14 @@ void DispatcherBase::StartClient() {
   }
   m_networkMode = NT_NET_MODE_CLIENT | NT_NET_MODE_STARTING;
   m_storage.SetDispatcher(this, false);
+  StartDatagramChannel();
 
   m_dispatch_thread = std::thread(&Dispatcher::DispatchThreadMain, this);
   m_clientserver_thread = std::thread(&Dispatcher::ClientThreadMain, this);
 }
 
 void DispatcherBase::Stop() {
+  bool client = (m_networkMode & NT_NET_MODE_CLIENT) != 0;
   m_active = false;
 
   // wake up dispatch thread with a flush
@@ -201,6 +281,22 @@ void DispatcherBase::Stop() {
   if (m_server_acceptor) {
     m_server_acceptor->shutdown();
   }
+  if (m_local_acceptor) {
+    m_local_acceptor->shutdown();
+  }
+
+  // stop the server event loop; this closes all of its connections
+  m_server_loop.reset();
+
+  // stop receiving datagrams; connections may still hold the channel
+  std::shared_ptr<DatagramChannel> datagram;
+  {
+    std::scoped_lock lock(m_user_mutex);
+    datagram = std::move(m_datagram);
+  }
+  if (datagram) {
+    datagram->Stop();
+  }
 
   // join threads, with timeout
   if (m_dispatch_thread.joinable()) {
@@ -209,6 +305,9 @@ void DispatcherBase::Stop() {
   if (m_clientserver_thread.joinable()) {
     m_clientserver_thread.join();
   }
+  if (m_local_thread.joinable()) {
+    m_local_thread.join();
+  }
 
   std::vector<std::shared_ptr<INetworkConnection>> conns;
   {
@@ -218,6 +317,49 @@ void DispatcherBase::Stop() {
 
   // close all connections
   conns.resize(0);
+
+  // outstanding RPC calls to the server will never be answered
+  if (client) {
+    m_storage.CancelRpcCalls();
+  }
+}
+
+void DispatcherBase::StartDatagramChannel() {
+  if (!m_datagrams) {
+    return;
+  }
+  using namespace std::placeholders;
+  auto datagram = std::make_shared<DatagramChannel>(
+      m_logger,
+      std::bind(&DispatcherBase::ProcessDatagram, this, _1, _2, _3, _4));
+  if (!datagram->Start()) {
+    return;  // connections just use the stream
+  }
+  std::scoped_lock lock(m_user_mutex);
+  m_datagram = std::move(datagram);
+}
+
+void DispatcherBase::ProcessDatagram(unsigned int token, wpi::StringRef data,
+                                     wpi::StringRef ip, unsigned int port) {
+  if (token == 0) {
+    return;
+  }
+  std::shared_ptr<NetworkConnection> conn;
+  {
+    std::scoped_lock lock(m_user_mutex);
+    for (auto& c : m_connections) {
+      auto nc = std::static_pointer_cast<NetworkConnection>(c);
+      if (nc->datagram_token() == token) {
+        conn = std::move(nc);
+        break;
+      }
+    }
+  }
+  // storage sends the updates on through QueueOutgoing, so this must be
+  // called without holding the user mutex
+  if (conn) {
+    conn->ProcessDatagram(data, ip, port);
+  }
 }
 
 void DispatcherBase::SetUpdateRate(double interval) {
@@ -230,6 +372,23 @@ void DispatcherBase::SetUpdateRate(double interval) {
   m_update_rate = static_cast<unsigned int>(interval * 1000);
 }
 
+void DispatcherBase::SetPublishPolicy(const wpi::Twine& prefix,
+                                      const PublishPolicy& policy) {
+  wpi::SmallString<128> buf;
+  m_publish_policies.Set(prefix.toStringRef(buf), policy);
+}
+
+void DispatcherBase::ClearPublishPolicy(const wpi::Twine& prefix) {
+  wpi::SmallString<128> buf;
+  m_publish_policies.Clear(prefix.toStringRef(buf));
+}
+
+bool DispatcherBase::GetPublishPolicyStats(const wpi::Twine& prefix,
+                                           PublishPolicyStats* stats) const {
+  wpi::SmallString<128> buf;
+  return m_publish_policies.GetStats(prefix.toStringRef(buf), stats);
+}
+
 void DispatcherBase::SetIdentity(const wpi::Twine& name) {
   std::scoped_lock lock(m_user_mutex);
   m_identity = name.str();
@@ -249,6 +408,31 @@ void DispatcherBase::Flush() {
   m_flush_cv.notify_one();
 }
 
+void DispatcherBase::FlushSoon() {
+  {
+    std::scoped_lock lock(m_flush_mutex);
+    m_do_flush = true;
+  }
+  m_flush_cv.notify_one();
+}
+
+std::vector<ConnectionMetrics> DispatcherBase::GetConnectionMetrics() const {
+  std::vector<ConnectionMetrics> conns;
+  if (!m_active) {
+    return conns;
+  }
+
+  std::scoped_lock lock(m_user_mutex);
+  for (auto& conn : m_connections) {
+    if (conn->state() != NetworkConnection::kActive) {
+      continue;
+    }
+    conns.emplace_back(conn->metrics());
+  }
+
+  return conns;
+}
+
 std::vector<ConnectionInfo> DispatcherBase::GetConnections() const {
   std::vector<ConnectionInfo> conns;
   if (!m_active) {
@@ -334,31 +518,38 @@ void DispatcherBase::ClearConnectorOverride() {
 }
 
 void DispatcherBase::DispatchThreadMain() {
-  auto timeout_time = std::chrono::steady_clock::now();
+  auto start = std::chrono::steady_clock::now();
+
+  // only the periodic timeout advances this, so frequent flushes can't
+  // postpone periodic updates
+  auto next_update_time = start + std::chrono::milliseconds(m_update_rate);
 
   static const auto save_delta_time = std::chrono::seconds(1);
-  auto next_save_time = timeout_time + save_delta_time;
+  auto next_save_time = start + save_delta_time;
+  auto next_metrics_time = start + save_delta_time;
 
   int count = 0;
 
   while (m_active) {
-    // handle loop taking too long
-    auto start = std::chrono::steady_clock::now();
-    if (start > timeout_time) {
-      timeout_time = start;
-    }
-
     // wait for periodic or when flushed
-    timeout_time += std::chrono::milliseconds(m_update_rate);
     std::unique_lock<wpi::mutex> flush_lock(m_flush_mutex);
-    m_flush_cv.wait_until(flush_lock, timeout_time,
-                          [&] { return !m_active || m_do_flush; });
+    bool periodic = !m_flush_cv.wait_until(
+        flush_lock, next_update_time, [&] { return !m_active || m_do_flush; });
     m_do_flush = false;
     flush_lock.unlock();
     if (!m_active) {
       break;  // in case we were woken up to terminate
     }
 
+    start = std::chrono::steady_clock::now();
+    if (periodic) {
+      next_update_time += std::chrono::milliseconds(m_update_rate);
+      // handle loop taking too long
+      if (start > next_update_time) {
+        next_update_time = start + std::chrono::milliseconds(m_update_rate);
+      }
+    }
+
     // perform periodic persistent save
     if ((m_networkMode & NT_NET_MODE_SERVER) != 0 &&
         !m_persist_filename.empty() && start > next_save_time) {
@@ -373,6 +564,14 @@ void DispatcherBase::DispatchThreadMain() {
       }
     }
 
+    // publish connection metrics (before posting so they go out this time)
+    if ((m_publish_metrics || !m_metrics_published.empty()) &&
+        start > next_metrics_time) {
+      next_metrics_time = start + save_delta_time;
+      PublishMetrics();
+    }
+
+    bool disconnected = false;
     {
       std::scoped_lock user_lock(m_user_mutex);
       bool reconnect = false;
@@ -399,9 +598,73 @@ void DispatcherBase::DispatchThreadMain() {
       if (reconnect && !m_do_reconnect) {
         m_do_reconnect = true;
         m_reconnect_cv.notify_one();
+        disconnected = true;
+      }
+    }
+
+    // the server can no longer answer outstanding RPC calls; storage calls
+    // back into the dispatcher, so this is done without the user mutex held
+    if (disconnected) {
+      m_storage.CancelRpcCalls();
+    }
+  }
+}
+
+void DispatcherBase::PublishMetrics() {
+  static const char* const kNames[] = {
+      "bytes_sent",    "bytes_received", "messages_sent",
+      "messages_received", "queue_depth", "flush_latency",
+      "handshake_duration", "rtt"};
+
+  wpi::SmallString<128> base{"/.nt/metrics/"};
+  {
+    std::scoped_lock lock(m_user_mutex);
+    if (m_identity.empty()) {
+      base += (m_networkMode & NT_NET_MODE_SERVER) != 0 ? "server" : "client";
+    } else {
+      base += m_identity;
+    }
+  }
+  base += '/';
+  size_t base_len = base.size();
+
+  // storage sends the updates through QueueOutgoing, so this must be called
+  // without holding the user mutex
+  std::vector<std::string> published;
+  if (m_publish_metrics) {
+    for (auto& m : GetConnectionMetrics()) {
+      // the port keeps connections from the same identity apart
+      base.resize(base_len);
+      wpi::raw_svector_ostream{base}
+          << (m.info.remote_id.empty() ? m.info.remote_ip : m.info.remote_id)
+          << ':' << m.info.remote_port << '/';
+      published.emplace_back(base.str());
+      size_t conn_len = base.size();
+      const uint64_t values[] = {m.bytes_sent,        m.bytes_received,
+                                 m.messages_sent,     m.messages_received,
+                                 m.queue_depth,       m.flush_latency,
+                                 m.handshake_duration, m.rtt};
+      for (size_t i = 0; i < std::size(kNames); ++i) {
+        base.resize(conn_len);
+        base += kNames[i];
+        m_storage.SetEntryValue(
+            base, Value::MakeDouble(static_cast<double>(values[i])));
       }
     }
   }
+
+  // remove the tables of connections that have closed (all of them once
+  // publishing is disabled)
+  for (auto& prefix : m_metrics_published) {
+    if (std::find(published.begin(), published.end(), prefix) !=
+        published.end()) {
+      continue;
+    }
+    for (auto name : kNames) {
+      m_storage.DeleteEntry(prefix + name);
+    }
+  }
+  m_metrics_published = std::move(published);
 }
 
 void DispatcherBase::QueueOutgoing(std::shared_ptr<Message> msg,
@@ -424,6 +687,30 @@ void DispatcherBase::QueueOutgoing(std::shared_ptr<Message> msg,
   }
 }
 
+void DispatcherBase::QueueOutgoingGroup(
+    wpi::ArrayRef<std::shared_ptr<Message>> msgs, INetworkConnection* only,
+    INetworkConnection* except) {
+  // Holding the user mutex keeps the dispatch thread from posting any
+  // connection's pending messages partway through the group.
+  std::scoped_lock user_lock(m_user_mutex);
+  for (auto& conn : m_connections) {
+    if (conn.get() == except) {
+      continue;
+    }
+    if (only && conn.get() != only) {
+      continue;
+    }
+    auto state = conn->state();
+    if (state != NetworkConnection::kSynchronized &&
+        state != NetworkConnection::kActive) {
+      continue;
+    }
+    for (auto& msg : msgs) {
+      conn->QueueOutgoing(msg);
+    }
+  }
+}
+
 void DispatcherBase::ServerThreadMain() {
   if (m_server_acceptor->start() != 0) {
     m_active = false;
@@ -441,36 +728,121 @@ void DispatcherBase::ServerThreadMain() {
       m_networkMode = NT_NET_MODE_NONE;
       return;
     }
-    DEBUG0("server: client connection from " << stream->getPeerIP() << " port "
-                                             << stream->getPeerPort());
+    AddServerConnection(std::move(stream));
+  }
+  m_networkMode = NT_NET_MODE_NONE;
+}
+
+void DispatcherBase::LocalThreadMain() {
+  if (m_local_acceptor->start() != 0) {
+    ERROR("server: could not start local transport");
+    return;
+  }
+  while (m_active) {
+    auto stream = m_local_acceptor->accept();
+    if (!stream || !m_active) {
+      return;
+    }
+    AddServerConnection(std::move(stream));
+  }
+}
+
+void DispatcherBase::AddServerConnection(
+    std::unique_ptr<wpi::NetworkStream> stream) {
+  DEBUG0("server: client connection from " << stream->getPeerIP() << " port "
+                                           << stream->getPeerPort());
+
+  // add to connections list
+  using namespace std::placeholders;
+  auto conn = std::make_shared<NetworkConnection>(
+      ++m_connections_uid, std::move(stream), m_notifier, m_logger,
+      std::bind(&Dispatcher::ServerHandshake, this, _1, _2, _3),   // NOLINT
+      std::bind(&IStorage::GetMessageEntryType, &m_storage, _1));  // NOLINT
+  AddServerConnection(std::move(conn));
+}
+
+void DispatcherBase::AddServerConnection(
+    std::shared_ptr<NetworkConnection> conn) {
+  InitConnection(conn);
+  std::scoped_lock lock(m_user_mutex);
+  // reuse dead connection slots
+  bool placed = false;
+  for (auto& c : m_connections) {
+    if (c->state() == NetworkConnection::kDead) {
+      c = conn;
+      placed = true;
+      break;
+    }
+  }
+  if (!placed) {
+    m_connections.emplace_back(conn);
+  }
+  conn->Start();
+}
+
+// Setup common to client and server connections of every transport; must
+// be called before the connection is started
+void DispatcherBase::InitConnection(
+    const std::shared_ptr<NetworkConnection>& conn) {
+  using namespace std::placeholders;
+  conn->set_process_incoming(
+      std::bind(&IStorage::ProcessIncoming, &m_storage, _1, _2,  // NOLINT
+                std::weak_ptr<NetworkConnection>(conn)));
+  conn->set_publish_policies(&m_publish_policies);
+  conn->set_compression_enabled(m_compression);
+}
+
+void DispatcherBase::ServerLoopListen(wpi::uv::Loop& loop,
+                                      const std::string& listen_address,
+                                      unsigned int port) {
+  auto server = wpi::uv::Tcp::Create(loop);
+  if (!server) {
+    m_active = false;
+    m_networkMode = NT_NET_MODE_SERVER | NT_NET_MODE_FAILURE;
+    return;
+  }
+
+  // any error on the listening socket shuts down the server
+  server->error.connect([this, srv = server.get(), port](wpi::uv::Error err) {
+    ERROR("server: error on port " << port << ": " << err.str());
+    m_active = false;
+    m_networkMode = NT_NET_MODE_SERVER | NT_NET_MODE_FAILURE;
+    srv->Close();
+  });
+
+  server->connection.connect([this, srv = server.get()] {
+    auto tcp = srv->Accept();
+    if (!tcp) {
+      return;
+    }
+    if (!m_active) {
+      tcp->Close();
+      return;
+    }
+
+    std::string ip;
+    unsigned int peer_port = 0;
+    wpi::uv::AddrToName(tcp->GetPeer(), &ip, &peer_port);
+    DEBUG0("server: client connection from " << ip << " port " << peer_port);
 
     // add to connections list
     using namespace std::placeholders;
-    auto conn = std::make_shared<NetworkConnection>(
-        ++m_connections_uid, std::move(stream), m_notifier, m_logger,
+    auto conn = std::make_shared<UvNetworkConnection>(
+        ++m_connections_uid, tcp, ip, peer_port, m_notifier, m_logger,
         std::bind(&Dispatcher::ServerHandshake, this, _1, _2, _3),   // NOLINT
         std::bind(&IStorage::GetMessageEntryType, &m_storage, _1));  // NOLINT
-    conn->set_process_incoming(
-        std::bind(&IStorage::ProcessIncoming, &m_storage, _1, _2,  // NOLINT
-                  std::weak_ptr<NetworkConnection>(conn)));
-    {
-      std::scoped_lock lock(m_user_mutex);
-      // reuse dead connection slots
-      bool placed = false;
-      for (auto& c : m_connections) {
-        if (c->state() == NetworkConnection::kDead) {
-          c = conn;
-          placed = true;
-          break;
-        }
-      }
-      if (!placed) {
-        m_connections.emplace_back(conn);
-      }
-      conn->Start();
-    }
+    AddServerConnection(std::move(conn));
+  });
+
+  server->Bind(listen_address, port);
+  if (server->IsClosing()) {
+    return;
   }
-  m_networkMode = NT_NET_MODE_NONE;
+  server->Listen();
+  if (server->IsClosing()) {
+    return;
+  }
+  m_networkMode = NT_NET_MODE_SERVER;
 }
 
 void DispatcherBase::ClientThreadMain() {
@@ -509,9 +881,7 @@ void DispatcherBase::ClientThreadMain() {
         ++m_connections_uid, std::move(stream), m_notifier, m_logger,
         std::bind(&Dispatcher::ClientHandshake, this, _1, _2, _3),   // NOLINT
         std::bind(&IStorage::GetMessageEntryType, &m_storage, _1));  // NOLINT
-    conn->set_process_incoming(
-        std::bind(&IStorage::ProcessIncoming, &m_storage, _1, _2,  // NOLINT
-                  std::weak_ptr<NetworkConnection>(conn)));
+    InitConnection(conn);
     m_connections.resize(0);  // disconnect any current
     m_connections.emplace_back(conn);
     conn->set_proto_rev(m_reconnect_proto_rev);
@@ -532,22 +902,39 @@ bool DispatcherBase::ClientHandshake(
     std::function<void(wpi::ArrayRef<std::shared_ptr<Message>>)> send_msgs) {
   // get identity
   std::string self_id;
+  std::shared_ptr<DatagramChannel> datagram;
   {
     std::scoped_lock lock(m_user_mutex);
     self_id = m_identity;
+    datagram = m_datagram;
   }
 
-  // send client hello
+  // send client hello, resuming the last session if possible
+  unsigned int resume_token = 0;
+  if (m_session_resume && conn.proto_rev() >= 0x0300) {
+    resume_token = m_client_session_token;
+  }
   DEBUG0("client: sending hello");
-  send_msgs(Message::ClientHello(self_id));
+  uint64_t hello_time = wpi::Now();
+  if (resume_token != 0) {
+    std::vector<Message::EntryWatermark> watermarks;
+    m_storage.GetResumeWatermarks(&watermarks);
+    send_msgs(Message::SessionResume(self_id, resume_token, watermarks));
+  } else {
+    send_msgs(Message::ClientHello(self_id));
+  }
 
   // wait for response
   auto msg = get_msg();
   if (!msg) {
     // disconnected, retry
     DEBUG0("client: server disconnected before first response");
+    // a server without session support disconnects on the resume; send a
+    // plain hello next time
+    m_client_session_token = 0;
     return false;
   }
+  conn.set_rtt(wpi::Now() - hello_time);
 
   if (msg->Is(Message::kProtoUnsup)) {
     if (msg->id() == 0x0200) {
@@ -557,6 +944,8 @@ bool DispatcherBase::ClientHandshake(
   }
 
   bool new_server = true;
+  bool resumed = false;
+  unsigned int client_flags = 0;
   if (conn.proto_rev() >= 0x0300) {
     // should be server hello; if not, disconnect.
     if (!msg->Is(Message::kServerHello)) {
@@ -566,6 +955,29 @@ bool DispatcherBase::ClientHandshake(
     if ((msg->flags() & 1) != 0) {
       new_server = false;
     }
+    if ((msg->flags() & NetworkConnection::kHelloFlagCompression) != 0) {
+      conn.StartCompression();
+    }
+    if ((msg->flags() & NetworkConnection::kHelloFlagArrayDelta) != 0) {
+      conn.set_array_deltas(true);
+      client_flags |= NetworkConnection::kHelloFlagArrayDelta;
+    }
+    if ((msg->flags() & NetworkConnection::kHelloFlagHistory) != 0) {
+      conn.set_entry_history(true);
+      client_flags |= NetworkConnection::kHelloFlagHistory;
+    }
+    if ((msg->flags() & NetworkConnection::kHelloFlagResume) != 0 &&
+        m_session_resume) {
+      client_flags |= NetworkConnection::kHelloFlagResume;
+    }
+    resumed = resume_token != 0 &&
+              (msg->flags() & NetworkConnection::kHelloFlagResumed) != 0;
+    // datagrams are sent to the server's IPv4 address
+    in_addr addr;
+    if ((msg->flags() & NetworkConnection::kHelloFlagDatagram) != 0 &&
+        datagram && wpi::uv::NameToAddr(conn.info().remote_ip, &addr) == 0) {
+      client_flags |= NetworkConnection::kHelloFlagDatagram;
+    }
     // get the next message
     msg = get_msg();
   }
@@ -588,7 +1000,8 @@ bool DispatcherBase::ClientHandshake(
       msg = get_msg();
       continue;
     }
-    if (!msg->Is(Message::kEntryAssign)) {
+    if (!msg->Is(Message::kEntryAssign) &&
+        !(resumed && msg->Is(Message::kEntryDelete))) {
       // unexpected message
       DEBUG0("client: received message ("
              << msg->type()
@@ -603,7 +1016,18 @@ bool DispatcherBase::ClientHandshake(
   // generate outgoing assignments
   NetworkConnection::Outgoing outgoing;
 
-  m_storage.ApplyInitialAssignments(conn, incoming, new_server, &outgoing);
+  // tell the server which of its extensions we accept
+  if (client_flags != 0) {
+    outgoing.emplace_back(Message::ClientFlags(client_flags));
+  }
+
+  if (resumed) {
+    DEBUG0("client: resumed session with " << incoming.size()
+                                           << " changed entries");
+    m_storage.ApplyResumeAssignments(conn, incoming, &outgoing);
+  } else {
+    m_storage.ApplyInitialAssignments(conn, incoming, new_server, &outgoing);
+  }
 
   if (conn.proto_rev() >= 0x0300) {
     outgoing.emplace_back(Message::ClientHelloDone());
@@ -613,8 +1037,33 @@ bool DispatcherBase::ClientHandshake(
     send_msgs(outgoing);
   }
 
-  INFO("client: CONNECTED to server " << conn.stream().getPeerIP() << " port "
-                                      << conn.stream().getPeerPort());
+  // the server replies to the client hello done with the datagram token
+  // and then the session token
+  if ((client_flags & NetworkConnection::kHelloFlagDatagram) != 0) {
+    do {
+      msg = get_msg();
+    } while (msg && msg->Is(Message::kKeepAlive));
+    if (!msg || !msg->Is(Message::kDatagramToken)) {
+      DEBUG0("client: server did not send datagram token");
+      return false;
+    }
+    conn.EnableDatagrams(datagram, msg->seq_num_uid(), true);
+    conn.set_datagram_peer(conn.info().remote_ip, msg->id());
+  }
+  if ((client_flags & NetworkConnection::kHelloFlagResume) != 0) {
+    do {
+      msg = get_msg();
+    } while (msg && msg->Is(Message::kKeepAlive));
+    if (!msg || !msg->Is(Message::kSessionToken)) {
+      DEBUG0("client: server did not send session token");
+      return false;
+    }
+    m_client_session_token = msg->seq_num_uid();
+  }
+
+  auto info = conn.info();
+  INFO("client: CONNECTED to server " << info.remote_ip << " port "
+                                      << info.remote_port);
   return true;
 }
 
@@ -627,10 +1076,13 @@ bool DispatcherBase::ServerHandshake(
     DEBUG0("server: client disconnected before sending hello");
     return false;
   }
-  if (!msg->Is(Message::kClientHello)) {
+  // A session resume is a client hello with the client's entry watermarks
+  bool resume = msg->Is(Message::kSessionResume);
+  if (!msg->Is(Message::kClientHello) && !resume) {
     DEBUG0("server: client initial message was not client hello");
     return false;
   }
+  auto hello = msg;
 
   // Check that the client requested version is not too high.
   unsigned int proto_rev = msg->id();
@@ -650,15 +1102,37 @@ bool DispatcherBase::ServerHandshake(
 
   // Send initial set of assignments
   NetworkConnection::Outgoing outgoing;
+  std::shared_ptr<DatagramChannel> datagram;
 
   // Start with server hello.  TODO: initial connection flag
   if (proto_rev >= 0x0300) {
+    unsigned int flags = NetworkConnection::kHelloFlagArrayDelta |
+                         NetworkConnection::kHelloFlagResume |
+                         NetworkConnection::kHelloFlagHistory;
+    if (conn.compression_enabled()) {
+      flags |= NetworkConnection::kHelloFlagCompression;
+    }
+    if (resume && hello->seq_num_uid() == m_server_session_token) {
+      flags |= NetworkConnection::kHelloFlagResumed;
+    } else {
+      resume = false;
+    }
     std::scoped_lock lock(m_user_mutex);
-    outgoing.emplace_back(Message::ServerHello(0u, m_identity));
+    datagram = m_datagram;
+    if (datagram) {
+      flags |= NetworkConnection::kHelloFlagDatagram;
+    }
+    outgoing.emplace_back(Message::ServerHello(flags, m_identity));
   }
 
-  // Get snapshot of initial assignments
-  m_storage.GetInitialAssignments(conn, &outgoing);
+  // Get snapshot of initial assignments; a resumed session only gets the
+  // entries that changed since the client's watermarks
+  if (resume) {
+    DEBUG0("server: resuming client session");
+    m_storage.GetResumeAssignments(conn, hello->watermarks(), &outgoing);
+  } else {
+    m_storage.GetInitialAssignments(conn, &outgoing);
+  }
 
   // Finish with server hello done
   outgoing.emplace_back(Message::ServerHelloDone());
@@ -674,6 +1148,8 @@ bool DispatcherBase::ServerHandshake(
   if (proto_rev >= 0x0300) {
     // receive client initial assignments
     std::vector<std::shared_ptr<Message>> incoming;
+    bool send_token = false;
+    bool client_datagram = false;
     msg = get_msg();
     for (;;) {
       if (!msg) {
@@ -689,6 +1165,22 @@ bool DispatcherBase::ServerHandshake(
         msg = get_msg();
         continue;
       }
+      if (msg->Is(Message::kClientFlags)) {
+        if ((msg->flags() & NetworkConnection::kHelloFlagArrayDelta) != 0) {
+          conn.set_array_deltas(true);
+        }
+        if ((msg->flags() & NetworkConnection::kHelloFlagHistory) != 0) {
+          conn.set_entry_history(true);
+        }
+        if ((msg->flags() & NetworkConnection::kHelloFlagResume) != 0) {
+          send_token = true;
+        }
+        if ((msg->flags() & NetworkConnection::kHelloFlagDatagram) != 0) {
+          client_datagram = true;
+        }
+        msg = get_msg();
+        continue;
+      }
       if (!msg->Is(Message::kEntryAssign)) {
         // unexpected message
         DEBUG0("server: received message ("
@@ -700,13 +1192,28 @@ bool DispatcherBase::ServerHandshake(
       // get the next message (blocks)
       msg = get_msg();
     }
+    // the client waits for its datagram and session tokens before going
+    // active
+    if (datagram && client_datagram) {
+      std::random_device rd;
+      unsigned int token;
+      do {
+        token = rd();
+      } while (token == 0);
+      conn.EnableDatagrams(datagram, token, false);
+      send_msgs(Message::DatagramToken(token, datagram->port()));
+    }
+    if (send_token) {
+      send_msgs(Message::SessionToken(m_server_session_token));
+    }
     for (auto& msg : incoming) {
       m_storage.ProcessIncoming(msg, &conn, std::weak_ptr<NetworkConnection>());
     }
   }
 
-  INFO("server: client CONNECTED: " << conn.stream().getPeerIP() << " port "
-                                    << conn.stream().getPeerPort());
+  auto info = conn.info();
+  INFO("server: client CONNECTED: " << info.remote_ip << " port "
+                                    << info.remote_port);
   return true;
 }
 
@@ -20,15 +20,21 @@
 
 #include "IDispatcher.h"
 #include "INetworkConnection.h"
+#include "PublishPolicyTable.h"
 
 namespace wpi {
+class EventLoopRunner;
 class Logger;
 class NetworkAcceptor;
 class NetworkStream;
+namespace uv {
+class Loop;
+}  // namespace uv
 }  // namespace wpi
 
 namespace nt {
 
+class DatagramChannel;
 class IConnectionNotifier;
 class IStorage;
 class NetworkConnection;
@@ -45,14 +51,31 @@ class DispatcherBase : public IDispatcher {
 
   unsigned int GetNetworkMode() const;
   void StartLocal();
+  // The optional local acceptor accepts additional connections from
+  // processes on the same host (e.g. a SharedMemoryAcceptor).
   void StartServer(const wpi::Twine& persist_filename,
-                   std::unique_ptr<wpi::NetworkAcceptor> acceptor);
+                   std::unique_ptr<wpi::NetworkAcceptor> acceptor,
+                   std::unique_ptr<wpi::NetworkAcceptor> local_acceptor = {});
+  void StartServerLoop(
+      const wpi::Twine& persist_filename, const wpi::Twine& listen_address,
+      unsigned int port,
+      std::unique_ptr<wpi::NetworkAcceptor> local_acceptor = {});
   void StartClient();
   void Stop();
   void SetUpdateRate(double interval);
+  void SetPublishPolicy(const wpi::Twine& prefix, const PublishPolicy& policy);
+  void ClearPublishPolicy(const wpi::Twine& prefix);
+  bool GetPublishPolicyStats(const wpi::Twine& prefix,
+                             PublishPolicyStats* stats) const;
   void SetIdentity(const wpi::Twine& name);
   void Flush();
+  void FlushSoon() override;
   std::vector<ConnectionInfo> GetConnections() const;
+  std::vector<ConnectionMetrics> GetConnectionMetrics() const;
+  void SetMetricsPublishing(bool enable) { m_publish_metrics = enable; }
+  void SetNetworkCompression(bool enable) { m_compression = enable; }
+  void SetNetworkSessionResume(bool enable) { m_session_resume = enable; }
+  void SetNetworkDatagrams(bool enable) { m_datagrams = enable; }
   bool IsConnected() const;
 
   unsigned int AddListener(
@@ -71,9 +94,21 @@ class DispatcherBase : public IDispatcher {
   DispatcherBase& operator=(const DispatcherBase&) = delete;
 
  private:
+  bool StartServerCommon(const wpi::Twine& persist_filename);
   void DispatchThreadMain();
+  void PublishMetrics();
   void ServerThreadMain();
+  void StartLocalAcceptor(std::unique_ptr<wpi::NetworkAcceptor> acceptor);
+  void LocalThreadMain();
+  void AddServerConnection(std::unique_ptr<wpi::NetworkStream> stream);
+  void AddServerConnection(std::shared_ptr<NetworkConnection> conn);
+  void InitConnection(const std::shared_ptr<NetworkConnection>& conn);
+  void ServerLoopListen(wpi::uv::Loop& loop, const std::string& listen_address,
+                        unsigned int port);
   void ClientThreadMain();
+  void StartDatagramChannel();
+  void ProcessDatagram(unsigned int token, wpi::StringRef data,
+                       wpi::StringRef ip, unsigned int port);
 
   bool ClientHandshake(
       NetworkConnection& conn,
@@ -88,6 +123,9 @@ class DispatcherBase : public IDispatcher {
 
   void QueueOutgoing(std::shared_ptr<Message> msg, INetworkConnection* only,
                      INetworkConnection* except) override;
+  void QueueOutgoingGroup(wpi::ArrayRef<std::shared_ptr<Message>> msgs,
+                          INetworkConnection* only,
+                          INetworkConnection* except) override;
 
   IStorage& m_storage;
   IConnectionNotifier& m_notifier;
@@ -95,11 +133,14 @@ class DispatcherBase : public IDispatcher {
   std::string m_persist_filename;
   std::thread m_dispatch_thread;
   std::thread m_clientserver_thread;
+  std::thread m_local_thread;
 
   std::unique_ptr<wpi::NetworkAcceptor> m_server_acceptor;
+  std::unique_ptr<wpi::NetworkAcceptor> m_local_acceptor;
+  std::unique_ptr<wpi::EventLoopRunner> m_server_loop;
   Connector m_client_connector_override;
   Connector m_client_connector;
-  uint8_t m_connections_uid = 0;
+  std::atomic<uint8_t> m_connections_uid{0};
 
   // Mutex for user-accessible items
   mutable wpi::mutex m_user_mutex;
@@ -108,6 +149,21 @@ class DispatcherBase : public IDispatcher {
 
   std::atomic_bool m_active;       // set to false to terminate threads
   std::atomic_uint m_update_rate;  // periodic dispatch update rate, in ms
+  PublishPolicyTable m_publish_policies;
+  std::atomic_bool m_publish_metrics{false};
+  // metrics tables currently published; only used by the dispatch thread
+  std::vector<std::string> m_metrics_published;
+  std::atomic_bool m_compression{false};
+
+  // Session resume.  The server token changes on each server start; the
+  // client token is the one received from the last server connected to.
+  std::atomic_bool m_session_resume{false};
+  std::atomic_uint m_server_session_token{0};
+  std::atomic_uint m_client_session_token{0};
+
+  // Datagram channel, if enabled (uses user mutex)
+  std::atomic_bool m_datagrams{false};
+  std::shared_ptr<DatagramChannel> m_datagram;
 
   // Condition variable for forced dispatch wakeup (flush)
   wpi::mutex m_flush_mutex;
@@ -132,9 +188,16 @@ class Dispatcher : public DispatcherBase {
              wpi::Logger& logger)
       : DispatcherBase(storage, notifier, logger) {}
 
+  // A listen address of "shm:<name>" listens on all addresses and also
+  // accepts same-host clients over shared memory with the given name.
   void StartServer(const wpi::Twine& persist_filename,
                    const char* listen_address, unsigned int port);
 
+  // Select the event loop server implementation for subsequent StartServer()
+  void SetServerEventLoop(bool enable) { m_server_event_loop = enable; }
+
+  // A server name of "shm:<name>" connects over shared memory instead of
+  // TCP; the port is ignored.
   void SetServer(const char* server_name, unsigned int port);
   void SetServer(
       wpi::ArrayRef<std::pair<wpi::StringRef, unsigned int>> servers);
@@ -142,6 +205,9 @@ class Dispatcher : public DispatcherBase {
 
   void SetServerOverride(const char* server_name, unsigned int port);
   void ClearServerOverride();
+
+ private:
+  std::atomic_bool m_server_event_loop{false};
 };
 
 }  // namespace nt
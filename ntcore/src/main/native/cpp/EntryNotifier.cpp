@@ -4,6 +4,8 @@
 
 #include "EntryNotifier.h"
 
+#include <algorithm>
+
 #include "Log.h"
 
 using namespace nt;
@@ -30,9 +32,13 @@ bool impl::EntryNotifierThread::Matches(const EntryListenerData& listener,
   // Flags must be within requested flag set for this listener.
   // Because assign messages can result in both a value and flags update,
   // we handle that case specially.
+  // History batches are updates to every listener; the flag only selects
+  // whether the batch is passed on (see SetListener()).
   unsigned int listen_flags =
-      listener.flags & ~(NT_NOTIFY_IMMEDIATE | NT_NOTIFY_LOCAL);
-  unsigned int flags = data.flags & ~(NT_NOTIFY_IMMEDIATE | NT_NOTIFY_LOCAL);
+      listener.flags &
+      ~(NT_NOTIFY_IMMEDIATE | NT_NOTIFY_LOCAL | NT_NOTIFY_HISTORY);
+  unsigned int flags =
+      data.flags & ~(NT_NOTIFY_IMMEDIATE | NT_NOTIFY_LOCAL | NT_NOTIFY_HISTORY);
   unsigned int assign_both = NT_NOTIFY_UPDATE | NT_NOTIFY_FLAGS;
   if ((flags & assign_both) == assign_both) {
     if ((listen_flags & assign_both) == 0) {
@@ -57,6 +63,194 @@ bool impl::EntryNotifierThread::Matches(const EntryListenerData& listener,
   return true;
 }
 
+void impl::EntryNotifierThread::SetListener(EntryNotification* data,
+                                            unsigned int listener_uid) {
+  data->listener =
+      Handle(m_inst, listener_uid, Handle::kEntryListener).handle();
+  // the batch stays with the notification for the listeners after this one
+  if (!data->history.empty()) {
+    if ((m_listeners[listener_uid].flags & NT_NOTIFY_HISTORY) != 0) {
+      data->flags |= NT_NOTIFY_HISTORY;
+    } else {
+      data->flags &= ~NT_NOTIFY_HISTORY;
+    }
+  }
+}
+
+void impl::EntryNotifierThread::Coalesce(EntryNotification* queued,
+                                         EntryNotification&& data) {
+  // keep every value of merged batches
+  if ((queued->flags & NT_NOTIFY_HISTORY) != 0) {
+    auto history = std::move(queued->history);
+    if ((data.flags & NT_NOTIFY_HISTORY) != 0) {
+      history.insert(history.end(), data.history.begin(), data.history.end());
+    } else if ((data.flags & NT_NOTIFY_UPDATE) != 0 && data.value) {
+      history.emplace_back(data.value);
+    }
+    data.history = std::move(history);
+  }
+  data.flags |= queued->flags;
+  *queued = std::move(data);
+}
+
+void impl::EntryNotifierThread::ListenerAdded(unsigned int listener_uid) {
+  if (listener_uid >= m_listeners.size() || !m_listeners[listener_uid]) {
+    return;
+  }
+  auto& listener = m_listeners[listener_uid];
+  if (listener.entry != 0) {
+    unsigned int index = Handle{listener.entry}.GetIndex();
+    if (index >= m_entry_listeners.size()) {
+      m_entry_listeners.resize(index + 1);
+    }
+    m_entry_listeners[index].push_back(listener_uid);
+  } else {
+    AddPrefix(&m_prefix_root, listener.prefix, listener_uid);
+  }
+}
+
+void impl::EntryNotifierThread::ListenerRemoved(unsigned int listener_uid) {
+  if (listener_uid >= m_listeners.size() || !m_listeners[listener_uid]) {
+    return;
+  }
+  auto& listener = m_listeners[listener_uid];
+  if (listener.entry != 0) {
+    unsigned int index = Handle{listener.entry}.GetIndex();
+    if (index < m_entry_listeners.size()) {
+      auto& uids = m_entry_listeners[index];
+      uids.erase(std::remove(uids.begin(), uids.end(), listener_uid),
+                 uids.end());
+    }
+  } else {
+    RemovePrefix(&m_prefix_root, listener.prefix, listener_uid);
+  }
+}
+
+bool impl::EntryNotifierThread::GetCandidates(
+    const EntryNotification& data, std::vector<unsigned int>* listener_uids) {
+  listener_uids->clear();
+
+  // listeners on this specific entry
+  Handle handle{data.entry};
+  if (handle.IsType(Handle::kEntry)) {
+    unsigned int index = handle.GetIndex();
+    if (index < m_entry_listeners.size()) {
+      auto& uids = m_entry_listeners[index];
+      listener_uids->insert(listener_uids->end(), uids.begin(), uids.end());
+    }
+  }
+
+  // listeners on every prefix of the name; walk down the trie as long as the
+  // remaining part of the name starts with the child's label
+  wpi::StringRef name = data.name;
+  const PrefixNode* node = &m_prefix_root;
+  while (node) {
+    listener_uids->insert(listener_uids->end(), node->listeners.begin(),
+                          node->listeners.end());
+    const PrefixNode* next = nullptr;
+    for (auto& child : node->children) {
+      if (name.startswith(child->label)) {
+        name = name.substr(child->label.size());
+        next = child.get();
+        break;
+      }
+    }
+    node = next;
+  }
+
+  // keep listener order consistent with an unindexed scan
+  std::sort(listener_uids->begin(), listener_uids->end());
+  return true;
+}
+
+void impl::EntryNotifierThread::AddPrefix(PrefixNode* node,
+                                          wpi::StringRef prefix,
+                                          unsigned int listener_uid) {
+  for (;;) {
+    if (prefix.empty()) {
+      node->listeners.push_back(listener_uid);
+      return;
+    }
+
+    // children labels never share a first character
+    PrefixNode* child = nullptr;
+    for (auto& c : node->children) {
+      if (c->label[0] == prefix[0]) {
+        child = c.get();
+        break;
+      }
+    }
+    if (!child) {
+      auto leaf = std::make_unique<PrefixNode>();
+      leaf->label = prefix;
+      leaf->listeners.push_back(listener_uid);
+      node->children.emplace_back(std::move(leaf));
+      return;
+    }
+
+    // length of common part of label and prefix
+    size_t common = 1;
+    size_t maxlen = (std::min)(child->label.size(), prefix.size());
+    while (common < maxlen && child->label[common] == prefix[common]) {
+      ++common;
+    }
+
+    // split the edge if the prefix diverges (or ends) partway through it
+    if (common < child->label.size()) {
+      auto split = std::make_unique<PrefixNode>();
+      split->label = child->label.substr(0, common);
+      auto& slot = *std::find_if(
+          node->children.begin(), node->children.end(),
+          [&](const std::unique_ptr<PrefixNode>& c) { return c.get() == child; });
+      slot->label.erase(0, common);
+      split->children.emplace_back(std::move(slot));
+      slot = std::move(split);
+      child = slot.get();
+    }
+
+    node = child;
+    prefix = prefix.substr(common);
+  }
+}
+
+bool impl::EntryNotifierThread::RemovePrefix(PrefixNode* node,
+                                             wpi::StringRef prefix,
+                                             unsigned int listener_uid) {
+  if (prefix.empty()) {
+    auto it = std::find(node->listeners.begin(), node->listeners.end(),
+                        listener_uid);
+    if (it == node->listeners.end()) {
+      return false;
+    }
+    node->listeners.erase(it);
+    return true;
+  }
+
+  auto it = std::find_if(node->children.begin(), node->children.end(),
+                         [&](const std::unique_ptr<PrefixNode>& c) {
+                           return prefix.startswith(c->label);
+                         });
+  if (it == node->children.end()) {
+    return false;
+  }
+  PrefixNode* child = it->get();
+  if (!RemovePrefix(child, prefix.substr(child->label.size()), listener_uid)) {
+    return false;
+  }
+
+  // prune the child if it is now empty, or merge it with its only child
+  if (child->listeners.empty()) {
+    if (child->children.empty()) {
+      node->children.erase(it);
+    } else if (child->children.size() == 1) {
+      auto grandchild = std::move(child->children[0]);
+      grandchild->label.insert(0, child->label);
+      *it = std::move(grandchild);
+    }
+  }
+  return true;
+}
+
 unsigned int EntryNotifier::Add(
     std::function<void(const EntryNotification& event)> callback,
     wpi::StringRef prefix, unsigned int flags) {
@@ -107,3 +301,13 @@ void EntryNotifier::NotifyEntry(unsigned int local_id, wpi::StringRef name,
   Send(only_listener, 0, Handle(m_inst, local_id, Handle::kEntry).handle(),
        name, value, flags);
 }
+
+void EntryNotifier::NotifyHistory(unsigned int local_id, wpi::StringRef name,
+                                  std::vector<std::shared_ptr<Value>> values) {
+  DEBUG0("notifying '" << name << "' (local=" << local_id << "), "
+                       << values.size() << " values");
+  auto value = values.back();
+  Send(UINT_MAX, 0, Handle(m_inst, local_id, Handle::kEntry).handle(), name,
+       std::move(value), NT_NOTIFY_UPDATE | NT_NOTIFY_HISTORY,
+       std::move(values));
+}
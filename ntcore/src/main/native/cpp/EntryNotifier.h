@@ -5,9 +5,13 @@
 #ifndef NTCORE_ENTRYNOTIFIER_H_
 #define NTCORE_ENTRYNOTIFIER_H_
 
+#include <stdint.h>
+
 #include <atomic>
 #include <memory>
 #include <string>
+#include <utility>
+#include <vector>
 
 #include <wpi/CallbackManager.h>
 
@@ -56,17 +60,48 @@ class EntryNotifierThread
   bool Matches(const EntryListenerData& listener,
                const EntryNotification& data);
 
-  void SetListener(EntryNotification* data, unsigned int listener_uid) {
-    data->listener =
-        Handle(m_inst, listener_uid, Handle::kEntryListener).handle();
-  }
+  void SetListener(EntryNotification* data, unsigned int listener_uid);
 
   void DoCallback(std::function<void(const EntryNotification& event)> callback,
                   const EntryNotification& data) {
     callback(data);
   }
 
+  // Listener index maintenance; called with m_mutex held.
+  void ListenerAdded(unsigned int listener_uid);
+  void ListenerRemoved(unsigned int listener_uid);
+  bool GetCandidates(const EntryNotification& data,
+                     std::vector<unsigned int>* listener_uids);
+
+  // Bounded pollers merge notifications by listener and entry
+  bool GetCoalesceKey(const EntryNotification& data, uint64_t* key) {
+    *key = (static_cast<uint64_t>(data.listener) << 32) | data.entry;
+    return true;
+  }
+  void Coalesce(EntryNotification* queued, EntryNotification&& data);
+
   int m_inst;
+
+ private:
+  /* Radix trie node for prefix listeners.  The label is the part of the
+   * prefix between the parent node and this node; listeners whose prefix
+   * ends exactly at this node are stored in it.
+   */
+  struct PrefixNode {
+    std::string label;
+    std::vector<unsigned int> listeners;
+    std::vector<std::unique_ptr<PrefixNode>> children;
+  };
+
+  void AddPrefix(PrefixNode* node, wpi::StringRef prefix,
+                 unsigned int listener_uid);
+  bool RemovePrefix(PrefixNode* node, wpi::StringRef prefix,
+                    unsigned int listener_uid);
+
+  // Listeners on a specific entry, indexed by entry handle index
+  std::vector<std::vector<unsigned int>> m_entry_listeners;
+  // Listeners on a prefix
+  PrefixNode m_prefix_root;
 };
 
 }  // namespace impl
@@ -96,6 +131,8 @@ class EntryNotifier
   void NotifyEntry(unsigned int local_id, wpi::StringRef name,
                    std::shared_ptr<Value> value, unsigned int flags,
                    unsigned int only_listener = UINT_MAX) override;
+  void NotifyHistory(unsigned int local_id, wpi::StringRef name,
+                     std::vector<std::shared_ptr<Value>> values) override;
 
  private:
   int m_inst;
@@ -7,6 +7,8 @@
 
 #include <memory>
 
+#include <wpi/ArrayRef.h>
+
 #include "Message.h"
 
 namespace nt {
@@ -24,6 +26,21 @@ class IDispatcher {
   virtual void QueueOutgoing(std::shared_ptr<Message> msg,
                              INetworkConnection* only,
                              INetworkConnection* except) = 0;
+
+  // Sends queued messages without waiting for the next periodic update.
+  // Unlike a user flush this is not rate limited; calls made before the
+  // dispatch thread wakes up go out together.
+  virtual void FlushSoon() {}
+
+  // Queues a group of messages that must go out in the same flush.  The
+  // default implementation just queues them one at a time.
+  virtual void QueueOutgoingGroup(wpi::ArrayRef<std::shared_ptr<Message>> msgs,
+                                  INetworkConnection* only,
+                                  INetworkConnection* except) {
+    for (auto& msg : msgs) {
+      QueueOutgoing(msg, only, except);
+    }
+  }
 };
 
 }  // namespace nt
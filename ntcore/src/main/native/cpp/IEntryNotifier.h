@@ -7,6 +7,7 @@
 
 #include <climits>
 #include <memory>
+#include <vector>
 
 #include "ntcore_cpp.h"
 
@@ -34,6 +35,10 @@ class IEntryNotifier {
   virtual void NotifyEntry(unsigned int local_id, wpi::StringRef name,
                            std::shared_ptr<Value> value, unsigned int flags,
                            unsigned int only_listener = UINT_MAX) = 0;
+  // Notify of a batch of values received for an NT_HISTORY entry, oldest
+  // first.
+  virtual void NotifyHistory(unsigned int local_id, wpi::StringRef name,
+                             std::vector<std::shared_ptr<Value>> values) = 0;
 };
 
 }  // namespace nt
@@ -7,6 +7,8 @@
 
 #include <memory>
 
+#include <wpi/StringRef.h>
+
 #include "Message.h"
 #include "ntcore_cpp.h"
 
@@ -23,6 +25,13 @@ class INetworkConnection {
 
   virtual ConnectionInfo info() const = 0;
 
+  // Traffic counters; connections without any just report info().
+  virtual ConnectionMetrics metrics() const {
+    ConnectionMetrics m;
+    m.info = info();
+    return m;
+  }
+
   virtual void QueueOutgoing(std::shared_ptr<Message> msg) = 0;
   virtual void PostOutgoing(bool keep_alive) = 0;
 
@@ -31,6 +40,14 @@ class INetworkConnection {
 
   virtual State state() const = 0;
   virtual void set_state(State state) = 0;
+
+  // Remember the name and flags of an assigned entry, which decide how
+  // outgoing updates to it are queued.  Storage calls this for every
+  // assigned entry (with its lock held) when it synchronizes the
+  // connection; after that the connection follows the assignments, flags
+  // updates and deletes that it sends and receives.
+  virtual void SetEntryInfo(unsigned int /*id*/, wpi::StringRef /*name*/,
+                            unsigned int /*flags*/) {}
 };
 
 }  // namespace nt
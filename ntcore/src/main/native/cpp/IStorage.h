@@ -7,6 +7,7 @@
 
 #include <functional>
 #include <memory>
+#include <string>
 #include <vector>
 
 #include <wpi/ArrayRef.h>
@@ -38,6 +39,11 @@ class IStorage {
   // message itself).  Not used in wire protocol 3.0.
   virtual NT_Type GetMessageEntryType(unsigned int id) const = 0;
 
+  // Used to publish connection metrics.
+  virtual bool SetEntryValue(wpi::StringRef name,
+                             std::shared_ptr<Value> value) = 0;
+  virtual void DeleteEntry(wpi::StringRef name) = 0;
+
   virtual void ProcessIncoming(std::shared_ptr<Message> msg,
                                INetworkConnection* conn,
                                std::weak_ptr<INetworkConnection> conn_weak) = 0;
@@ -48,6 +54,24 @@ class IStorage {
       INetworkConnection& conn, wpi::ArrayRef<std::shared_ptr<Message>> msgs,
       bool new_server, std::vector<std::shared_ptr<Message>>* out_msgs) = 0;
 
+  // Session resume.  The client sends watermarks for the entries it holds;
+  // the server replies with assignments for entries that changed since and
+  // deletes for entries that no longer exist, which the client applies.
+  virtual void GetResumeWatermarks(
+      std::vector<Message::EntryWatermark>* watermarks) const = 0;
+  virtual void GetResumeAssignments(
+      INetworkConnection& conn,
+      wpi::ArrayRef<Message::EntryWatermark> watermarks,
+      std::vector<std::shared_ptr<Message>>* msgs) = 0;
+  virtual void ApplyResumeAssignments(
+      INetworkConnection& conn, wpi::ArrayRef<std::shared_ptr<Message>> msgs,
+      std::vector<std::shared_ptr<Message>>* out_msgs) = 0;
+
+  // Called on the client when its connection to the server closes.  Async
+  // RPC calls still waiting for a response get an empty result, as the
+  // response can no longer arrive.
+  virtual void CancelRpcCalls() = 0;
+
   // Filename-based save/load functions.  Used both by periodic saves and
   // accessible directly via the user API.
   virtual const char* SavePersistent(const wpi::Twine& filename,
@@ -6,7 +6,13 @@
 
 #include <stdint.h>
 
+#include <string>
+#include <utility>
+
+#include <wpi/timestamp.h>
+
 #include "Log.h"
+#include "PoolAllocator.h"
 #include "WireDecoder.h"
 #include "WireEncoder.h"
 
@@ -14,14 +20,18 @@
 
 using namespace nt;
 
-std::shared_ptr<Message> Message::Read(WireDecoder& decoder,
-                                       GetEntryTypeFunc get_entry_type) {
+std::shared_ptr<Message> Message::Create(MsgType type) {
+  return std::allocate_shared<Message>(PoolAllocator<Message>(), type,
+                                       private_init());
+}
+
+std::shared_ptr<Message> Message::Read(
+    WireDecoder& decoder, const GetEntryTypeFunc& get_entry_type) {
   unsigned int msg_type = 0;
   if (!decoder.Read8(&msg_type)) {
     return nullptr;
   }
-  auto msg =
-      std::make_shared<Message>(static_cast<MsgType>(msg_type), private_init());
+  auto msg = Create(static_cast<MsgType>(msg_type));
   switch (msg_type) {
     case kKeepAlive:
       break;
@@ -66,6 +76,61 @@ std::shared_ptr<Message> Message::Read(WireDecoder& decoder,
         return nullptr;
       }
       break;
+    case kClientFlags:
+      if (decoder.proto_rev() < 0x0300u) {
+        decoder.set_error("received CLIENT_FLAGS in protocol < 3.0");
+        return nullptr;
+      }
+      if (!decoder.Read8(&msg->m_flags)) {
+        return nullptr;
+      }
+      break;
+    case kSessionResume: {
+      if (!decoder.Read16(&msg->m_id)) {
+        return nullptr;  // proto rev
+      }
+      if (msg->m_id < 0x0300u) {
+        decoder.set_error("received SESSION_RESUME in protocol < 3.0");
+        return nullptr;
+      }
+      uint32_t token;
+      std::string watermarks;
+      if (!decoder.ReadString(&msg->m_str) || !decoder.Read32(&token) ||
+          !decoder.ReadString(&watermarks)) {
+        return nullptr;
+      }
+      if (watermarks.size() % 5 != 0) {
+        decoder.set_error("bad SESSION_RESUME watermarks length");
+        return nullptr;
+      }
+      msg->m_seq_num_uid = token;
+      msg->m_value = Value::MakeRaw(std::move(watermarks));
+      break;
+    }
+    case kSessionToken: {
+      if (decoder.proto_rev() < 0x0300u) {
+        decoder.set_error("received SESSION_TOKEN in protocol < 3.0");
+        return nullptr;
+      }
+      uint32_t token;
+      if (!decoder.Read32(&token)) {
+        return nullptr;
+      }
+      msg->m_seq_num_uid = token;
+      break;
+    }
+    case kDatagramToken: {
+      if (decoder.proto_rev() < 0x0300u) {
+        decoder.set_error("received DATAGRAM_TOKEN in protocol < 3.0");
+        return nullptr;
+      }
+      uint32_t token;
+      if (!decoder.Read32(&token) || !decoder.Read16(&msg->m_id)) {
+        return nullptr;
+      }
+      msg->m_seq_num_uid = token;
+      break;
+    }
     case kEntryAssign: {
       if (!decoder.ReadString(&msg->m_str)) {
         return nullptr;  // name
@@ -89,6 +154,7 @@ std::shared_ptr<Message> Message::Read(WireDecoder& decoder,
       if (!msg->m_value) {
         return nullptr;
       }
+      decoder.SetArrayBase(msg->m_id, msg->m_value);
       break;
     }
     case kEntryUpdate: {
@@ -111,6 +177,69 @@ std::shared_ptr<Message> Message::Read(WireDecoder& decoder,
       if (!msg->m_value) {
         return nullptr;
       }
+      decoder.SetArrayBase(msg->m_id, msg->m_value);
+      break;
+    }
+    case kEntryArrayDelta: {
+      if (decoder.proto_rev() < 0x0300u) {
+        decoder.set_error("received ENTRY_ARRAY_DELTA in protocol < 3.0");
+        return nullptr;
+      }
+      if (!decoder.Read16(&msg->m_id)) {
+        return nullptr;  // id
+      }
+      if (!decoder.Read16(&msg->m_seq_num_uid)) {
+        return nullptr;  // seq num
+      }
+      NT_Type type;
+      if (!decoder.ReadType(&type)) {
+        return nullptr;
+      }
+      msg->m_value = decoder.ReadArrayDelta(msg->m_id, type);
+      if (!msg->m_value) {
+        return nullptr;
+      }
+      // the rest of the system only sees the full value
+      msg->m_type = kEntryUpdate;
+      break;
+    }
+    case kEntryHistory: {
+      if (decoder.proto_rev() < 0x0300u) {
+        decoder.set_error("received ENTRY_HISTORY in protocol < 3.0");
+        return nullptr;
+      }
+      if (!decoder.Read16(&msg->m_id)) {
+        return nullptr;  // id
+      }
+      uint64_t count;
+      if (!decoder.ReadUleb128(&count)) {
+        return nullptr;
+      }
+      if (count == 0 || count > 0xffff) {
+        decoder.set_error("bad ENTRY_HISTORY count");
+        return nullptr;
+      }
+      // ages are relative to the last update, which is taken to be now
+      uint64_t now = wpi::Now();
+      msg->m_history.reserve(count);
+      for (uint64_t i = 0; i < count; ++i) {
+        unsigned int seq_num;
+        uint64_t age;
+        NT_Type type;
+        if (!decoder.Read16(&seq_num) || !decoder.ReadUleb128(&age) ||
+            !decoder.ReadType(&type)) {
+          return nullptr;
+        }
+        auto value = decoder.ReadValue(type, age < now ? now - age : 1);
+        if (!value) {
+          return nullptr;
+        }
+        msg->m_history.emplace_back(
+            EntryUpdate(msg->m_id, seq_num, std::move(value)));
+      }
+      msg->m_seq_num_uid = msg->m_history.back()->m_seq_num_uid;
+      msg->m_value = msg->m_history.back()->m_value;
+      decoder.SetArrayBase(msg->m_id, msg->m_value);
       break;
     }
     case kFlagsUpdate: {
@@ -134,6 +263,7 @@ std::shared_ptr<Message> Message::Read(WireDecoder& decoder,
       if (!decoder.Read16(&msg->m_id)) {
         return nullptr;
       }
+      decoder.SetArrayBase(msg->m_id, nullptr);
       break;
     }
     case kClearEntries: {
@@ -150,6 +280,7 @@ std::shared_ptr<Message> Message::Read(WireDecoder& decoder,
             "received incorrect CLEAR_ENTRIES magic value, ignoring");
         return nullptr;
       }
+      decoder.ClearArrayBases();
       break;
     }
     case kExecuteRpc: {
@@ -205,25 +336,81 @@ std::shared_ptr<Message> Message::Read(WireDecoder& decoder,
 }
 
 std::shared_ptr<Message> Message::ClientHello(wpi::StringRef self_id) {
-  auto msg = std::make_shared<Message>(kClientHello, private_init());
+  auto msg = Create(kClientHello);
   msg->m_str = self_id;
   return msg;
 }
 
 std::shared_ptr<Message> Message::ServerHello(unsigned int flags,
                                               wpi::StringRef self_id) {
-  auto msg = std::make_shared<Message>(kServerHello, private_init());
+  auto msg = Create(kServerHello);
   msg->m_str = self_id;
   msg->m_flags = flags;
   return msg;
 }
 
+std::shared_ptr<Message> Message::ClientFlags(unsigned int flags) {
+  auto msg = Create(kClientFlags);
+  msg->m_flags = flags;
+  return msg;
+}
+
+std::shared_ptr<Message> Message::SessionResume(
+    wpi::StringRef self_id, unsigned int token,
+    wpi::ArrayRef<EntryWatermark> watermarks) {
+  auto msg = Create(kSessionResume);
+  msg->m_str = self_id;
+  msg->m_seq_num_uid = token;
+  // packed as 16-bit id, 16-bit sequence number, and 8-bit flags
+  std::string packed;
+  packed.reserve(watermarks.size() * 5);
+  for (auto&& mark : watermarks) {
+    packed.push_back(static_cast<char>((mark.id >> 8) & 0xff));
+    packed.push_back(static_cast<char>(mark.id & 0xff));
+    packed.push_back(static_cast<char>((mark.seq_num >> 8) & 0xff));
+    packed.push_back(static_cast<char>(mark.seq_num & 0xff));
+    packed.push_back(static_cast<char>(mark.flags & 0xff));
+  }
+  msg->m_value = Value::MakeRaw(std::move(packed));
+  return msg;
+}
+
+std::shared_ptr<Message> Message::SessionToken(unsigned int token) {
+  auto msg = Create(kSessionToken);
+  msg->m_seq_num_uid = token;
+  return msg;
+}
+
+std::shared_ptr<Message> Message::DatagramToken(unsigned int token,
+                                                unsigned int port) {
+  auto msg = Create(kDatagramToken);
+  msg->m_seq_num_uid = token;
+  msg->m_id = port;
+  return msg;
+}
+
+std::vector<Message::EntryWatermark> Message::watermarks() const {
+  std::vector<EntryWatermark> marks;
+  if (!m_value || !m_value->IsRaw()) {
+    return marks;
+  }
+  const unsigned char* packed = m_value->GetRaw().bytes_begin();
+  size_t count = m_value->GetRaw().size() / 5;
+  marks.reserve(count);
+  for (size_t i = 0; i < count; ++i, packed += 5) {
+    unsigned int id = (packed[0] << 8u) | packed[1];
+    unsigned int seq_num = (packed[2] << 8u) | packed[3];
+    marks.push_back({id, seq_num, packed[4]});
+  }
+  return marks;
+}
+
 std::shared_ptr<Message> Message::EntryAssign(wpi::StringRef name,
                                               unsigned int id,
                                               unsigned int seq_num,
                                               std::shared_ptr<Value> value,
                                               unsigned int flags) {
-  auto msg = std::make_shared<Message>(kEntryAssign, private_init());
+  auto msg = Create(kEntryAssign);
   msg->m_str = name;
   msg->m_value = value;
   msg->m_id = id;
@@ -235,30 +422,40 @@ std::shared_ptr<Message> Message::EntryAssign(wpi::StringRef name,
 std::shared_ptr<Message> Message::EntryUpdate(unsigned int id,
                                               unsigned int seq_num,
                                               std::shared_ptr<Value> value) {
-  auto msg = std::make_shared<Message>(kEntryUpdate, private_init());
+  auto msg = Create(kEntryUpdate);
   msg->m_value = value;
   msg->m_id = id;
   msg->m_seq_num_uid = seq_num;
   return msg;
 }
 
+std::shared_ptr<Message> Message::EntryHistory(
+    std::vector<std::shared_ptr<Message>> updates) {
+  auto msg = Create(kEntryHistory);
+  msg->m_id = updates.back()->m_id;
+  msg->m_seq_num_uid = updates.back()->m_seq_num_uid;
+  msg->m_value = updates.back()->m_value;
+  msg->m_history = std::move(updates);
+  return msg;
+}
+
 std::shared_ptr<Message> Message::FlagsUpdate(unsigned int id,
                                               unsigned int flags) {
-  auto msg = std::make_shared<Message>(kFlagsUpdate, private_init());
+  auto msg = Create(kFlagsUpdate);
   msg->m_id = id;
   msg->m_flags = flags;
   return msg;
 }
 
 std::shared_ptr<Message> Message::EntryDelete(unsigned int id) {
-  auto msg = std::make_shared<Message>(kEntryDelete, private_init());
+  auto msg = Create(kEntryDelete);
   msg->m_id = id;
   return msg;
 }
 
 std::shared_ptr<Message> Message::ExecuteRpc(unsigned int id, unsigned int uid,
                                              wpi::StringRef params) {
-  auto msg = std::make_shared<Message>(kExecuteRpc, private_init());
+  auto msg = Create(kExecuteRpc);
   msg->m_str = params;
   msg->m_id = id;
   msg->m_seq_num_uid = uid;
@@ -267,7 +464,7 @@ std::shared_ptr<Message> Message::ExecuteRpc(unsigned int id, unsigned int uid,
 
 std::shared_ptr<Message> Message::RpcResponse(unsigned int id, unsigned int uid,
                                               wpi::StringRef result) {
-  auto msg = std::make_shared<Message>(kRpcResponse, private_init());
+  auto msg = Create(kRpcResponse);
   msg->m_str = result;
   msg->m_id = id;
   msg->m_seq_num_uid = uid;
@@ -308,6 +505,38 @@ void Message::Write(WireEncoder& encoder) const {
       }
       encoder.Write8(kClientHelloDone);
       break;
+    case kClientFlags:
+      if (encoder.proto_rev() < 0x0300u) {
+        return;  // extension of version 3.0
+      }
+      encoder.Write8(kClientFlags);
+      encoder.Write8(m_flags);
+      break;
+    case kSessionResume:
+      if (encoder.proto_rev() < 0x0300u) {
+        return;  // extension of version 3.0
+      }
+      encoder.Write8(kSessionResume);
+      encoder.Write16(encoder.proto_rev());
+      encoder.WriteString(m_str);
+      encoder.Write32(m_seq_num_uid);
+      encoder.WriteString(m_value->GetRaw());
+      break;
+    case kSessionToken:
+      if (encoder.proto_rev() < 0x0300u) {
+        return;  // extension of version 3.0
+      }
+      encoder.Write8(kSessionToken);
+      encoder.Write32(m_seq_num_uid);
+      break;
+    case kDatagramToken:
+      if (encoder.proto_rev() < 0x0300u) {
+        return;  // extension of version 3.0
+      }
+      encoder.Write8(kDatagramToken);
+      encoder.Write32(m_seq_num_uid);
+      encoder.Write16(m_id);
+      break;
     case kEntryAssign:
       encoder.Write8(kEntryAssign);
       encoder.WriteString(m_str);
@@ -318,8 +547,21 @@ void Message::Write(WireEncoder& encoder) const {
         encoder.Write8(m_flags);
       }
       encoder.WriteValue(*m_value);
+      encoder.SetArrayBase(m_id, m_value);
       break;
     case kEntryUpdate:
+      // send only the changed array elements if that is smaller
+      if (auto base = encoder.SetArrayBase(m_id, m_value)) {
+        size_t delta_size = encoder.GetArrayDeltaSize(*base, *m_value);
+        if (delta_size != 0 && delta_size < encoder.GetValueSize(*m_value)) {
+          encoder.Write8(kEntryArrayDelta);
+          encoder.Write16(m_id);
+          encoder.Write16(m_seq_num_uid);
+          encoder.WriteType(m_value->type());
+          encoder.WriteArrayDelta(*base, *m_value);
+          break;
+        }
+      }
       encoder.Write8(kEntryUpdate);
       encoder.Write16(m_id);
       encoder.Write16(m_seq_num_uid);
@@ -328,6 +570,29 @@ void Message::Write(WireEncoder& encoder) const {
       }
       encoder.WriteValue(*m_value);
       break;
+    case kEntryHistory: {
+      if (!encoder.entry_history()) {
+        // peer doesn't accept batches; send the updates one by one
+        for (auto&& update : m_history) {
+          update->Write(encoder);
+        }
+        break;
+      }
+      encoder.Write8(kEntryHistory);
+      encoder.Write16(m_id);
+      encoder.WriteUleb128(m_history.size());
+      uint64_t last = m_value->time();
+      for (auto&& update : m_history) {
+        uint64_t time = update->m_value->time();
+        uint64_t age = time < last ? last - time : 0;
+        encoder.Write16(update->m_seq_num_uid);
+        encoder.WriteUleb128(age < UINT32_MAX ? age : UINT32_MAX);
+        encoder.WriteType(update->m_value->type());
+        encoder.WriteValue(*update->m_value);
+      }
+      encoder.SetArrayBase(m_id, m_value);
+      break;
+    }
     case kFlagsUpdate:
       if (encoder.proto_rev() < 0x0300u) {
         return;  // new message in version 3.0
@@ -342,6 +607,7 @@ void Message::Write(WireEncoder& encoder) const {
       }
       encoder.Write8(kEntryDelete);
       encoder.Write16(m_id);
+      encoder.SetArrayBase(m_id, nullptr);
       break;
     case kClearEntries:
       if (encoder.proto_rev() < 0x0300u) {
@@ -349,6 +615,7 @@ void Message::Write(WireEncoder& encoder) const {
       }
       encoder.Write8(kClearEntries);
       encoder.Write32(kClearAllMagic);
+      encoder.ClearArrayBases();
       break;
     case kExecuteRpc:
       if (encoder.proto_rev() < 0x0300u) {
@@ -8,6 +8,9 @@
 #include <functional>
 #include <memory>
 #include <string>
+#include <vector>
+
+#include <wpi/ArrayRef.h>
 
 #include "networktables/NetworkTableValue.h"
 
@@ -28,16 +31,30 @@ class Message {
     kServerHelloDone = 0x03,
     kServerHello = 0x04,
     kClientHelloDone = 0x05,
+    kClientFlags = 0x06,    // extension: reply to server hello flags
+    kSessionResume = 0x07,  // extension: client hello resuming a session
+    kSessionToken = 0x08,   // extension: token for a later session resume
+    kDatagramToken = 0x09,  // extension: token and port of datagram channel
     kEntryAssign = 0x10,
     kEntryUpdate = 0x11,
     kFlagsUpdate = 0x12,
     kEntryDelete = 0x13,
     kClearEntries = 0x14,
+    kEntryArrayDelta = 0x15,  // extension: decoded as kEntryUpdate
+    kEntryHistory = 0x16,     // extension: batch of updates to one entry
     kExecuteRpc = 0x20,
     kRpcResponse = 0x21
   };
   typedef std::function<NT_Type(unsigned int id)> GetEntryTypeFunc;
 
+  // Sequence number and flags of an entry held by a client resuming a
+  // session; the server only sends entries that no longer match.
+  struct EntryWatermark {
+    unsigned int id;
+    unsigned int seq_num;
+    unsigned int flags;
+  };
+
   Message() = default;
   Message(MsgType type, const private_init&) : m_type(type) {}
 
@@ -52,32 +69,51 @@ class Message {
   unsigned int flags() const { return m_flags; }
   unsigned int seq_num_uid() const { return m_seq_num_uid; }
 
+  // The kEntryUpdate messages batched in a kEntryHistory message, oldest
+  // first.  The id, sequence number and value of a kEntryHistory message are
+  // those of the last one.
+  wpi::ArrayRef<std::shared_ptr<Message>> history() const {
+    return m_history;
+  }
+
+  // Decodes the entry watermarks of a kSessionResume message.
+  std::vector<EntryWatermark> watermarks() const;
+
   // Read and write from wire representation
   void Write(WireEncoder& encoder) const;
-  static std::shared_ptr<Message> Read(WireDecoder& decoder,
-                                       GetEntryTypeFunc get_entry_type);
+  static std::shared_ptr<Message> Read(
+      WireDecoder& decoder, const GetEntryTypeFunc& get_entry_type);
 
   // Create messages without data
   static std::shared_ptr<Message> KeepAlive() {
-    return std::make_shared<Message>(kKeepAlive, private_init());
+    return Create(kKeepAlive);
   }
   static std::shared_ptr<Message> ProtoUnsup() {
-    return std::make_shared<Message>(kProtoUnsup, private_init());
+    return Create(kProtoUnsup);
   }
   static std::shared_ptr<Message> ServerHelloDone() {
-    return std::make_shared<Message>(kServerHelloDone, private_init());
+    return Create(kServerHelloDone);
   }
   static std::shared_ptr<Message> ClientHelloDone() {
-    return std::make_shared<Message>(kClientHelloDone, private_init());
+    return Create(kClientHelloDone);
   }
   static std::shared_ptr<Message> ClearEntries() {
-    return std::make_shared<Message>(kClearEntries, private_init());
+    return Create(kClearEntries);
   }
 
   // Create messages with data
   static std::shared_ptr<Message> ClientHello(wpi::StringRef self_id);
   static std::shared_ptr<Message> ServerHello(unsigned int flags,
                                               wpi::StringRef self_id);
+  static std::shared_ptr<Message> ClientFlags(unsigned int flags);
+  // The session token is returned by seq_num_uid().
+  static std::shared_ptr<Message> SessionResume(
+      wpi::StringRef self_id, unsigned int token,
+      wpi::ArrayRef<EntryWatermark> watermarks);
+  static std::shared_ptr<Message> SessionToken(unsigned int token);
+  // The token is returned by seq_num_uid() and the UDP port by id().
+  static std::shared_ptr<Message> DatagramToken(unsigned int token,
+                                                unsigned int port);
   static std::shared_ptr<Message> EntryAssign(wpi::StringRef name,
                                               unsigned int id,
                                               unsigned int seq_num,
@@ -86,6 +122,10 @@ class Message {
   static std::shared_ptr<Message> EntryUpdate(unsigned int id,
                                               unsigned int seq_num,
                                               std::shared_ptr<Value> value);
+  // The updates must all be for the same entry; they keep the times of their
+  // values relative to the last one on the wire.
+  static std::shared_ptr<Message> EntryHistory(
+      std::vector<std::shared_ptr<Message>> updates);
   static std::shared_ptr<Message> FlagsUpdate(unsigned int id,
                                               unsigned int flags);
   static std::shared_ptr<Message> EntryDelete(unsigned int id);
@@ -98,6 +138,9 @@ class Message {
   Message& operator=(const Message&) = delete;
 
  private:
+  // Allocates from a message pool rather than the general heap.
+  static std::shared_ptr<Message> Create(MsgType type);
+
   MsgType m_type{kUnknown};
 
   // Message data.  Use varies by message type.
@@ -105,7 +148,8 @@ class Message {
   std::shared_ptr<Value> m_value;
   unsigned int m_id{0};  // also used for proto_rev
   unsigned int m_flags{0};
-  unsigned int m_seq_num_uid{0};
+  unsigned int m_seq_num_uid{0};  // also used for session token
+  std::vector<std::shared_ptr<Message>> m_history;
 };
 
 }  // namespace nt
@@ -4,12 +4,20 @@
 
 #include "NetworkConnection.h"
 
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <functional>
 #include <utility>
 
+#include <wpi/Lz4.h>
 #include <wpi/NetworkStream.h>
+#include <wpi/leb128.h>
+#include <wpi/raw_istream.h>
 #include <wpi/raw_socket_istream.h>
 #include <wpi/timestamp.h>
 
+#include "DatagramChannel.h"
 #include "IConnectionNotifier.h"
 #include "Log.h"
 #include "WireDecoder.h"
@@ -17,25 +25,138 @@
 
 using namespace nt;
 
+namespace {
+
+// Counts the bytes read through another stream
+class CountingIstream : public wpi::raw_istream {
+ public:
+  CountingIstream(wpi::raw_istream& is, std::atomic<uint64_t>& count)
+      : m_is(is), m_count(count) {}
+
+  void close() override { m_is.close(); }
+  size_t in_avail() const override { return m_is.in_avail(); }
+
+ private:
+  void read_impl(void* data, size_t len) override {
+    m_is.read(data, len);
+    if (m_is.has_error()) {
+      error_detected();
+      return;
+    }
+    m_count += len;
+    set_read_count(len);
+  }
+
+  wpi::raw_istream& m_is;
+  std::atomic<uint64_t>& m_count;
+};
+
+// Expands compressed blocks read through another stream.  StartMessage()
+// must be called at each message boundary, as blocks only start there.
+// A block is an error if on_block returns false.
+class BlockIstream : public wpi::raw_istream {
+ public:
+  BlockIstream(wpi::raw_istream& is, std::function<bool()> on_block)
+      : m_is(is), m_on_block(std::move(on_block)) {}
+
+  void StartMessage() {
+    if (m_pos < m_buf.size()) {
+      return;
+    }
+    m_buf.clear();
+    m_pos = 0;
+    m_in_block = false;
+    for (;;) {
+      char type;
+      m_is.read(&type, 1);
+      if (m_is.has_error()) {
+        error_detected();
+        return;
+      }
+      if (static_cast<unsigned char>(type) !=
+          NetworkConnection::kCompressedBlock) {
+        m_buf.push_back(type);
+        return;
+      }
+      if (!m_on_block() ||
+          !NetworkConnection::ReadCompressedBlock(m_is, m_buf)) {
+        error_detected();
+        return;
+      }
+      if (!m_buf.empty()) {
+        m_in_block = true;
+        return;
+      }
+    }
+  }
+
+  void close() override { m_is.close(); }
+  size_t in_avail() const override {
+    return (m_buf.size() - m_pos) + m_is.in_avail();
+  }
+
+ private:
+  void read_impl(void* data, size_t len) override {
+    size_t n = (std::min)(len, m_buf.size() - m_pos);
+    std::memcpy(data, m_buf.data() + m_pos, n);
+    m_pos += n;
+    set_read_count(len);
+    if (n == len) {
+      return;
+    }
+    // blocks only contain whole messages
+    if (m_in_block) {
+      error_detected();
+      return;
+    }
+    m_is.read(static_cast<char*>(data) + n, len - n);
+    if (m_is.has_error()) {
+      error_detected();
+    }
+  }
+
+  wpi::raw_istream& m_is;
+  std::function<bool()> m_on_block;
+  wpi::SmallVector<char, 128> m_buf;
+  size_t m_pos = 0;
+  bool m_in_block = false;
+};
+
+}  // namespace
+
 NetworkConnection::NetworkConnection(unsigned int uid,
                                      std::unique_ptr<wpi::NetworkStream> stream,
                                      IConnectionNotifier& notifier,
                                      wpi::Logger& logger,
                                      HandshakeFunc handshake,
                                      Message::GetEntryTypeFunc get_entry_type)
+    : NetworkConnection(uid, stream->getPeerIP(),
+                        static_cast<unsigned int>(stream->getPeerPort()),
+                        notifier, logger, std::move(handshake),
+                        std::move(get_entry_type)) {
+  m_stream = std::move(stream);
+
+  // turn off Nagle algorithm; we bundle packets for transmission
+  m_stream->setNoDelay();
+}
+
+NetworkConnection::NetworkConnection(unsigned int uid, wpi::StringRef peer_ip,
+                                     unsigned int peer_port,
+                                     IConnectionNotifier& notifier,
+                                     wpi::Logger& logger,
+                                     HandshakeFunc handshake,
+                                     Message::GetEntryTypeFunc get_entry_type)
     : m_uid(uid),
-      m_stream(std::move(stream)),
-      m_notifier(notifier),
       m_logger(logger),
       m_handshake(std::move(handshake)),
       m_get_entry_type(std::move(get_entry_type)),
+      m_notifier(notifier),
+      m_peer_ip(peer_ip),
+      m_peer_port(peer_port),
       m_state(kCreated) {
   m_active = false;
   m_proto_rev = 0x0300;
   m_last_update = 0;
-
-  // turn off Nagle algorithm; we bundle packets for transmission
-  m_stream->setNoDelay();
 }
 
 NetworkConnection::~NetworkConnection() {
@@ -103,9 +224,80 @@ void NetworkConnection::Stop() {
 }
 
 ConnectionInfo NetworkConnection::info() const {
-  return ConnectionInfo{remote_id(), m_stream->getPeerIP(),
-                        static_cast<unsigned int>(m_stream->getPeerPort()),
-                        m_last_update, m_proto_rev};
+  return ConnectionInfo{remote_id(), m_peer_ip, m_peer_port, m_last_update,
+                        m_proto_rev};
+}
+
+ConnectionMetrics NetworkConnection::metrics() const {
+  ConnectionMetrics m;
+  m.info = info();
+  m.bytes_sent = m_bytes_sent;
+  m.bytes_received = m_bytes_received;
+  m.messages_sent = m_msgs_sent;
+  m.messages_received = m_msgs_received;
+  m.queue_depth = m_outgoing.size();
+  m.flush_latency = m_flush_latency;
+  m.handshake_duration = m_handshake_duration;
+  m.rtt = m_rtt;
+  return m;
+}
+
+void NetworkConnection::StartCompression() {
+  if (m_compression_enabled && !m_compress_out) {
+    m_compress_out = true;
+    m_compress_announce = true;
+  }
+}
+
+bool NetworkConnection::ReadCompressedBlock(wpi::raw_istream& is,
+                                            wpi::SmallVectorImpl<char>& out) {
+  uint64_t plain_len;
+  uint64_t comp_len;
+  if (!wpi::ReadUleb128(is, &plain_len) || !wpi::ReadUleb128(is, &comp_len) ||
+      plain_len > kMaxBlockSize ||
+      comp_len > wpi::Lz4CompressBound(kMaxBlockSize)) {
+    return false;
+  }
+  if (plain_len == 0 && comp_len == 0) {
+    return true;  // empty block
+  }
+  wpi::SmallVector<char, 256> comp;
+  is.readinto(comp, comp_len);
+  if (is.has_error()) {
+    return false;
+  }
+  return wpi::Lz4Decompress(wpi::StringRef{comp.data(), comp.size()},
+                            plain_len, out);
+}
+
+wpi::StringRef NetworkConnection::CompressOutgoing(wpi::StringRef data) {
+  if (!m_compress_out) {
+    return data;
+  }
+  m_compress_buf.clear();
+  if (data.size() >= kMinCompressSize && data.size() <= kMaxBlockSize) {
+    m_compress_scratch.clear();
+    wpi::Lz4Compress(data, m_compress_scratch);
+    // only worth it if the block (with its header) is smaller
+    if (m_compress_scratch.size() + 16 < data.size()) {
+      m_compress_buf.push_back(static_cast<char>(kCompressedBlock));
+      wpi::WriteUleb128(m_compress_buf, data.size());
+      wpi::WriteUleb128(m_compress_buf, m_compress_scratch.size());
+      m_compress_buf.append(m_compress_scratch.begin(),
+                            m_compress_scratch.end());
+      m_compress_announce = false;
+      return {m_compress_buf.data(), m_compress_buf.size()};
+    }
+  }
+  if (m_compress_announce.exchange(false)) {
+    // an empty block tells the peer we accept them
+    m_compress_buf.push_back(static_cast<char>(kCompressedBlock));
+    m_compress_buf.push_back(0);
+    m_compress_buf.push_back(0);
+    m_compress_buf.append(data.begin(), data.end());
+    return {m_compress_buf.data(), m_compress_buf.size()};
+  }
+  return data;
 }
 
 unsigned int NetworkConnection::proto_rev() const {
@@ -148,18 +340,26 @@ void NetworkConnection::set_remote_id(wpi::StringRef remote_id) {
 }
 
 void NetworkConnection::ReadThreadMain() {
-  wpi::raw_socket_istream is(*m_stream);
+  wpi::raw_socket_istream sis(*m_stream);
+  CountingIstream cis(sis, m_bytes_received);
+  BlockIstream is(cis, [this] { return PeerSentCompressed(); });
   WireDecoder decoder(is, m_proto_rev, m_logger);
+  decoder.set_array_deltas(true);
 
   set_state(kHandshake);
+  uint64_t handshake_start = Now();
   if (!m_handshake(
           *this,
           [&] {
             decoder.set_proto_rev(m_proto_rev);
+            is.StartMessage();
             auto msg = Message::Read(decoder, m_get_entry_type);
             if (!msg && decoder.error()) {
               DEBUG0("error reading in handshake: " << decoder.error());
             }
+            if (msg) {
+              ++m_msgs_received;
+            }
             return msg;
           },
           [&](wpi::ArrayRef<std::shared_ptr<Message>> msgs) {
@@ -170,6 +370,7 @@ void NetworkConnection::ReadThreadMain() {
     goto done;
   }
 
+  m_handshake_duration = Now() - handshake_start;
   set_state(kActive);
   while (m_active) {
     if (!m_stream) {
@@ -177,6 +378,7 @@ void NetworkConnection::ReadThreadMain() {
     }
     decoder.set_proto_rev(m_proto_rev);
     decoder.Reset();
+    is.StartMessage();
     auto msg = Message::Read(decoder, m_get_entry_type);
     if (!msg) {
       if (decoder.error()) {
@@ -192,7 +394,8 @@ void NetworkConnection::ReadThreadMain() {
                             << " id=" << msg->id()
                             << " seq_num=" << msg->seq_num_uid());
     m_last_update = Now();
-    m_process_incoming(std::move(msg), this);
+    ++m_msgs_received;
+    ProcessIncoming(std::move(msg));
   }
   DEBUG2("read thread died (" << this << ")");
   set_state(kDead);
@@ -217,15 +420,20 @@ void NetworkConnection::WriteThreadMain() {
     if (msgs.empty()) {
       continue;
     }
+    uint64_t flush_start = m_flush_start.exchange(0);
     encoder.set_proto_rev(m_proto_rev);
+    encoder.set_array_deltas(m_array_deltas);
+    encoder.set_entry_history(m_entry_history);
     encoder.Reset();
     DEBUG3("sending " << msgs.size() << " messages");
+    size_t count = 0;
     for (auto& msg : msgs) {
       if (msg) {
         DEBUG3("sending type=" << msg->type() << " with str=" << msg->str()
                                << " id=" << msg->id()
                                << " seq_num=" << msg->seq_num_uid());
         msg->Write(encoder);
+        ++count;
       }
     }
     wpi::NetworkStream::Error err;
@@ -235,10 +443,13 @@ void NetworkConnection::WriteThreadMain() {
     if (encoder.size() == 0) {
       continue;
     }
-    if (m_stream->send(encoder.data(), encoder.size(), &err) == 0) {
+    auto data = CompressOutgoing({encoder.data(), encoder.size()});
+    if (m_stream->send(data.data(), data.size(), &err) == 0) {
       break;
     }
-    DEBUG4("sent " << encoder.size() << " bytes");
+    DEBUG4("sent " << data.size() << " bytes");
+    CountWrite(count, data.size(), flush_start);
+    RecycleOutgoing(std::move(msgs));
   }
   DEBUG2("write thread died (" << this << ")");
   set_state(kDead);
@@ -257,26 +468,243 @@ void NetworkConnection::WriteThreadMain() {
 
 void NetworkConnection::QueueOutgoing(std::shared_ptr<Message> msg) {
   std::scoped_lock lock(m_pending_mutex);
+  NoteEntryMessage(*msg);
+  if (m_policies && (!m_policies->empty() || !m_policy_state.empty()) &&
+      !ApplyPublishPolicy(msg)) {
+    return;
+  }
+  QueueOutgoingImpl(std::move(msg));
+}
 
-  // Merge with previous.  One case we don't combine: delete/assign loop.
+void NetworkConnection::SetEntryInfo(unsigned int id, wpi::StringRef name,
+                                     unsigned int flags) {
+  if (id == 0xffff) {
+    return;
+  }
+  std::scoped_lock lock(m_pending_mutex);
+  if (id >= m_entry_info.size()) {
+    m_entry_info.resize(id + 1);
+  }
+  auto& info = m_entry_info[id];
+  info.name = name;
+  info.flags = flags;
+}
+
+void NetworkConnection::ProcessIncoming(std::shared_ptr<Message> msg) {
+  switch (msg->type()) {
+    case Message::kEntryAssign:
+    case Message::kFlagsUpdate:
+    case Message::kEntryDelete:
+    case Message::kClearEntries: {
+      std::scoped_lock lock(m_pending_mutex);
+      NoteEntryMessage(*msg);
+      break;
+    }
+    default:
+      break;
+  }
+  m_process_incoming(std::move(msg), this);
+}
+
+void NetworkConnection::NoteEntryMessage(const Message& msg) {
+  unsigned int id = msg.id();
+  switch (msg.type()) {
+    case Message::kEntryAssign:
+    case Message::kEntryDelete:
+      if (id == 0xffff) {
+        break;
+      }
+      // the publish policy is looked up again for the new name
+      if (id < m_policy_state.size()) {
+        m_policy_state[id] = PolicyState{};
+      }
+      if (msg.Is(Message::kEntryDelete)) {
+        if (id < m_entry_info.size()) {
+          m_entry_info[id] = EntryInfo{};
+        }
+        break;
+      }
+      if (id >= m_entry_info.size()) {
+        m_entry_info.resize(id + 1);
+      }
+      m_entry_info[id].name = msg.str();
+      m_entry_info[id].flags = msg.flags();
+      break;
+    case Message::kFlagsUpdate:
+      if (id < m_entry_info.size()) {
+        m_entry_info[id].flags = msg.flags();
+      }
+      break;
+    case Message::kClearEntries:
+      m_entry_info.resize(0);
+      m_policy_state.resize(0);
+      m_policy_held.resize(0);
+      break;
+    default:
+      break;
+  }
+}
+
+wpi::StringRef NetworkConnection::EntryName(unsigned int id) const {
+  if (id >= m_entry_info.size()) {
+    return {};
+  }
+  return m_entry_info[id].name;
+}
+
+unsigned int NetworkConnection::EntryFlags(unsigned int id) const {
+  if (id >= m_entry_info.size()) {
+    return 0;
+  }
+  return m_entry_info[id].flags;
+}
+
+bool NetworkConnection::ApplyPublishPolicy(std::shared_ptr<Message>& msg) {
   switch (msg->type()) {
     case Message::kEntryAssign:
     case Message::kEntryUpdate: {
+      unsigned int id = msg->id();
+      if (id == 0xffff) {
+        return true;
+      }
+      if (id >= m_policy_state.size()) {
+        m_policy_state.resize(id + 1);
+      }
+      auto& state = m_policy_state[id];
+      unsigned int generation = m_policies->generation();
+      auto value = msg->value();
+
+      // assignments always go out and carry the entry name
+      if (msg->Is(Message::kEntryAssign)) {
+        state.generation = generation;
+        state.policy = m_policies->Find(msg->str());
+        state.last_sent = std::chrono::steady_clock::now();
+        state.last_value = std::move(value);
+        state.held.reset();
+        return true;
+      }
+
+      if (state.generation != generation) {
+        state.generation = generation;
+        state.policy = m_policies->Find(EntryName(id));
+      }
+      if (!state.policy) {
+        return true;
+      }
+      auto& policy = *state.policy;
+
+      // deadband against the last value sent (or held)
+      if ((policy.policy.abs_deadband > 0 || policy.policy.rel_deadband > 0) &&
+          value && value->IsDouble() && state.last_value &&
+          state.last_value->IsDouble()) {
+        double last = state.last_value->GetDouble();
+        double delta = std::abs(value->GetDouble() - last);
+        if (delta < policy.policy.abs_deadband ||
+            delta < policy.policy.rel_deadband * std::abs(last)) {
+          ++policy.deadband;
+          return false;
+        }
+      }
+
+      if (policy.policy.period > 0) {
+        auto now = std::chrono::steady_clock::now();
+        if ((now - state.last_sent) <
+            std::chrono::duration<double>(policy.policy.period)) {
+          if (!policy.policy.latest_only) {
+            ++policy.rate_limited;
+            return false;
+          }
+          if (state.held) {
+            ++policy.coalesced;
+          } else {
+            m_policy_held.push_back(id);
+          }
+          state.last_value = std::move(value);
+          state.held = std::move(msg);
+          return false;
+        }
+        state.last_sent = now;
+      }
+      if (state.held) {
+        // period elapsed before the held update was released
+        ++policy.coalesced;
+        state.held.reset();
+      }
+      state.last_value = std::move(value);
+      return true;
+    }
+    default:
+      return true;
+  }
+}
+
+void NetworkConnection::ReleaseHeld(std::chrono::steady_clock::time_point now) {
+  auto it = std::remove_if(
+      m_policy_held.begin(), m_policy_held.end(), [&](unsigned int id) {
+        if (id >= m_policy_state.size()) {
+          return true;
+        }
+        auto& state = m_policy_state[id];
+        if (!state.held) {
+          return true;
+        }
+        double period = state.policy ? state.policy->policy.period : 0;
+        if ((now - state.last_sent) < std::chrono::duration<double>(period)) {
+          return false;
+        }
+        state.last_sent = now;
+        QueueOutgoingImpl(std::move(state.held));
+        state.held.reset();
+        return true;
+      });
+  m_policy_held.erase(it, m_policy_held.end());
+}
+
+void NetworkConnection::QueueOutgoingImpl(std::shared_ptr<Message> msg) {
+  // Merge with previous.  One case we don't combine: delete/assign loop.
+  switch (msg->type()) {
+    case Message::kEntryAssign:
+    case Message::kEntryUpdate:
+    case Message::kEntryHistory: {
       // don't do this for unassigned id's
       unsigned int id = msg->id();
       if (id == 0xffff) {
         m_pending_outgoing.push_back(msg);
         break;
       }
-      if (id < m_pending_update.size() && m_pending_update[id].first != 0) {
+      bool pending = id < m_pending_update.size() &&
+                     m_pending_update[id].first != 0;
+      if (m_datagram_port != 0) {
+        // updates queued behind a pending assignment stay with it; history
+        // entries stay on the stream as lost batches can't be recovered
+        if (!pending && msg->Is(Message::kEntryUpdate) &&
+            (EntryFlags(id) & (NT_UNRELIABLE | NT_HISTORY)) == NT_UNRELIABLE) {
+          QueueDatagram(std::move(msg));
+          break;
+        }
+        DropDatagram(id);
+      }
+      if (pending) {
         // overwrite the previous one for this id
         auto& oldmsg = m_pending_outgoing[m_pending_update[id].first - 1];
         if (oldmsg && oldmsg->Is(Message::kEntryAssign) &&
-            msg->Is(Message::kEntryUpdate)) {
+            !msg->Is(Message::kEntryAssign) &&
+            (EntryFlags(id) & NT_HISTORY) != 0) {
+          // the assignment keeps its value; the updates after it start a
+          // new batch so that none of them are lost
+          m_pending_update[id].first = m_pending_outgoing.size() + 1;
+          m_pending_outgoing.push_back(std::move(msg));
+        } else if (oldmsg && oldmsg->Is(Message::kEntryAssign) &&
+                   !msg->Is(Message::kEntryAssign)) {
           // need to update assignment with new seq_num and value
           oldmsg = Message::EntryAssign(oldmsg->str(), id, msg->seq_num_uid(),
                                         msg->value(), oldmsg->flags());
+        } else if (oldmsg && !msg->Is(Message::kEntryAssign) &&
+                   (EntryFlags(id) & NT_HISTORY) != 0) {
+          // keep every update rather than just the latest
+          AppendHistory(id, &oldmsg, std::move(msg));
         } else {
+          m_pending_history.erase(id);
           oldmsg = msg;  // easy update
         }
       } else {
@@ -299,6 +727,8 @@ void NetworkConnection::QueueOutgoing(std::shared_ptr<Message> msg) {
       }
 
       // clear previous updates
+      DropDatagram(id);
+      m_pending_history.erase(id);
       if (id < m_pending_update.size()) {
         if (m_pending_update[id].first != 0) {
           m_pending_outgoing[m_pending_update[id].first - 1].reset();
@@ -349,6 +779,9 @@ void NetworkConnection::QueueOutgoing(std::shared_ptr<Message> msg) {
         }
       }
       m_pending_update.resize(0);
+      m_pending_history.clear();
+      m_pending_datagrams.resize(0);
+      m_pending_datagram_update.resize(0);
       m_pending_outgoing.push_back(msg);
       break;
     }
@@ -358,9 +791,204 @@ void NetworkConnection::QueueOutgoing(std::shared_ptr<Message> msg) {
   }
 }
 
-void NetworkConnection::PostOutgoing(bool keep_alive) {
+void NetworkConnection::AppendHistory(unsigned int id,
+                                      std::shared_ptr<Message>* pending,
+                                      std::shared_ptr<Message> msg) {
+  auto& updates = m_pending_history[id];
+  auto append = [&](const std::shared_ptr<Message>& m) {
+    if (m->Is(Message::kEntryHistory)) {
+      updates.insert(updates.end(), m->history().begin(), m->history().end());
+    } else {
+      updates.push_back(m);
+    }
+  };
+  if (updates.empty()) {
+    append(*pending);
+  }
+  append(msg);
+  // trim in bulk; PostStream() trims to the limit
+  if (updates.size() >= 2 * kMaxHistory) {
+    updates.erase(updates.begin(), updates.end() - kMaxHistory);
+  }
+  *pending = std::move(msg);
+}
+
+void NetworkConnection::QueueDatagram(std::shared_ptr<Message> msg) {
+  unsigned int id = msg->id();
+  if (id < m_pending_datagram_update.size() &&
+      m_pending_datagram_update[id] != 0) {
+    // latest value wins
+    m_pending_datagrams[m_pending_datagram_update[id] - 1] = std::move(msg);
+    return;
+  }
+  if (id >= m_pending_datagram_update.size()) {
+    m_pending_datagram_update.resize(id + 1);
+  }
+  m_pending_datagrams.push_back(std::move(msg));
+  m_pending_datagram_update[id] = m_pending_datagrams.size();
+}
+
+void NetworkConnection::DropDatagram(unsigned int id) {
+  if (id < m_pending_datagram_update.size() &&
+      m_pending_datagram_update[id] != 0) {
+    m_pending_datagrams[m_pending_datagram_update[id] - 1].reset();
+    m_pending_datagram_update[id] = 0;
+  }
+}
+
+size_t NetworkConnection::EncodeDatagrams(
+    std::chrono::steady_clock::time_point now,
+    std::vector<std::string>* datagrams) {
+  char token[4] = {static_cast<char>((m_datagram_token >> 24) & 0xff),
+                   static_cast<char>((m_datagram_token >> 16) & 0xff),
+                   static_cast<char>((m_datagram_token >> 8) & 0xff),
+                   static_cast<char>(m_datagram_token & 0xff)};
+  if (m_datagram_announce &&
+      (now - m_last_announce) >= std::chrono::seconds(1)) {
+    m_last_announce = now;
+    datagrams->emplace_back(token, sizeof(token));
+  }
+
+  size_t count = 0;
+  std::string* datagram = nullptr;
+  WireEncoder encoder(0x0300);
+  for (auto& msg : m_pending_datagrams) {
+    if (!msg) {
+      continue;
+    }
+    encoder.Reset();
+    msg->Write(encoder);
+    if (sizeof(token) + encoder.size() > DatagramChannel::kMaxDatagramSize) {
+      // too large for a datagram; any earlier update to the entry was sent
+      // in a previous datagram, so ordering on the stream doesn't matter
+      m_pending_outgoing.emplace_back(std::move(msg));
+      continue;
+    }
+    if (!datagram ||
+        datagram->size() + encoder.size() > DatagramChannel::kMaxDatagramSize) {
+      datagram = &datagrams->emplace_back(token, sizeof(token));
+    }
+    datagram->append(encoder.data(), encoder.size());
+    ++count;
+  }
+  m_pending_datagrams.resize(0);
+  m_pending_datagram_update.resize(0);
+  return count;
+}
+
+void NetworkConnection::EnableDatagrams(
+    std::shared_ptr<DatagramChannel> channel, unsigned int token,
+    bool announce) {
   std::scoped_lock lock(m_pending_mutex);
-  auto now = std::chrono::steady_clock::now();
+  m_datagram = std::move(channel);
+  m_datagram_token = token;
+  m_datagram_announce = announce;
+}
+
+void NetworkConnection::set_datagram_peer(wpi::StringRef ip,
+                                          unsigned int port) {
+  std::scoped_lock lock(m_pending_mutex);
+  if (m_datagram) {
+    m_datagram_ip = ip;
+    m_datagram_port = port;
+  }
+}
+
+void NetworkConnection::ProcessDatagram(wpi::StringRef data,
+                                        wpi::StringRef ip, unsigned int port) {
+  if (state() != kActive) {
+    return;
+  }
+  // the token alone could be sniffed or guessed; only the stream's peer may
+  // send datagrams, though its port may change (e.g. NAT rebinding)
+  if (ip != m_peer_ip) {
+    DEBUG0("datagram from " << ip << " port " << port << " for connection to "
+                            << m_peer_ip << "; ignored");
+    return;
+  }
+  {
+    std::scoped_lock lock(m_pending_mutex);
+    if (!m_datagram) {
+      return;
+    }
+    if (m_datagram_port != port || m_datagram_ip != ip) {
+      m_datagram_ip = ip;
+      m_datagram_port = port;
+    }
+  }
+  m_bytes_received += data.size() + 4;
+
+  wpi::raw_mem_istream is(data.data(), data.size());
+  WireDecoder decoder(is, 0x0300, m_logger);
+  while (is.in_avail() > 0) {
+    decoder.Reset();
+    auto msg = Message::Read(decoder, m_get_entry_type);
+    // only entry updates are sent as datagrams
+    if (!msg || !msg->Is(Message::kEntryUpdate)) {
+      DEBUG0("bad datagram from " << ip << " port " << port);
+      break;
+    }
+    m_last_update = Now();
+    ++m_msgs_received;
+    ProcessIncoming(std::move(msg));
+  }
+}
+
+void NetworkConnection::RecycleOutgoing(Outgoing&& msgs) {
+  // release the messages outside the lock
+  msgs.clear();
+  std::scoped_lock lock(m_pending_mutex);
+  if (m_pending_outgoing.empty() &&
+      m_pending_outgoing.capacity() < msgs.capacity()) {
+    m_pending_outgoing.swap(msgs);
+  }
+}
+
+void NetworkConnection::CountWrite(size_t msgs, size_t bytes,
+                                   uint64_t flush_start) {
+  m_msgs_sent += msgs;
+  m_bytes_sent += bytes;
+  if (flush_start != 0) {
+    m_flush_latency = Now() - flush_start;
+  }
+}
+
+void NetworkConnection::PostOutgoing(bool keep_alive) {
+  std::vector<std::string> datagrams;
+  std::shared_ptr<DatagramChannel> channel;
+  std::string ip;
+  unsigned int port = 0;
+  size_t count = 0;
+  {
+    std::scoped_lock lock(m_pending_mutex);
+    auto now = std::chrono::steady_clock::now();
+    if (!m_policy_held.empty()) {
+      ReleaseHeld(now);
+    }
+    if (m_datagram_port != 0) {
+      count = EncodeDatagrams(now, &datagrams);
+      if (!datagrams.empty()) {
+        channel = m_datagram;
+        ip = m_datagram_ip;
+        port = m_datagram_port;
+      }
+    }
+    PostStream(keep_alive, now);
+  }
+
+  // send outside the lock
+  size_t bytes = 0;
+  for (auto&& datagram : datagrams) {
+    channel->Send(datagram, ip, port);
+    bytes += datagram.size();
+  }
+  if (bytes != 0) {
+    CountWrite(count, bytes, 0);
+  }
+}
+
+void NetworkConnection::PostStream(bool keep_alive,
+                                   std::chrono::steady_clock::time_point now) {
   if (m_pending_outgoing.empty()) {
     if (!keep_alive) {
       return;
@@ -371,9 +999,20 @@ void NetworkConnection::PostOutgoing(bool keep_alive) {
     }
     m_outgoing.emplace(Outgoing{Message::KeepAlive()});
   } else {
+    for (auto&& history : m_pending_history) {
+      auto& updates = history.second;
+      if (updates.size() > kMaxHistory) {
+        updates.erase(updates.begin(), updates.end() - kMaxHistory);
+      }
+      m_pending_outgoing[m_pending_update[history.first].first - 1] =
+          Message::EntryHistory(std::move(updates));
+    }
+    m_pending_history.clear();
     m_outgoing.emplace(std::move(m_pending_outgoing));
     m_pending_outgoing.resize(0);
     m_pending_update.resize(0);
   }
   m_last_post = now;
+  uint64_t unset = 0;
+  m_flush_start.compare_exchange_strong(unset, Now());
 }  // NOLINT
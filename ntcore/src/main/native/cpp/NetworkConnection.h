@@ -16,20 +16,25 @@
 #include <vector>
 
 #include <wpi/ConcurrentQueue.h>
+#include <wpi/DenseMap.h>
+#include <wpi/SmallVector.h>
 #include <wpi/condition_variable.h>
 #include <wpi/mutex.h>
 
 #include "INetworkConnection.h"
 #include "Message.h"
+#include "PublishPolicyTable.h"
 #include "ntcore_cpp.h"
 
 namespace wpi {
 class Logger;
 class NetworkStream;
+class raw_istream;
 }  // namespace wpi
 
 namespace nt {
 
+class DatagramChannel;
 class IConnectionNotifier;
 
 class NetworkConnection : public INetworkConnection {
@@ -56,10 +61,17 @@ class NetworkConnection : public INetworkConnection {
     m_process_incoming = func;
   }
 
-  void Start();
-  void Stop();
+  // Set the publish policies applied to outgoing entry updates.  This must
+  // be called before Start().
+  void set_publish_policies(const PublishPolicyTable* policies) {
+    m_policies = policies;
+  }
+
+  virtual void Start();
+  virtual void Stop();
 
   ConnectionInfo info() const final;
+  ConnectionMetrics metrics() const final;
 
   bool active() const { return m_active; }
   wpi::NetworkStream& stream() { return *m_stream; }
@@ -67,6 +79,9 @@ class NetworkConnection : public INetworkConnection {
   void QueueOutgoing(std::shared_ptr<Message> msg) final;
   void PostOutgoing(bool keep_alive) override;
 
+  void SetEntryInfo(unsigned int id, wpi::StringRef name,
+                    unsigned int flags) final;
+
   unsigned int uid() const { return m_uid; }
 
   unsigned int proto_rev() const final;
@@ -80,36 +95,219 @@ class NetworkConnection : public INetworkConnection {
 
   uint64_t last_update() const { return m_last_update; }
 
+  // Round trip time measured by the handshake, in microseconds.
+  void set_rtt(uint64_t rtt) { m_rtt = rtt; }
+
+  // Flag set in the server hello when the server accepts compressed blocks.
+  static constexpr unsigned int kHelloFlagCompression = 0x02;
+  // Flag set in the server hello (and the client flags reply) when the
+  // sender accepts array deltas.
+  static constexpr unsigned int kHelloFlagArrayDelta = 0x04;
+  // Flag set in the server hello when the server can resume sessions, and
+  // in the client flags reply when the client wants a session token.
+  static constexpr unsigned int kHelloFlagResume = 0x08;
+  // Flag set in the server hello replying to a session resume when only
+  // the entries that changed since the client's watermarks follow.
+  static constexpr unsigned int kHelloFlagResumed = 0x10;
+  // Flag set in the server hello when the server has a datagram channel,
+  // and in the client flags reply when the client wants to use it.
+  static constexpr unsigned int kHelloFlagDatagram = 0x20;
+  // Flag set in the server hello (and the client flags reply) when the
+  // sender accepts entry history batches.
+  static constexpr unsigned int kHelloFlagHistory = 0x40;
+
+  // Most updates to an NT_HISTORY entry kept between posts; older ones are
+  // dropped.
+  static constexpr size_t kMaxHistory = 128;
+
+  // Send double and boolean array updates as deltas; only enable once the
+  // peer is known to accept them.  Incoming deltas are always accepted.
+  void set_array_deltas(bool enable) { m_array_deltas = enable; }
+
+  // Send the updates batched for NT_HISTORY entries as single messages;
+  // only enable once the peer is known to accept them.  Otherwise they are
+  // sent as ordinary updates.
+  void set_entry_history(bool enable) { m_entry_history = enable; }
+
+  // Allow sending compressed blocks once the peer is known to accept them.
+  // Servers learn this by receiving a block from the client; clients call
+  // StartCompression() when the server hello has kHelloFlagCompression set.
+  void set_compression_enabled(bool enabled) {
+    m_compression_enabled = enabled;
+  }
+  bool compression_enabled() const { return m_compression_enabled; }
+  void StartCompression();
+
+  // Send updates to entries flagged NT_UNRELIABLE as datagrams carrying
+  // token, once the peer's datagram address is known.  Updates to other
+  // entries, assignments, deletes and RPCs stay on the stream.  If announce
+  // is set, a datagram with just the token is sent every second so the peer
+  // learns (and keeps) our address.
+  void EnableDatagrams(std::shared_ptr<DatagramChannel> channel,
+                       unsigned int token, bool announce);
+  void set_datagram_peer(wpi::StringRef ip, unsigned int port);
+  unsigned int datagram_token() const { return m_datagram_token; }
+
+  // Process a datagram received with this connection's token; data is the
+  // contents following the token.  Datagrams are only accepted from the
+  // stream's peer IP, and the sender becomes the datagram peer.
+  void ProcessDatagram(wpi::StringRef data, wpi::StringRef ip,
+                       unsigned int port);
+
+  // Wire type byte of a compressed block.  It is followed by the ULEB128
+  // decompressed size, the ULEB128 compressed size, and an LZ4 block that
+  // holds only whole messages.  Only sent to peers that accept them.
+  static constexpr unsigned int kCompressedBlock = 0x30;
+  static constexpr size_t kMinCompressSize = 128;
+  static constexpr size_t kMaxBlockSize = 16 * 1024 * 1024;
+
+  // Read the remainder of a compressed block (after the type byte) and
+  // append its decompressed contents to out.  Returns false on stream error
+  // or malformed block.
+  static bool ReadCompressedBlock(wpi::raw_istream& is,
+                                  wpi::SmallVectorImpl<char>& out);
+
   NetworkConnection(const NetworkConnection&) = delete;
   NetworkConnection& operator=(const NetworkConnection&) = delete;
 
- private:
-  void ReadThreadMain();
-  void WriteThreadMain();
+ protected:
+  // Constructor for derived classes that provide their own transport rather
+  // than a blocking wpi::NetworkStream.
+  NetworkConnection(unsigned int uid, wpi::StringRef peer_ip,
+                    unsigned int peer_port, IConnectionNotifier& notifier,
+                    wpi::Logger& logger, HandshakeFunc handshake,
+                    Message::GetEntryTypeFunc get_entry_type);
+
+  // Hand back a batch popped from m_outgoing after it has been written so
+  // its storage can be reused for the next batch.
+  void RecycleOutgoing(Outgoing&& msgs);
+
+  // Returns the data to write for an encoded batch, which is compressed
+  // into a block when that is enabled and worthwhile.  Writer only.
+  wpi::StringRef CompressOutgoing(wpi::StringRef data);
+
+  // Called when a compressed block is received, before it is read.  Returns
+  // false if compression is not enabled on this connection, as a peer may
+  // only send blocks in reply to ours or to the server hello flag.
+  bool PeerSentCompressed() {
+    if (!m_compression_enabled) {
+      return false;
+    }
+    m_compress_out = true;
+    return true;
+  }
+
+  // Hand a received message to the input processor, first noting any
+  // entry assignment, flags update or delete in it.
+  void ProcessIncoming(std::shared_ptr<Message> msg);
+
+  // Record a completed write for the metrics; flush_start is the value
+  // exchanged out of m_flush_start when the batches were popped.
+  void CountWrite(size_t msgs, size_t bytes, uint64_t flush_start);
 
   unsigned int m_uid;
-  std::unique_ptr<wpi::NetworkStream> m_stream;
-  IConnectionNotifier& m_notifier;
   wpi::Logger& m_logger;
   OutgoingQueue m_outgoing;
   HandshakeFunc m_handshake;
   Message::GetEntryTypeFunc m_get_entry_type;
   ProcessIncomingFunc m_process_incoming;
-  std::thread m_read_thread;
-  std::thread m_write_thread;
   std::atomic_bool m_active;
   std::atomic_uint m_proto_rev;
+  std::atomic_ullong m_last_update;
+
+  // Metrics
+  std::atomic<uint64_t> m_bytes_sent{0};
+  std::atomic<uint64_t> m_bytes_received{0};
+  std::atomic<uint64_t> m_msgs_sent{0};
+  std::atomic<uint64_t> m_msgs_received{0};
+  std::atomic<uint64_t> m_flush_start{0};  // oldest unwritten post, or 0
+  std::atomic<uint64_t> m_flush_latency{0};
+  std::atomic<uint64_t> m_handshake_duration{0};
+  std::atomic<uint64_t> m_rtt{0};
+
+  std::atomic_bool m_array_deltas{false};
+  std::atomic_bool m_entry_history{false};
+
+  // Compression
+  std::atomic_bool m_compression_enabled{false};
+  std::atomic_bool m_compress_out{false};
+  std::atomic_bool m_compress_announce{false};
+  wpi::SmallVector<char, 0> m_compress_scratch;  // writer only
+  wpi::SmallVector<char, 0> m_compress_buf;      // writer only
+
+ private:
+  void ReadThreadMain();
+  void WriteThreadMain();
+
+  // These must be called with m_pending_mutex held.
+  void NoteEntryMessage(const Message& msg);
+  wpi::StringRef EntryName(unsigned int id) const;
+  unsigned int EntryFlags(unsigned int id) const;
+  void QueueOutgoingImpl(std::shared_ptr<Message> msg);
+  void AppendHistory(unsigned int id, std::shared_ptr<Message>* pending,
+                     std::shared_ptr<Message> msg);
+  bool ApplyPublishPolicy(std::shared_ptr<Message>& msg);
+  void ReleaseHeld(std::chrono::steady_clock::time_point now);
+  void PostStream(bool keep_alive, std::chrono::steady_clock::time_point now);
+  void QueueDatagram(std::shared_ptr<Message> msg);
+  void DropDatagram(unsigned int id);
+  size_t EncodeDatagrams(std::chrono::steady_clock::time_point now,
+                         std::vector<std::string>* datagrams);
+
+  std::unique_ptr<wpi::NetworkStream> m_stream;
+  IConnectionNotifier& m_notifier;
+  std::string m_peer_ip;
+  unsigned int m_peer_port;
+  std::thread m_read_thread;
+  std::thread m_write_thread;
   mutable wpi::mutex m_state_mutex;
   State m_state;
   mutable wpi::mutex m_remote_id_mutex;
   std::string m_remote_id;
-  std::atomic_ullong m_last_update;
   std::chrono::steady_clock::time_point m_last_post;
 
   wpi::mutex m_pending_mutex;
   Outgoing m_pending_outgoing;
   std::vector<std::pair<size_t, size_t>> m_pending_update;
 
+  // Name and flags of each assigned entry, indexed by id (uses pending
+  // mutex).  Kept here, rather than looked up in Storage, because Storage
+  // must not be called with the pending mutex held: Storage calls into
+  // connections with its own mutex held.
+  struct EntryInfo {
+    std::string name;
+    unsigned int flags = 0;
+  };
+  std::vector<EntryInfo> m_entry_info;
+
+  // Updates to NT_HISTORY entries since the last post, by id (uses pending
+  // mutex).  The pending update for the id is replaced by a batch of these
+  // when posting.
+  wpi::DenseMap<unsigned int, Outgoing> m_pending_history;
+
+  // Publish policy state, indexed by entry id (uses pending mutex)
+  struct PolicyState {
+    unsigned int generation = 0;  // of m_policies when policy was looked up
+    std::shared_ptr<PublishPolicyTable::Policy> policy;
+    std::chrono::steady_clock::time_point last_sent;
+    std::shared_ptr<Value> last_value;  // last value sent or held
+    std::shared_ptr<Message> held;      // update waiting for the period
+  };
+  const PublishPolicyTable* m_policies = nullptr;
+  std::vector<PolicyState> m_policy_state;
+  std::vector<unsigned int> m_policy_held;  // ids with a held update
+
+  // Datagram channel (uses pending mutex); datagrams are only sent once the
+  // peer port is known
+  std::shared_ptr<DatagramChannel> m_datagram;
+  std::atomic_uint m_datagram_token{0};
+  std::string m_datagram_ip;
+  unsigned int m_datagram_port = 0;
+  bool m_datagram_announce = false;
+  std::chrono::steady_clock::time_point m_last_announce;
+  Outgoing m_pending_datagrams;
+  std::vector<size_t> m_pending_datagram_update;  // by id, index + 1
+
   // Condition variables for shutdown
   wpi::mutex m_shutdown_mutex;
   wpi::condition_variable m_read_shutdown_cv;
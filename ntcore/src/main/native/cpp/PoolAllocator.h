@@ -0,0 +1,126 @@
+// Copyright (c) FIRST and other WPILib contributors.
+// Open Source Software; you can modify and/or share it under the terms of
+// the WPILib BSD license file in the root directory of this project.
+
+#ifndef NTCORE_POOLALLOCATOR_H_
+#define NTCORE_POOLALLOCATOR_H_
+
+#include <stddef.h>
+
+#include <memory>
+#include <new>
+#include <vector>
+
+#include <wpi/mutex.h>
+
+namespace nt {
+
+/* Thread-safe pool of fixed-size memory blocks.
+ * Blocks are carved out of larger slabs and recycled through a free list;
+ * memory is never returned to the heap, so the pool size tracks the peak
+ * number of live blocks.  Once warmed up, Allocate() and Deallocate() do not
+ * touch the heap.
+ */
+template <size_t Size, size_t Align>
+class BlockPool {
+ public:
+  static constexpr size_t kBlocksPerSlab = 64;
+
+  // One pool per block size.  Intentionally leaked so blocks can be freed
+  // during static destruction.
+  static BlockPool& GetInstance() {
+    static BlockPool* inst = new BlockPool;
+    return *inst;
+  }
+
+  void* Allocate() {
+    std::scoped_lock lock(m_mutex);
+    if (!m_free) {
+      AddSlab();
+    }
+    FreeBlock* block = m_free;
+    m_free = block->next;
+    return block;
+  }
+
+  void Deallocate(void* p) {
+    std::scoped_lock lock(m_mutex);
+    auto block = static_cast<FreeBlock*>(p);
+    block->next = m_free;
+    m_free = block;
+  }
+
+ private:
+  struct FreeBlock {
+    FreeBlock* next;
+  };
+
+  static constexpr size_t kAlign =
+      Align > alignof(FreeBlock) ? Align : alignof(FreeBlock);
+  static constexpr size_t kBlockSize =
+      ((Size > sizeof(FreeBlock) ? Size : sizeof(FreeBlock)) + kAlign - 1) /
+      kAlign * kAlign;
+
+  BlockPool() = default;
+
+  void AddSlab() {
+    auto slab = std::make_unique<Slab>();
+    for (size_t i = 0; i < kBlocksPerSlab; ++i) {
+      auto block = reinterpret_cast<FreeBlock*>(slab->data + i * kBlockSize);
+      block->next = m_free;
+      m_free = block;
+    }
+    m_slabs.emplace_back(std::move(slab));
+  }
+
+  struct Slab {
+    alignas(kAlign) char data[kBlockSize * kBlocksPerSlab];
+  };
+
+  wpi::mutex m_mutex;
+  FreeBlock* m_free = nullptr;
+  std::vector<std::unique_ptr<Slab>> m_slabs;
+};
+
+/* Standard allocator that serves single-object allocations from a BlockPool.
+ * Intended for use with std::allocate_shared(), which allocates the object
+ * and its control block together as a single object.
+ */
+template <typename T>
+class PoolAllocator {
+ public:
+  using value_type = T;
+
+  PoolAllocator() noexcept = default;
+  template <typename U>
+  PoolAllocator(const PoolAllocator<U>&) noexcept {}  // NOLINT
+
+  T* allocate(size_t n) {
+    if (n != 1) {
+      return static_cast<T*>(::operator new(n * sizeof(T)));
+    }
+    return static_cast<T*>(
+        BlockPool<sizeof(T), alignof(T)>::GetInstance().Allocate());
+  }
+
+  void deallocate(T* p, size_t n) noexcept {
+    if (n != 1) {
+      ::operator delete(p);
+      return;
+    }
+    BlockPool<sizeof(T), alignof(T)>::GetInstance().Deallocate(p);
+  }
+
+  template <typename U>
+  bool operator==(const PoolAllocator<U>&) const noexcept {
+    return true;
+  }
+  template <typename U>
+  bool operator!=(const PoolAllocator<U>&) const noexcept {
+    return false;
+  }
+};
+
+}  // namespace nt
+
+#endif  // NTCORE_POOLALLOCATOR_H_
@@ -0,0 +1,69 @@
+// Copyright (c) FIRST and other WPILib contributors.
+// Open Source Software; you can modify and/or share it under the terms of
+// the WPILib BSD license file in the root directory of this project.
+
+#include "PublishPolicyTable.h"
+
+#include <algorithm>
+
+using namespace nt;
+
+void PublishPolicyTable::Set(wpi::StringRef prefix,
+                             const PublishPolicy& policy) {
+  auto newp = std::make_shared<Policy>(prefix, policy);
+  std::scoped_lock lock(m_mutex);
+  auto it = std::find_if(m_policies.begin(), m_policies.end(),
+                         [&](const auto& p) { return p->prefix == prefix; });
+  if (it == m_policies.end()) {
+    m_policies.emplace_back(std::move(newp));
+  } else {
+    // carry the counters over; connections may still briefly count against
+    // the old policy until they notice the generation change
+    newp->rate_limited = (*it)->rate_limited.load();
+    newp->deadband = (*it)->deadband.load();
+    newp->coalesced = (*it)->coalesced.load();
+    *it = std::move(newp);
+  }
+  m_empty = false;
+  ++m_generation;
+}
+
+bool PublishPolicyTable::Clear(wpi::StringRef prefix) {
+  std::scoped_lock lock(m_mutex);
+  auto it = std::find_if(m_policies.begin(), m_policies.end(),
+                         [&](const auto& p) { return p->prefix == prefix; });
+  if (it == m_policies.end()) {
+    return false;
+  }
+  m_policies.erase(it);
+  m_empty = m_policies.empty();
+  ++m_generation;
+  return true;
+}
+
+bool PublishPolicyTable::GetStats(wpi::StringRef prefix,
+                                  PublishPolicyStats* stats) const {
+  std::scoped_lock lock(m_mutex);
+  for (auto& p : m_policies) {
+    if (p->prefix == prefix) {
+      stats->rate_limited = p->rate_limited;
+      stats->deadband = p->deadband;
+      stats->coalesced = p->coalesced;
+      return true;
+    }
+  }
+  return false;
+}
+
+std::shared_ptr<PublishPolicyTable::Policy> PublishPolicyTable::Find(
+    wpi::StringRef name) const {
+  std::scoped_lock lock(m_mutex);
+  std::shared_ptr<Policy> best;
+  for (auto& p : m_policies) {
+    if (name.startswith(p->prefix) &&
+        (!best || p->prefix.size() > best->prefix.size())) {
+      best = p;
+    }
+  }
+  return best;
+}
@@ -0,0 +1,61 @@
+// Copyright (c) FIRST and other WPILib contributors.
+// Open Source Software; you can modify and/or share it under the terms of
+// the WPILib BSD license file in the root directory of this project.
+
+#ifndef NTCORE_PUBLISHPOLICYTABLE_H_
+#define NTCORE_PUBLISHPOLICYTABLE_H_
+
+#include <stdint.h>
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <wpi/StringRef.h>
+#include <wpi/mutex.h>
+
+#include "ntcore_cpp.h"
+
+namespace nt {
+
+/* Publish policies by entry name prefix, shared by all connections of an
+ * instance.  Policies are immutable once created; setting a policy for an
+ * existing prefix creates a new one and bumps the generation so connections
+ * know to look up their cached policies again.
+ */
+class PublishPolicyTable {
+ public:
+  struct Policy {
+    Policy(wpi::StringRef prefix_, const PublishPolicy& policy_)
+        : prefix(prefix_), policy(policy_) {}
+
+    const std::string prefix;
+    const PublishPolicy policy;
+    std::atomic<uint64_t> rate_limited{0};
+    std::atomic<uint64_t> deadband{0};
+    std::atomic<uint64_t> coalesced{0};
+  };
+
+  void Set(wpi::StringRef prefix, const PublishPolicy& policy);
+  bool Clear(wpi::StringRef prefix);
+  bool GetStats(wpi::StringRef prefix, PublishPolicyStats* stats) const;
+
+  // Returns the policy with the longest prefix of name, or nullptr.
+  std::shared_ptr<Policy> Find(wpi::StringRef name) const;
+
+  bool empty() const { return m_empty; }
+
+  // Starts at 1 and is incremented on every change.
+  unsigned int generation() const { return m_generation; }
+
+ private:
+  mutable wpi::mutex m_mutex;
+  std::vector<std::shared_ptr<Policy>> m_policies;
+  std::atomic_bool m_empty{true};
+  std::atomic_uint m_generation{1};
+};
+
+}  // namespace nt
+
+#endif  // NTCORE_PUBLISHPOLICYTABLE_H_
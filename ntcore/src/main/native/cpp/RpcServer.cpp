@@ -6,11 +6,66 @@
 
 using namespace nt;
 
+impl::RpcWorkerPool::RpcWorkerPool(unsigned int count) {
+  m_threads.reserve(count);
+  for (unsigned int i = 0; i < count; ++i) {
+    m_threads.emplace_back(&RpcWorkerPool::ThreadMain, this);
+  }
+}
+
+impl::RpcWorkerPool::~RpcWorkerPool() {
+  {
+    std::scoped_lock lock(m_mutex);
+    m_stopping = true;
+  }
+  m_cond.notify_all();
+  for (auto&& thread : m_threads) {
+    thread.join();
+  }
+}
+
+void impl::RpcWorkerPool::Run(std::function<void()> func) {
+  {
+    std::scoped_lock lock(m_mutex);
+    m_queue.emplace_back(std::move(func));
+  }
+  m_cond.notify_one();
+}
+
+void impl::RpcWorkerPool::ThreadMain() {
+  std::unique_lock lock(m_mutex);
+  for (;;) {
+    m_cond.wait(lock, [&] { return m_stopping || !m_queue.empty(); });
+    if (m_queue.empty()) {
+      return;  // stopping
+    }
+    auto func = std::move(m_queue.front());
+    m_queue.pop_front();
+    lock.unlock();
+    func();
+    lock.lock();
+  }
+}
+
 RpcServer::RpcServer(int inst, wpi::Logger& logger)
     : m_inst(inst), m_logger(logger) {}
 
 void RpcServer::Start() {
-  DoStart(m_inst, m_logger);
+  DoStart(m_inst, m_logger, m_workers.load());
+}
+
+void RpcServer::SetWorkerThreads(unsigned int count) {
+  m_workers = count;
+  std::shared_ptr<impl::RpcWorkerPool> old;
+  {
+    auto thr = GetThread();
+    if (!thr) {
+      return;  // applied on start
+    }
+    old = thr->SetWorkers(count);
+  }
+  // queued calls on the old pool finish outside the lock, as they take it
+  // to clean up after the callback
 }
 
 unsigned int RpcServer::Add(
@@ -5,10 +5,17 @@
 #ifndef NTCORE_RPCSERVER_H_
 #define NTCORE_RPCSERVER_H_
 
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <thread>
 #include <utility>
+#include <vector>
 
 #include <wpi/CallbackManager.h>
 #include <wpi/DenseMap.h>
+#include <wpi/condition_variable.h>
 #include <wpi/mutex.h>
 
 #include "Handle.h"
@@ -31,6 +38,29 @@ struct RpcNotifierData : public RpcAnswer {
   IRpcServer::SendResponseFunc send_response;
 };
 
+// Runs RPC callbacks on a fixed set of threads, so slow callbacks don't
+// hold up other calls.
+class RpcWorkerPool {
+ public:
+  explicit RpcWorkerPool(unsigned int count);
+  // Finishes the queued callbacks before returning.
+  ~RpcWorkerPool();
+
+  RpcWorkerPool(const RpcWorkerPool&) = delete;
+  RpcWorkerPool& operator=(const RpcWorkerPool&) = delete;
+
+  void Run(std::function<void()> func);
+
+ private:
+  void ThreadMain();
+
+  wpi::mutex m_mutex;
+  wpi::condition_variable m_cond;
+  std::deque<std::function<void()>> m_queue;
+  bool m_stopping = false;
+  std::vector<std::thread> m_threads;
+};
+
 using RpcListenerData =
     wpi::CallbackListenerData<std::function<void(const RpcAnswer& answer)>>;
 
@@ -38,8 +68,25 @@ class RpcServerThread
     : public wpi::CallbackThread<RpcServerThread, RpcAnswer, RpcListenerData,
                                  RpcNotifierData> {
  public:
-  RpcServerThread(int inst, wpi::Logger& logger)
-      : m_inst(inst), m_logger(logger) {}
+  RpcServerThread(int inst, wpi::Logger& logger, unsigned int workers)
+      : m_inst(inst), m_logger(logger) {
+    SetWorkers(workers);
+  }
+
+  ~RpcServerThread() override {
+    // finish any calls running on the pool while the response map exists
+    m_pool.reset();
+  }
+
+  // Runs callbacks on a pool of worker threads; 0 runs them on this
+  // thread.  Must be called with m_mutex held.
+  std::shared_ptr<RpcWorkerPool> SetWorkers(unsigned int workers) {
+    auto old = std::move(m_pool);
+    if (workers > 0) {
+      m_pool = std::make_shared<RpcWorkerPool>(workers);
+    }
+    return old;
+  }
 
   bool Matches(const RpcListenerData& /*listener*/,
                const RpcNotifierData& data) {
@@ -55,6 +102,22 @@ class RpcServerThread
 
   void DoCallback(std::function<void(const RpcAnswer& call)> callback,
                   const RpcNotifierData& data) {
+    std::shared_ptr<RpcWorkerPool> pool;
+    {
+      std::scoped_lock lock(m_mutex);
+      pool = m_pool;
+    }
+    if (pool) {
+      pool->Run([this, callback = std::move(callback), data] {
+        CallRpc(callback, data);
+      });
+    } else {
+      CallRpc(callback, data);
+    }
+  }
+
+  void CallRpc(const std::function<void(const RpcAnswer& call)>& callback,
+               const RpcNotifierData& data) {
     DEBUG4("rpc calling " << data.name);
     unsigned int local_id = Handle{data.entry}.GetIndex();
     unsigned int call_uid = Handle{data.call}.GetIndex();
@@ -74,6 +137,7 @@ class RpcServerThread
   int m_inst;
   wpi::Logger& m_logger;
   wpi::DenseMap<RpcIdPair, IRpcServer::SendResponseFunc> m_response_map;
+  std::shared_ptr<RpcWorkerPool> m_pool;
 };
 
 }  // namespace impl
@@ -101,9 +165,12 @@ class RpcServer
   bool PostRpcResponse(unsigned int local_id, unsigned int call_uid,
                        wpi::StringRef result);
 
+  void SetWorkerThreads(unsigned int count);
+
  private:
   int m_inst;
   wpi::Logger& m_logger;
+  std::atomic_uint m_workers{0};
 };
 
 }  // namespace nt
@@ -4,6 +4,8 @@
 
 #include "Storage.h"
 
+#include <cassert>
+
 #include <wpi/timestamp.h>
 
 #include "Handle.h"
@@ -15,6 +17,14 @@
 
 using namespace nt;
 
+// Completes async RPC calls with an empty result, as a canceled call would
+static void CancelRpcRequests(wpi::ArrayRef<uint64_t> requests) {
+  auto& promises = wpi::PromiseFactory<std::string>::GetInstance();
+  for (uint64_t request : requests) {
+    promises.SetValue(request, std::string{});
+  }
+}
+
 Storage::Storage(IEntryNotifier& notifier, IRpcServer& rpc_server,
                  wpi::Logger& logger)
     : m_notifier(notifier), m_rpc_server(rpc_server), m_logger(logger) {
@@ -24,6 +34,93 @@ Storage::Storage(IEntryNotifier& notifier, IRpcServer& rpc_server,
 Storage::~Storage() {
   m_terminating = true;
   m_rpc_results_cond.notify_all();
+  CancelRpcRequests(TakeRpcRequests());
+}
+
+Storage::LocalMap::~LocalMap() {
+  for (auto& chunk : m_chunks) {
+    delete[] chunk.load(std::memory_order_relaxed);
+  }
+}
+
+void Storage::LocalMap::emplace_back(Entry* entry) {
+  size_t i = m_size.load(std::memory_order_relaxed);
+  assert(i < kMaxSize);
+  auto& chunk = m_chunks[i / kChunkSize];
+  if (!chunk.load(std::memory_order_relaxed)) {
+    chunk.store(new std::unique_ptr<Entry>[kChunkSize],
+                std::memory_order_release);
+  }
+  chunk.load(std::memory_order_relaxed)[i % kChunkSize].reset(entry);
+  // publish the new entry to lock-free readers
+  m_size.store(i + 1, std::memory_order_release);
+}
+
+void Storage::PathIndex::Add(Entry* entry) {
+  Node* node = &m_root;
+  wpi::StringRef rest = entry->name;
+  while (!rest.empty()) {
+    size_t len = rest.find('/');
+    len = len == wpi::StringRef::npos ? rest.size() : len + 1;
+    auto& child = node->children[rest.substr(0, len)];
+    if (!child) {
+      child = std::make_unique<Node>();
+    }
+    node = child.get();
+    rest = rest.substr(len);
+  }
+  node->entry = entry;
+}
+
+void Storage::PathIndex::ForEachPrefix(
+    wpi::StringRef prefix, wpi::function_ref<void(Entry*)> func) const {
+  // walk the complete segments of the prefix
+  const Node* node = &m_root;
+  for (;;) {
+    size_t len = prefix.find('/');
+    if (len == wpi::StringRef::npos) {
+      break;
+    }
+    auto i = node->children.find(prefix.substr(0, len + 1));
+    if (i == node->children.end()) {
+      return;
+    }
+    node = i->getValue().get();
+    prefix = prefix.substr(len + 1);
+  }
+
+  // the rest of the prefix is the start of a child segment
+  if (prefix.empty()) {
+    ForEach(*node, func);
+    return;
+  }
+  for (auto& child : node->children) {
+    if (child.getKey().startswith(prefix)) {
+      ForEach(*child.getValue(), func);
+    }
+  }
+}
+
+void Storage::PathIndex::ForEach(const Node& node,
+                                 wpi::function_ref<void(Entry*)> func) {
+  if (node.entry) {
+    func(node.entry);
+  }
+  for (auto& child : node.children) {
+    ForEach(*child.getValue(), func);
+  }
+}
+
+void Storage::ForEachEntry(wpi::StringRef prefix,
+                           wpi::function_ref<void(Entry*)> func) const {
+  // walking the flat list is faster when every entry matches
+  if (prefix.empty()) {
+    for (size_t i = 0, size = m_localmap.size(); i < size; ++i) {
+      func(m_localmap[i].get());
+    }
+  } else {
+    m_path_index.ForEachPrefix(prefix, func);
+  }
 }
 
 void Storage::SetDispatcher(IDispatcher* dispatcher, bool server) {
@@ -59,6 +156,10 @@ void Storage::ProcessIncoming(std::shared_ptr<Message> msg,
     case Message::kServerHelloDone:
     case Message::kServerHello:
     case Message::kClientHelloDone:
+    case Message::kClientFlags:
+    case Message::kSessionResume:
+    case Message::kSessionToken:
+    case Message::kDatagramToken:
       // shouldn't get these, but ignore if we do
       break;
     case Message::kEntryAssign:
@@ -67,6 +168,9 @@ void Storage::ProcessIncoming(std::shared_ptr<Message> msg,
     case Message::kEntryUpdate:
       ProcessIncomingEntryUpdate(std::move(msg), conn);
       break;
+    case Message::kEntryHistory:
+      ProcessIncomingEntryHistory(std::move(msg), conn);
+      break;
     case Message::kFlagsUpdate:
       ProcessIncomingFlagsUpdate(std::move(msg), conn);
       break;
@@ -101,6 +205,11 @@ void Storage::ProcessIncomingEntryAssign(std::shared_ptr<Message> msg,
     // the sender as well as all other connections.
     if (id == 0xffff) {
       entry = GetOrNew(name);
+      if (!entry) {
+        lock.unlock();
+        DEBUG0("server: too many entries to assign " << name);
+        return;
+      }
       // see if it was already assigned; ignore if so.
       if (entry->id != 0xffff) {
         return;
@@ -133,14 +242,20 @@ void Storage::ProcessIncomingEntryAssign(std::shared_ptr<Message> msg,
     if (!entry) {
       // create local
       entry = GetOrNew(name);
+      if (!entry) {
+        lock.unlock();
+        DEBUG0("client: too many entries to create " << name);
+        return;
+      }
       entry->id = id;
       m_idmap[id] = entry;
       if (!entry->value) {
         // didn't exist at all (rather than just being a response to a
         // id assignment request)
-        entry->value = msg->value();
+        entry->SetValue(msg->value());
         entry->flags = msg->flags();
         entry->seq_num = seq_num;
+        entry->unsynced_write = false;
 
         // notify
         m_notifier.NotifyEntry(entry->local_id, name, entry->value,
@@ -203,8 +318,9 @@ void Storage::ProcessIncomingEntryAssign(std::shared_ptr<Message> msg,
   }
 
   // update local
-  entry->value = msg->value();
+  entry->SetValue(msg->value());
   entry->seq_num = seq_num;
+  entry->unsynced_write = false;
 
   // notify
   m_notifier.NotifyEntry(entry->local_id, name, entry->value, notify_flags);
@@ -240,8 +356,9 @@ void Storage::ProcessIncomingEntryUpdate(std::shared_ptr<Message> msg,
   }
 
   // update local
-  entry->value = msg->value();
+  entry->SetValue(msg->value());
   entry->seq_num = seq_num;
+  entry->unsynced_write = false;
 
   // update persistent dirty flag if it's a persistent value
   if (entry->IsPersistent()) {
@@ -261,6 +378,53 @@ void Storage::ProcessIncomingEntryUpdate(std::shared_ptr<Message> msg,
   }
 }
 
+void Storage::ProcessIncomingEntryHistory(std::shared_ptr<Message> msg,
+                                          INetworkConnection* conn) {
+  std::unique_lock lock(m_mutex);
+  unsigned int id = msg->id();
+  if (id >= m_idmap.size() || !m_idmap[id]) {
+    // ignore arbitrary entry updates;
+    // this can happen due to deleted entries
+    lock.unlock();
+    DEBUG0("received history to unknown entry");
+    return;
+  }
+  Entry* entry = m_idmap[id];
+
+  // apply each update in turn, skipping any not newer than local
+  std::vector<std::shared_ptr<Value>> values;
+  values.reserve(msg->history().size());
+  for (auto&& update : msg->history()) {
+    SequenceNumber seq_num(update->seq_num_uid());
+    if (seq_num <= entry->seq_num) {
+      continue;
+    }
+    entry->SetValue(update->value());
+    entry->seq_num = seq_num;
+    values.emplace_back(update->value());
+  }
+  if (values.empty()) {
+    return;
+  }
+  entry->unsynced_write = false;
+
+  // update persistent dirty flag if it's a persistent value
+  if (entry->IsPersistent()) {
+    m_persistent_dirty = true;
+  }
+
+  // notify
+  m_notifier.NotifyHistory(entry->local_id, entry->name, std::move(values));
+
+  // broadcast to all other connections (note for client there won't
+  // be any other connections, so don't bother)
+  if (m_server && m_dispatcher) {
+    auto dispatcher = m_dispatcher;
+    lock.unlock();
+    dispatcher->QueueOutgoing(msg, nullptr, conn);
+  }
+}
+
 void Storage::ProcessIncomingFlagsUpdate(std::shared_ptr<Message> msg,
                                          INetworkConnection* conn) {
   std::unique_lock lock(m_mutex);
@@ -357,12 +521,18 @@ void Storage::ProcessIncomingExecuteRpc(
     conn_info.protocol_version = 0;
   }
   unsigned int call_uid = msg->seq_num_uid();
+  // the response is sent with the RPC server's lock held, so it can't take
+  // the storage lock to find the dispatcher
+  auto dispatcher = m_dispatcher;
   m_rpc_server.ProcessRpc(
       entry->local_id, call_uid, entry->name, msg->str(), conn_info,
       [=](wpi::StringRef result) {
         auto c = conn_weak.lock();
         if (c) {
           c->QueueOutgoing(Message::RpcResponse(id, call_uid, result));
+          if (dispatcher) {
+            dispatcher->FlushSoon();
+          }
         }
       },
       entry->rpc_uid);
@@ -388,15 +558,47 @@ void Storage::ProcessIncomingRpcResponse(std::shared_ptr<Message> msg,
     DEBUG0("received RPC response to non-RPC entry");
     return;
   }
-  m_rpc_results.insert(std::make_pair(
-      RpcIdPair{entry->local_id, msg->seq_num_uid()}, msg->str()));
-  m_rpc_results_cond.notify_all();
+  SetRpcResult(lock, RpcIdPair{entry->local_id, msg->seq_num_uid()},
+               msg->str());
+}
+
+void Storage::SetRpcResult(std::unique_lock<wpi::mutex>& lock,
+                           RpcIdPair call_pair, wpi::StringRef result) {
+  auto i = m_rpc_requests.find(call_pair);
+  if (i == m_rpc_requests.end()) {
+    m_rpc_results.insert(std::make_pair(call_pair, result));
+    m_rpc_results_cond.notify_all();
+    return;
+  }
+  uint64_t request = i->getSecond();
+  m_rpc_requests.erase(i);
+  lock.unlock();
+  wpi::PromiseFactory<std::string>::GetInstance().SetValue(request,
+                                                           result.str());
+}
+
+std::vector<uint64_t> Storage::TakeRpcRequests() {
+  std::vector<uint64_t> requests;
+  requests.reserve(m_rpc_requests.size());
+  for (auto&& request : m_rpc_requests) {
+    requests.push_back(request.getSecond());
+  }
+  m_rpc_requests.clear();
+  return requests;
+}
+
+void Storage::CancelRpcCalls() {
+  std::unique_lock lock(m_mutex);
+  auto requests = TakeRpcRequests();
+  lock.unlock();
+  CancelRpcRequests(requests);
 }
 
 void Storage::GetInitialAssignments(
     INetworkConnection& conn, std::vector<std::shared_ptr<Message>>* msgs) {
   std::scoped_lock lock(m_mutex);
   conn.set_state(INetworkConnection::kSynchronized);
+  SyncEntryInfo(conn);
   for (auto& i : m_entries) {
     Entry* entry = i.getValue();
     if (!entry->value) {
@@ -420,6 +622,9 @@ void Storage::ApplyInitialAssignments(
 
   std::vector<std::shared_ptr<Message>> update_msgs;
 
+  // calls from before this connection are never answered on it
+  auto requests = TakeRpcRequests();
+
   // clear existing id's
   for (auto& i : m_entries) {
     i.getValue()->id = 0xffff;
@@ -434,57 +639,169 @@ void Storage::ApplyInitialAssignments(
       DEBUG0("client: received non-entry assignment request?");
       continue;
     }
+    ApplyInitialAssignment(conn, *msg, &update_msgs);
+  }
 
-    unsigned int id = msg->id();
-    if (id == 0xffff) {
-      DEBUG0("client: received entry assignment request?");
+  ResolveUnassignedEntries(out_msgs);
+  SyncEntryInfo(conn);
+  auto dispatcher = m_dispatcher;
+  lock.unlock();
+  CancelRpcRequests(requests);
+  for (auto& msg : update_msgs) {
+    dispatcher->QueueOutgoing(msg, nullptr, nullptr);
+  }
+}
+
+void Storage::GetResumeWatermarks(
+    std::vector<Message::EntryWatermark>* watermarks) const {
+  std::scoped_lock lock(m_mutex);
+  for (auto& i : m_entries) {
+    Entry* entry = i.getValue();
+    // entries written since they were last received from the server are
+    // left out, so the server sends them and they are reconciled
+    if (entry->value && entry->id != 0xffff && !entry->unsynced_write) {
+      watermarks->push_back(
+          {entry->id, entry->seq_num.value(), entry->flags.load()});
+    }
+  }
+}
+
+void Storage::GetResumeAssignments(
+    INetworkConnection& conn,
+    wpi::ArrayRef<Message::EntryWatermark> watermarks,
+    std::vector<std::shared_ptr<Message>>* msgs) {
+  std::scoped_lock lock(m_mutex);
+  conn.set_state(INetworkConnection::kSynchronized);
+  SyncEntryInfo(conn);
+
+  // entries the client already holds in their current state
+  std::vector<bool> current(m_idmap.size(), false);
+  for (auto&& mark : watermarks) {
+    Entry* entry = mark.id < m_idmap.size() ? m_idmap[mark.id] : nullptr;
+    if (!entry || !entry->value) {
+      msgs->emplace_back(Message::EntryDelete(mark.id));
+    } else if (entry->seq_num.value() == mark.seq_num &&
+               entry->flags == mark.flags) {
+      current[mark.id] = true;
+    }
+  }
+
+  for (auto& i : m_entries) {
+    Entry* entry = i.getValue();
+    if (!entry->value ||
+        (entry->id < current.size() && current[entry->id])) {
       continue;
     }
+    msgs->emplace_back(Message::EntryAssign(i.getKey(), entry->id,
+                                            entry->seq_num.value(),
+                                            entry->value, entry->flags));
+  }
+}
 
-    SequenceNumber seq_num(msg->seq_num_uid());
-    wpi::StringRef name = msg->str();
+void Storage::ApplyResumeAssignments(
+    INetworkConnection& conn, wpi::ArrayRef<std::shared_ptr<Message>> msgs,
+    std::vector<std::shared_ptr<Message>>* out_msgs) {
+  std::unique_lock lock(m_mutex);
+  if (m_server) {
+    return;  // should not do this on server
+  }
 
-    Entry* entry = GetOrNew(name);
-    entry->seq_num = seq_num;
-    entry->id = id;
-    if (!entry->value) {
-      // doesn't currently exist
-      entry->value = msg->value();
-      entry->flags = msg->flags();
-      // notify
-      m_notifier.NotifyEntry(entry->local_id, name, entry->value,
-                             NT_NOTIFY_NEW);
+  conn.set_state(INetworkConnection::kSynchronized);
+
+  // calls from before this connection are never answered on it
+  auto requests = TakeRpcRequests();
+
+  // unlike a full resync, ids not mentioned by the server stay assigned
+  std::vector<std::shared_ptr<Message>> update_msgs;
+  for (auto& msg : msgs) {
+    unsigned int id = msg->id();
+    if (msg->Is(Message::kEntryAssign)) {
+      ApplyInitialAssignment(conn, *msg, &update_msgs);
+    } else if (msg->Is(Message::kEntryDelete) && id < m_idmap.size() &&
+               m_idmap[id]) {
+      // unassign; resolved below like an entry missing from a full resync
+      m_idmap[id]->id = 0xffff;
+      m_idmap[id] = nullptr;
+    }
+  }
+
+  ResolveUnassignedEntries(out_msgs);
+  SyncEntryInfo(conn);
+  auto dispatcher = m_dispatcher;
+  lock.unlock();
+  CancelRpcRequests(requests);
+  for (auto& msg : update_msgs) {
+    dispatcher->QueueOutgoing(msg, nullptr, nullptr);
+  }
+}
+
+void Storage::ApplyInitialAssignment(
+    INetworkConnection& conn, const Message& msg,
+    std::vector<std::shared_ptr<Message>>* update_msgs) {
+  unsigned int id = msg.id();
+  if (id == 0xffff) {
+    DEBUG0("client: received entry assignment request?");
+    return;
+  }
+
+  SequenceNumber seq_num(msg.seq_num_uid());
+  wpi::StringRef name = msg.str();
+
+  Entry* entry = GetOrNew(name);
+  if (!entry) {
+    return;
+  }
+  entry->seq_num = seq_num;
+  entry->id = id;
+  if (!entry->value) {
+    // doesn't currently exist
+    entry->SetValue(msg.value());
+    entry->flags = msg.flags();
+    entry->unsynced_write = false;
+    // notify
+    m_notifier.NotifyEntry(entry->local_id, name, entry->value, NT_NOTIFY_NEW);
+  } else {
+    // if we have written the value locally and the value is not persistent,
+    // then we don't update the local value and instead send it back to the
+    // server as an update message
+    if (entry->local_write && !entry->IsPersistent()) {
+      ++entry->seq_num;
+      update_msgs->emplace_back(Message::EntryUpdate(
+          entry->id, entry->seq_num.value(), entry->value));
     } else {
-      // if we have written the value locally and the value is not persistent,
-      // then we don't update the local value and instead send it back to the
-      // server as an update message
-      if (entry->local_write && !entry->IsPersistent()) {
-        ++entry->seq_num;
-        update_msgs.emplace_back(Message::EntryUpdate(
-            entry->id, entry->seq_num.value(), entry->value));
-      } else {
-        entry->value = msg->value();
-        unsigned int notify_flags = NT_NOTIFY_UPDATE;
-        // don't update flags from a <3.0 remote (not part of message)
-        if (conn.proto_rev() >= 0x0300) {
-          if (entry->flags != msg->flags()) {
-            notify_flags |= NT_NOTIFY_FLAGS;
-          }
-          entry->flags = msg->flags();
+      entry->SetValue(msg.value());
+      entry->unsynced_write = false;
+      unsigned int notify_flags = NT_NOTIFY_UPDATE;
+      // don't update flags from a <3.0 remote (not part of message)
+      if (conn.proto_rev() >= 0x0300) {
+        if (entry->flags != msg.flags()) {
+          notify_flags |= NT_NOTIFY_FLAGS;
         }
-        // notify
-        m_notifier.NotifyEntry(entry->local_id, name, entry->value,
-                               notify_flags);
+        entry->flags = msg.flags();
       }
+      // notify
+      m_notifier.NotifyEntry(entry->local_id, name, entry->value,
+                             notify_flags);
     }
+  }
 
-    // save to idmap
-    if (id >= m_idmap.size()) {
-      m_idmap.resize(id + 1);
+  // save to idmap
+  if (id >= m_idmap.size()) {
+    m_idmap.resize(id + 1);
+  }
+  m_idmap[id] = entry;
+}
+
+void Storage::SyncEntryInfo(INetworkConnection& conn) const {
+  for (size_t id = 0; id < m_idmap.size(); ++id) {
+    if (Entry* entry = m_idmap[id]) {
+      conn.SetEntryInfo(id, entry->name, entry->flags);
     }
-    m_idmap[id] = entry;
   }
+}
 
+void Storage::ResolveUnassignedEntries(
+    std::vector<std::shared_ptr<Message>>* out_msgs) {
   // delete or generate assign messages for unassigned local entries
   DeleteAllEntriesImpl(false, [&](Entry* entry) -> bool {
     // was assigned by the server, don't delete
@@ -502,11 +819,6 @@ void Storage::ApplyInitialAssignments(
     // otherwise delete
     return true;
   });
-  auto dispatcher = m_dispatcher;
-  lock.unlock();
-  for (auto& msg : update_msgs) {
-    dispatcher->QueueOutgoing(msg, nullptr, nullptr);
-  }
 }
 
 std::shared_ptr<Value> Storage::GetEntryValue(wpi::StringRef name) const {
@@ -519,11 +831,11 @@ std::shared_ptr<Value> Storage::GetEntryValue(wpi::StringRef name) const {
 }
 
 std::shared_ptr<Value> Storage::GetEntryValue(unsigned int local_id) const {
-  std::scoped_lock lock(m_mutex);
+  // lock-free; see LocalMap and Entry::LoadValue()
   if (local_id >= m_localmap.size()) {
     return nullptr;
   }
-  return m_localmap[local_id]->value;
+  return m_localmap[local_id]->LoadValue();
 }
 
 bool Storage::SetDefaultEntryValue(wpi::StringRef name,
@@ -536,6 +848,9 @@ bool Storage::SetDefaultEntryValue(wpi::StringRef name,
   }
   std::unique_lock lock(m_mutex);
   Entry* entry = GetOrNew(name);
+  if (!entry) {
+    return false;
+  }
 
   // we return early if value already exists; if types match return true
   if (entry->value) {
@@ -575,6 +890,9 @@ bool Storage::SetEntryValue(wpi::StringRef name, std::shared_ptr<Value> value) {
   }
   std::unique_lock lock(m_mutex);
   Entry* entry = GetOrNew(name);
+  if (!entry) {
+    return false;
+  }
 
   if (entry->value && entry->value->type() != value->type()) {
     return false;  // error on type mismatch
@@ -603,14 +921,57 @@ bool Storage::SetEntryValue(unsigned int local_id,
   return true;
 }
 
+bool Storage::SetEntryValues(wpi::ArrayRef<unsigned int> local_ids,
+                             wpi::ArrayRef<std::shared_ptr<Value>> values) {
+  if (local_ids.size() != values.size()) {
+    return false;
+  }
+  std::unique_lock lock(m_mutex);
+
+  // all or nothing: check everything before changing anything.  An id may
+  // appear more than once, so check against the type it will have by then.
+  wpi::SmallDenseMap<unsigned int, NT_Type, 16> types;
+  for (size_t i = 0; i < local_ids.size(); ++i) {
+    if (!values[i] || local_ids[i] >= m_localmap.size()) {
+      return false;
+    }
+    auto& old_value = m_localmap[local_ids[i]]->value;
+    auto type = types
+                    .try_emplace(local_ids[i], old_value ? old_value->type()
+                                                         : values[i]->type())
+                    .first->second;
+    if (type != values[i]->type()) {
+      return false;  // error on type mismatch
+    }
+  }
+
+  // notifications are queued back to back while the lock is held; messages
+  // are collected and queued as a group so they go out in the same flush
+  std::vector<std::shared_ptr<Message>> msgs;
+  for (size_t i = 0; i < local_ids.size(); ++i) {
+    SetEntryValueImpl(m_localmap[local_ids[i]].get(), values[i], lock, true,
+                      &msgs);
+  }
+
+  if (!m_dispatcher || msgs.empty()) {
+    return true;
+  }
+  auto dispatcher = m_dispatcher;
+  lock.unlock();
+  dispatcher->QueueOutgoingGroup(msgs, nullptr, nullptr);
+  return true;
+}
+
 void Storage::SetEntryValueImpl(Entry* entry, std::shared_ptr<Value> value,
-                                std::unique_lock<wpi::mutex>& lock,
-                                bool local) {
+                                std::unique_lock<wpi::mutex>& lock, bool local,
+                                std::vector<std::shared_ptr<Message>>* msgs) {
   if (!value) {
     return;
   }
   auto old_value = entry->value;
-  entry->value = value;
+  // compare the contents once; setting the same value object is no change
+  bool changed = !old_value || (old_value != value && *old_value != *value);
+  entry->SetValue(value);
 
   // if we're the server, assign an id if it doesn't have one
   if (m_server && entry->id == 0xffff) {
@@ -620,7 +981,7 @@ void Storage::SetEntryValueImpl(Entry* entry, std::shared_ptr<Value> value,
   }
 
   // update persistent dirty flag if value changed and it's persistent
-  if (entry->IsPersistent() && (!old_value || *old_value != *value)) {
+  if (entry->IsPersistent() && changed) {
     m_persistent_dirty = true;
   }
 
@@ -628,7 +989,7 @@ void Storage::SetEntryValueImpl(Entry* entry, std::shared_ptr<Value> value,
   if (!old_value) {
     m_notifier.NotifyEntry(entry->local_id, entry->name, value,
                            NT_NOTIFY_NEW | (local ? NT_NOTIFY_LOCAL : 0));
-  } else if (*old_value != *value) {
+  } else if (changed) {
     m_notifier.NotifyEntry(entry->local_id, entry->name, value,
                            NT_NOTIFY_UPDATE | (local ? NT_NOTIFY_LOCAL : 0));
   }
@@ -636,6 +997,9 @@ void Storage::SetEntryValueImpl(Entry* entry, std::shared_ptr<Value> value,
   // remember local changes
   if (local) {
     entry->local_write = true;
+    if (changed) {
+      entry->unsynced_write = true;
+    }
   }
 
   // generate message
@@ -649,15 +1013,23 @@ void Storage::SetEntryValueImpl(Entry* entry, std::shared_ptr<Value> value,
     }
     auto msg = Message::EntryAssign(
         entry->name, entry->id, entry->seq_num.value(), value, entry->flags);
+    if (msgs) {
+      msgs->emplace_back(std::move(msg));
+      return;
+    }
     lock.unlock();
     dispatcher->QueueOutgoing(msg, nullptr, nullptr);
-  } else if (*old_value != *value) {
+  } else if (changed) {
     if (local) {
       ++entry->seq_num;
     }
     // don't send an update if we don't have an assigned id yet
     if (entry->id != 0xffff) {
       auto msg = Message::EntryUpdate(entry->id, entry->seq_num.value(), value);
+      if (msgs) {
+        msgs->emplace_back(std::move(msg));
+        return;
+      }
       lock.unlock();
       dispatcher->QueueOutgoing(msg, nullptr, nullptr);
     }
@@ -674,6 +1046,9 @@ void Storage::SetEntryTypeValue(wpi::StringRef name,
   }
   std::unique_lock lock(m_mutex);
   Entry* entry = GetOrNew(name);
+  if (!entry) {
+    return;
+  }
 
   SetEntryValueImpl(entry, value, lock, true);
 }
@@ -757,7 +1132,7 @@ unsigned int Storage::GetEntryFlags(wpi::StringRef name) const {
 }
 
 unsigned int Storage::GetEntryFlags(unsigned int local_id) const {
-  std::scoped_lock lock(m_mutex);
+  // lock-free; see LocalMap
   if (local_id >= m_localmap.size()) {
     return 0;
   }
@@ -791,8 +1166,8 @@ void Storage::DeleteEntryImpl(Entry* entry, std::unique_lock<wpi::mutex>& lock,
   }
 
   // empty the value and reset id and local_write flag
-  std::shared_ptr<Value> old_value;
-  old_value.swap(entry->value);
+  std::shared_ptr<Value> old_value = entry->value;
+  entry->SetValue(nullptr);
   entry->id = 0xffff;
   entry->local_write = false;
 
@@ -844,7 +1219,7 @@ void Storage::DeleteAllEntriesImpl(bool local, F should_delete) {
       }
       entry->id = 0xffff;
       entry->local_write = false;
-      entry->value.reset();
+      entry->SetValue(nullptr);
       continue;
     }
   }
@@ -878,9 +1253,14 @@ Storage::Entry* Storage::GetOrNew(const wpi::Twine& name) {
   wpi::StringRef nameStr = name.toStringRef(nameBuf);
   auto& entry = m_entries[nameStr];
   if (!entry) {
-    m_localmap.emplace_back(new Entry(nameStr));
-    entry = m_localmap.back().get();
-    entry->local_id = m_localmap.size() - 1;
+    if (m_localmap.full()) {
+      m_entries.erase(nameStr);
+      return nullptr;
+    }
+    entry = new Entry(nameStr);
+    entry->local_id = m_localmap.size();
+    m_localmap.emplace_back(entry);
+    m_path_index.Add(entry);
   }
   return entry;
 }
@@ -891,7 +1271,8 @@ unsigned int Storage::GetEntry(const wpi::Twine& name) {
     return UINT_MAX;
   }
   std::unique_lock lock(m_mutex);
-  return GetOrNew(name)->local_id;
+  Entry* entry = GetOrNew(name);
+  return entry ? entry->local_id : UINT_MAX;
 }
 
 std::vector<unsigned int> Storage::GetEntries(const wpi::Twine& prefix,
@@ -900,17 +1281,13 @@ std::vector<unsigned int> Storage::GetEntries(const wpi::Twine& prefix,
   wpi::StringRef prefixStr = prefix.toStringRef(prefixBuf);
   std::scoped_lock lock(m_mutex);
   std::vector<unsigned int> ids;
-  for (auto& i : m_entries) {
-    Entry* entry = i.getValue();
+  ForEachEntry(prefixStr, [&](Entry* entry) {
     auto value = entry->value.get();
-    if (!value || !i.getKey().startswith(prefixStr)) {
-      continue;
-    }
-    if (types != 0 && (types & value->type()) == 0) {
-      continue;
+    if (!value || (types != 0 && (types & value->type()) == 0)) {
+      return;
     }
     ids.push_back(entry->local_id);
-  }
+  });
   return ids;
 }
 
@@ -939,7 +1316,7 @@ EntryInfo Storage::GetEntryInfo(int inst, unsigned int local_id) const {
 }
 
 std::string Storage::GetEntryName(unsigned int local_id) const {
-  std::unique_lock lock(m_mutex);
+  // lock-free; the name never changes once the entry is created
   if (local_id >= m_localmap.size()) {
     return {};
   }
@@ -947,27 +1324,35 @@ std::string Storage::GetEntryName(unsigned int local_id) const {
 }
 
 NT_Type Storage::GetEntryType(unsigned int local_id) const {
-  std::unique_lock lock(m_mutex);
+  // lock-free; see LocalMap and Entry::LoadValue()
   if (local_id >= m_localmap.size()) {
     return NT_UNASSIGNED;
   }
-  Entry* entry = m_localmap[local_id].get();
-  if (!entry->value) {
+  auto value = m_localmap[local_id]->LoadValue();
+  if (!value) {
     return NT_UNASSIGNED;
   }
-  return entry->value->type();
+  return value->type();
 }
 
 uint64_t Storage::GetEntryLastChange(unsigned int local_id) const {
-  std::unique_lock lock(m_mutex);
+  // lock-free; see LocalMap and Entry::LoadValue()
   if (local_id >= m_localmap.size()) {
     return 0;
   }
-  Entry* entry = m_localmap[local_id].get();
-  if (!entry->value) {
+  auto value = m_localmap[local_id]->LoadValue();
+  if (!value) {
     return 0;
   }
-  return entry->value->last_change();
+  return value->last_change();
+}
+
+uint64_t Storage::GetEntryUpdateCount(unsigned int local_id) const {
+  // lock-free; see LocalMap
+  if (local_id >= m_localmap.size()) {
+    return 0;
+  }
+  return m_localmap[local_id]->update_count.load(std::memory_order_relaxed);
 }
 
 std::vector<EntryInfo> Storage::GetEntryInfo(int inst, const wpi::Twine& prefix,
@@ -976,23 +1361,19 @@ std::vector<EntryInfo> Storage::GetEntryInfo(int inst, const wpi::Twine& prefix,
   wpi::StringRef prefixStr = prefix.toStringRef(prefixBuf);
   std::scoped_lock lock(m_mutex);
   std::vector<EntryInfo> infos;
-  for (auto& i : m_entries) {
-    Entry* entry = i.getValue();
+  ForEachEntry(prefixStr, [&](Entry* entry) {
     auto value = entry->value.get();
-    if (!value || !i.getKey().startswith(prefixStr)) {
-      continue;
-    }
-    if (types != 0 && (types & value->type()) == 0) {
-      continue;
+    if (!value || (types != 0 && (types & value->type()) == 0)) {
+      return;
     }
     EntryInfo info;
     info.entry = Handle(inst, entry->local_id, Handle::kEntry);
-    info.name = i.getKey();
+    info.name = entry->name;
     info.type = value->type();
     info.flags = entry->flags;
     info.last_change = value->last_change();
     infos.push_back(std::move(info));
-  }
+  });
   return infos;
 }
 
@@ -1006,14 +1387,12 @@ unsigned int Storage::AddListener(
   unsigned int uid = m_notifier.Add(callback, prefixStr, flags);
   // perform immediate notifications
   if ((flags & NT_NOTIFY_IMMEDIATE) != 0 && (flags & NT_NOTIFY_NEW) != 0) {
-    for (auto& i : m_entries) {
-      Entry* entry = i.getValue();
-      if (!entry->value || !i.getKey().startswith(prefixStr)) {
-        continue;
+    ForEachEntry(prefixStr, [&](Entry* entry) {
+      if (entry->value) {
+        m_notifier.NotifyEntry(entry->local_id, entry->name, entry->value,
+                               NT_NOTIFY_IMMEDIATE | NT_NOTIFY_NEW, uid);
       }
-      m_notifier.NotifyEntry(entry->local_id, i.getKey(), entry->value,
-                             NT_NOTIFY_IMMEDIATE | NT_NOTIFY_NEW, uid);
-    }
+    });
   }
   return uid;
 }
@@ -1045,17 +1424,12 @@ unsigned int Storage::AddPolledListener(unsigned int poller,
   unsigned int uid = m_notifier.AddPolled(poller, prefixStr, flags);
   // perform immediate notifications
   if ((flags & NT_NOTIFY_IMMEDIATE) != 0 && (flags & NT_NOTIFY_NEW) != 0) {
-    for (auto& i : m_entries) {
-      if (!i.getKey().startswith(prefixStr)) {
-        continue;
+    ForEachEntry(prefixStr, [&](Entry* entry) {
+      if (entry->value) {
+        m_notifier.NotifyEntry(entry->local_id, entry->name, entry->value,
+                               NT_NOTIFY_IMMEDIATE | NT_NOTIFY_NEW, uid);
       }
-      Entry* entry = i.getValue();
-      if (!entry->value) {
-        continue;
-      }
-      m_notifier.NotifyEntry(entry->local_id, i.getKey(), entry->value,
-                             NT_NOTIFY_IMMEDIATE | NT_NOTIFY_NEW, uid);
-    }
+    });
   }
   return uid;
 }
@@ -1119,15 +1493,12 @@ bool Storage::GetEntries(
   // copy values out of storage as quickly as possible so lock isn't held
   {
     std::scoped_lock lock(m_mutex);
-    entries->reserve(m_entries.size());
-    for (auto& i : m_entries) {
-      Entry* entry = i.getValue();
-      // only write values with given prefix
-      if (!entry->value || !i.getKey().startswith(prefixStr)) {
-        continue;
+    // only write values with given prefix
+    ForEachEntry(prefixStr, [&](Entry* entry) {
+      if (entry->value) {
+        entries->emplace_back(entry->name, entry->value);
       }
-      entries->emplace_back(i.getKey(), entry->value);
-    }
+    });
   }
 
   // sort in name order
@@ -1149,7 +1520,7 @@ void Storage::CreateRpc(unsigned int local_id, wpi::StringRef def,
 
   auto old_value = entry->value;
   auto value = Value::MakeRpc(def);
-  entry->value = value;
+  entry->SetValue(value);
 
   // set up the RPC info
   entry->rpc_uid = rpc_uid;
@@ -1185,6 +1556,22 @@ void Storage::CreateRpc(unsigned int local_id, wpi::StringRef def,
 }
 
 unsigned int Storage::CallRpc(unsigned int local_id, wpi::StringRef params) {
+  return CallRpcImpl(local_id, params, 0);
+}
+
+wpi::future<std::string> Storage::CallRpcAsync(unsigned int local_id,
+                                               wpi::StringRef params) {
+  auto& promises = wpi::PromiseFactory<std::string>::GetInstance();
+  uint64_t request = promises.CreateRequest();
+  auto future = promises.CreateFuture(request);
+  if (CallRpcImpl(local_id, params, request) == 0) {
+    promises.SetValue(request, std::string{});
+  }
+  return future;
+}
+
+unsigned int Storage::CallRpcImpl(unsigned int local_id, wpi::StringRef params,
+                                  uint64_t request) {
   std::unique_lock lock(m_mutex);
   if (local_id >= m_localmap.size()) {
     return 0;
@@ -1195,11 +1582,28 @@ unsigned int Storage::CallRpc(unsigned int local_id, wpi::StringRef params) {
     return 0;
   }
 
-  ++entry->rpc_call_uid;
-  if (entry->rpc_call_uid > 0xffff) {
-    entry->rpc_call_uid = 0;
+  // call uids run from 1 to 0xffff, as 0 means the call failed.  Skip
+  // those that an async call is still waiting on; if every one is, the
+  // oldest waiting call is given up on rather than getting this call's
+  // result
+  unsigned int first_uid = entry->rpc_call_uid % 0xffff + 1;
+  unsigned int call_uid = first_uid;
+  while (m_rpc_requests.count(RpcIdPair{local_id, call_uid}) != 0) {
+    call_uid = call_uid % 0xffff + 1;
+    if (call_uid == first_uid) {
+      break;
+    }
+  }
+  entry->rpc_call_uid = call_uid;
+  uint64_t stale_request = 0;
+  auto i = m_rpc_requests.find(RpcIdPair{local_id, call_uid});
+  if (i != m_rpc_requests.end()) {
+    stale_request = i->getSecond();
+    m_rpc_requests.erase(i);
+  }
+  if (request != 0) {
+    m_rpc_requests[RpcIdPair{local_id, call_uid}] = request;
   }
-  unsigned int call_uid = entry->rpc_call_uid;
 
   auto msg = Message::ExecuteRpc(entry->id, call_uid, params);
   wpi::StringRef name{entry->name};
@@ -1209,6 +1613,9 @@ unsigned int Storage::CallRpc(unsigned int local_id, wpi::StringRef params) {
     // gracefully anyway.
     auto rpc_uid = entry->rpc_uid;
     lock.unlock();
+    if (stale_request != 0) {
+      CancelRpcRequests(stale_request);
+    }
     ConnectionInfo conn_info;
     conn_info.remote_id = "Server";
     conn_info.remote_ip = "localhost";
@@ -1219,16 +1626,18 @@ unsigned int Storage::CallRpc(unsigned int local_id, wpi::StringRef params) {
     m_rpc_server.ProcessRpc(
         local_id, call_uid, name, msg->str(), conn_info,
         [=](wpi::StringRef result) {
-          std::scoped_lock lock(m_mutex);
-          m_rpc_results.insert(
-              std::make_pair(RpcIdPair{local_id, call_uid}, result));
-          m_rpc_results_cond.notify_all();
+          std::unique_lock lock(m_mutex);
+          SetRpcResult(lock, RpcIdPair{local_id, call_uid}, result);
         },
         rpc_uid);
   } else {
     auto dispatcher = m_dispatcher;
     lock.unlock();
+    if (stale_request != 0) {
+      CancelRpcRequests(stale_request);
+    }
     dispatcher->QueueOutgoing(msg, nullptr, nullptr);
+    dispatcher->FlushSoon();
   }
   return call_uid;
 }
@@ -16,9 +16,11 @@
 #include <vector>
 
 #include <wpi/DenseMap.h>
+#include <wpi/STLExtras.h>
 #include <wpi/SmallSet.h>
 #include <wpi/StringMap.h>
 #include <wpi/condition_variable.h>
+#include <wpi/future.h>
 #include <wpi/mutex.h>
 
 #include "IStorage.h"
@@ -69,6 +71,16 @@ class Storage : public IStorage {
       INetworkConnection& conn, wpi::ArrayRef<std::shared_ptr<Message>> msgs,
       bool new_server,
       std::vector<std::shared_ptr<Message>>* out_msgs) override;
+  void GetResumeWatermarks(
+      std::vector<Message::EntryWatermark>* watermarks) const override;
+  void GetResumeAssignments(
+      INetworkConnection& conn,
+      wpi::ArrayRef<Message::EntryWatermark> watermarks,
+      std::vector<std::shared_ptr<Message>>* msgs) override;
+  void ApplyResumeAssignments(
+      INetworkConnection& conn, wpi::ArrayRef<std::shared_ptr<Message>> msgs,
+      std::vector<std::shared_ptr<Message>>* out_msgs) override;
+  void CancelRpcCalls() override;
 
   // User functions.  These are the actual implementations of the corresponding
   // user API functions in ntcore_cpp.
@@ -79,8 +91,11 @@ class Storage : public IStorage {
   bool SetDefaultEntryValue(unsigned int local_id,
                             std::shared_ptr<Value> value);
 
-  bool SetEntryValue(wpi::StringRef name, std::shared_ptr<Value> value);
+  bool SetEntryValue(wpi::StringRef name,
+                     std::shared_ptr<Value> value) override;
   bool SetEntryValue(unsigned int local_id, std::shared_ptr<Value> value);
+  bool SetEntryValues(wpi::ArrayRef<unsigned int> local_ids,
+                      wpi::ArrayRef<std::shared_ptr<Value>> values);
 
   void SetEntryTypeValue(wpi::StringRef name, std::shared_ptr<Value> value);
   void SetEntryTypeValue(unsigned int local_id, std::shared_ptr<Value> value);
@@ -91,7 +106,7 @@ class Storage : public IStorage {
   unsigned int GetEntryFlags(wpi::StringRef name) const;
   unsigned int GetEntryFlags(unsigned int local_id) const;
 
-  void DeleteEntry(wpi::StringRef name);
+  void DeleteEntry(wpi::StringRef name) override;
   void DeleteEntry(unsigned int local_id);
 
   void DeleteAllEntries();
@@ -122,6 +137,7 @@ class Storage : public IStorage {
   std::string GetEntryName(unsigned int local_id) const;
   NT_Type GetEntryType(unsigned int local_id) const;
   uint64_t GetEntryLastChange(unsigned int local_id) const;
+  uint64_t GetEntryUpdateCount(unsigned int local_id) const;
 
   // Filename-based save/load functions.  Used both by periodic saves and
   // accessible directly via the user API.
@@ -146,11 +162,25 @@ class Storage : public IStorage {
 
   void SaveEntries(wpi::raw_ostream& os, const wpi::Twine& prefix) const;
 
+  // Binary persistent format file header and record types.
+  static constexpr char kBinaryHeader[] = "NTPB\x01";
+  enum BinaryRecordType { kBinarySet = 1, kBinaryDelete = 2 };
+
+  // Binary format equivalents of the stream-based functions (exposed for
+  // testing purposes).  The filename-based functions use the binary format
+  // when saving to a filename ending in ".bin", and detect it when loading.
+  void SavePersistentBinary(wpi::raw_ostream& os) const;
+  bool LoadEntriesBinary(
+      wpi::StringRef data, const wpi::Twine& prefix, bool persistent,
+      std::function<void(size_t line, const char* msg)> warn);
+
   // RPC configuration needs to come through here as RPC definitions are
   // actually special Storage value types.
   void CreateRpc(unsigned int local_id, wpi::StringRef def,
                  unsigned int rpc_uid);
   unsigned int CallRpc(unsigned int local_id, wpi::StringRef params);
+  wpi::future<std::string> CallRpcAsync(unsigned int local_id,
+                                        wpi::StringRef params);
   bool GetRpcResult(unsigned int local_id, unsigned int call_uid,
                     std::string* result);
   bool GetRpcResult(unsigned int local_id, unsigned int call_uid,
@@ -163,13 +193,28 @@ class Storage : public IStorage {
     explicit Entry(wpi::StringRef name_) : name(name_) {}
     bool IsPersistent() const { return (flags & NT_PERSISTENT) != 0; }
 
+    // The value may be read without m_mutex held, but only via LoadValue().
+    // Changes (always made with m_mutex held) must go through SetValue().
+    std::shared_ptr<Value> LoadValue() const {
+      return std::atomic_load(&value);
+    }
+    void SetValue(std::shared_ptr<Value> value_) {
+      if (value_) {
+        update_count.fetch_add(1, std::memory_order_relaxed);
+      }
+      std::atomic_store(&value, std::move(value_));
+    }
+
     // We redundantly store the name so that it's available when accessing the
-    // raw Entry* via the ID map.
+    // raw Entry* via the ID map.  Never changes after construction.
     std::string name;
 
     // The current value and flags.
     std::shared_ptr<Value> value;
-    unsigned int flags{0};
+    std::atomic<unsigned int> flags{0};
+
+    // Number of values set (locally or remotely); read without m_mutex.
+    std::atomic<uint64_t> update_count{0};
 
     // Unique ID for this entry as used in network messages.  The value is
     // assigned by the server, so on the client this is 0xffff until an
@@ -186,6 +231,12 @@ class Storage : public IStorage {
     // on client to determine whether or not to accept remote changes.
     bool local_write{false};
 
+    // If value has been written locally since it was last received from the
+    // remote.  A client leaves such entries out of its session resume
+    // watermarks: the server may have moved to the same sequence number
+    // with a different value, so it must resend them to be reconciled.
+    bool unsynced_write{false};
+
     // RPC handle.
     unsigned int rpc_uid{UINT_MAX};
 
@@ -194,22 +245,94 @@ class Storage : public IStorage {
     unsigned int rpc_call_uid{0};
   };
 
+  /* Append-only map from local id to entry.  Entries are stored in
+   * fixed-size chunks that never move, so lookups by local id (e.g. value
+   * reads) may be done without holding m_mutex; appends require m_mutex.
+   */
+  class LocalMap {
+   public:
+    static constexpr size_t kChunkSize = 1024;
+    // local ids are limited by the handle index size
+    static constexpr size_t kMaxChunks = (1u << 20) / kChunkSize;
+    static constexpr size_t kMaxSize = kMaxChunks * kChunkSize;
+
+    LocalMap() = default;
+    LocalMap(const LocalMap&) = delete;
+    LocalMap& operator=(const LocalMap&) = delete;
+    ~LocalMap();
+
+    size_t size() const { return m_size.load(std::memory_order_acquire); }
+    const std::unique_ptr<Entry>& operator[](size_t i) const {
+      return m_chunks[i / kChunkSize].load(
+          std::memory_order_acquire)[i % kChunkSize];
+    }
+    const std::unique_ptr<Entry>& back() const { return (*this)[size() - 1]; }
+    bool full() const { return size() >= kMaxSize; }
+
+    // Must be called with m_mutex held, and only if not full()
+    void emplace_back(Entry* entry);
+
+   private:
+    std::atomic<std::unique_ptr<Entry>*> m_chunks[kMaxChunks] = {};
+    std::atomic<size_t> m_size{0};
+  };
+
+  /* Index of entries by path segment.  Names are split after each '/'
+   * (e.g. "/a/b" is "/", "a/", "b"), so a prefix query only descends the
+   * segments of the prefix and then visits the matching subtrees, instead
+   * of comparing the prefix against every name.  Entries are never removed
+   * from m_entries, so nodes are never removed either.  Must be used with
+   * m_mutex held.
+   */
+  class PathIndex {
+   public:
+    void Add(Entry* entry);
+
+    // Calls func for every entry whose name starts with prefix
+    void ForEachPrefix(wpi::StringRef prefix,
+                       wpi::function_ref<void(Entry*)> func) const;
+
+   private:
+    struct Node {
+      Entry* entry = nullptr;
+      wpi::StringMap<std::unique_ptr<Node>> children;
+    };
+
+    static void ForEach(const Node& node,
+                        wpi::function_ref<void(Entry*)> func);
+
+    Node m_root;
+  };
+
   typedef wpi::StringMap<Entry*> EntriesMap;
   using IdMap = std::vector<Entry*>;
-  using LocalMap = std::vector<std::unique_ptr<Entry>>;
   using RpcIdPair = std::pair<unsigned int, unsigned int>;
   using RpcResultMap = wpi::DenseMap<RpcIdPair, std::string>;
   using RpcBlockingCallSet = wpi::SmallSet<RpcIdPair, 12>;
+  using RpcRequestMap = wpi::DenseMap<RpcIdPair, uint64_t>;
 
   mutable wpi::mutex m_mutex;
   EntriesMap m_entries;
+  PathIndex m_path_index;
   IdMap m_idmap;
   LocalMap m_localmap;
   RpcResultMap m_rpc_results;
   RpcBlockingCallSet m_rpc_blocking_calls;
+  // Outstanding async calls; results go to these promise requests (of
+  // wpi::PromiseFactory<std::string>::GetInstance()) instead of the map
+  RpcRequestMap m_rpc_requests;
   // If any persistent values have changed
   mutable bool m_persistent_dirty = false;
 
+  // Binary persistent file journal state.  Periodic saves to a binary file
+  // append records for only the entries that changed since the last save
+  // (as recorded in m_journal_saved), and rewrite the whole file once the
+  // journal grows larger than the number of live entries.
+  mutable wpi::mutex m_journal_mutex;
+  mutable std::string m_journal_filename;
+  mutable wpi::StringMap<std::shared_ptr<Value>> m_journal_saved;
+  mutable size_t m_journal_records = 0;
+
   // condition variable and termination flag for blocking on a RPC result
   std::atomic_bool m_terminating;
   wpi::condition_variable m_rpc_results_cond;
@@ -222,10 +345,26 @@ class Storage : public IStorage {
   IRpcServer& m_rpc_server;
   wpi::Logger& m_logger;
 
+  // Calls func for every entry whose name starts with prefix
+  void ForEachEntry(wpi::StringRef prefix,
+                    wpi::function_ref<void(Entry*)> func) const;
+
+  // Starts a call; request is the promise request for an async call, or 0
+  unsigned int CallRpcImpl(unsigned int local_id, wpi::StringRef params,
+                           uint64_t request);
+  // Stores a call result for GetRpcResult() or its async caller
+  void SetRpcResult(std::unique_lock<wpi::mutex>& lock, RpcIdPair call_pair,
+                    wpi::StringRef result);
+  // Removes all async calls waiting for a result; they must be completed
+  // with CancelRpcRequests() after m_mutex is released
+  std::vector<uint64_t> TakeRpcRequests();
+
   void ProcessIncomingEntryAssign(std::shared_ptr<Message> msg,
                                   INetworkConnection* conn);
   void ProcessIncomingEntryUpdate(std::shared_ptr<Message> msg,
                                   INetworkConnection* conn);
+  void ProcessIncomingEntryHistory(std::shared_ptr<Message> msg,
+                                   INetworkConnection* conn);
   void ProcessIncomingFlagsUpdate(std::shared_ptr<Message> msg,
                                   INetworkConnection* conn);
   void ProcessIncomingEntryDelete(std::shared_ptr<Message> msg,
@@ -245,17 +384,39 @@ class Storage : public IStorage {
   bool GetEntries(const wpi::Twine& prefix,
                   std::vector<std::pair<std::string, std::shared_ptr<Value>>>*
                       entries) const;
+  void ApplyLoadedEntries(
+      wpi::ArrayRef<std::pair<std::string, std::shared_ptr<Value>>> entries,
+      bool persistent);
+  const char* SavePersistentBinary(wpi::StringRef filename,
+                                   bool periodic) const;
+  const char* SaveEntriesBinary(
+      wpi::StringRef filename,
+      wpi::ArrayRef<std::pair<std::string, std::shared_ptr<Value>>> entries)
+      const;
+  // If msgs is non-null, outgoing messages are appended to it rather than
+  // being queued, and the lock is not released.
   void SetEntryValueImpl(Entry* entry, std::shared_ptr<Value> value,
-                         std::unique_lock<wpi::mutex>& lock, bool local);
+                         std::unique_lock<wpi::mutex>& lock, bool local,
+                         std::vector<std::shared_ptr<Message>>* msgs = nullptr);
   void SetEntryFlagsImpl(Entry* entry, unsigned int flags,
                          std::unique_lock<wpi::mutex>& lock, bool local);
   void DeleteEntryImpl(Entry* entry, std::unique_lock<wpi::mutex>& lock,
                        bool local);
 
+  // Must be called with m_mutex held
+  void ApplyInitialAssignment(
+      INetworkConnection& conn, const Message& msg,
+      std::vector<std::shared_ptr<Message>>* update_msgs);
+  void ResolveUnassignedEntries(
+      std::vector<std::shared_ptr<Message>>* out_msgs);
+  void SyncEntryInfo(INetworkConnection& conn) const;
+
   // Must be called with m_mutex held
   template <typename F>
   void DeleteAllEntriesImpl(bool local, F should_delete);
   void DeleteAllEntriesImpl(bool local);
+  // Returns nullptr if the entry doesn't exist and there are too many
+  // entries to create it
   Entry* GetOrNew(const wpi::Twine& name);
 };
 
@@ -2,11 +2,21 @@
 // Open Source Software; you can modify and/or share it under the terms of
 // the WPILib BSD license file in the root directory of this project.
 
+#define _CRT_NONSTDC_NO_WARNINGS
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+#include <algorithm>
 #include <cctype>
 #include <string>
 #include <utility>
 
 #include <wpi/Base64.h>
+#include <wpi/FileSystem.h>
 #include <wpi/SmallString.h>
 #include <wpi/StringExtras.h>
 #include <wpi/raw_istream.h>
@@ -14,6 +24,7 @@
 #include "IDispatcher.h"
 #include "IEntryNotifier.h"
 #include "Storage.h"
+#include "WireDecoder.h"
 
 using namespace nt;
 
@@ -63,6 +74,258 @@ class LoadPersistentImpl {
 
 }  // namespace
 
+namespace {
+
+/* Loads the binary persistent format (see Storage_save.cpp) directly from
+ * memory.  Records are replayed in order, so later records (appended by
+ * periodic saves) override earlier ones.
+ */
+class LoadBinaryImpl {
+ public:
+  typedef std::pair<std::string, std::shared_ptr<Value>> Entry;
+  using WarnFunc = std::function<void(size_t, const char*)>;
+
+  LoadBinaryImpl(wpi::StringRef data, wpi::Logger& logger, WarnFunc warn)
+      : m_is(data.data(), data.size()),
+        m_decoder(m_is, 0x0300, logger),
+        m_warn(std::move(warn)) {}
+
+  bool Load(wpi::StringRef prefix, std::vector<Entry>* entries,
+            size_t* records = nullptr);
+
+  // True if Load() stopped at a truncated record
+  bool truncated() const { return m_truncated; }
+
+ private:
+  bool ReadRecord(wpi::StringRef prefix,
+                  wpi::StringMap<std::shared_ptr<Value>>* state);
+  std::shared_ptr<Value> ReadValue(NT_Type type);
+
+  void Warn(const char* msg) {
+    if (m_warn) {
+      m_warn(m_record_num, msg);
+    }
+  }
+
+  wpi::raw_mem_istream m_is;
+  WireDecoder m_decoder;
+  WarnFunc m_warn;
+  size_t m_record_num = 0;
+  bool m_truncated = false;
+
+  std::vector<int> m_buf_boolean_array;
+  std::vector<double> m_buf_double_array;
+  std::vector<std::string> m_buf_string_array;
+};
+
+/* Read-only memory mapping of a whole file.  data() is empty if the file
+ * could not be opened or mapped.
+ */
+class MappedFile {
+ public:
+  explicit MappedFile(const wpi::Twine& filename);
+
+  wpi::StringRef data() const {
+    return m_region ? wpi::StringRef(m_region->const_data(), m_region->size())
+                    : wpi::StringRef{};
+  }
+
+  bool IsBinary() const {
+    return data().startswith(wpi::StringRef(
+        Storage::kBinaryHeader, sizeof(Storage::kBinaryHeader) - 1));
+  }
+
+ private:
+  std::unique_ptr<wpi::sys::fs::mapped_file_region> m_region;
+};
+
+}  // namespace
+
+MappedFile::MappedFile(const wpi::Twine& filename) {
+  int fd;
+  if (wpi::sys::fs::openFileForRead(filename, fd)) {
+    return;
+  }
+  wpi::sys::fs::file_status status;
+  if (!wpi::sys::fs::status(fd, status) && status.getSize() > 0) {
+    std::error_code ec;
+    auto region = std::make_unique<wpi::sys::fs::mapped_file_region>(
+        fd, wpi::sys::fs::mapped_file_region::readonly, status.getSize(), 0,
+        ec);
+    if (!ec) {
+      m_region = std::move(region);
+    }
+  }
+  // the mapping stays valid after the descriptor is closed
+  ::close(fd);
+}
+
+bool LoadBinaryImpl::Load(wpi::StringRef prefix, std::vector<Entry>* entries,
+                          size_t* records) {
+  const char* header;
+  if (!m_decoder.Read(&header, sizeof(Storage::kBinaryHeader) - 1) ||
+      wpi::StringRef(header, sizeof(Storage::kBinaryHeader) - 1) !=
+          wpi::StringRef(Storage::kBinaryHeader,
+                         sizeof(Storage::kBinaryHeader) - 1)) {
+    Warn("header line mismatch, ignoring rest of file");
+    return false;
+  }
+
+  wpi::StringMap<std::shared_ptr<Value>> state;
+  while (m_is.in_avail() > 0) {
+    ++m_record_num;
+    if (!ReadRecord(prefix, &state)) {
+      break;
+    }
+  }
+  if (records) {
+    *records = m_record_num;
+  }
+
+  entries->reserve(state.size());
+  for (auto& i : state) {
+    entries->emplace_back(i.getKey(), std::move(i.getValue()));
+  }
+  // sort in name order, to match the order they were saved in
+  std::sort(entries->begin(), entries->end(),
+            [](const Entry& a, const Entry& b) { return a.first < b.first; });
+  return true;
+}
+
+bool LoadBinaryImpl::ReadRecord(
+    wpi::StringRef prefix, wpi::StringMap<std::shared_ptr<Value>>* state) {
+  // length
+  uint32_t len;
+  if (!m_decoder.Read32(&len) || len > m_is.in_avail()) {
+    // most likely a save was interrupted partway through appending
+    Warn("truncated record, ignoring rest of file");
+    m_truncated = true;
+    return false;
+  }
+  size_t end = m_is.in_avail() - len;
+
+  unsigned int kind = 0;
+  std::string name;
+  std::shared_ptr<Value> value;
+  m_decoder.Reset();
+  if (!m_decoder.Read8(&kind) || !m_decoder.ReadString(&name)) {
+    Warn("invalid record");
+  } else if (kind == Storage::kBinarySet) {
+    NT_Type type;
+    if (m_decoder.ReadType(&type)) {
+      value = ReadValue(type);
+    }
+    if (!value) {
+      Warn("invalid value");
+    }
+  } else if (kind != Storage::kBinaryDelete) {
+    Warn("unrecognized record type");
+  }
+
+  // a record that decoded to the wrong length is corrupt
+  if (m_is.in_avail() < end) {
+    Warn("record overruns its length, ignoring rest of file");
+    return false;
+  }
+  if (m_is.in_avail() > end) {
+    const char* skip;
+    m_decoder.Read(&skip, m_is.in_avail() - end);
+    if (value) {
+      Warn("record has trailing data");
+    }
+  }
+
+  if (name.empty() || !wpi::StringRef(name).startswith(prefix)) {
+    return true;
+  }
+  if (kind == Storage::kBinaryDelete) {
+    state->erase(name);
+  } else if (value) {
+    (*state)[name] = std::move(value);
+  }
+  return true;
+}
+
+std::shared_ptr<Value> LoadBinaryImpl::ReadValue(NT_Type type) {
+  // array lengths are ULEB128 encoded so that arrays longer than the wire
+  // protocol's 255 element limit are saved in full
+  uint64_t size;
+  switch (type) {
+    case NT_BOOLEAN: {
+      unsigned int v;
+      if (!m_decoder.Read8(&v)) {
+        return nullptr;
+      }
+      return Value::MakeBoolean(v != 0);
+    }
+    case NT_DOUBLE: {
+      double v;
+      if (!m_decoder.ReadDouble(&v)) {
+        return nullptr;
+      }
+      return Value::MakeDouble(v);
+    }
+    case NT_STRING: {
+      std::string v;
+      if (!m_decoder.ReadString(&v)) {
+        return nullptr;
+      }
+      return Value::MakeString(std::move(v));
+    }
+    case NT_RAW: {
+      std::string v;
+      if (!m_decoder.ReadString(&v)) {
+        return nullptr;
+      }
+      return Value::MakeRaw(std::move(v));
+    }
+    case NT_BOOLEAN_ARRAY: {
+      if (!m_decoder.ReadUleb128(&size) || size > m_is.in_avail()) {
+        return nullptr;
+      }
+      m_buf_boolean_array.clear();
+      for (uint64_t i = 0; i < size; ++i) {
+        unsigned int v;
+        if (!m_decoder.Read8(&v)) {
+          return nullptr;
+        }
+        m_buf_boolean_array.push_back(v != 0);
+      }
+      return Value::MakeBooleanArray(std::move(m_buf_boolean_array));
+    }
+    case NT_DOUBLE_ARRAY: {
+      if (!m_decoder.ReadUleb128(&size) || size > m_is.in_avail() / 8) {
+        return nullptr;
+      }
+      m_buf_double_array.clear();
+      for (uint64_t i = 0; i < size; ++i) {
+        double v;
+        if (!m_decoder.ReadDouble(&v)) {
+          return nullptr;
+        }
+        m_buf_double_array.push_back(v);
+      }
+      return Value::MakeDoubleArray(std::move(m_buf_double_array));
+    }
+    case NT_STRING_ARRAY: {
+      if (!m_decoder.ReadUleb128(&size) || size > m_is.in_avail()) {
+        return nullptr;
+      }
+      m_buf_string_array.clear();
+      for (uint64_t i = 0; i < size; ++i) {
+        std::string v;
+        if (!m_decoder.ReadString(&v)) {
+          return nullptr;
+        }
+        m_buf_string_array.push_back(std::move(v));
+      }
+      return Value::MakeStringArray(std::move(m_buf_string_array));
+    }
+    default:
+      return nullptr;
+  }
+}
+
 /* Extracts an escaped string token.  Does not unescape the string.
  * If a string cannot be matched, an empty string is returned.
  * If the string is unterminated, an empty tail string is returned.
@@ -387,13 +650,41 @@ bool Storage::LoadEntries(
     return false;
   }
 
+  ApplyLoadedEntries(entries, persistent);
+  return true;
+}
+
+bool Storage::LoadEntriesBinary(
+    wpi::StringRef data, const wpi::Twine& prefix, bool persistent,
+    std::function<void(size_t line, const char* msg)> warn) {
+  wpi::SmallString<128> prefixBuf;
+  wpi::StringRef prefixStr = prefix.toStringRef(prefixBuf);
+
+  // entries to add
+  std::vector<LoadBinaryImpl::Entry> entries;
+
+  // load file
+  if (!LoadBinaryImpl(data, m_logger, warn).Load(prefixStr, &entries)) {
+    return false;
+  }
+
+  ApplyLoadedEntries(entries, persistent);
+  return true;
+}
+
+void Storage::ApplyLoadedEntries(
+    wpi::ArrayRef<std::pair<std::string, std::shared_ptr<Value>>> entries,
+    bool persistent) {
   // copy values into storage as quickly as possible so lock isn't held
   std::vector<std::shared_ptr<Message>> msgs;
   std::unique_lock lock(m_mutex);
   for (auto& i : entries) {
     Entry* entry = GetOrNew(i.first);
+    if (!entry) {
+      continue;
+    }
     auto old_value = entry->value;
-    entry->value = i.second;
+    entry->SetValue(i.second);
     bool was_persist = entry->IsPersistent();
     if (!was_persist && persistent) {
       entry->flags |= NT_PERSISTENT;
@@ -452,13 +743,38 @@ bool Storage::LoadEntries(
       dispatcher->QueueOutgoing(std::move(msg), nullptr, nullptr);
     }
   }
-
-  return true;
 }
 
 const char* Storage::LoadPersistent(
     const wpi::Twine& filename,
     std::function<void(size_t line, const char* msg)> warn) {
+  MappedFile file(filename);
+  if (file.IsBinary()) {
+    std::vector<LoadBinaryImpl::Entry> entries;
+    size_t records = 0;
+    LoadBinaryImpl impl(file.data(), m_logger, warn);
+    if (!impl.Load("", &entries, &records)) {
+      return "error reading file";
+    }
+    ApplyLoadedEntries(entries, true);
+
+    // periodic saves can append to this file, unless it ends with a torn
+    // record: anything appended after that would be ignored when loading,
+    // so the next save must write a full snapshot instead
+    std::scoped_lock lock(m_journal_mutex);
+    if (impl.truncated()) {
+      m_journal_filename.clear();
+      return nullptr;
+    }
+    m_journal_filename = filename.str();
+    m_journal_saved.clear();
+    for (auto& entry : entries) {
+      m_journal_saved[entry.first] = entry.second;
+    }
+    m_journal_records = records - entries.size();
+    return nullptr;
+  }
+
   std::error_code ec;
   wpi::raw_fd_istream is(filename, ec);
   if (ec.value() != 0) {
@@ -473,6 +789,14 @@ const char* Storage::LoadPersistent(
 const char* Storage::LoadEntries(
     const wpi::Twine& filename, const wpi::Twine& prefix,
     std::function<void(size_t line, const char* msg)> warn) {
+  MappedFile file(filename);
+  if (file.IsBinary()) {
+    if (!LoadEntriesBinary(file.data(), prefix, false, warn)) {
+      return "error reading file";
+    }
+    return nullptr;
+  }
+
   std::error_code ec;
   wpi::raw_fd_istream is(filename, ec);
   if (ec.value() != 0) {
@@ -2,6 +2,7 @@
 // Open Source Software; you can modify and/or share it under the terms of
 // the WPILib BSD license file in the root directory of this project.
 
+#include <algorithm>
 #include <cctype>
 #include <string>
 
@@ -14,6 +15,7 @@
 
 #include "Log.h"
 #include "Storage.h"
+#include "WireEncoder.h"
 
 using namespace nt;
 
@@ -38,6 +40,37 @@ class SavePersistentImpl {
   wpi::raw_ostream& m_os;
 };
 
+/* Writes the binary persistent format.  The file starts with
+ * Storage::kBinaryHeader, followed by records:
+ *   4-byte record length (big endian), not including the length itself
+ *   1-byte record type (Storage::BinaryRecordType)
+ *   entry name (wire protocol 3.0 string)
+ *   for kBinarySet: value type and value (wire protocol 3.0 encoding, except
+ *   array lengths are ULEB128 so long arrays aren't truncated)
+ * A snapshot is the header and a set record per entry; periodic saves append
+ * set and delete records for changed entries.  The length prefix lets a
+ * loader skip records it can't decode and detect an interrupted append.
+ */
+class SaveBinaryImpl {
+ public:
+  typedef std::pair<std::string, std::shared_ptr<Value>> Entry;
+
+  explicit SaveBinaryImpl(wpi::raw_ostream& os) : m_os(os), m_enc(0x0300) {}
+
+  void Save(wpi::ArrayRef<Entry> entries);
+
+  void WriteHeader();
+  bool WriteSet(wpi::StringRef name, const Value& value);
+  void WriteDelete(wpi::StringRef name);
+
+ private:
+  bool WriteValue(const Value& value);
+  void WriteRecord();
+
+  wpi::raw_ostream& m_os;
+  WireEncoder m_enc;
+};
+
 }  // namespace
 
 /* Escapes and writes a string, including start and end double quotes */
@@ -182,6 +215,89 @@ void SavePersistentImpl::WriteValue(const Value& value) {
   }
 }
 
+void SaveBinaryImpl::Save(wpi::ArrayRef<Entry> entries) {
+  WriteHeader();
+  for (auto& i : entries) {
+    if (i.second) {
+      WriteSet(i.first, *i.second);
+    }
+  }
+}
+
+void SaveBinaryImpl::WriteHeader() {
+  m_os << wpi::StringRef(Storage::kBinaryHeader,
+                         sizeof(Storage::kBinaryHeader) - 1);
+}
+
+bool SaveBinaryImpl::WriteSet(wpi::StringRef name, const Value& value) {
+  m_enc.Reset();
+  m_enc.Write8(Storage::kBinarySet);
+  m_enc.WriteString(name);
+  if (!WriteValue(value)) {
+    return false;  // unsupported type
+  }
+  WriteRecord();
+  return true;
+}
+
+void SaveBinaryImpl::WriteDelete(wpi::StringRef name) {
+  m_enc.Reset();
+  m_enc.Write8(Storage::kBinaryDelete);
+  m_enc.WriteString(name);
+  WriteRecord();
+}
+
+bool SaveBinaryImpl::WriteValue(const Value& value) {
+  switch (value.type()) {
+    case NT_BOOLEAN:
+    case NT_DOUBLE:
+    case NT_STRING:
+    case NT_RAW:
+      m_enc.WriteType(value.type());
+      m_enc.WriteValue(value);
+      break;
+    case NT_BOOLEAN_ARRAY: {
+      m_enc.WriteType(value.type());
+      auto v = value.GetBooleanArray();
+      m_enc.WriteUleb128(v.size());
+      for (auto elem : v) {
+        m_enc.Write8(elem ? 1 : 0);
+      }
+      break;
+    }
+    case NT_DOUBLE_ARRAY: {
+      m_enc.WriteType(value.type());
+      auto v = value.GetDoubleArray();
+      m_enc.WriteUleb128(v.size());
+      for (auto elem : v) {
+        m_enc.WriteDouble(elem);
+      }
+      break;
+    }
+    case NT_STRING_ARRAY: {
+      m_enc.WriteType(value.type());
+      auto v = value.GetStringArray();
+      m_enc.WriteUleb128(v.size());
+      for (auto& elem : v) {
+        m_enc.WriteString(elem);
+      }
+      break;
+    }
+    default:
+      return false;
+  }
+  return true;
+}
+
+void SaveBinaryImpl::WriteRecord() {
+  uint32_t len = m_enc.size();
+  char buf[4] = {static_cast<char>((len >> 24) & 0xff),
+                 static_cast<char>((len >> 16) & 0xff),
+                 static_cast<char>((len >> 8) & 0xff),
+                 static_cast<char>(len & 0xff)};
+  m_os << wpi::StringRef(buf, 4) << m_enc.ToStringRef();
+}
+
 void Storage::SavePersistent(wpi::raw_ostream& os, bool periodic) const {
   std::vector<SavePersistentImpl::Entry> entries;
   if (!GetPersistentEntries(periodic, &entries)) {
@@ -194,6 +310,9 @@ const char* Storage::SavePersistent(const wpi::Twine& filename,
                                     bool periodic) const {
   wpi::SmallString<128> fn;
   filename.toVector(fn);
+  if (wpi::StringRef(fn).endswith(".bin")) {
+    return SavePersistentBinary(fn, periodic);
+  }
   wpi::SmallString<128> tmp = fn;
   tmp += ".tmp";
   wpi::SmallString<128> bak = fn;
@@ -264,6 +383,10 @@ const char* Storage::SaveEntries(const wpi::Twine& filename,
     return nullptr;
   }
 
+  if (wpi::StringRef(fn).endswith(".bin")) {
+    return SaveEntriesBinary(fn, entries);
+  }
+
   // start by writing to temporary file
   std::error_code ec;
   wpi::raw_fd_ostream os(tmp, ec, wpi::sys::fs::F_Text);
@@ -288,3 +411,116 @@ const char* Storage::SaveEntries(const wpi::Twine& filename,
 
   return nullptr;
 }
+
+void Storage::SavePersistentBinary(wpi::raw_ostream& os) const {
+  std::vector<SaveBinaryImpl::Entry> entries;
+  if (!GetPersistentEntries(false, &entries)) {
+    return;
+  }
+  SaveBinaryImpl(os).Save(entries);
+}
+
+const char* Storage::SavePersistentBinary(wpi::StringRef filename,
+                                          bool periodic) const {
+  std::scoped_lock lock(m_journal_mutex);
+
+  // Get entries before touching the file
+  std::vector<SaveBinaryImpl::Entry> entries;
+  if (!GetPersistentEntries(periodic, &entries)) {
+    return nullptr;
+  }
+
+  // Append only the changes if this file's contents are known and the
+  // journal hasn't grown too large; otherwise write a compacted snapshot.
+  const char* err = nullptr;
+  if (periodic && filename == m_journal_filename &&
+      m_journal_records <= std::max<size_t>(entries.size(), 64)) {
+    std::error_code ec;
+    wpi::raw_fd_ostream os(filename, ec, wpi::sys::fs::CD_OpenExisting,
+                           wpi::sys::fs::FA_Write, wpi::sys::fs::F_Append);
+    if (ec.value() == 0) {
+      DEBUG0("appending to persistent file '" << filename << "'");
+      SaveBinaryImpl save(os);
+      size_t records = 0;
+      wpi::StringMap<bool> current;
+      for (auto& i : entries) {
+        current[i.first] = true;
+        auto& saved = m_journal_saved[i.first];
+        if (saved && (saved == i.second || *saved == *i.second)) {
+          continue;
+        }
+        if (save.WriteSet(i.first, *i.second)) {
+          saved = i.second;
+          ++records;
+        }
+      }
+      for (auto i = m_journal_saved.begin(); i != m_journal_saved.end();) {
+        auto cur = i++;
+        if (current.count(cur->getKey()) == 0) {
+          save.WriteDelete(cur->getKey());
+          m_journal_saved.erase(cur);
+          ++records;
+        }
+      }
+      os.close();
+      if (!os.has_error()) {
+        m_journal_records += records;
+        return nullptr;
+      }
+    }
+    // fall back to rewriting the whole file
+    DEBUG0("could not append to persistent file '" << filename << "'");
+  }
+
+  m_journal_filename.clear();
+  err = SaveEntriesBinary(filename, entries);
+  if (!err) {
+    m_journal_filename = filename;
+    m_journal_saved.clear();
+    for (auto& i : entries) {
+      if (i.second) {
+        m_journal_saved[i.first] = i.second;
+      }
+    }
+    m_journal_records = 0;
+  } else if (periodic) {
+    // try again if there was an error
+    m_persistent_dirty = true;
+  }
+  return err;
+}
+
+const char* Storage::SaveEntriesBinary(
+    wpi::StringRef filename,
+    wpi::ArrayRef<std::pair<std::string, std::shared_ptr<Value>>> entries)
+    const {
+  wpi::SmallString<128> tmp = filename;
+  tmp += ".tmp";
+  wpi::SmallString<128> bak = filename;
+  bak += ".bak";
+
+  // start by writing to temporary file
+  std::error_code ec;
+  wpi::raw_fd_ostream os(tmp, ec, wpi::sys::fs::F_None);
+  if (ec.value() != 0) {
+    return "could not open file";
+  }
+  DEBUG0("saving file '" << filename << "'");
+  SaveBinaryImpl(os).Save(entries);
+  os.close();
+  if (os.has_error()) {
+    std::remove(tmp.c_str());
+    return "error saving file";
+  }
+
+  // Safely move to real file.  We ignore any failures related to the backup.
+  wpi::SmallString<128> fn = filename;
+  std::remove(bak.c_str());
+  std::rename(fn.c_str(), bak.c_str());
+  if (std::rename(tmp.c_str(), fn.c_str()) != 0) {
+    std::rename(bak.c_str(), fn.c_str());  // attempt to restore backup
+    return "could not rename temp file to real file";
+  }
+
+  return nullptr;
+}
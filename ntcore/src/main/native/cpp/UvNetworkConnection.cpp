@@ -0,0 +1,330 @@
+// Copyright (c) FIRST and other WPILib contributors.
+// Open Source Software; you can modify and/or share it under the terms of
+// the WPILib BSD license file in the root directory of this project.
+
+#include "UvNetworkConnection.h"
+
+#include <cstring>
+#include <utility>
+
+#include <wpi/timestamp.h>
+#include <wpi/uv/Async.h>
+#include <wpi/uv/Tcp.h>
+#include <wpi/uv/Timer.h>
+
+#include "Log.h"
+
+using namespace nt;
+namespace uv = wpi::uv;
+
+void UvNetworkConnection::BufferStream::read_impl(void* data, size_t len) {
+  if (len > m_left) {
+    error_detected();
+    len = m_left;
+  }
+  std::memcpy(data, m_cur, len);
+  m_cur += len;
+  m_left -= len;
+  set_read_count(len);
+}
+
+UvNetworkConnection::UvNetworkConnection(
+    unsigned int uid, std::shared_ptr<uv::Tcp> stream, wpi::StringRef peer_ip,
+    unsigned int peer_port, IConnectionNotifier& notifier, wpi::Logger& logger,
+    HandshakeFunc handshake, Message::GetEntryTypeFunc get_entry_type)
+    : NetworkConnection(uid, peer_ip, peer_port, notifier, logger,
+                        std::move(handshake), std::move(get_entry_type)),
+      m_stream(stream),
+      m_decoder(m_is, m_proto_rev, m_logger),
+      m_encoder(m_proto_rev) {
+  // turn off Nagle algorithm; we bundle packets for transmission
+  stream->SetNoDelay(true);
+  m_decoder.set_array_deltas(true);
+}
+
+UvNetworkConnection::~UvNetworkConnection() {
+  // normally already joined by Close() or FinishHandshake()
+  if (m_handshake_thread.joinable()) {
+    m_handshake_queue.push(nullptr);
+    m_handshake_thread.join();
+  }
+}
+
+void UvNetworkConnection::Start() {
+  if (m_active) {
+    return;
+  }
+  auto stream = m_stream.lock();
+  if (!stream) {
+    return;
+  }
+  m_active = true;
+  set_state(kHandshake);
+  m_handshake_start = wpi::Now();
+
+  auto self = shared_from_this();
+
+  auto wakeup = uv::Async<>::Create(stream->GetLoop());
+  if (!wakeup) {
+    Close();
+    return;
+  }
+  wakeup->SetData(self);
+  wakeup->wakeup.connect([this] {
+    DoWrite();
+    if (!m_active) {
+      Close();
+    } else if (!m_handshake_done && m_handshake_finished) {
+      FinishHandshake(m_handshake_ok);
+    }
+  });
+  {
+    std::scoped_lock lock(m_wakeup_mutex);
+    m_wakeup = wakeup;
+  }
+
+  stream->SetData(self);
+  stream->data.connect(
+      [this](uv::Buffer& buf, size_t len) { HandleData(buf, len); });
+  stream->end.connect([this] {
+    DEBUG2("connection closed by peer (" << this << ")");
+    Close();
+  });
+  stream->error.connect([this](uv::Error err) {
+    DEBUG1("connection error: " << err.str());
+    Close();
+  });
+  stream->closed.connect([this] { Close(); });
+  stream->StartRead();
+
+  // disconnect peers that stall the handshake
+  auto timer = uv::Timer::Create(stream->GetLoop());
+  if (!timer) {
+    Close();
+    return;
+  }
+  timer->SetData(self);
+  timer->timeout.connect([this] {
+    if (!m_handshake_done) {
+      INFO("handshake timed out");
+      Close();
+    }
+  });
+  timer->Start(uv::Timer::Time{kHandshakeTimeout});
+  m_handshake_timer = timer;
+
+  // The handshake function blocks waiting for messages, so run it on its own
+  // thread and feed it from the loop.  The thread is always joined before the
+  // loop lets go of this connection.
+  m_handshake_thread = std::thread([this] {
+    m_handshake_ok = m_handshake(
+        *this, [&] { return m_handshake_queue.pop(); },
+        [&](wpi::ArrayRef<std::shared_ptr<Message>> msgs) {
+          m_outgoing.emplace(msgs);
+          Wakeup();
+        });
+    m_handshake_finished = true;
+    Wakeup();
+  });
+}
+
+void UvNetworkConnection::Stop() {
+  DEBUG2("UvNetworkConnection stopping (" << this << ")");
+  set_state(kDead);
+  m_active = false;
+  // unblock the handshake (if running)
+  m_handshake_queue.push(nullptr);
+  // the loop closes the stream when it sees we're no longer active
+  Wakeup();
+}
+
+void UvNetworkConnection::PostOutgoing(bool keep_alive) {
+  NetworkConnection::PostOutgoing(keep_alive);
+  if (!m_outgoing.empty()) {
+    Wakeup();
+  }
+}
+
+void UvNetworkConnection::Wakeup() {
+  std::scoped_lock lock(m_wakeup_mutex);
+  if (auto wakeup = m_wakeup.lock()) {
+    wakeup->Send();
+  }
+}
+
+void UvNetworkConnection::HandleData(uv::Buffer& buf, size_t len) {
+  m_rbuf.append(buf.base, len);
+  m_bytes_received += len;
+
+  // decode as many complete messages as are available
+  size_t pos = 0;
+  while (pos < m_rbuf.size() && m_active) {
+    m_is.reset(m_rbuf.data() + pos, m_rbuf.size() - pos);
+    if (static_cast<unsigned char>(m_rbuf[pos]) == kCompressedBlock) {
+      if (!PeerSentCompressed()) {
+        INFO("read error: compressed block without compression enabled");
+        Close();
+        return;
+      }
+      char type;
+      m_is.read(&type, 1);
+      m_block.clear();
+      if (!ReadCompressedBlock(m_is, m_block)) {
+        if (m_is.has_error()) {
+          break;  // partial block; wait for more data
+        }
+        INFO("read error: bad compressed block");
+        Close();
+        return;
+      }
+      pos = m_rbuf.size() - m_is.in_avail();
+      // blocks only contain whole messages
+      m_is.reset(m_block.data(), m_block.size());
+      while (m_is.in_avail() > 0 && m_active) {
+        if (!DecodeMessage()) {
+          Close();
+          return;
+        }
+      }
+      continue;
+    }
+    if (!DecodeMessage()) {
+      if (m_is.has_error()) {
+        break;  // partial message; wait for more data
+      }
+      // terminate connection on bad message
+      Close();
+      return;
+    }
+    pos = m_rbuf.size() - m_is.in_avail();
+  }
+  m_rbuf.erase(0, pos);
+}
+
+bool UvNetworkConnection::DecodeMessage() {
+  m_decoder.set_proto_rev(m_proto_rev);
+  m_decoder.Reset();
+  auto msg = Message::Read(m_decoder, m_get_entry_type);
+  if (!msg) {
+    if (!m_is.has_error() && m_decoder.error()) {
+      INFO("read error: " << m_decoder.error());
+    }
+    return false;
+  }
+  DEBUG3("received type=" << msg->type() << " with str=" << msg->str()
+                          << " id=" << msg->id()
+                          << " seq_num=" << msg->seq_num_uid());
+  ++m_msgs_received;
+  HandleMessage(std::move(msg));
+  return true;
+}
+
+void UvNetworkConnection::HandleMessage(std::shared_ptr<Message> msg) {
+  if (!m_handshake_done) {
+    m_handshake_queue.push(std::move(msg));
+    return;
+  }
+  m_last_update = wpi::Now();
+  ProcessIncoming(std::move(msg));
+}
+
+void UvNetworkConnection::FinishHandshake(bool ok) {
+  m_handshake_done = true;
+  JoinHandshakeThread();
+  if (auto timer = m_handshake_timer.lock()) {
+    if (!timer->IsClosing()) {
+      timer->Close();
+    }
+  }
+  if (!ok || !m_active) {
+    // flush anything sent by the handshake (e.g. protocol unsupported)
+    DoWrite();
+    Close();
+    return;
+  }
+  m_handshake_duration = wpi::Now() - m_handshake_start;
+  set_state(kActive);
+
+  // process anything that arrived after the handshake completed
+  while (m_active && !m_handshake_queue.empty()) {
+    auto msg = m_handshake_queue.pop();
+    if (!msg) {
+      break;
+    }
+    HandleMessage(std::move(msg));
+  }
+}
+
+void UvNetworkConnection::DoWrite() {
+  auto stream = m_stream.lock();
+  if (!stream || stream->IsClosing()) {
+    return;
+  }
+  m_encoder.set_proto_rev(m_proto_rev);
+  m_encoder.set_array_deltas(m_array_deltas);
+  m_encoder.set_entry_history(m_entry_history);
+  m_encoder.Reset();
+  uint64_t flush_start = m_flush_start.exchange(0);
+  size_t count = 0;
+  while (!m_outgoing.empty()) {
+    auto msgs = m_outgoing.pop();
+    for (auto& msg : msgs) {
+      if (msg) {
+        DEBUG3("sending type=" << msg->type() << " with str=" << msg->str()
+                               << " id=" << msg->id()
+                               << " seq_num=" << msg->seq_num_uid());
+        msg->Write(m_encoder);
+        ++count;
+      }
+    }
+    RecycleOutgoing(std::move(msgs));
+  }
+  if (m_encoder.size() == 0) {
+    return;
+  }
+  auto data = CompressOutgoing({m_encoder.data(), m_encoder.size()});
+  CountWrite(count, data.size(), flush_start);
+  DEBUG4("sending " << data.size() << " bytes");
+  stream->Write({uv::Buffer::Dup(data)},
+                [](auto bufs, uv::Error) {
+                  for (auto&& buf : bufs) {
+                    buf.Deallocate();
+                  }
+                });
+}
+
+void UvNetworkConnection::Close() {
+  set_state(kDead);
+  m_active = false;
+  if (!m_handshake_done) {
+    m_handshake_queue.push(nullptr);
+  }
+  JoinHandshakeThread();
+  if (auto timer = m_handshake_timer.lock()) {
+    if (!timer->IsClosing()) {
+      timer->Close();
+    }
+  }
+  if (auto stream = m_stream.lock()) {
+    if (!stream->IsClosing()) {
+      stream->Close();
+    }
+  }
+  std::shared_ptr<uv::Async<>> wakeup;
+  {
+    std::scoped_lock lock(m_wakeup_mutex);
+    wakeup = m_wakeup.lock();
+    m_wakeup.reset();
+  }
+  if (wakeup && !wakeup->IsClosing()) {
+    wakeup->Close();
+  }
+}
+
+void UvNetworkConnection::JoinHandshakeThread() {
+  // the handshake only waits for messages from the loop, which Close() ends
+  // by queueing a nullptr, so this doesn't block for long
+  if (m_handshake_thread.joinable()) {
+    m_handshake_thread.join();
+  }
+}
@@ -0,0 +1,121 @@
+// Copyright (c) FIRST and other WPILib contributors.
+// Open Source Software; you can modify and/or share it under the terms of
+// the WPILib BSD license file in the root directory of this project.
+
+#ifndef NTCORE_UVNETWORKCONNECTION_H_
+#define NTCORE_UVNETWORKCONNECTION_H_
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+
+#include <wpi/ConcurrentQueue.h>
+#include <wpi/mutex.h>
+#include <wpi/raw_istream.h>
+
+#include "NetworkConnection.h"
+#include "WireDecoder.h"
+#include "WireEncoder.h"
+
+namespace wpi::uv {
+template <typename... T>
+class Async;
+class Buffer;
+class Tcp;
+class Timer;
+}  // namespace wpi::uv
+
+namespace nt {
+
+/* A network connection driven by a libuv event loop.
+ * Instead of dedicated read and write threads, reads are processed by the
+ * loop's data callback and writes are issued from the loop when it is woken
+ * up by PostOutgoing().  The (blocking) handshake function is run on a thread
+ * of its own so it does not stall the loop, and not on the libuv work queue,
+ * whose few threads a handful of silent peers would tie up.  A peer that
+ * doesn't finish the handshake within kHandshakeTimeout is disconnected.
+ *
+ * Must be created and started on the loop thread.
+ */
+class UvNetworkConnection
+    : public NetworkConnection,
+      public std::enable_shared_from_this<UvNetworkConnection> {
+ public:
+  UvNetworkConnection(unsigned int uid, std::shared_ptr<wpi::uv::Tcp> stream,
+                      wpi::StringRef peer_ip, unsigned int peer_port,
+                      IConnectionNotifier& notifier, wpi::Logger& logger,
+                      HandshakeFunc handshake,
+                      Message::GetEntryTypeFunc get_entry_type);
+  ~UvNetworkConnection() override;
+
+  // Time a peer has to complete the handshake, in milliseconds
+  static constexpr unsigned int kHandshakeTimeout = 5000;
+
+  void Start() override;
+  void Stop() override;
+
+  void PostOutgoing(bool keep_alive) override;
+
+ private:
+  // Input stream over the not yet decoded portion of the receive buffer.
+  // Running off the end sets the stream error, which is how a partially
+  // received message is detected.
+  class BufferStream : public wpi::raw_istream {
+   public:
+    void reset(const char* data, size_t len) {
+      m_cur = data;
+      m_left = len;
+      clear_error();
+    }
+    void close() override {}
+    size_t in_avail() const override { return m_left; }
+
+   private:
+    void read_impl(void* data, size_t len) override;
+
+    const char* m_cur = nullptr;
+    size_t m_left = 0;
+  };
+
+  void Wakeup();
+  void HandleData(wpi::uv::Buffer& buf, size_t len);
+  // Decode and handle one message from m_is; false on error or partial
+  bool DecodeMessage();
+  void HandleMessage(std::shared_ptr<Message> msg);
+  void FinishHandshake(bool ok);
+  void JoinHandshakeThread();
+  void DoWrite();
+  void Close();
+
+  std::weak_ptr<wpi::uv::Tcp> m_stream;
+
+  // Guards m_wakeup so Send() never races the loop closing the handle
+  wpi::mutex m_wakeup_mutex;
+  std::weak_ptr<wpi::uv::Async<>> m_wakeup;
+
+  // Loop thread only
+  std::string m_rbuf;
+  wpi::SmallVector<char, 128> m_block;  // decompressed block
+  BufferStream m_is;
+  WireDecoder m_decoder;
+  WireEncoder m_encoder;
+  bool m_handshake_done = false;
+  uint64_t m_handshake_start = 0;
+  std::weak_ptr<wpi::uv::Timer> m_handshake_timer;
+
+  // Runs the handshake function; joined on the loop thread when it has
+  // finished or the connection is closed
+  std::thread m_handshake_thread;
+
+  // Written by the handshake thread before it wakes up the loop
+  std::atomic_bool m_handshake_finished{false};
+  std::atomic_bool m_handshake_ok{false};
+
+  // Messages handed to the handshake function (nullptr means disconnected)
+  wpi::ConcurrentQueue<std::shared_ptr<Message>> m_handshake_queue;
+};
+
+}  // namespace nt
+
+#endif  // NTCORE_UVNETWORKCONNECTION_H_
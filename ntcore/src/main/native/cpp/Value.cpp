@@ -4,7 +4,16 @@
 
 #include <stdint.h>
 
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <string>
+#include <vector>
+
 #include <wpi/MemAlloc.h>
+#include <wpi/SmallString.h>
 #include <wpi/timestamp.h>
 
 #include "Value_internal.h"
@@ -12,6 +21,57 @@
 
 using namespace nt;
 
+namespace {
+
+// Sizes the trailing storage of a single Value allocation
+struct TrailingRequest {
+  size_t extra;
+  char* payload;
+};
+
+// Allocator for std::allocate_shared() that places the requested number of
+// extra bytes after the object, so that a value's contents share a single
+// allocation with the value and its reference count.  Only allocate() uses
+// the request, which must outlive the allocate_shared() call.
+template <typename T>
+class TrailingAllocator {
+ public:
+  using value_type = T;
+
+  explicit TrailingAllocator(TrailingRequest* req) noexcept : m_req{req} {}
+  template <typename U>
+  TrailingAllocator(const TrailingAllocator<U>& other) noexcept  // NOLINT
+      : m_req{other.m_req} {}
+
+  T* allocate(size_t n) {
+    // keep the payload aligned for doubles and std::string
+    constexpr size_t kAlign = alignof(std::max_align_t);
+    size_t size = (n * sizeof(T) + kAlign - 1) / kAlign * kAlign;
+    auto p = static_cast<char*>(::operator new(size + m_req->extra));
+    m_req->payload = p + size;
+    return reinterpret_cast<T*>(p);
+  }
+
+  void deallocate(T* p, size_t) noexcept { ::operator delete(p); }
+
+  template <typename U>
+  bool operator==(const TrailingAllocator<U>& other) const noexcept {
+    return m_req == other.m_req;
+  }
+  template <typename U>
+  bool operator!=(const TrailingAllocator<U>& other) const noexcept {
+    return m_req != other.m_req;
+  }
+
+ private:
+  template <typename U>
+  friend class TrailingAllocator;
+
+  TrailingRequest* m_req;
+};
+
+}  // namespace
+
 Value::Value() {
   m_val.type = NT_UNASSIGNED;
   m_val.last_change = wpi::Now();
@@ -26,27 +86,60 @@ Value::Value(NT_Type type, uint64_t time, const private_init&) {
   }
   if (m_val.type == NT_BOOLEAN_ARRAY) {
     m_val.data.arr_boolean.arr = nullptr;
+    m_val.data.arr_boolean.size = 0;
   } else if (m_val.type == NT_DOUBLE_ARRAY) {
     m_val.data.arr_double.arr = nullptr;
+    m_val.data.arr_double.size = 0;
   } else if (m_val.type == NT_STRING_ARRAY) {
     m_val.data.arr_string.arr = nullptr;
+    m_val.data.arr_string.size = 0;
   }
 }
 
 Value::~Value() {
-  if (m_val.type == NT_BOOLEAN_ARRAY) {
-    delete[] m_val.data.arr_boolean.arr;
-  } else if (m_val.type == NT_DOUBLE_ARRAY) {
-    delete[] m_val.data.arr_double.arr;
-  } else if (m_val.type == NT_STRING_ARRAY) {
-    delete[] m_val.data.arr_string.arr;
+  // the storage itself is freed with the value; only the strings of a
+  // string array need to be destroyed
+  if (m_val.type == NT_STRING_ARRAY) {
+    for (auto& str : GetStringArray()) {
+      str.~basic_string();
+    }
   }
 }
 
+std::shared_ptr<Value> Value::Allocate(NT_Type type, size_t extra,
+                                       uint64_t time, char** payload) {
+  TrailingRequest req{extra, nullptr};
+  auto val = std::allocate_shared<Value>(TrailingAllocator<Value>(&req), type,
+                                         time, private_init());
+  *payload = req.payload;
+  return val;
+}
+
+std::shared_ptr<Value> Value::MakeString(const wpi::Twine& value,
+                                         uint64_t time) {
+  wpi::SmallString<128> buf;
+  return MakeStringValue(NT_STRING, value.toStringRef(buf), time);
+}
+
+std::shared_ptr<Value> Value::MakeStringValue(NT_Type type,
+                                              wpi::StringRef value,
+                                              uint64_t time) {
+  char* payload;
+  auto val = Allocate(type, value.size() + 1, time, &payload);
+  std::memcpy(payload, value.data(), value.size());
+  payload[value.size()] = '\0';
+  // v_string and v_raw have the same layout
+  val->m_val.data.v_string.str = payload;
+  val->m_val.data.v_string.len = value.size();
+  return val;
+}
+
 std::shared_ptr<Value> Value::MakeBooleanArray(wpi::ArrayRef<bool> value,
                                                uint64_t time) {
-  auto val = std::make_shared<Value>(NT_BOOLEAN_ARRAY, time, private_init());
-  val->m_val.data.arr_boolean.arr = new int[value.size()];
+  char* payload;
+  auto val =
+      Allocate(NT_BOOLEAN_ARRAY, value.size() * sizeof(int), time, &payload);
+  val->m_val.data.arr_boolean.arr = reinterpret_cast<int*>(payload);
   val->m_val.data.arr_boolean.size = value.size();
   std::copy(value.begin(), value.end(), val->m_val.data.arr_boolean.arr);
   return val;
@@ -54,8 +147,10 @@ std::shared_ptr<Value> Value::MakeBooleanArray(wpi::ArrayRef<bool> value,
 
 std::shared_ptr<Value> Value::MakeBooleanArray(wpi::ArrayRef<int> value,
                                                uint64_t time) {
-  auto val = std::make_shared<Value>(NT_BOOLEAN_ARRAY, time, private_init());
-  val->m_val.data.arr_boolean.arr = new int[value.size()];
+  char* payload;
+  auto val =
+      Allocate(NT_BOOLEAN_ARRAY, value.size() * sizeof(int), time, &payload);
+  val->m_val.data.arr_boolean.arr = reinterpret_cast<int*>(payload);
   val->m_val.data.arr_boolean.size = value.size();
   std::copy(value.begin(), value.end(), val->m_val.data.arr_boolean.arr);
   return val;
@@ -63,40 +158,58 @@ std::shared_ptr<Value> Value::MakeBooleanArray(wpi::ArrayRef<int> value,
 
 std::shared_ptr<Value> Value::MakeDoubleArray(wpi::ArrayRef<double> value,
                                               uint64_t time) {
-  auto val = std::make_shared<Value>(NT_DOUBLE_ARRAY, time, private_init());
-  val->m_val.data.arr_double.arr = new double[value.size()];
+  char* payload;
+  auto val =
+      Allocate(NT_DOUBLE_ARRAY, value.size() * sizeof(double), time, &payload);
+  val->m_val.data.arr_double.arr = reinterpret_cast<double*>(payload);
   val->m_val.data.arr_double.size = value.size();
   std::copy(value.begin(), value.end(), val->m_val.data.arr_double.arr);
   return val;
 }
 
+// The storage of a string array holds the NT_String array followed by the
+// std::string objects it points to.
+static size_t StringArrayStorage(size_t size) {
+  return size * (sizeof(NT_String) + sizeof(std::string));
+}
+
+static std::string* StringArrayStrings(char* payload, size_t size) {
+  return reinterpret_cast<std::string*>(payload + size * sizeof(NT_String));
+}
+
+// Called once all of the strings are constructed, so the destructor never
+// sees a partially constructed array.
+static void SetStringArray(NT_Value& val, char* payload, size_t size) {
+  auto arr = reinterpret_cast<NT_String*>(payload);
+  auto strs = StringArrayStrings(payload, size);
+  for (size_t i = 0; i < size; ++i) {
+    arr[i].str = const_cast<char*>(strs[i].c_str());
+    arr[i].len = strs[i].size();
+  }
+  val.data.arr_string.arr = arr;
+  val.data.arr_string.size = size;
+}
+
 std::shared_ptr<Value> Value::MakeStringArray(wpi::ArrayRef<std::string> value,
                                               uint64_t time) {
-  auto val = std::make_shared<Value>(NT_STRING_ARRAY, time, private_init());
-  val->m_string_array = value;
-  // point NT_Value to the contents in the vector.
-  val->m_val.data.arr_string.arr = new NT_String[value.size()];
-  val->m_val.data.arr_string.size = val->m_string_array.size();
-  for (size_t i = 0; i < value.size(); ++i) {
-    val->m_val.data.arr_string.arr[i].str = const_cast<char*>(value[i].c_str());
-    val->m_val.data.arr_string.arr[i].len = value[i].size();
-  }
+  char* payload;
+  auto val = Allocate(NT_STRING_ARRAY, StringArrayStorage(value.size()), time,
+                      &payload);
+  std::uninitialized_copy(value.begin(), value.end(),
+                          StringArrayStrings(payload, value.size()));
+  SetStringArray(val->m_val, payload, value.size());
   return val;
 }
 
 std::shared_ptr<Value> Value::MakeStringArray(std::vector<std::string>&& value,
                                               uint64_t time) {
-  auto val = std::make_shared<Value>(NT_STRING_ARRAY, time, private_init());
-  val->m_string_array = std::move(value);
+  char* payload;
+  auto val = Allocate(NT_STRING_ARRAY, StringArrayStorage(value.size()), time,
+                      &payload);
+  std::uninitialized_move(value.begin(), value.end(),
+                          StringArrayStrings(payload, value.size()));
+  SetStringArray(val->m_val, payload, value.size());
   value.clear();
-  // point NT_Value to the contents in the vector.
-  val->m_val.data.arr_string.arr = new NT_String[val->m_string_array.size()];
-  val->m_val.data.arr_string.size = val->m_string_array.size();
-  for (size_t i = 0; i < val->m_string_array.size(); ++i) {
-    val->m_val.data.arr_string.arr[i].str =
-        const_cast<char*>(val->m_string_array[i].c_str());
-    val->m_val.data.arr_string.arr[i].len = val->m_string_array[i].size();
-  }
   return val;
 }
 
@@ -208,7 +321,11 @@ bool nt::operator==(const Value& lhs, const Value& rhs) {
     case NT_STRING:
     case NT_RAW:
     case NT_RPC:
-      return lhs.m_string == rhs.m_string;
+      // v_string and v_raw have the same layout
+      return wpi::StringRef(lhs.m_val.data.v_string.str,
+                            lhs.m_val.data.v_string.len) ==
+             wpi::StringRef(rhs.m_val.data.v_string.str,
+                            rhs.m_val.data.v_string.len);
     case NT_BOOLEAN_ARRAY:
       if (lhs.m_val.data.arr_boolean.size != rhs.m_val.data.arr_boolean.size) {
         return false;
@@ -225,8 +342,11 @@ bool nt::operator==(const Value& lhs, const Value& rhs) {
                          rhs.m_val.data.arr_double.arr,
                          lhs.m_val.data.arr_double.size *
                              sizeof(lhs.m_val.data.arr_double.arr[0])) == 0;
-    case NT_STRING_ARRAY:
-      return lhs.m_string_array == rhs.m_string_array;
+    case NT_STRING_ARRAY: {
+      auto l = lhs.GetStringArray();
+      auto r = rhs.GetStringArray();
+      return l.size() == r.size() && std::equal(l.begin(), l.end(), r.begin());
+    }
     default:
       // assert(false && "unknown value type");
       return false;
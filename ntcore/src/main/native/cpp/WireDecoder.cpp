@@ -6,6 +6,7 @@
 
 #include <stdint.h>
 
+#include <algorithm>
 #include <cassert>
 #include <cstdlib>
 #include <cstring>
@@ -14,6 +15,8 @@
 #include <wpi/MemAlloc.h>
 #include <wpi/leb128.h>
 
+#include "PoolAllocator.h"
+
 using namespace nt;
 
 static double ReadDouble(const char*& buf) {
@@ -120,28 +123,34 @@ bool WireDecoder::ReadType(NT_Type* type) {
   return true;
 }
 
-std::shared_ptr<Value> WireDecoder::ReadValue(NT_Type type) {
+std::shared_ptr<Value> WireDecoder::ReadValue(NT_Type type, uint64_t time) {
   switch (type) {
     case NT_BOOLEAN: {
       unsigned int v;
       if (!Read8(&v)) {
         return nullptr;
       }
-      return Value::MakeBoolean(v != 0);
+      auto val = std::allocate_shared<Value>(
+          PoolAllocator<Value>(), NT_BOOLEAN, time, Value::private_init());
+      val->m_val.data.v_boolean = v != 0;
+      return val;
     }
     case NT_DOUBLE: {
       double v;
       if (!ReadDouble(&v)) {
         return nullptr;
       }
-      return Value::MakeDouble(v);
+      auto val = std::allocate_shared<Value>(
+          PoolAllocator<Value>(), NT_DOUBLE, time, Value::private_init());
+      val->m_val.data.v_double = v;
+      return val;
     }
     case NT_STRING: {
       std::string v;
       if (!ReadString(&v)) {
         return nullptr;
       }
-      return Value::MakeString(std::move(v));
+      return Value::MakeString(std::move(v), time);
     }
     case NT_RAW: {
       if (m_proto_rev < 0x0300u) {
@@ -152,7 +161,7 @@ std::shared_ptr<Value> WireDecoder::ReadValue(NT_Type type) {
       if (!ReadString(&v)) {
         return nullptr;
       }
-      return Value::MakeRaw(std::move(v));
+      return Value::MakeRaw(std::move(v), time);
     }
     case NT_RPC: {
       if (m_proto_rev < 0x0300u) {
@@ -163,7 +172,7 @@ std::shared_ptr<Value> WireDecoder::ReadValue(NT_Type type) {
       if (!ReadString(&v)) {
         return nullptr;
       }
-      return Value::MakeRpc(std::move(v));
+      return Value::MakeRpc(std::move(v), time);
     }
     case NT_BOOLEAN_ARRAY: {
       // size
@@ -181,7 +190,7 @@ std::shared_ptr<Value> WireDecoder::ReadValue(NT_Type type) {
       for (unsigned int i = 0; i < size; ++i) {
         v[i] = buf[i] ? 1 : 0;
       }
-      return Value::MakeBooleanArray(std::move(v));
+      return Value::MakeBooleanArray(std::move(v), time);
     }
     case NT_DOUBLE_ARRAY: {
       // size
@@ -199,7 +208,7 @@ std::shared_ptr<Value> WireDecoder::ReadValue(NT_Type type) {
       for (unsigned int i = 0; i < size; ++i) {
         v[i] = ::ReadDouble(buf);
       }
-      return Value::MakeDoubleArray(std::move(v));
+      return Value::MakeDoubleArray(std::move(v), time);
     }
     case NT_STRING_ARRAY: {
       // size
@@ -215,7 +224,7 @@ std::shared_ptr<Value> WireDecoder::ReadValue(NT_Type type) {
           return nullptr;
         }
       }
-      return Value::MakeStringArray(std::move(v));
+      return Value::MakeStringArray(std::move(v), time);
     }
     default:
       m_error = "invalid type when trying to read value";
@@ -245,3 +254,72 @@ bool WireDecoder::ReadString(std::string* str) {
   *str = wpi::StringRef(buf, len);
   return true;
 }
+
+void WireDecoder::SetArrayBase(unsigned int id, std::shared_ptr<Value> value) {
+  if (!m_array_deltas || id >= 0xffff) {
+    return;
+  }
+  if (value && !value->IsDoubleArray() && !value->IsBooleanArray()) {
+    value.reset();
+  }
+  if (id >= m_array_bases.size()) {
+    if (!value) {
+      return;
+    }
+    m_array_bases.resize(id + 1);
+  }
+  m_array_bases[id] = std::move(value);
+}
+
+std::shared_ptr<Value> WireDecoder::ReadArrayDelta(unsigned int id,
+                                                   NT_Type type) {
+  if (!m_array_deltas || id >= m_array_bases.size() || !m_array_bases[id] ||
+      m_array_bases[id]->type() != type) {
+    m_error = "received array delta without a base value";
+    return nullptr;
+  }
+  unsigned int size;
+  unsigned int count;
+  if (!Read8(&size) || !Read8(&count)) {
+    return nullptr;
+  }
+
+  std::shared_ptr<Value> value;
+  if (type == NT_DOUBLE_ARRAY) {
+    auto base = m_array_bases[id]->GetDoubleArray();
+    std::vector<double> v(size);
+    std::copy_n(base.begin(), (std::min)(base.size(), v.size()), v.begin());
+    for (unsigned int i = 0; i < count; ++i) {
+      unsigned int index;
+      double elem;
+      if (!Read8(&index) || !ReadDouble(&elem)) {
+        return nullptr;
+      }
+      if (index >= size) {
+        m_error = "array delta index out of range";
+        return nullptr;
+      }
+      v[index] = elem;
+    }
+    value = Value::MakeDoubleArray(std::move(v));
+  } else {
+    auto base = m_array_bases[id]->GetBooleanArray();
+    std::vector<int> v(size);
+    std::copy_n(base.begin(), (std::min)(base.size(), v.size()), v.begin());
+    for (unsigned int i = 0; i < count; ++i) {
+      unsigned int index;
+      unsigned int elem;
+      if (!Read8(&index) || !Read8(&elem)) {
+        return nullptr;
+      }
+      if (index >= size) {
+        m_error = "array delta index out of range";
+        return nullptr;
+      }
+      v[index] = elem ? 1 : 0;
+    }
+    value = Value::MakeBooleanArray(std::move(v));
+  }
+  m_array_bases[id] = value;
+  return value;
+}
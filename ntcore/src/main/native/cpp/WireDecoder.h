@@ -10,6 +10,7 @@
 #include <cstddef>
 #include <memory>
 #include <string>
+#include <vector>
 
 #include <wpi/leb128.h>
 #include <wpi/raw_istream.h>
@@ -129,7 +130,25 @@ class WireDecoder {
 
   bool ReadType(NT_Type* type);
   bool ReadString(std::string* str);
-  std::shared_ptr<Value> ReadValue(NT_Type type);
+  /* Reads a value; a nonzero time is used as its creation time. */
+  std::shared_ptr<Value> ReadValue(NT_Type type, uint64_t time = 0);
+
+  /* Enables decoding of array deltas (see WireEncoder::WriteArrayDelta).
+   * While enabled, the last double or boolean array value read for each
+   * entry id is kept as the base for the next delta.
+   */
+  void set_array_deltas(bool enable) { m_array_deltas = enable; }
+
+  /* Records the value read for an entry id.  Values other than double and
+   * boolean arrays (including nullptr) clear the base.
+   */
+  void SetArrayBase(unsigned int id, std::shared_ptr<Value> value);
+  void ClearArrayBases() { m_array_bases.clear(); }
+
+  /* Reads an array delta and applies it to the base for an entry id,
+   * returning the new value (which also becomes the base).
+   */
+  std::shared_ptr<Value> ReadArrayDelta(unsigned int id, NT_Type type);
 
   WireDecoder(const WireDecoder&) = delete;
   WireDecoder& operator=(const WireDecoder&) = delete;
@@ -156,6 +175,10 @@ class WireDecoder {
 
   /* allocated size of temporary buffer */
   size_t m_allocated;
+
+  /* array delta bases, indexed by entry id */
+  bool m_array_deltas = false;
+  std::vector<std::shared_ptr<Value>> m_array_bases;
 };
 
 }  // namespace nt
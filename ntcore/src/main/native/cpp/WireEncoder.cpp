@@ -6,15 +6,41 @@
 
 #include <stdint.h>
 
+#include <algorithm>
 #include <cassert>
 #include <cstdlib>
 #include <cstring>
+#include <utility>
 
 #include <wpi/MathExtras.h>
 #include <wpi/leb128.h>
 
 using namespace nt;
 
+static bool IsDeltaArray(const Value& value) {
+  return value.IsDoubleArray() || value.IsBooleanArray();
+}
+
+// Number of array elements sent; the size is only 1 byte
+static size_t WireArraySize(const Value& value) {
+  size_t size = value.IsDoubleArray() ? value.GetDoubleArray().size()
+                                      : value.GetBooleanArray().size();
+  return (std::min)(size, static_cast<size_t>(0xff));
+}
+
+// Whether element i of value differs from base (missing elements are zero)
+static bool ArrayElementChanged(const Value& base, const Value& value,
+                                size_t i) {
+  if (value.IsDoubleArray()) {
+    auto b = base.GetDoubleArray();
+    // compare bits so NaN and -0.0 changes are sent
+    return wpi::DoubleToBits(i < b.size() ? b[i] : 0.0) !=
+           wpi::DoubleToBits(value.GetDoubleArray()[i]);
+  }
+  auto b = base.GetBooleanArray();
+  return (i < b.size() && b[i] != 0) != (value.GetBooleanArray()[i] != 0);
+}
+
 WireEncoder::WireEncoder(unsigned int proto_rev) {
   m_proto_rev = proto_rev;
   m_error = nullptr;
@@ -224,3 +250,58 @@ void WireEncoder::WriteString(wpi::StringRef str) {
   // contents
   m_data.append(str.data(), str.data() + len);
 }
+
+std::shared_ptr<Value> WireEncoder::SetArrayBase(unsigned int id,
+                                                 std::shared_ptr<Value> value) {
+  if (!m_array_deltas || id >= 0xffff) {
+    return nullptr;
+  }
+  if (value && !IsDeltaArray(*value)) {
+    value.reset();
+  }
+  if (id >= m_array_bases.size()) {
+    if (!value) {
+      return nullptr;
+    }
+    m_array_bases.resize(id + 1);
+  }
+  return std::exchange(m_array_bases[id], std::move(value));
+}
+
+size_t WireEncoder::GetArrayDeltaSize(const Value& base,
+                                      const Value& value) const {
+  if (base.type() != value.type() || !IsDeltaArray(value)) {
+    return 0;
+  }
+  size_t elem_size = value.IsDoubleArray() ? 8 : 1;
+  size_t size = 2;  // new size, count
+  for (size_t i = 0, n = WireArraySize(value); i < n; ++i) {
+    if (ArrayElementChanged(base, value, i)) {
+      size += 1 + elem_size;
+    }
+  }
+  return size;
+}
+
+void WireEncoder::WriteArrayDelta(const Value& base, const Value& value) {
+  size_t size = WireArraySize(value);
+  size_t count = 0;
+  for (size_t i = 0; i < size; ++i) {
+    if (ArrayElementChanged(base, value, i)) {
+      ++count;
+    }
+  }
+  Write8(size);
+  Write8(count);
+  for (size_t i = 0; i < size; ++i) {
+    if (!ArrayElementChanged(base, value, i)) {
+      continue;
+    }
+    Write8(i);
+    if (value.IsDoubleArray()) {
+      WriteDouble(value.GetDoubleArray()[i]);
+    } else {
+      Write8(value.GetBooleanArray()[i] ? 1 : 0);
+    }
+  }
+}
@@ -9,6 +9,8 @@
 
 #include <cassert>
 #include <cstddef>
+#include <memory>
+#include <vector>
 
 #include <wpi/SmallVector.h>
 #include <wpi/StringRef.h>
@@ -92,6 +94,38 @@ class WireEncoder {
    */
   size_t GetStringSize(wpi::StringRef str) const;
 
+  /* Enables delta encoding of double and boolean array updates.  While
+   * enabled, the last array value written for each entry id is kept as the
+   * base for the next delta.
+   */
+  void set_array_deltas(bool enable) { m_array_deltas = enable; }
+  bool array_deltas() const { return m_array_deltas; }
+
+  /* Enables writing history batches as single messages.  Otherwise each
+   * update in a batch is written as an ordinary entry update.
+   */
+  void set_entry_history(bool enable) { m_entry_history = enable; }
+  bool entry_history() const { return m_entry_history; }
+
+  /* Records the value written for an entry id and returns the previous
+   * array base.  Values other than double and boolean arrays (including
+   * nullptr) clear the base.  Does nothing unless array deltas are enabled.
+   */
+  std::shared_ptr<Value> SetArrayBase(unsigned int id,
+                                      std::shared_ptr<Value> value);
+  void ClearArrayBases() { m_array_bases.clear(); }
+
+  /* Utility function to get the written size of an array delta from base
+   * to value, or 0 if value can't be delta encoded against base.
+   */
+  size_t GetArrayDeltaSize(const Value& base, const Value& value) const;
+
+  /* Writes the elements that differ between two arrays of the same type:
+   * 1-byte new size, 1-byte count, and count (1-byte index, element)
+   * pairs.  Elements past the end of base that are not written are zero.
+   */
+  void WriteArrayDelta(const Value& base, const Value& value);
+
  protected:
   /* The protocol revision.  E.g. 0x0200 for version 2.0. */
   unsigned int m_proto_rev;
@@ -101,6 +135,10 @@ class WireEncoder {
 
  private:
   wpi::SmallVector<char, 256> m_data;
+
+  bool m_array_deltas = false;
+  bool m_entry_history = false;
+  std::vector<std::shared_ptr<Value>> m_array_bases;
 };
 
 }  // namespace nt
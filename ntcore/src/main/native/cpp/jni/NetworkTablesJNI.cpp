@@ -3,11 +3,15 @@
 // the WPILib BSD license file in the root directory of this project.
 
 #include <jni.h>
+#include <stdint.h>
 
+#include <algorithm>
 #include <cassert>
+#include <vector>
 
 #include <wpi/ConvertUTF.h>
 #include <wpi/SmallString.h>
+#include <wpi/SmallVector.h>
 #include <wpi/jni_util.h>
 #include <wpi/raw_ostream.h>
 
@@ -159,6 +163,39 @@ std::shared_ptr<nt::Value> FromJavaDoubleArray(JNIEnv* env, jdoubleArray jarr,
   return nt::Value::MakeDoubleArray(ref, time);
 }
 
+// Gets the address of a direct buffer holding at least size bytes.  Throws
+// and returns nullptr if buf is null, not a direct buffer, or too small.
+static void* GetDirectBuffer(JNIEnv* env, jobject buf, size_t size) {
+  if (!buf) {
+    nullPointerEx.Throw(env, "buffer cannot be null");
+    return nullptr;
+  }
+  void* addr = env->GetDirectBufferAddress(buf);
+  jlong capacity = env->GetDirectBufferCapacity(buf);
+  if (!addr || capacity < 0) {
+    illegalArgEx.Throw(env, "must be a direct buffer");
+    return nullptr;
+  }
+  if (static_cast<size_t>(capacity) < size) {
+    illegalArgEx.Throw(env, "buffer is too small");
+    return nullptr;
+  }
+  return addr;
+}
+
+// Copies entry handles out of a Java array; throws and returns false if the
+// array is null.
+static bool FromJavaEntries(JNIEnv* env, jintArray jarr,
+                            wpi::SmallVectorImpl<NT_Entry>* entries) {
+  if (!jarr) {
+    nullPointerEx.Throw(env, "entries cannot be null");
+    return false;
+  }
+  CriticalJIntArrayRef ref{env, jarr};
+  entries->assign(ref.array().begin(), ref.array().end());
+  return true;
+}
+
 std::shared_ptr<nt::Value> FromJavaStringArray(JNIEnv* env, jobjectArray jarr,
                                                jlong time) {
   size_t len = env->GetArrayLength(jarr);
@@ -617,7 +654,7 @@ Java_edu_wpi_first_networktables_NetworkTablesJNI_setBooleanArray
  * Signature: (IJ[DZ)Z
  */
 JNIEXPORT jboolean JNICALL
-Java_edu_wpi_first_networktables_NetworkTablesJNI_setDoubleArray
+Java_edu_wpi_first_networktables_NetworkTablesJNI_setDoubleArray__IJ_3DZ
   (JNIEnv* env, jclass, jint entry, jlong time, jdoubleArray value,
    jboolean force)
 {
@@ -636,6 +673,33 @@ Java_edu_wpi_first_networktables_NetworkTablesJNI_setDoubleArray
   return nt::SetEntryValue(entry, v);
 }
 
+/*
+ * Class:     edu_wpi_first_networktables_NetworkTablesJNI
+ * Method:    setDoubleArray
+ * Signature: (IJLjava/lang/Object;IZ)Z
+ */
+JNIEXPORT jboolean JNICALL
+Java_edu_wpi_first_networktables_NetworkTablesJNI_setDoubleArray__IJLjava_nio_ByteBuffer_2IZ
+  (JNIEnv* env, jclass, jint entry, jlong time, jobject value, jint len,
+   jboolean force)
+{
+  if (len < 0) {
+    illegalArgEx.Throw(env, "len cannot be negative");
+    return false;
+  }
+  auto data = static_cast<const double*>(
+      GetDirectBuffer(env, value, len * sizeof(double)));
+  if (!data) {
+    return false;
+  }
+  auto v = nt::Value::MakeDoubleArray(wpi::ArrayRef<double>(data, len), time);
+  if (force) {
+    nt::SetEntryTypeValue(entry, v);
+    return JNI_TRUE;
+  }
+  return nt::SetEntryValue(entry, v);
+}
+
 /*
  * Class:     edu_wpi_first_networktables_NetworkTablesJNI
  * Method:    setStringArray
@@ -760,7 +824,7 @@ Java_edu_wpi_first_networktables_NetworkTablesJNI_getBooleanArray
  * Signature: (I[D)[D
  */
 JNIEXPORT jdoubleArray JNICALL
-Java_edu_wpi_first_networktables_NetworkTablesJNI_getDoubleArray
+Java_edu_wpi_first_networktables_NetworkTablesJNI_getDoubleArray__I_3D
   (JNIEnv* env, jclass, jint entry, jdoubleArray defaultValue)
 {
   auto val = nt::GetEntryValue(entry);
@@ -770,6 +834,143 @@ Java_edu_wpi_first_networktables_NetworkTablesJNI_getDoubleArray
   return MakeJDoubleArray(env, val->GetDoubleArray());
 }
 
+/*
+ * Class:     edu_wpi_first_networktables_NetworkTablesJNI
+ * Method:    getDoubleArray
+ * Signature: (ILjava/lang/Object;)I
+ */
+JNIEXPORT jint JNICALL
+Java_edu_wpi_first_networktables_NetworkTablesJNI_getDoubleArray__ILjava_nio_ByteBuffer_2
+  (JNIEnv* env, jclass, jint entry, jobject dest)
+{
+  auto data = static_cast<double*>(GetDirectBuffer(env, dest, 0));
+  if (!data) {
+    return -1;
+  }
+  auto val = nt::GetEntryValue(entry);
+  if (!val || !val->IsDoubleArray()) {
+    return -1;
+  }
+  auto arr = val->GetDoubleArray();
+  size_t room = env->GetDirectBufferCapacity(dest) / sizeof(double);
+  std::copy_n(arr.begin(), (std::min)(arr.size(), room), data);
+  return static_cast<jint>(arr.size());
+}
+
+/*
+ * Class:     edu_wpi_first_networktables_NetworkTablesJNI
+ * Method:    getDoubles
+ * Signature: ([ILjava/nio/ByteBuffer;D)I
+ */
+JNIEXPORT jint JNICALL
+Java_edu_wpi_first_networktables_NetworkTablesJNI_getDoubles
+  (JNIEnv* env, jclass, jintArray entries, jobject dest, jdouble defaultValue)
+{
+  wpi::SmallVector<NT_Entry, 64> ids;
+  if (!FromJavaEntries(env, entries, &ids)) {
+    return 0;
+  }
+  auto data = static_cast<double*>(
+      GetDirectBuffer(env, dest, ids.size() * sizeof(double)));
+  if (!data) {
+    return 0;
+  }
+  jint count = 0;
+  for (auto id : ids) {
+    auto val = nt::GetEntryValue(id);
+    if (val && val->IsDouble()) {
+      *data++ = val->GetDouble();
+      ++count;
+    } else {
+      *data++ = defaultValue;
+    }
+  }
+  return count;
+}
+
+/*
+ * Class:     edu_wpi_first_networktables_NetworkTablesJNI
+ * Method:    getBooleans
+ * Signature: ([ILjava/nio/ByteBuffer;Z)I
+ */
+JNIEXPORT jint JNICALL
+Java_edu_wpi_first_networktables_NetworkTablesJNI_getBooleans
+  (JNIEnv* env, jclass, jintArray entries, jobject dest,
+   jboolean defaultValue)
+{
+  wpi::SmallVector<NT_Entry, 64> ids;
+  if (!FromJavaEntries(env, entries, &ids)) {
+    return 0;
+  }
+  auto data = static_cast<uint8_t*>(GetDirectBuffer(env, dest, ids.size()));
+  if (!data) {
+    return 0;
+  }
+  jint count = 0;
+  for (auto id : ids) {
+    auto val = nt::GetEntryValue(id);
+    if (val && val->IsBoolean()) {
+      *data++ = val->GetBoolean() ? 1 : 0;
+      ++count;
+    } else {
+      *data++ = defaultValue ? 1 : 0;
+    }
+  }
+  return count;
+}
+
+/*
+ * Class:     edu_wpi_first_networktables_NetworkTablesJNI
+ * Method:    setDoubles
+ * Signature: ([IJLjava/nio/ByteBuffer;)Z
+ */
+JNIEXPORT jboolean JNICALL
+Java_edu_wpi_first_networktables_NetworkTablesJNI_setDoubles
+  (JNIEnv* env, jclass, jintArray entries, jlong time, jobject values)
+{
+  wpi::SmallVector<NT_Entry, 64> ids;
+  if (!FromJavaEntries(env, entries, &ids)) {
+    return false;
+  }
+  auto data = static_cast<const double*>(
+      GetDirectBuffer(env, values, ids.size() * sizeof(double)));
+  if (!data) {
+    return false;
+  }
+  std::vector<std::shared_ptr<nt::Value>> vals;
+  vals.reserve(ids.size());
+  for (size_t i = 0; i < ids.size(); ++i) {
+    vals.emplace_back(nt::Value::MakeDouble(data[i], time));
+  }
+  return nt::SetEntryValues(ids, vals);
+}
+
+/*
+ * Class:     edu_wpi_first_networktables_NetworkTablesJNI
+ * Method:    setBooleans
+ * Signature: ([IJLjava/nio/ByteBuffer;)Z
+ */
+JNIEXPORT jboolean JNICALL
+Java_edu_wpi_first_networktables_NetworkTablesJNI_setBooleans
+  (JNIEnv* env, jclass, jintArray entries, jlong time, jobject values)
+{
+  wpi::SmallVector<NT_Entry, 64> ids;
+  if (!FromJavaEntries(env, entries, &ids)) {
+    return false;
+  }
+  auto data =
+      static_cast<const uint8_t*>(GetDirectBuffer(env, values, ids.size()));
+  if (!data) {
+    return false;
+  }
+  std::vector<std::shared_ptr<nt::Value>> vals;
+  vals.reserve(ids.size());
+  for (size_t i = 0; i < ids.size(); ++i) {
+    vals.emplace_back(nt::Value::MakeBoolean(data[i] != 0, time));
+  }
+  return nt::SetEntryValues(ids, vals);
+}
+
 /*
  * Class:     edu_wpi_first_networktables_NetworkTablesJNI
  * Method:    getStringArray
@@ -995,6 +1196,20 @@ Java_edu_wpi_first_networktables_NetworkTablesJNI_createEntryListenerPoller
   return nt::CreateEntryListenerPoller(inst);
 }
 
+/*
+ * Class:     edu_wpi_first_networktables_NetworkTablesJNI
+ * Method:    createBoundedEntryListenerPoller
+ * Signature: (III)I
+ */
+JNIEXPORT jint JNICALL
+Java_edu_wpi_first_networktables_NetworkTablesJNI_createBoundedEntryListenerPoller
+  (JNIEnv*, jclass, jint inst, jint capacity, jint overflow)
+{
+  return nt::CreateEntryListenerPoller(
+      inst, capacity > 0 ? capacity : 1,
+      static_cast<NT_PollerOverflow>(overflow));
+}
+
 /*
  * Class:     edu_wpi_first_networktables_NetworkTablesJNI
  * Method:    destroyEntryListenerPoller
@@ -1083,6 +1298,18 @@ Java_edu_wpi_first_networktables_NetworkTablesJNI_cancelPollEntryListener
   nt::CancelPollEntryListener(poller);
 }
 
+/*
+ * Class:     edu_wpi_first_networktables_NetworkTablesJNI
+ * Method:    getEntryListenerPollerDropped
+ * Signature: (I)J
+ */
+JNIEXPORT jlong JNICALL
+Java_edu_wpi_first_networktables_NetworkTablesJNI_getEntryListenerPollerDropped
+  (JNIEnv*, jclass, jint poller)
+{
+  return nt::GetEntryListenerPollerDropped(poller);
+}
+
 /*
  * Class:     edu_wpi_first_networktables_NetworkTablesJNI
  * Method:    removeEntryListener
@@ -1119,6 +1346,20 @@ Java_edu_wpi_first_networktables_NetworkTablesJNI_createConnectionListenerPoller
   return nt::CreateConnectionListenerPoller(inst);
 }
 
+/*
+ * Class:     edu_wpi_first_networktables_NetworkTablesJNI
+ * Method:    createBoundedConnectionListenerPoller
+ * Signature: (III)I
+ */
+JNIEXPORT jint JNICALL
+Java_edu_wpi_first_networktables_NetworkTablesJNI_createBoundedConnectionListenerPoller
+  (JNIEnv*, jclass, jint inst, jint capacity, jint overflow)
+{
+  return nt::CreateConnectionListenerPoller(
+      inst, capacity > 0 ? capacity : 1,
+      static_cast<NT_PollerOverflow>(overflow));
+}
+
 /*
  * Class:     edu_wpi_first_networktables_NetworkTablesJNI
  * Method:    destroyConnectionListenerPoller
@@ -1190,6 +1431,18 @@ Java_edu_wpi_first_networktables_NetworkTablesJNI_cancelPollConnectionListener
   nt::CancelPollConnectionListener(poller);
 }
 
+/*
+ * Class:     edu_wpi_first_networktables_NetworkTablesJNI
+ * Method:    getConnectionListenerPollerDropped
+ * Signature: (I)J
+ */
+JNIEXPORT jlong JNICALL
+Java_edu_wpi_first_networktables_NetworkTablesJNI_getConnectionListenerPollerDropped
+  (JNIEnv*, jclass, jint poller)
+{
+  return nt::GetConnectionListenerPollerDropped(poller);
+}
+
 /*
  * Class:     edu_wpi_first_networktables_NetworkTablesJNI
  * Method:    removeConnectionListener
@@ -39,6 +39,19 @@ static void ConvertToC(const ConnectionInfo& in, NT_ConnectionInfo* out) {
   out->protocol_version = in.protocol_version;
 }
 
+static void ConvertToC(const ConnectionMetrics& in,
+                       NT_ConnectionMetrics* out) {
+  ConvertToC(in.info, &out->info);
+  out->bytes_sent = in.bytes_sent;
+  out->bytes_received = in.bytes_received;
+  out->messages_sent = in.messages_sent;
+  out->messages_received = in.messages_received;
+  out->queue_depth = in.queue_depth;
+  out->flush_latency = in.flush_latency;
+  out->handshake_duration = in.handshake_duration;
+  out->rtt = in.rtt;
+}
+
 static void ConvertToC(const RpcParamDef& in, NT_RpcParamDef* out) {
   ConvertToC(in.name, &out->name);
   ConvertToC(*in.def_value, &out->def_value);
@@ -82,6 +95,16 @@ static void ConvertToC(const EntryNotification& in, NT_EntryNotification* out) {
   ConvertToC(in.name, &out->name);
   ConvertToC(*in.value, &out->value);
   out->flags = in.flags;
+  out->history = nullptr;
+  out->history_len = 0;
+  if ((in.flags & NT_NOTIFY_HISTORY) != 0 && !in.history.empty()) {
+    out->history = static_cast<NT_Value*>(
+        wpi::safe_malloc(in.history.size() * sizeof(NT_Value)));
+    out->history_len = in.history.size();
+    for (size_t i = 0; i < in.history.size(); ++i) {
+      ConvertToC(*in.history[i], &out->history[i]);
+    }
+  }
 }
 
 static void ConvertToC(const ConnectionNotification& in,
@@ -127,6 +150,10 @@ static void DisposeEntryInfo(NT_EntryInfo* info) {
 static void DisposeEntryNotification(NT_EntryNotification* info) {
   std::free(info->name.str);
   NT_DisposeValue(&info->value);
+  for (size_t i = 0; i < info->history_len; ++i) {
+    NT_DisposeValue(&info->history[i]);
+  }
+  std::free(info->history);
 }
 
 static void DisposeConnectionNotification(NT_ConnectionNotification* info) {
@@ -225,6 +252,10 @@ uint64_t NT_GetEntryLastChange(NT_Entry entry) {
   return nt::GetEntryLastChange(entry);
 }
 
+uint64_t NT_GetEntryUpdateCount(NT_Entry entry) {
+  return nt::GetEntryUpdateCount(entry);
+}
+
 void NT_GetEntryValue(NT_Entry entry, struct NT_Value* value) {
   NT_InitValue(value);
   auto v = nt::GetEntryValue(entry);
@@ -243,6 +274,16 @@ int NT_SetEntryValue(NT_Entry entry, const struct NT_Value* value) {
   return nt::SetEntryValue(entry, ConvertFromC(*value));
 }
 
+NT_Bool NT_SetEntryValues(const NT_Entry* entries,
+                          const struct NT_Value* values, size_t count) {
+  std::vector<std::shared_ptr<Value>> v;
+  v.reserve(count);
+  for (size_t i = 0; i < count; ++i) {
+    v.emplace_back(ConvertFromC(values[i]));
+  }
+  return nt::SetEntryValues(wpi::makeArrayRef(entries, count), v);
+}
+
 void NT_SetEntryTypeValue(NT_Entry entry, const struct NT_Value* value) {
   nt::SetEntryTypeValue(entry, ConvertFromC(*value));
 }
@@ -317,6 +358,11 @@ NT_EntryListenerPoller NT_CreateEntryListenerPoller(NT_Inst inst) {
   return nt::CreateEntryListenerPoller(inst);
 }
 
+NT_EntryListenerPoller NT_CreateBoundedEntryListenerPoller(
+    NT_Inst inst, size_t capacity, enum NT_PollerOverflow overflow) {
+  return nt::CreateEntryListenerPoller(inst, capacity, overflow);
+}
+
 void NT_DestroyEntryListenerPoller(NT_EntryListenerPoller poller) {
   nt::DestroyEntryListenerPoller(poller);
 }
@@ -354,6 +400,10 @@ void NT_CancelPollEntryListener(NT_EntryListenerPoller poller) {
   nt::CancelPollEntryListener(poller);
 }
 
+uint64_t NT_GetEntryListenerPollerDropped(NT_EntryListenerPoller poller) {
+  return nt::GetEntryListenerPollerDropped(poller);
+}
+
 void NT_RemoveEntryListener(NT_EntryListener entry_listener) {
   nt::RemoveEntryListener(entry_listener);
 }
@@ -380,6 +430,11 @@ NT_ConnectionListenerPoller NT_CreateConnectionListenerPoller(NT_Inst inst) {
   return nt::CreateConnectionListenerPoller(inst);
 }
 
+NT_ConnectionListenerPoller NT_CreateBoundedConnectionListenerPoller(
+    NT_Inst inst, size_t capacity, enum NT_PollerOverflow overflow) {
+  return nt::CreateConnectionListenerPoller(inst, capacity, overflow);
+}
+
 void NT_DestroyConnectionListenerPoller(NT_ConnectionListenerPoller poller) {
   nt::DestroyConnectionListenerPoller(poller);
 }
@@ -408,6 +463,11 @@ void NT_CancelPollConnectionListener(NT_ConnectionListenerPoller poller) {
   nt::CancelPollConnectionListener(poller);
 }
 
+uint64_t NT_GetConnectionListenerPollerDropped(
+    NT_ConnectionListenerPoller poller) {
+  return nt::GetConnectionListenerPollerDropped(poller);
+}
+
 void NT_RemoveConnectionListener(NT_ConnectionListener conn_listener) {
   nt::RemoveConnectionListener(conn_listener);
 }
@@ -593,6 +653,10 @@ void NT_StartServer(NT_Inst inst, const char* persist_filename,
   nt::StartServer(inst, persist_filename, listen_address, port);
 }
 
+void NT_SetServerEventLoop(NT_Inst inst, NT_Bool enable) {
+  nt::SetServerEventLoop(inst, enable);
+}
+
 void NT_StopServer(NT_Inst inst) {
   nt::StopServer(inst);
 }
@@ -653,6 +717,51 @@ void NT_SetUpdateRate(NT_Inst inst, double interval) {
   nt::SetUpdateRate(inst, interval);
 }
 
+void NT_SetNetworkCompression(NT_Inst inst, NT_Bool enable) {
+  nt::SetNetworkCompression(inst, enable);
+}
+
+void NT_SetNetworkSessionResume(NT_Inst inst, NT_Bool enable) {
+  nt::SetNetworkSessionResume(inst, enable);
+}
+
+void NT_SetRpcWorkerThreads(NT_Inst inst, unsigned int count) {
+  nt::SetRpcWorkerThreads(inst, count);
+}
+
+void NT_SetNetworkDatagrams(NT_Inst inst, NT_Bool enable) {
+  nt::SetNetworkDatagrams(inst, enable);
+}
+
+void NT_SetPublishPolicy(NT_Inst inst, const char* prefix, size_t prefix_len,
+                         const struct NT_PublishPolicy* policy) {
+  nt::PublishPolicy cpp_policy;
+  cpp_policy.period = policy->period;
+  cpp_policy.abs_deadband = policy->abs_deadband;
+  cpp_policy.rel_deadband = policy->rel_deadband;
+  cpp_policy.latest_only = policy->latest_only;
+  nt::SetPublishPolicy(inst, wpi::StringRef(prefix, prefix_len), cpp_policy);
+}
+
+void NT_ClearPublishPolicy(NT_Inst inst, const char* prefix,
+                           size_t prefix_len) {
+  nt::ClearPublishPolicy(inst, wpi::StringRef(prefix, prefix_len));
+}
+
+NT_Bool NT_GetPublishPolicyStats(NT_Inst inst, const char* prefix,
+                                 size_t prefix_len,
+                                 struct NT_PublishPolicyStats* stats) {
+  nt::PublishPolicyStats cpp_stats;
+  if (!nt::GetPublishPolicyStats(inst, wpi::StringRef(prefix, prefix_len),
+                                 &cpp_stats)) {
+    return false;
+  }
+  stats->rate_limited = cpp_stats.rate_limited;
+  stats->deadband = cpp_stats.deadband;
+  stats->coalesced = cpp_stats.coalesced;
+  return true;
+}
+
 void NT_Flush(NT_Inst inst) {
   nt::Flush(inst);
 }
@@ -666,6 +775,16 @@ struct NT_ConnectionInfo* NT_GetConnections(NT_Inst inst, size_t* count) {
   return ConvertToC<NT_ConnectionInfo>(conn_v, count);
 }
 
+struct NT_ConnectionMetrics* NT_GetConnectionMetrics(NT_Inst inst,
+                                                     size_t* count) {
+  auto metrics_v = nt::GetConnectionMetrics(inst);
+  return ConvertToC<NT_ConnectionMetrics>(metrics_v, count);
+}
+
+void NT_SetMetricsPublishing(NT_Inst inst, NT_Bool enable) {
+  nt::SetMetricsPublishing(inst, enable);
+}
+
 /*
  * File Save/Load Functions
  */
@@ -808,6 +927,14 @@ void NT_DisposeConnectionInfoArray(NT_ConnectionInfo* arr, size_t count) {
   std::free(arr);
 }
 
+void NT_DisposeConnectionMetricsArray(NT_ConnectionMetrics* arr,
+                                      size_t count) {
+  for (size_t i = 0; i < count; i++) {
+    DisposeConnectionInfo(&arr[i].info);
+  }
+  std::free(arr);
+}
+
 void NT_DisposeEntryInfoArray(NT_EntryInfo* arr, size_t count) {
   for (size_t i = 0; i < count; i++) {
     DisposeEntryInfo(&arr[i]);
@@ -8,6 +8,7 @@
 #include <cstdio>
 #include <cstdlib>
 
+#include <wpi/SmallVector.h>
 #include <wpi/timestamp.h>
 
 #include "Handle.h"
@@ -116,6 +117,17 @@ uint64_t GetEntryLastChange(NT_Entry entry) {
   return ii->storage.GetEntryLastChange(id);
 }
 
+uint64_t GetEntryUpdateCount(NT_Entry entry) {
+  Handle handle{entry};
+  int id = handle.GetTypedIndex(Handle::kEntry);
+  auto ii = InstanceImpl::Get(handle.GetInst());
+  if (id < 0 || !ii) {
+    return 0;
+  }
+
+  return ii->storage.GetEntryUpdateCount(id);
+}
+
 std::shared_ptr<Value> GetEntryValue(NT_Entry entry) {
   Handle handle{entry};
   int id = handle.GetTypedIndex(Handle::kEntry);
@@ -149,6 +161,30 @@ bool SetEntryValue(NT_Entry entry, std::shared_ptr<Value> value) {
   return ii->storage.SetEntryValue(id, value);
 }
 
+bool SetEntryValues(wpi::ArrayRef<NT_Entry> entries,
+                    wpi::ArrayRef<std::shared_ptr<Value>> values) {
+  if (entries.empty()) {
+    return entries.size() == values.size();
+  }
+  int inst = Handle{entries[0]}.GetInst();
+  wpi::SmallVector<unsigned int, 16> ids;
+  ids.reserve(entries.size());
+  for (auto entry : entries) {
+    Handle handle{entry};
+    int id = handle.GetTypedIndex(Handle::kEntry);
+    if (id < 0 || handle.GetInst() != inst) {
+      return false;
+    }
+    ids.push_back(id);
+  }
+  auto ii = InstanceImpl::Get(inst);
+  if (!ii) {
+    return false;
+  }
+
+  return ii->storage.SetEntryValues(ids, values);
+}
+
 void SetEntryTypeValue(NT_Entry entry, std::shared_ptr<Value> value) {
   Handle handle{entry};
   int id = handle.GetTypedIndex(Handle::kEntry);
@@ -276,6 +312,30 @@ NT_EntryListenerPoller CreateEntryListenerPoller(NT_Inst inst) {
                 Handle::kEntryListenerPoller);
 }
 
+static wpi::PollerOverflow ConvertOverflow(NT_PollerOverflow overflow) {
+  switch (overflow) {
+    case NT_POLLER_DROP_NEWEST:
+      return wpi::PollerOverflow::kDropNewest;
+    case NT_POLLER_COALESCE:
+      return wpi::PollerOverflow::kCoalesce;
+    default:
+      return wpi::PollerOverflow::kDropOldest;
+  }
+}
+
+NT_EntryListenerPoller CreateEntryListenerPoller(NT_Inst inst, size_t capacity,
+                                                 NT_PollerOverflow overflow) {
+  int i = Handle{inst}.GetTypedInst(Handle::kInstance);
+  auto ii = InstanceImpl::Get(i);
+  if (!ii) {
+    return 0;
+  }
+
+  return Handle(
+      i, ii->entry_notifier.CreatePoller(capacity, ConvertOverflow(overflow)),
+      Handle::kEntryListenerPoller);
+}
+
 void DestroyEntryListenerPoller(NT_EntryListenerPoller poller) {
   Handle handle{poller};
   int id = handle.GetTypedIndex(Handle::kEntryListenerPoller);
@@ -352,6 +412,21 @@ std::vector<EntryNotification> PollEntryListener(NT_EntryListenerPoller poller,
                                  timed_out);
 }
 
+size_t PollEntryListener(NT_EntryListenerPoller poller,
+                         std::vector<EntryNotification>* events,
+                         size_t max_events, double timeout, bool* timed_out) {
+  *timed_out = false;
+  Handle handle{poller};
+  int id = handle.GetTypedIndex(Handle::kEntryListenerPoller);
+  auto ii = InstanceImpl::Get(handle.GetInst());
+  if (id < 0 || !ii) {
+    return 0;
+  }
+
+  return ii->entry_notifier.PollBatch(static_cast<unsigned int>(id), events,
+                                      max_events, timeout, timed_out);
+}
+
 void CancelPollEntryListener(NT_EntryListenerPoller poller) {
   Handle handle{poller};
   int id = handle.GetTypedIndex(Handle::kEntryListenerPoller);
@@ -363,6 +438,17 @@ void CancelPollEntryListener(NT_EntryListenerPoller poller) {
   ii->entry_notifier.CancelPoll(id);
 }
 
+uint64_t GetEntryListenerPollerDropped(NT_EntryListenerPoller poller) {
+  Handle handle{poller};
+  int id = handle.GetTypedIndex(Handle::kEntryListenerPoller);
+  auto ii = InstanceImpl::Get(handle.GetInst());
+  if (id < 0 || !ii) {
+    return 0;
+  }
+
+  return ii->entry_notifier.GetPollerDropped(id);
+}
+
 void RemoveEntryListener(NT_EntryListener entry_listener) {
   Handle handle{entry_listener};
   int uid = handle.GetTypedIndex(Handle::kEntryListener);
@@ -408,6 +494,20 @@ NT_ConnectionListenerPoller CreateConnectionListenerPoller(NT_Inst inst) {
                 Handle::kConnectionListenerPoller);
 }
 
+NT_ConnectionListenerPoller CreateConnectionListenerPoller(
+    NT_Inst inst, size_t capacity, NT_PollerOverflow overflow) {
+  int i = Handle{inst}.GetTypedInst(Handle::kInstance);
+  auto ii = InstanceImpl::Get(i);
+  if (!ii) {
+    return 0;
+  }
+
+  return Handle(i,
+                ii->connection_notifier.CreatePoller(
+                    capacity, ConvertOverflow(overflow)),
+                Handle::kConnectionListenerPoller);
+}
+
 void DestroyConnectionListenerPoller(NT_ConnectionListenerPoller poller) {
   Handle handle{poller};
   int id = handle.GetTypedIndex(Handle::kConnectionListenerPoller);
@@ -459,6 +559,23 @@ std::vector<ConnectionNotification> PollConnectionListener(
                                       timed_out);
 }
 
+size_t PollConnectionListener(NT_ConnectionListenerPoller poller,
+                              std::vector<ConnectionNotification>* events,
+                              size_t max_events, double timeout,
+                              bool* timed_out) {
+  *timed_out = false;
+  Handle handle{poller};
+  int id = handle.GetTypedIndex(Handle::kConnectionListenerPoller);
+  auto ii = InstanceImpl::Get(handle.GetInst());
+  if (id < 0 || !ii) {
+    return 0;
+  }
+
+  return ii->connection_notifier.PollBatch(static_cast<unsigned int>(id),
+                                           events, max_events, timeout,
+                                           timed_out);
+}
+
 void CancelPollConnectionListener(NT_ConnectionListenerPoller poller) {
   Handle handle{poller};
   int id = handle.GetTypedIndex(Handle::kConnectionListenerPoller);
@@ -470,6 +587,18 @@ void CancelPollConnectionListener(NT_ConnectionListenerPoller poller) {
   ii->connection_notifier.CancelPoll(id);
 }
 
+uint64_t GetConnectionListenerPollerDropped(
+    NT_ConnectionListenerPoller poller) {
+  Handle handle{poller};
+  int id = handle.GetTypedIndex(Handle::kConnectionListenerPoller);
+  auto ii = InstanceImpl::Get(handle.GetInst());
+  if (id < 0 || !ii) {
+    return 0;
+  }
+
+  return ii->connection_notifier.GetPollerDropped(id);
+}
+
 void RemoveConnectionListener(NT_ConnectionListener conn_listener) {
   Handle handle{conn_listener};
   int uid = handle.GetTypedIndex(Handle::kConnectionListener);
@@ -608,6 +737,15 @@ bool WaitForRpcCallQueue(NT_Inst inst, double timeout) {
   return ii->rpc_server.WaitForQueue(timeout);
 }
 
+void SetRpcWorkerThreads(NT_Inst inst, unsigned int count) {
+  auto ii = InstanceImpl::Get(Handle{inst}.GetTypedInst(Handle::kInstance));
+  if (!ii) {
+    return;
+  }
+
+  ii->rpc_server.SetWorkerThreads(count);
+}
+
 bool PostRpcResponse(NT_Entry entry, NT_RpcCall call, wpi::StringRef result) {
   Handle handle{entry};
   int id = handle.GetTypedIndex(Handle::kEntry);
@@ -644,6 +782,18 @@ NT_RpcCall CallRpc(NT_Entry entry, wpi::StringRef params) {
   return Handle(i, call_uid, Handle::kRpcCall);
 }
 
+wpi::future<std::string> CallRpcAsync(NT_Entry entry, wpi::StringRef params) {
+  Handle handle{entry};
+  int id = handle.GetTypedIndex(Handle::kEntry);
+  auto ii = InstanceImpl::Get(handle.GetInst());
+  if (id < 0 || !ii) {
+    return wpi::PromiseFactory<std::string>::GetInstance().MakeReadyFuture(
+        std::string{});
+  }
+
+  return ii->storage.CallRpcAsync(id, params);
+}
+
 bool GetRpcResult(NT_Entry entry, NT_RpcCall call, std::string* result) {
   Handle handle{entry};
   int id = handle.GetTypedIndex(Handle::kEntry);
@@ -870,6 +1020,15 @@ void StartServer(NT_Inst inst, const wpi::Twine& persist_filename,
   ii->dispatcher.StartServer(persist_filename, listen_address, port);
 }
 
+void SetServerEventLoop(NT_Inst inst, bool enable) {
+  auto ii = InstanceImpl::Get(Handle{inst}.GetTypedInst(Handle::kInstance));
+  if (!ii) {
+    return;
+  }
+
+  ii->dispatcher.SetServerEventLoop(enable);
+}
+
 void StopServer(NT_Inst inst) {
   auto ii = InstanceImpl::Get(Handle{inst}.GetTypedInst(Handle::kInstance));
   if (!ii) {
@@ -984,6 +1143,62 @@ void SetUpdateRate(NT_Inst inst, double interval) {
   ii->dispatcher.SetUpdateRate(interval);
 }
 
+void SetNetworkCompression(NT_Inst inst, bool enable) {
+  auto ii = InstanceImpl::Get(Handle{inst}.GetTypedInst(Handle::kInstance));
+  if (!ii) {
+    return;
+  }
+
+  ii->dispatcher.SetNetworkCompression(enable);
+}
+
+void SetNetworkSessionResume(NT_Inst inst, bool enable) {
+  auto ii = InstanceImpl::Get(Handle{inst}.GetTypedInst(Handle::kInstance));
+  if (!ii) {
+    return;
+  }
+
+  ii->dispatcher.SetNetworkSessionResume(enable);
+}
+
+void SetNetworkDatagrams(NT_Inst inst, bool enable) {
+  auto ii = InstanceImpl::Get(Handle{inst}.GetTypedInst(Handle::kInstance));
+  if (!ii) {
+    return;
+  }
+
+  ii->dispatcher.SetNetworkDatagrams(enable);
+}
+
+void SetPublishPolicy(NT_Inst inst, const wpi::Twine& prefix,
+                      const PublishPolicy& policy) {
+  auto ii = InstanceImpl::Get(Handle{inst}.GetTypedInst(Handle::kInstance));
+  if (!ii) {
+    return;
+  }
+
+  ii->dispatcher.SetPublishPolicy(prefix, policy);
+}
+
+void ClearPublishPolicy(NT_Inst inst, const wpi::Twine& prefix) {
+  auto ii = InstanceImpl::Get(Handle{inst}.GetTypedInst(Handle::kInstance));
+  if (!ii) {
+    return;
+  }
+
+  ii->dispatcher.ClearPublishPolicy(prefix);
+}
+
+bool GetPublishPolicyStats(NT_Inst inst, const wpi::Twine& prefix,
+                           PublishPolicyStats* stats) {
+  auto ii = InstanceImpl::Get(Handle{inst}.GetTypedInst(Handle::kInstance));
+  if (!ii) {
+    return false;
+  }
+
+  return ii->dispatcher.GetPublishPolicyStats(prefix, stats);
+}
+
 void Flush(NT_Inst inst) {
   auto ii = InstanceImpl::Get(Handle{inst}.GetTypedInst(Handle::kInstance));
   if (!ii) {
@@ -1011,6 +1226,24 @@ bool IsConnected(NT_Inst inst) {
   return ii->dispatcher.IsConnected();
 }
 
+std::vector<ConnectionMetrics> GetConnectionMetrics(NT_Inst inst) {
+  auto ii = InstanceImpl::Get(Handle{inst}.GetTypedInst(Handle::kInstance));
+  if (!ii) {
+    return {};
+  }
+
+  return ii->dispatcher.GetConnectionMetrics();
+}
+
+void SetMetricsPublishing(NT_Inst inst, bool enable) {
+  auto ii = InstanceImpl::Get(Handle{inst}.GetTypedInst(Handle::kInstance));
+  if (!ii) {
+    return;
+  }
+
+  ii->dispatcher.SetMetricsPublishing(enable);
+}
+
 /*
  * Persistent Functions
  */
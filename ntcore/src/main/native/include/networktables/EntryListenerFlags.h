@@ -67,7 +67,15 @@ enum {
    * Set this flag to receive a notification when an entry's flags value
    * changes.
    */
-  kFlags = NT_NOTIFY_FLAGS
+  kFlags = NT_NOTIFY_FLAGS,
+
+  /**
+   * Value updates batched.
+   * Set this flag (with kUpdate) to receive the remote updates of an entry
+   * with the kHistory flag that arrive together as a single notification
+   * holding every value, instead of only the latest one.
+   */
+  kHistory = NT_NOTIFY_HISTORY
 };
 
 }  // namespace nt::EntryListenerFlags
@@ -34,7 +34,11 @@ class NetworkTableEntry final {
   /**
    * Flag values (as returned by GetFlags()).
    */
-  enum Flags { kPersistent = NT_PERSISTENT };
+  enum Flags {
+    kPersistent = NT_PERSISTENT,
+    kUnreliable = NT_UNRELIABLE,
+    kHistory = NT_HISTORY
+  };
 
   /**
    * Construct invalid instance.
@@ -104,6 +108,14 @@ class NetworkTableEntry final {
    */
   uint64_t GetLastChange() const;
 
+  /**
+   * Gets the number of times the entry's value has been set, locally or by a
+   * remote node.
+   *
+   * @return Entry update count
+   */
+  uint64_t GetUpdateCount() const;
+
   /**
    * Gets combined information about the entry.
    *
@@ -598,6 +610,15 @@ class NetworkTableEntry final {
    */
   RpcCall CallRpc(wpi::StringRef params);
 
+  /**
+   * Call a RPC function asynchronously.  May be used on either the client
+   * or server.  Any number of calls may be outstanding at once.
+   *
+   * @param params      parameter
+   * @return Future for the result; empty if the call could not be made.
+   */
+  wpi::future<std::string> CallRpcAsync(wpi::StringRef params);
+
   /**
    * Add a listener for changes to this entry.
    *
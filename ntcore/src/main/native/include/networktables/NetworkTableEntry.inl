@@ -42,6 +42,10 @@ inline uint64_t NetworkTableEntry::GetLastChange() const {
   return GetEntryLastChange(m_handle);
 }
 
+inline uint64_t NetworkTableEntry::GetUpdateCount() const {
+  return GetEntryUpdateCount(m_handle);
+}
+
 inline EntryInfo NetworkTableEntry::GetInfo() const {
   return GetEntryInfo(m_handle);
 }
@@ -328,6 +332,11 @@ inline RpcCall NetworkTableEntry::CallRpc(wpi::StringRef params) {
   return RpcCall{m_handle, ::nt::CallRpc(m_handle, params)};
 }
 
+inline wpi::future<std::string> NetworkTableEntry::CallRpcAsync(
+    wpi::StringRef params) {
+  return ::nt::CallRpcAsync(m_handle, params);
+}
+
 inline NT_EntryListener NetworkTableEntry::AddListener(
     std::function<void(const EntryNotification& event)> callback,
     unsigned int flags) const {
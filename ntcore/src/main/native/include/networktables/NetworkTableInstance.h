@@ -161,6 +161,22 @@ class NetworkTableInstance final {
   std::vector<EntryInfo> GetEntryInfo(const wpi::Twine& prefix,
                                       unsigned int types) const;
 
+  /**
+   * Sets the values of several entries as a group.
+   *
+   * The values are set under a single lock acquisition, so no other change
+   * is interleaved with them, and they are sent to remote peers in the same
+   * network update.  This is useful for values that must be consistent with
+   * each other, such as the components of a pose.  If the type of any new
+   * value differs from the type of its entry, no value is updated.
+   *
+   * @param entries entries to set (must belong to this instance)
+   * @param values new values (same length as entries)
+   * @return False on error (type mismatch or invalid entry), True on success
+   */
+  bool SetEntryValues(wpi::ArrayRef<NetworkTableEntry> entries,
+                      wpi::ArrayRef<std::shared_ptr<Value>> values);
+
   /**
    * Gets the table with the specified key.
    *
@@ -268,6 +284,15 @@ class NetworkTableInstance final {
    */
   bool WaitForRpcCallQueue(double timeout);
 
+  /**
+   * Set the number of threads that run RPC callbacks, so several calls can
+   * run at once.  By default (0) callbacks run one at a time on the RPC
+   * callback thread.
+   *
+   * @param count     number of worker threads, or 0 for none
+   */
+  void SetRpcWorkerThreads(unsigned int count);
+
   /** @} */
 
   /**
@@ -318,6 +343,15 @@ class NetworkTableInstance final {
                    const char* listen_address = "",
                    unsigned int port = kDefaultPort);
 
+  /**
+   * Selects the server implementation used by subsequent calls to
+   * StartServer().  When enabled, all client connections are serviced by a
+   * single event loop thread instead of a pair of threads per connection.
+   *
+   * @param enable  true to use the event loop server
+   */
+  void SetServerEventLoop(bool enable);
+
   /**
    * Stops the server if it is running.
    */
@@ -427,6 +461,61 @@ class NetworkTableInstance final {
    */
   void SetUpdateRate(double interval);
 
+  /**
+   * Enables LZ4 compression of network traffic.  Compression is negotiated
+   * per connection and only used when both ends have it enabled.  Applies
+   * to connections made after this call.
+   *
+   * @param enable  true to enable compression
+   */
+  void SetNetworkCompression(bool enable);
+
+  /**
+   * Enables resumable sessions for a client.  On reconnecting to the same
+   * server instance, only entries that changed while disconnected are
+   * sent instead of every entry.
+   *
+   * @param enable  true to enable session resume
+   */
+  void SetNetworkSessionResume(bool enable);
+
+  /**
+   * Enables the datagram channel for updates to entries with the
+   * kUnreliable flag, which may then be lost or superseded.  Only used
+   * when both ends have it enabled.  Applies the next time the server or
+   * client is started.
+   *
+   * @param enable  true to enable the datagram channel
+   */
+  void SetNetworkDatagrams(bool enable);
+
+  /**
+   * Sets the publish policy for entries starting with a prefix.  When
+   * several policy prefixes match an entry, the longest one is used.
+   *
+   * @param prefix  entry name prefix (empty for all entries)
+   * @param policy  publish policy
+   */
+  void SetPublishPolicy(const wpi::Twine& prefix, const PublishPolicy& policy);
+
+  /**
+   * Removes the publish policy for a prefix.
+   *
+   * @param prefix  entry name prefix passed to SetPublishPolicy()
+   */
+  void ClearPublishPolicy(const wpi::Twine& prefix);
+
+  /**
+   * Gets the number of updates suppressed by the publish policy for a
+   * prefix, summed over all connections.
+   *
+   * @param prefix  entry name prefix passed to SetPublishPolicy()
+   * @param stats   counters (output)
+   * @return False if there is no policy for the prefix.
+   */
+  bool GetPublishPolicyStats(const wpi::Twine& prefix,
+                             PublishPolicyStats* stats) const;
+
   /**
    * Flushes all updated values immediately to the network.
    * @note This is rate-limited to protect the network from flooding.
@@ -450,6 +539,22 @@ class NetworkTableInstance final {
    */
   bool IsConnected() const;
 
+  /**
+   * Get traffic and timing counters for the currently established network
+   * connections.
+   *
+   * @return array of connection metrics
+   */
+  std::vector<ConnectionMetrics> GetConnectionMetrics() const;
+
+  /**
+   * Enable or disable publishing of connection metrics under the
+   * "/.nt/metrics" table.
+   *
+   * @param enable  true to publish metrics
+   */
+  void SetMetricsPublishing(bool enable);
+
   /** @} */
 
   /**
@@ -54,6 +54,20 @@ inline std::vector<EntryInfo> NetworkTableInstance::GetEntryInfo(
   return ::nt::GetEntryInfo(m_handle, prefix, types);
 }
 
+inline bool NetworkTableInstance::SetEntryValues(
+    wpi::ArrayRef<NetworkTableEntry> entries,
+    wpi::ArrayRef<std::shared_ptr<Value>> values) {
+  std::vector<NT_Entry> handles;
+  handles.reserve(entries.size());
+  for (auto& entry : entries) {
+    if (::nt::GetInstanceFromHandle(entry.GetHandle()) != m_handle) {
+      return false;
+    }
+    handles.push_back(entry.GetHandle());
+  }
+  return ::nt::SetEntryValues(handles, values);
+}
+
 inline void NetworkTableInstance::DeleteAllEntries() {
   ::nt::DeleteAllEntries(m_handle);
 }
@@ -81,6 +95,10 @@ inline bool NetworkTableInstance::WaitForRpcCallQueue(double timeout) {
   return ::nt::WaitForRpcCallQueue(m_handle, timeout);
 }
 
+inline void NetworkTableInstance::SetRpcWorkerThreads(unsigned int count) {
+  ::nt::SetRpcWorkerThreads(m_handle, count);
+}
+
 inline void NetworkTableInstance::SetNetworkIdentity(const wpi::Twine& name) {
   ::nt::SetNetworkIdentity(m_handle, name);
 }
@@ -103,6 +121,10 @@ inline void NetworkTableInstance::StartServer(
   ::nt::StartServer(m_handle, persist_filename, listen_address, port);
 }
 
+inline void NetworkTableInstance::SetServerEventLoop(bool enable) {
+  ::nt::SetServerEventLoop(m_handle, enable);
+}
+
 inline void NetworkTableInstance::StopServer() {
   ::nt::StopServer(m_handle);
 }
@@ -157,6 +179,33 @@ inline void NetworkTableInstance::SetUpdateRate(double interval) {
   ::nt::SetUpdateRate(m_handle, interval);
 }
 
+inline void NetworkTableInstance::SetNetworkCompression(bool enable) {
+  ::nt::SetNetworkCompression(m_handle, enable);
+}
+
+inline void NetworkTableInstance::SetNetworkSessionResume(bool enable) {
+  ::nt::SetNetworkSessionResume(m_handle, enable);
+}
+
+inline void NetworkTableInstance::SetNetworkDatagrams(bool enable) {
+  ::nt::SetNetworkDatagrams(m_handle, enable);
+}
+
+inline void NetworkTableInstance::SetPublishPolicy(
+    const wpi::Twine& prefix, const PublishPolicy& policy) {
+  ::nt::SetPublishPolicy(m_handle, prefix, policy);
+}
+
+inline void NetworkTableInstance::ClearPublishPolicy(
+    const wpi::Twine& prefix) {
+  ::nt::ClearPublishPolicy(m_handle, prefix);
+}
+
+inline bool NetworkTableInstance::GetPublishPolicyStats(
+    const wpi::Twine& prefix, PublishPolicyStats* stats) const {
+  return ::nt::GetPublishPolicyStats(m_handle, prefix, stats);
+}
+
 inline void NetworkTableInstance::Flush() const {
   ::nt::Flush(m_handle);
 }
@@ -170,6 +219,15 @@ inline bool NetworkTableInstance::IsConnected() const {
   return ::nt::IsConnected(m_handle);
 }
 
+inline std::vector<ConnectionMetrics>
+NetworkTableInstance::GetConnectionMetrics() const {
+  return ::nt::GetConnectionMetrics(m_handle);
+}
+
+inline void NetworkTableInstance::SetMetricsPublishing(bool enable) {
+  ::nt::SetMetricsPublishing(m_handle, enable);
+}
+
 inline const char* NetworkTableInstance::SavePersistent(
     const wpi::Twine& filename) const {
   return ::nt::SavePersistent(m_handle, filename);
@@ -25,6 +25,10 @@ namespace nt {
 
 /**
  * A network table entry value.
+ *
+ * Values are immutable and are always created by the factory functions,
+ * which allocate the contents of strings and arrays together with the value
+ * (and the shared_ptr reference count) as a single block.
  * @ingroup ntcore_cpp_api
  */
 class Value final {
@@ -165,7 +169,7 @@ class Value final {
    */
   wpi::StringRef GetString() const {
     assert(m_val.type == NT_STRING);
-    return m_string;
+    return wpi::StringRef(m_val.data.v_string.str, m_val.data.v_string.len);
   }
 
   /**
@@ -175,7 +179,7 @@ class Value final {
    */
   wpi::StringRef GetRaw() const {
     assert(m_val.type == NT_RAW);
-    return m_string;
+    return wpi::StringRef(m_val.data.v_raw.str, m_val.data.v_raw.len);
   }
 
   /**
@@ -185,7 +189,7 @@ class Value final {
    */
   wpi::StringRef GetRpc() const {
     assert(m_val.type == NT_RPC);
-    return m_string;
+    return wpi::StringRef(m_val.data.v_raw.str, m_val.data.v_raw.len);
   }
 
   /**
@@ -217,7 +221,11 @@ class Value final {
    */
   wpi::ArrayRef<std::string> GetStringArray() const {
     assert(m_val.type == NT_STRING_ARRAY);
-    return m_string_array;
+    // the strings follow the NT_String array (see MakeStringArray)
+    return wpi::ArrayRef<std::string>(
+        reinterpret_cast<const std::string*>(m_val.data.arr_string.arr +
+                                             m_val.data.arr_string.size),
+        m_val.data.arr_string.size);
   }
 
   /** @} */
@@ -264,13 +272,7 @@ class Value final {
    * @return The entry value
    */
   static std::shared_ptr<Value> MakeString(const wpi::Twine& value,
-                                           uint64_t time = 0) {
-    auto val = std::make_shared<Value>(NT_STRING, time, private_init());
-    val->m_string = value.str();
-    val->m_val.data.v_string.str = const_cast<char*>(val->m_string.c_str());
-    val->m_val.data.v_string.len = val->m_string.size();
-    return val;
-  }
+                                           uint64_t time = 0);
 
   /**
    * Creates a string entry value.
@@ -283,11 +285,7 @@ class Value final {
   template <typename T,
             typename std::enable_if<std::is_same<T, std::string>::value>::type>
   static std::shared_ptr<Value> MakeString(T&& value, uint64_t time = 0) {
-    auto val = std::make_shared<Value>(NT_STRING, time, private_init());
-    val->m_string = std::forward<T>(value);
-    val->m_val.data.v_string.str = const_cast<char*>(val->m_string.c_str());
-    val->m_val.data.v_string.len = val->m_string.size();
-    return val;
+    return MakeStringValue(NT_STRING, value, time);
   }
 
   /**
@@ -300,11 +298,7 @@ class Value final {
    */
   static std::shared_ptr<Value> MakeRaw(wpi::StringRef value,
                                         uint64_t time = 0) {
-    auto val = std::make_shared<Value>(NT_RAW, time, private_init());
-    val->m_string = value;
-    val->m_val.data.v_raw.str = const_cast<char*>(val->m_string.c_str());
-    val->m_val.data.v_raw.len = val->m_string.size();
-    return val;
+    return MakeStringValue(NT_RAW, value, time);
   }
 
   /**
@@ -318,11 +312,7 @@ class Value final {
   template <typename T,
             typename std::enable_if<std::is_same<T, std::string>::value>::type>
   static std::shared_ptr<Value> MakeRaw(T&& value, uint64_t time = 0) {
-    auto val = std::make_shared<Value>(NT_RAW, time, private_init());
-    val->m_string = std::forward<T>(value);
-    val->m_val.data.v_raw.str = const_cast<char*>(val->m_string.c_str());
-    val->m_val.data.v_raw.len = val->m_string.size();
-    return val;
+    return MakeStringValue(NT_RAW, value, time);
   }
 
   /**
@@ -335,11 +325,7 @@ class Value final {
    */
   static std::shared_ptr<Value> MakeRpc(wpi::StringRef value,
                                         uint64_t time = 0) {
-    auto val = std::make_shared<Value>(NT_RPC, time, private_init());
-    val->m_string = value;
-    val->m_val.data.v_raw.str = const_cast<char*>(val->m_string.c_str());
-    val->m_val.data.v_raw.len = val->m_string.size();
-    return val;
+    return MakeStringValue(NT_RPC, value, time);
   }
 
   /**
@@ -352,11 +338,7 @@ class Value final {
    */
   template <typename T>
   static std::shared_ptr<Value> MakeRpc(T&& value, uint64_t time = 0) {
-    auto val = std::make_shared<Value>(NT_RPC, time, private_init());
-    val->m_string = std::forward<T>(value);
-    val->m_val.data.v_raw.str = const_cast<char*>(val->m_string.c_str());
-    val->m_val.data.v_raw.len = val->m_string.size();
-    return val;
+    return MakeStringValue(NT_RPC, value, time);
   }
 
   /**
@@ -477,9 +459,21 @@ class Value final {
   friend bool operator==(const Value& lhs, const Value& rhs);
 
  private:
+  // Allocates scalar values received off the wire from a pool
+  friend class WireDecoder;
+
+  // Creates a value with extra bytes of storage for its contents in the
+  // same allocation; payload is set to the start of that storage.
+  static std::shared_ptr<Value> Allocate(NT_Type type, size_t extra,
+                                         uint64_t time, char** payload);
+
+  // Creates a string, raw, or rpc value
+  static std::shared_ptr<Value> MakeStringValue(NT_Type type,
+                                                wpi::StringRef value,
+                                                uint64_t time);
+
+  // Strings and arrays point into the storage following the value
   NT_Value m_val;
-  std::string m_string;
-  std::vector<std::string> m_string_array;
 };
 
 bool operator==(const Value& lhs, const Value& rhs);
@@ -59,7 +59,20 @@ enum NT_Type {
 };
 
 /** NetworkTables entry flags. */
-enum NT_EntryFlags { NT_PERSISTENT = 0x01 };
+enum NT_EntryFlags {
+  NT_PERSISTENT = 0x01,
+  /**
+   * Value updates may be sent over the datagram channel, if the connection
+   * has one (see NT_SetNetworkDatagrams()).
+   */
+  NT_UNRELIABLE = 0x02,
+  /**
+   * Every value update (up to a bounded number per entry) is sent, rather
+   * than only the latest one at each network update.  Remote listeners with
+   * NT_NOTIFY_HISTORY receive the updates as a batch.
+   */
+  NT_HISTORY = 0x04
+};
 
 /** NetworkTables logging levels. */
 enum NT_LogLevel {
@@ -82,7 +95,8 @@ enum NT_NotifyKind {
   NT_NOTIFY_NEW = 0x04,       /* newly created entry */
   NT_NOTIFY_DELETE = 0x08,    /* deleted */
   NT_NOTIFY_UPDATE = 0x10,    /* value changed */
-  NT_NOTIFY_FLAGS = 0x20      /* flags changed */
+  NT_NOTIFY_FLAGS = 0x20,     /* flags changed */
+  NT_NOTIFY_HISTORY = 0x40    /* value updates batched (NT_HISTORY entries) */
 };
 
 /** Client/server modes */
@@ -95,6 +109,13 @@ enum NT_NetworkMode {
   NT_NET_MODE_LOCAL = 0x10,    /* running in local-only mode */
 };
 
+/** Bounded listener poller overflow policies */
+enum NT_PollerOverflow {
+  NT_POLLER_DROP_OLDEST = 0, /* discard the oldest queued event */
+  NT_POLLER_DROP_NEWEST = 1, /* discard the new event */
+  NT_POLLER_COALESCE = 2     /* once full, merge new events per entry */
+};
+
 /*
  * Structures
  */
@@ -185,6 +206,63 @@ struct NT_ConnectionInfo {
   unsigned int protocol_version;
 };
 
+/** NetworkTables Connection Metrics (see nt::ConnectionMetrics) */
+struct NT_ConnectionMetrics {
+  /** Connection information. */
+  struct NT_ConnectionInfo info;
+
+  /** Bytes sent to the remote node. */
+  uint64_t bytes_sent;
+
+  /** Bytes received from the remote node. */
+  uint64_t bytes_received;
+
+  /** Messages sent to the remote node. */
+  uint64_t messages_sent;
+
+  /** Messages received from the remote node. */
+  uint64_t messages_received;
+
+  /** Number of flushed message batches waiting to be written. */
+  unsigned int queue_depth;
+
+  /** Latency of the most recent flush, in microseconds. */
+  uint64_t flush_latency;
+
+  /** Duration of the connection handshake, in microseconds. */
+  uint64_t handshake_duration;
+
+  /** Round trip time (clients only, 0 if unknown), in microseconds. */
+  uint64_t rtt;
+};
+
+/** NetworkTables Publish Policy (see nt::PublishPolicy) */
+struct NT_PublishPolicy {
+  /** Minimum time between updates sent for each entry, in seconds. */
+  double period;
+
+  /** Minimum absolute change of a double value to be sent. */
+  double abs_deadband;
+
+  /** Minimum relative change of a double value to be sent. */
+  double rel_deadband;
+
+  /** If true, send the newest held update once the period elapses. */
+  NT_Bool latest_only;
+};
+
+/** NetworkTables Publish Policy Counters */
+struct NT_PublishPolicyStats {
+  /** Number of updates dropped because they arrived within the period. */
+  uint64_t rate_limited;
+
+  /** Number of updates dropped because they were within the deadband. */
+  uint64_t deadband;
+
+  /** Number of held updates replaced by a newer update before being sent. */
+  uint64_t coalesced;
+};
+
 /** NetworkTables RPC Version 1 Definition Parameter */
 struct NT_RpcParamDef {
   struct NT_String name;
@@ -235,6 +313,16 @@ struct NT_EntryNotification {
    * exist.
    */
   unsigned int flags;
+
+  /**
+   * Every value received in a batch for an NT_HISTORY entry, oldest first;
+   * the last one is the same as value.  Set when flags includes
+   * NT_NOTIFY_HISTORY.
+   */
+  struct NT_Value* history;
+
+  /** Number of elements in history. */
+  size_t history_len;
 };
 
 /** NetworkTables Connection Notification */
@@ -364,6 +452,15 @@ enum NT_Type NT_GetEntryType(NT_Entry entry);
  */
 uint64_t NT_GetEntryLastChange(NT_Entry entry);
 
+/**
+ * Gets the number of times the entry's value has been set, locally or by a
+ * remote node.  Returns 0 if the handle is invalid.
+ *
+ * @param entry   entry handle
+ * @return Entry update count
+ */
+uint64_t NT_GetEntryUpdateCount(NT_Entry entry);
+
 /**
  * Get Entry Value.
  *
@@ -405,6 +502,23 @@ NT_Bool NT_SetDefaultEntryValue(NT_Entry entry,
  */
 NT_Bool NT_SetEntryValue(NT_Entry entry, const struct NT_Value* value);
 
+/**
+ * Set Multiple Entry Values.
+ *
+ * Sets new values for several entries of the same instance as a group.  The
+ * values are set under a single lock acquisition, so no other change is
+ * interleaved with them, and they are sent to remote peers in the same
+ * network update.  If the type of any new value differs from the type of the
+ * currently stored entry, returns error and does not update any value.
+ *
+ * @param entries   array of entry handles
+ * @param values    array of new entry values
+ * @param count     number of entries (and values)
+ * @return 0 on error (type mismatch or invalid entry), 1 on success
+ */
+NT_Bool NT_SetEntryValues(const NT_Entry* entries,
+                          const struct NT_Value* values, size_t count);
+
 /**
  * Set Entry Type and Value.
  *
@@ -558,6 +672,27 @@ NT_EntryListener NT_AddEntryListenerSingle(NT_Entry entry, void* data,
  */
 NT_EntryListenerPoller NT_CreateEntryListenerPoller(NT_Inst inst);
 
+/**
+ * Create a bounded entry listener poller.
+ *
+ * Like NT_CreateEntryListenerPoller(), but the queue holds at most capacity
+ * events, so a slow consumer can't make it grow without bound.  Events are
+ * added without blocking the notifier thread.  When the queue is full, the
+ * overflow policy determines which events are kept.  NT_POLLER_COALESCE
+ * holds up to capacity further events until the queue is drained, merging
+ * those for the same listener and entry (keeping the latest value and the
+ * union of the flags); events already in the queue are never merged.
+ * Discarded events are counted (see NT_GetEntryListenerPollerDropped()).
+ *
+ * @param inst      instance handle
+ * @param capacity  maximum number of queued events (rounded up to a power
+ *                  of 2)
+ * @param overflow  overflow policy
+ * @return poller handle
+ */
+NT_EntryListenerPoller NT_CreateBoundedEntryListenerPoller(
+    NT_Inst inst, size_t capacity, enum NT_PollerOverflow overflow);
+
 /**
  * Destroy a entry listener poller.  This will abort any blocked polling
  * call and prevent additional events from being generated for this poller.
@@ -635,6 +770,15 @@ struct NT_EntryNotification* NT_PollEntryListenerTimeout(
  */
 void NT_CancelPollEntryListener(NT_EntryListenerPoller poller);
 
+/**
+ * Get the number of events a bounded entry listener poller has discarded
+ * because its queue was full.  Merged events are not counted.
+ *
+ * @param poller  poller handle
+ * @return Number of discarded events (0 for an unbounded poller)
+ */
+uint64_t NT_GetEntryListenerPollerDropped(NT_EntryListenerPoller poller);
+
 /**
  * Remove an entry listener.
  *
@@ -698,6 +842,23 @@ NT_ConnectionListener NT_AddConnectionListener(
  */
 NT_ConnectionListenerPoller NT_CreateConnectionListenerPoller(NT_Inst inst);
 
+/**
+ * Create a bounded connection listener poller.
+ *
+ * Like NT_CreateConnectionListenerPoller(), but the queue holds at most
+ * capacity events.  Connection events are never merged, so
+ * NT_POLLER_COALESCE holds up to capacity further events until the queue is
+ * drained, then discards new events like NT_POLLER_DROP_NEWEST.
+ *
+ * @param inst      instance handle
+ * @param capacity  maximum number of queued events (rounded up to a power
+ *                  of 2)
+ * @param overflow  overflow policy
+ * @return poller handle
+ */
+NT_ConnectionListenerPoller NT_CreateBoundedConnectionListenerPoller(
+    NT_Inst inst, size_t capacity, enum NT_PollerOverflow overflow);
+
 /**
  * Destroy a connection listener poller.  This will abort any blocked polling
  * call and prevent additional events from being generated for this poller.
@@ -758,6 +919,16 @@ struct NT_ConnectionNotification* NT_PollConnectionListenerTimeout(
  */
 void NT_CancelPollConnectionListener(NT_ConnectionListenerPoller poller);
 
+/**
+ * Get the number of events a bounded connection listener poller has
+ * discarded because its queue was full.
+ *
+ * @param poller  poller handle
+ * @return Number of discarded events (0 for an unbounded poller)
+ */
+uint64_t NT_GetConnectionListenerPollerDropped(
+    NT_ConnectionListenerPoller poller);
+
 /**
  * Remove a connection listener.
  *
@@ -899,6 +1070,17 @@ void NT_CancelPollRpc(NT_RpcCallPoller poller);
  */
 NT_Bool NT_WaitForRpcCallQueue(NT_Inst inst, double timeout);
 
+/**
+ * Set the number of threads that run RPC callbacks created with
+ * NT_CreateRpc().  By default (0) callbacks run one at a time on the RPC
+ * callback thread.  With worker threads, several calls may run at once, so
+ * callbacks must be thread-safe.
+ *
+ * @param inst      instance handle
+ * @param count     number of worker threads, or 0 for none
+ */
+void NT_SetRpcWorkerThreads(NT_Inst inst, unsigned int count);
+
 /**
  * Post RPC response (return value) for a polled RPC.
  *
@@ -1061,6 +1243,17 @@ void NT_StopLocal(NT_Inst inst);
 void NT_StartServer(NT_Inst inst, const char* persist_filename,
                     const char* listen_address, unsigned int port);
 
+/**
+ * Selects the server implementation used by subsequent calls to
+ * NT_StartServer.  When enabled, all client connections are serviced by a
+ * single event loop thread instead of a pair of threads per connection.  Has
+ * no effect on a server that is already running.
+ *
+ * @param inst    instance handle
+ * @param enable  true to use the event loop server
+ */
+void NT_SetServerEventLoop(NT_Inst inst, NT_Bool enable);
+
 /**
  * Stops the server if it is running.
  *
@@ -1171,6 +1364,80 @@ void NT_StopDSClient(NT_Inst inst);
  */
 void NT_SetUpdateRate(NT_Inst inst, double interval);
 
+/**
+ * Enables LZ4 compression of network traffic.  Compression is negotiated
+ * per connection: it is only used when both ends have it enabled, so peers
+ * without support are unaffected.  Applies to connections made after this
+ * call.
+ *
+ * @param inst    instance handle
+ * @param enable  true to enable compression
+ */
+void NT_SetNetworkCompression(NT_Inst inst, NT_Bool enable);
+
+/**
+ * Enables resumable sessions for a client.  On reconnecting to the same
+ * server instance, the client sends the sequence number and flags of each
+ * entry it holds, and the server only sends entries that changed while
+ * disconnected instead of every entry.  Servers always support resuming;
+ * a server without support is detected and a full resync is used.
+ *
+ * @param inst    instance handle
+ * @param enable  true to enable session resume
+ */
+void NT_SetNetworkSessionResume(NT_Inst inst, NT_Bool enable);
+
+/**
+ * Enables the datagram channel.  Value updates of entries with the
+ * NT_UNRELIABLE flag are sent over UDP instead of the TCP connection, so a
+ * lost packet does not delay other entries.  Updates may be lost or
+ * superseded, and only the latest value is kept; assignments, deletes,
+ * flags and RPCs always use TCP.  The channel is only used when both ends
+ * have it enabled and otherwise updates fall back to TCP.  Applies the
+ * next time the server or client is started.
+ *
+ * @param inst    instance handle
+ * @param enable  true to enable the datagram channel
+ */
+void NT_SetNetworkDatagrams(NT_Inst inst, NT_Bool enable);
+
+/**
+ * Set the publish policy for entries starting with a prefix.
+ * The policy is applied separately for each network connection.  When
+ * several policy prefixes match an entry, the longest one is used.
+ *
+ * @param inst        instance handle
+ * @param prefix      entry name prefix (empty for all entries)
+ * @param prefix_len  length of prefix in bytes
+ * @param policy      publish policy
+ */
+void NT_SetPublishPolicy(NT_Inst inst, const char* prefix, size_t prefix_len,
+                         const struct NT_PublishPolicy* policy);
+
+/**
+ * Remove the publish policy for a prefix.
+ *
+ * @param inst        instance handle
+ * @param prefix      entry name prefix passed to NT_SetPublishPolicy()
+ * @param prefix_len  length of prefix in bytes
+ */
+void NT_ClearPublishPolicy(NT_Inst inst, const char* prefix,
+                           size_t prefix_len);
+
+/**
+ * Get the number of updates suppressed by the publish policy for a prefix,
+ * summed over all connections.
+ *
+ * @param inst        instance handle
+ * @param prefix      entry name prefix passed to NT_SetPublishPolicy()
+ * @param prefix_len  length of prefix in bytes
+ * @param stats       counters (output)
+ * @return False if there is no policy for the prefix.
+ */
+NT_Bool NT_GetPublishPolicyStats(NT_Inst inst, const char* prefix,
+                                 size_t prefix_len,
+                                 struct NT_PublishPolicyStats* stats);
+
 /**
  * Flush Entries.
  *
@@ -1207,6 +1474,29 @@ struct NT_ConnectionInfo* NT_GetConnections(NT_Inst inst, size_t* count);
  */
 NT_Bool NT_IsConnected(NT_Inst inst);
 
+/**
+ * Get traffic and timing counters for the currently established network
+ * connections.
+ *
+ * @param inst  instance handle
+ * @param count returns the number of elements in the array
+ * @return      array of connection metrics
+ *
+ * It is the caller's responsibility to free the array. The
+ * NT_DisposeConnectionMetricsArray function is useful for this purpose.
+ */
+struct NT_ConnectionMetrics* NT_GetConnectionMetrics(NT_Inst inst,
+                                                     size_t* count);
+
+/**
+ * Enable or disable publishing of connection metrics under the
+ * "/.nt/metrics" table.
+ *
+ * @param inst    instance handle
+ * @param enable  true to publish metrics
+ */
+void NT_SetMetricsPublishing(NT_Inst inst, NT_Bool enable);
+
 /** @} */
 
 /**
@@ -1319,6 +1609,15 @@ void NT_DisposeEntryArray(NT_Entry* arr, size_t count);
  */
 void NT_DisposeConnectionInfoArray(struct NT_ConnectionInfo* arr, size_t count);
 
+/**
+ * Disposes a connection metrics array.
+ *
+ * @param arr   pointer to the array to dispose
+ * @param count number of elements in the array
+ */
+void NT_DisposeConnectionMetricsArray(struct NT_ConnectionMetrics* arr,
+                                      size_t count);
+
 /**
  * Disposes an entry info array.
  *
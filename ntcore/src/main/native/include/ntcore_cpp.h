@@ -18,6 +18,7 @@
 #include <wpi/ArrayRef.h>
 #include <wpi/StringRef.h>
 #include <wpi/Twine.h>
+#include <wpi/future.h>
 
 #include "networktables/NetworkTableValue.h"
 
@@ -95,6 +96,104 @@ struct ConnectionInfo {
   }
 };
 
+/** NetworkTables Connection Metrics */
+struct ConnectionMetrics {
+  /** Connection information. */
+  ConnectionInfo info;
+
+  /** Bytes sent to the remote node. */
+  uint64_t bytes_sent{0};
+
+  /** Bytes received from the remote node. */
+  uint64_t bytes_received{0};
+
+  /** Messages sent to the remote node. */
+  uint64_t messages_sent{0};
+
+  /** Messages received from the remote node. */
+  uint64_t messages_received{0};
+
+  /** Number of flushed message batches waiting to be written. */
+  unsigned int queue_depth{0};
+
+  /**
+   * Time from the most recent flush of pending messages until they were
+   * written to the network, in microseconds.
+   */
+  uint64_t flush_latency{0};
+
+  /** Duration of the connection handshake, in microseconds. */
+  uint64_t handshake_duration{0};
+
+  /**
+   * Round trip time to the remote node, in microseconds.  This is measured
+   * from the client hello to the server's first response, so it is only
+   * available on clients; 0 if unknown.
+   */
+  uint64_t rtt{0};
+
+  friend void swap(ConnectionMetrics& first, ConnectionMetrics& second) {
+    using std::swap;
+    swap(first.info, second.info);
+    swap(first.bytes_sent, second.bytes_sent);
+    swap(first.bytes_received, second.bytes_received);
+    swap(first.messages_sent, second.messages_sent);
+    swap(first.messages_received, second.messages_received);
+    swap(first.queue_depth, second.queue_depth);
+    swap(first.flush_latency, second.flush_latency);
+    swap(first.handshake_duration, second.handshake_duration);
+    swap(first.rtt, second.rtt);
+  }
+};
+
+/**
+ * NetworkTables Publish Policy.
+ * Controls which value updates for a group of entries are sent to each
+ * remote node.  Entry creation, flag changes, and deletions are never
+ * suppressed.
+ */
+struct PublishPolicy {
+  /**
+   * Minimum time between updates sent for each entry, in seconds.  Updates
+   * arriving sooner are held back (see latest_only).  0 means no limit.
+   */
+  double period{0};
+
+  /**
+   * Minimum absolute change of a double value from the last value sent for
+   * it to be sent.  0 disables this check.
+   */
+  double abs_deadband{0};
+
+  /**
+   * Minimum change of a double value from the last value sent, relative to
+   * the magnitude of that value, for it to be sent.  0 disables this check.
+   */
+  double rel_deadband{0};
+
+  /**
+   * If true, the newest update held back by the period is sent once the
+   * period elapses; if false, updates arriving within the period are
+   * dropped.
+   */
+  bool latest_only{false};
+};
+
+/** NetworkTables Publish Policy Counters */
+struct PublishPolicyStats {
+  /** Number of updates dropped because they arrived within the period. */
+  uint64_t rate_limited{0};
+
+  /** Number of updates dropped because they were within the deadband. */
+  uint64_t deadband{0};
+
+  /**
+   * Number of held updates replaced by a newer update before being sent
+   * (latest_only policies).
+   */
+  uint64_t coalesced{0};
+};
+
 /** NetworkTables RPC Version 1 Definition Parameter */
 struct RpcParamDef {
   RpcParamDef() = default;
@@ -185,6 +284,16 @@ class EntryNotification {
         name(name_),
         value(std::move(value_)),
         flags(flags_) {}
+  EntryNotification(NT_EntryListener listener_, NT_Entry entry_,
+                    wpi::StringRef name_, std::shared_ptr<Value> value_,
+                    unsigned int flags_,
+                    std::vector<std::shared_ptr<Value>> history_)
+      : listener(listener_),
+        entry(entry_),
+        name(name_),
+        value(std::move(value_)),
+        flags(flags_),
+        history(std::move(history_)) {}
 
   /** Listener that was triggered. */
   NT_EntryListener listener{0};
@@ -204,6 +313,13 @@ class EntryNotification {
    */
   unsigned int flags{0};
 
+  /**
+   * Every value received in a batch for an NT_HISTORY entry, oldest first;
+   * the last one is the same as value.  Set when flags includes
+   * NT_NOTIFY_HISTORY.
+   */
+  std::vector<std::shared_ptr<Value>> history;
+
   friend void swap(EntryNotification& first, EntryNotification& second) {
     using std::swap;
     swap(first.listener, second.listener);
@@ -211,6 +327,7 @@ class EntryNotification {
     swap(first.name, second.name);
     swap(first.value, second.value);
     swap(first.flags, second.flags);
+    swap(first.history, second.history);
   }
 };
 
@@ -372,6 +489,15 @@ NT_Type GetEntryType(NT_Entry entry);
  */
 uint64_t GetEntryLastChange(NT_Entry entry);
 
+/**
+ * Gets the number of times the entry's value has been set, locally or by a
+ * remote node.  Returns 0 if the handle is invalid.
+ *
+ * @param entry   entry handle
+ * @return Entry update count
+ */
+uint64_t GetEntryUpdateCount(NT_Entry entry);
+
 /**
  * Get Entry Value.
  *
@@ -408,6 +534,22 @@ bool SetDefaultEntryValue(NT_Entry entry, std::shared_ptr<Value> value);
  */
 bool SetEntryValue(NT_Entry entry, std::shared_ptr<Value> value);
 
+/**
+ * Set Multiple Entry Values.
+ *
+ * Sets new values for several entries of the same instance as a group.  The
+ * values are set under a single lock acquisition, so no other change is
+ * interleaved with them, and they are sent to remote peers in the same
+ * network update.  If the type of any new value differs from the type of the
+ * currently stored entry, returns error and does not update any value.
+ *
+ * @param entries   entry handles
+ * @param values    new entry values (same length as entries)
+ * @return False on error (type mismatch or invalid entry), True on success
+ */
+bool SetEntryValues(wpi::ArrayRef<NT_Entry> entries,
+                    wpi::ArrayRef<std::shared_ptr<Value>> values);
+
 /**
  * Set Entry Type and Value.
  *
@@ -560,6 +702,27 @@ NT_EntryListener AddEntryListener(
  */
 NT_EntryListenerPoller CreateEntryListenerPoller(NT_Inst inst);
 
+/**
+ * Create a bounded entry listener poller.
+ *
+ * Like CreateEntryListenerPoller(), but the queue holds at most capacity
+ * events, so a slow consumer can't make it grow without bound.  Events are
+ * added without blocking the notifier thread.  When the queue is full, the
+ * overflow policy determines which events are kept.  NT_POLLER_COALESCE
+ * holds up to capacity further events until the queue is drained, merging
+ * those for the same listener and entry (keeping the latest value and the
+ * union of the flags); events already in the queue are never merged.
+ * Discarded events are counted (see GetEntryListenerPollerDropped()).
+ *
+ * @param inst      instance handle
+ * @param capacity  maximum number of queued events (rounded up to a power
+ *                  of 2)
+ * @param overflow  overflow policy
+ * @return poller handle
+ */
+NT_EntryListenerPoller CreateEntryListenerPoller(NT_Inst inst, size_t capacity,
+                                                 NT_PollerOverflow overflow);
+
 /**
  * Destroy a entry listener poller.  This will abort any blocked polling
  * call and prevent additional events from being generated for this poller.
@@ -621,6 +784,24 @@ std::vector<EntryNotification> PollEntryListener(NT_EntryListenerPoller poller,
                                                  double timeout,
                                                  bool* timed_out);
 
+/**
+ * Get a batch of entry listener events.  This blocks until at least one
+ * event occurs or it times out, then appends up to max_events events to
+ * events.  Reusing the same vector avoids an allocation per call.
+ *
+ * @param poller      poller handle
+ * @param events      events (output); appended to
+ * @param max_events  maximum number of events to get (0 for no limit)
+ * @param timeout     timeout, in seconds (negative for no timeout)
+ * @param timed_out   true if the timeout period elapsed (output)
+ * @return Number of events appended.  If 0 is returned and timed_out is
+ *         also false, an error occurred (e.g. the instance was invalid or is
+ *         shutting down) or the call was canceled.
+ */
+size_t PollEntryListener(NT_EntryListenerPoller poller,
+                         std::vector<EntryNotification>* events,
+                         size_t max_events, double timeout, bool* timed_out);
+
 /**
  * Cancel a PollEntryListener call.  This wakes up a call to
  * PollEntryListener for this poller and causes it to immediately return
@@ -630,6 +811,15 @@ std::vector<EntryNotification> PollEntryListener(NT_EntryListenerPoller poller,
  */
 void CancelPollEntryListener(NT_EntryListenerPoller poller);
 
+/**
+ * Get the number of events a bounded entry listener poller has discarded
+ * because its queue was full.  Merged events are not counted.
+ *
+ * @param poller  poller handle
+ * @return Number of discarded events (0 for an unbounded poller)
+ */
+uint64_t GetEntryListenerPollerDropped(NT_EntryListenerPoller poller);
+
 /**
  * Remove an entry listener.
  *
@@ -695,6 +885,23 @@ NT_ConnectionListener AddConnectionListener(
  */
 NT_ConnectionListenerPoller CreateConnectionListenerPoller(NT_Inst inst);
 
+/**
+ * Create a bounded connection listener poller.
+ *
+ * Like CreateConnectionListenerPoller(), but the queue holds at most
+ * capacity events.  Connection events are never merged, so
+ * NT_POLLER_COALESCE holds up to capacity further events until the queue is
+ * drained, then discards new events like NT_POLLER_DROP_NEWEST.
+ *
+ * @param inst      instance handle
+ * @param capacity  maximum number of queued events (rounded up to a power
+ *                  of 2)
+ * @param overflow  overflow policy
+ * @return poller handle
+ */
+NT_ConnectionListenerPoller CreateConnectionListenerPoller(
+    NT_Inst inst, size_t capacity, NT_PollerOverflow overflow);
+
 /**
  * Destroy a connection listener poller.  This will abort any blocked polling
  * call and prevent additional events from being generated for this poller.
@@ -742,6 +949,24 @@ std::vector<ConnectionNotification> PollConnectionListener(
 std::vector<ConnectionNotification> PollConnectionListener(
     NT_ConnectionListenerPoller poller, double timeout, bool* timed_out);
 
+/**
+ * Get a batch of connection events.  This blocks until at least one event
+ * occurs or it times out, then appends up to max_events events to events.
+ *
+ * @param poller      poller handle
+ * @param events      events (output); appended to
+ * @param max_events  maximum number of events to get (0 for no limit)
+ * @param timeout     timeout, in seconds (negative for no timeout)
+ * @param timed_out   true if the timeout period elapsed (output)
+ * @return Number of events appended.  If 0 is returned and timed_out is
+ *         also false, an error occurred (e.g. the instance was invalid or is
+ *         shutting down) or the call was canceled.
+ */
+size_t PollConnectionListener(NT_ConnectionListenerPoller poller,
+                              std::vector<ConnectionNotification>* events,
+                              size_t max_events, double timeout,
+                              bool* timed_out);
+
 /**
  * Cancel a PollConnectionListener call.  This wakes up a call to
  * PollConnectionListener for this poller and causes it to immediately return
@@ -751,6 +976,16 @@ std::vector<ConnectionNotification> PollConnectionListener(
  */
 void CancelPollConnectionListener(NT_ConnectionListenerPoller poller);
 
+/**
+ * Get the number of events a bounded connection listener poller has
+ * discarded because its queue was full.
+ *
+ * @param poller  poller handle
+ * @return Number of discarded events (0 for an unbounded poller)
+ */
+uint64_t GetConnectionListenerPollerDropped(
+    NT_ConnectionListenerPoller poller);
+
 /**
  * Remove a connection listener.
  *
@@ -874,6 +1109,18 @@ void CancelPollRpc(NT_RpcCallPoller poller);
  */
 bool WaitForRpcCallQueue(NT_Inst inst, double timeout);
 
+/**
+ * Set the number of threads that run RPC callbacks created with CreateRpc().
+ * By default (0) callbacks run one at a time on the RPC callback thread, so
+ * a slow callback delays every other call.  With worker threads, several
+ * calls may run at once, so callbacks must be thread-safe.  Calls are
+ * dispatched to the workers in order but may complete in any order.
+ *
+ * @param inst      instance handle
+ * @param count     number of worker threads, or 0 for none
+ */
+void SetRpcWorkerThreads(NT_Inst inst, unsigned int count);
+
 /**
  * Post RPC response (return value) for a polled RPC.
  * The rpc and call parameters should come from the RpcAnswer returned
@@ -899,6 +1146,22 @@ bool PostRpcResponse(NT_Entry entry, NT_RpcCall call, wpi::StringRef result);
  */
 NT_RpcCall CallRpc(NT_Entry entry, wpi::StringRef params);
 
+/**
+ * Call a RPC function asynchronously.  May be used on either the client or
+ * server.  The call is sent without waiting for the next periodic update,
+ * and any number of calls may be outstanding at once; results are matched
+ * to their calls as they arrive.
+ *
+ * The future is ready with an empty result if the call could not be made
+ * or the instance is destroyed first.  If the connection is lost, the
+ * result may never arrive, so use a timed wait where that matters.
+ *
+ * @param entry       entry handle of RPC entry
+ * @param params      parameter
+ * @return Future for the result
+ */
+wpi::future<std::string> CallRpcAsync(NT_Entry entry, wpi::StringRef params);
+
 /**
  * Get the result (return value) of a RPC call.  This function blocks until
  * the result is received.
@@ -1008,6 +1271,9 @@ void StopLocal(NT_Inst inst);
 
 /**
  * Starts a server using the specified filename, listening address, and port.
+ * A listening address of "shm:<name>" listens on any address and also
+ * accepts clients on the same host over shared memory with that name
+ * (Linux only).
  *
  * @param inst              instance handle
  * @param persist_filename  the name of the persist file to use (UTF-8 string,
@@ -1019,6 +1285,17 @@ void StopLocal(NT_Inst inst);
 void StartServer(NT_Inst inst, const wpi::Twine& persist_filename,
                  const char* listen_address, unsigned int port);
 
+/**
+ * Selects the server implementation used by subsequent calls to StartServer.
+ * When enabled, all client connections are serviced by a single event loop
+ * thread instead of a pair of threads per connection.  Has no effect on a
+ * server that is already running.
+ *
+ * @param inst    instance handle
+ * @param enable  true to use the event loop server
+ */
+void SetServerEventLoop(NT_Inst inst, bool enable);
+
 /**
  * Stops the server if it is running.
  *
@@ -1034,7 +1311,9 @@ void StopServer(NT_Inst inst);
 void StartClient(NT_Inst inst);
 
 /**
- * Starts a client using the specified server and port
+ * Starts a client using the specified server and port.  A server name of
+ * "shm:<name>" connects to a server on the same host over shared memory
+ * (see StartServer); the port is then ignored.
  *
  * @param inst        instance handle
  * @param server_name server name (UTF-8 string, null terminated)
@@ -1125,6 +1404,77 @@ void StopDSClient(NT_Inst inst);
  */
 void SetUpdateRate(NT_Inst inst, double interval);
 
+/**
+ * Enables LZ4 compression of network traffic.  Compression is negotiated
+ * per connection: it is only used when both ends have it enabled, so peers
+ * without support are unaffected.  Applies to connections made after this
+ * call.
+ *
+ * @param inst    instance handle
+ * @param enable  true to enable compression
+ */
+void SetNetworkCompression(NT_Inst inst, bool enable);
+
+/**
+ * Enables resumable sessions for a client.  On reconnecting to the same
+ * server instance, the client sends the sequence number and flags of each
+ * entry it holds, and the server only sends entries that changed while
+ * disconnected instead of every entry.  Servers always support resuming;
+ * a server without support is detected and a full resync is used.
+ *
+ * @param inst    instance handle
+ * @param enable  true to enable session resume
+ */
+void SetNetworkSessionResume(NT_Inst inst, bool enable);
+
+/**
+ * Enables the datagram channel.  Value updates of entries with the
+ * NT_UNRELIABLE flag are sent over UDP instead of the TCP connection, so a
+ * lost packet does not delay other entries.  Updates may be lost or
+ * superseded, and only the latest value is kept; assignments, deletes,
+ * flags and RPCs always use TCP.  The channel is only used when both ends
+ * have it enabled and otherwise updates fall back to TCP.  Applies the
+ * next time the server or client is started.
+ *
+ * @param inst    instance handle
+ * @param enable  true to enable the datagram channel
+ */
+void SetNetworkDatagrams(NT_Inst inst, bool enable);
+
+/**
+ * Set the publish policy for entries starting with a prefix.
+ * The policy is applied separately for each network connection.  When
+ * several policy prefixes match an entry, the longest one is used.  Setting
+ * a policy for a prefix that already has one replaces it but keeps its
+ * counters.
+ *
+ * @param inst      instance handle
+ * @param prefix    entry name prefix (empty for all entries)
+ * @param policy    publish policy
+ */
+void SetPublishPolicy(NT_Inst inst, const wpi::Twine& prefix,
+                      const PublishPolicy& policy);
+
+/**
+ * Remove the publish policy for a prefix.
+ *
+ * @param inst      instance handle
+ * @param prefix    entry name prefix passed to SetPublishPolicy()
+ */
+void ClearPublishPolicy(NT_Inst inst, const wpi::Twine& prefix);
+
+/**
+ * Get the number of updates suppressed by the publish policy for a prefix,
+ * summed over all connections.
+ *
+ * @param inst      instance handle
+ * @param prefix    entry name prefix passed to SetPublishPolicy()
+ * @param stats     counters (output)
+ * @return False if there is no policy for the prefix.
+ */
+bool GetPublishPolicyStats(NT_Inst inst, const wpi::Twine& prefix,
+                           PublishPolicyStats* stats);
+
 /**
  * Flush Entries.
  *
@@ -1157,6 +1507,26 @@ std::vector<ConnectionInfo> GetConnections(NT_Inst inst);
  */
 bool IsConnected(NT_Inst inst);
 
+/**
+ * Get traffic and timing counters for the currently established network
+ * connections.
+ *
+ * @param inst  instance handle
+ * @return      array of connection metrics
+ */
+std::vector<ConnectionMetrics> GetConnectionMetrics(NT_Inst inst);
+
+/**
+ * Enable or disable publishing of connection metrics as entries.  When
+ * enabled, the metrics returned by GetConnectionMetrics() are published once
+ * a second under "/.nt/metrics/<local identity>/<remote identity>:<remote
+ * port>/"; the table of a connection is deleted once it closes.
+ *
+ * @param inst    instance handle
+ * @param enable  true to publish metrics
+ */
+void SetMetricsPublishing(NT_Inst inst, bool enable);
+
 /** @} */
 
 /**
@@ -1169,6 +1539,11 @@ bool IsConnected(NT_Inst inst);
  * but this function provides a way to save persistent values in the same
  * format to a file on either a client or a server.
  *
+ * If the filename ends in ".bin", a binary format is used instead of the
+ * text format.  It is faster to load and save, and the server's periodic
+ * saves to a binary file append only the entries that changed rather than
+ * rewriting the whole file.
+ *
  * @param inst      instance handle
  * @param filename  filename
  * @return error string, or nullptr if successful
@@ -1179,6 +1554,7 @@ const char* SavePersistent(NT_Inst inst, const wpi::Twine& filename);
  * Load persistent values from a file.  The server automatically does this
  * at startup, but this function provides a way to restore persistent values
  * in the same format from a file at any time on either a client or a server.
+ * Both the text and binary formats are accepted (see SavePersistent).
  *
  * @param inst      instance handle
  * @param filename  filename
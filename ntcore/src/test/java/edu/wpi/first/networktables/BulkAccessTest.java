@@ -0,0 +1,101 @@
+// Copyright (c) FIRST and other WPILib contributors.
+// Open Source Software; you can modify and/or share it under the terms of
+// the WPILib BSD license file in the root directory of this project.
+
+package edu.wpi.first.networktables;
+
+import static org.junit.jupiter.api.Assertions.assertArrayEquals;
+import static org.junit.jupiter.api.Assertions.assertEquals;
+import static org.junit.jupiter.api.Assertions.assertFalse;
+import static org.junit.jupiter.api.Assertions.assertThrows;
+import static org.junit.jupiter.api.Assertions.assertTrue;
+
+import java.nio.ByteBuffer;
+import java.nio.ByteOrder;
+import org.junit.jupiter.api.AfterEach;
+import org.junit.jupiter.api.BeforeEach;
+import org.junit.jupiter.api.Test;
+
+class BulkAccessTest {
+  private NetworkTableInstance m_inst;
+  private int[] m_handles;
+
+  @BeforeEach
+  void setUp() {
+    m_inst = NetworkTableInstance.create();
+    m_handles = new int[3];
+    for (int i = 0; i < m_handles.length; i++) {
+      m_handles[i] = m_inst.getEntry("/bulk/" + i).getHandle();
+    }
+  }
+
+  @AfterEach
+  void tearDown() {
+    m_inst.close();
+  }
+
+  private static ByteBuffer allocate(int size) {
+    return ByteBuffer.allocateDirect(size).order(ByteOrder.nativeOrder());
+  }
+
+  @Test
+  void testDoubles() {
+    ByteBuffer values = allocate(3 * Double.BYTES);
+    values.putDouble(0, 1.5).putDouble(8, 2.5).putDouble(16, 3.5);
+    assertTrue(NetworkTablesJNI.setDoubles(m_handles, 0, values));
+    assertEquals(2.5, m_inst.getEntry("/bulk/1").getDouble(0), 0.0);
+
+    m_inst.getEntry("/bulk/2").forceSetString("text");
+    ByteBuffer dest = allocate(3 * Double.BYTES);
+    assertEquals(2, NetworkTablesJNI.getDoubles(m_handles, dest, -1.0));
+    assertEquals(1.5, dest.getDouble(0), 0.0);
+    assertEquals(2.5, dest.getDouble(8), 0.0);
+    assertEquals(-1.0, dest.getDouble(16), 0.0);
+
+    // a type mismatch sets nothing
+    assertFalse(NetworkTablesJNI.setDoubles(m_handles, 0, values));
+    assertEquals("text", m_inst.getEntry("/bulk/2").getString(""));
+  }
+
+  @Test
+  void testBooleans() {
+    ByteBuffer values = allocate(3);
+    values.put(0, (byte) 1).put(1, (byte) 0).put(2, (byte) 1);
+    assertTrue(NetworkTablesJNI.setBooleans(m_handles, 0, values));
+
+    ByteBuffer dest = allocate(3);
+    assertEquals(3, NetworkTablesJNI.getBooleans(m_handles, dest, false));
+    assertEquals(1, dest.get(0));
+    assertEquals(0, dest.get(1));
+    assertEquals(1, dest.get(2));
+  }
+
+  @Test
+  void testDoubleArray() {
+    NetworkTableEntry entry = m_inst.getEntry("/bulk/array");
+    ByteBuffer value = allocate(4 * Double.BYTES);
+    for (int i = 0; i < 4; i++) {
+      value.putDouble(i * Double.BYTES, i + 0.5);
+    }
+    assertTrue(entry.setDoubleArray(value, 4));
+    assertArrayEquals(new double[] {0.5, 1.5, 2.5, 3.5}, entry.getDoubleArray(new double[0]));
+
+    // the length is returned even if the buffer only holds part of the value
+    ByteBuffer dest = allocate(2 * Double.BYTES);
+    assertEquals(4, entry.getDoubleArray(dest));
+    assertEquals(0.5, dest.getDouble(0), 0.0);
+    assertEquals(1.5, dest.getDouble(8), 0.0);
+
+    assertEquals(-1, m_inst.getEntry("/bulk/0").getDoubleArray(dest));
+  }
+
+  @Test
+  void testBufferTooSmall() {
+    assertThrows(
+        IllegalArgumentException.class,
+        () -> NetworkTablesJNI.getDoubles(m_handles, allocate(Double.BYTES), 0.0));
+    assertThrows(
+        IllegalArgumentException.class,
+        () -> NetworkTablesJNI.getDoubles(m_handles, ByteBuffer.allocate(64), 0.0));
+  }
+}
@@ -0,0 +1,180 @@
+// Copyright (c) FIRST and other WPILib contributors.
+// Open Source Software; you can modify and/or share it under the terms of
+// the WPILib BSD license file in the root directory of this project.
+
+#include <atomic>
+#include <cstdlib>
+#include <functional>
+#include <memory>
+#include <new>
+#include <string>
+#include <vector>
+
+#include <wpi/raw_istream.h>
+
+#include "EntryNotifier.h"
+#include "IDispatcher.h"
+#include "INetworkConnection.h"
+#include "Log.h"
+#include "Message.h"
+#include "RpcServer.h"
+#include "Storage.h"
+#include "WireDecoder.h"
+#include "WireEncoder.h"
+#include "gtest/gtest.h"
+
+// Count heap allocations made while g_counting is set.  Replacing the global
+// operator new also covers allocations made inside the ntcore library; this
+// is why these tests are built into their own executable.
+static std::atomic_bool g_counting{false};
+static std::atomic<size_t> g_allocs{0};
+
+#if defined(__GNUC__) && !defined(__clang__)
+// GCC can't tell these replacements pair malloc() with free()
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+
+void* operator new(size_t size) {
+  if (g_counting) {
+    ++g_allocs;
+  }
+  if (size == 0) {
+    size = 1;
+  }
+  if (void* p = std::malloc(size)) {
+    return p;
+  }
+  throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept {
+  std::free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+  std::free(p);
+}
+
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+
+namespace nt {
+
+namespace {
+
+// Server-side connection that just reports itself as active
+class ActiveConnection : public INetworkConnection {
+ public:
+  ConnectionInfo info() const override { return ConnectionInfo{}; }
+  void QueueOutgoing(std::shared_ptr<Message>) override {}
+  void PostOutgoing(bool) override {}
+  unsigned int proto_rev() const override { return 0x0300; }
+  void set_proto_rev(unsigned int) override {}
+  State state() const override { return kActive; }
+  void set_state(State) override {}
+};
+
+// Collects the messages Storage forwards to other connections
+class CollectingDispatcher : public IDispatcher {
+ public:
+  CollectingDispatcher() { msgs.reserve(16); }
+
+  void QueueOutgoing(std::shared_ptr<Message> msg, INetworkConnection*,
+                     INetworkConnection*) override {
+    msgs.emplace_back(std::move(msg));
+  }
+
+  std::vector<std::shared_ptr<Message>> msgs;
+};
+
+}  // namespace
+
+class WirePathAllocationTest : public ::testing::Test {
+ public:
+  WirePathAllocationTest()
+      : notifier(1, logger),
+        rpc_server(1, logger),
+        storage(notifier, rpc_server, logger) {
+    storage.SetDispatcher(&dispatcher, true);
+  }
+
+  wpi::Logger logger;
+  EntryNotifier notifier;
+  RpcServer rpc_server;
+  CollectingDispatcher dispatcher;
+  Storage storage;
+  ActiveConnection conn;
+};
+
+TEST_F(WirePathAllocationTest, EntryUpdateSteadyState) {
+  // create entries; as the server, ids are assigned in order from 0
+  const unsigned int kNumEntries = 4;
+  for (unsigned int i = 0; i < kNumEntries; ++i) {
+    storage.SetEntryValue("/entry" + std::to_string(i), Value::MakeDouble(0));
+    storage.SetEntryValue("/flag" + std::to_string(i), Value::MakeBoolean(0));
+  }
+  dispatcher.msgs.clear();
+
+  // incoming updates to all entries, repeated
+  const unsigned int kRounds = 200;
+  WireEncoder wire(0x0300);
+  for (unsigned int round = 1; round <= kRounds; ++round) {
+    for (unsigned int i = 0; i < kNumEntries * 2; ++i) {
+      auto value = (i % 2) == 0 ? Value::MakeDouble(round)
+                                : Value::MakeBoolean((round % 2) != 0);
+      Message::EntryUpdate(i, round, value)->Write(wire);
+    }
+  }
+  std::string incoming(wire.data(), wire.size());
+
+  // same binding as the dispatcher uses
+  using namespace std::placeholders;
+  Message::GetEntryTypeFunc get_entry_type =
+      std::bind(&IStorage::GetMessageEntryType, &storage, _1);  // NOLINT
+
+  wpi::raw_mem_istream is(incoming);
+  WireDecoder decoder(is, 0x0300, logger);
+  WireEncoder outgoing(0x0300);
+
+  auto process = [&](unsigned int rounds) {
+    size_t count = 0;
+    for (unsigned int round = 0; round < rounds; ++round) {
+      for (unsigned int i = 0; i < kNumEntries * 2; ++i) {
+        decoder.Reset();
+        auto msg = Message::Read(decoder, get_entry_type);
+        if (!msg) {
+          return count;
+        }
+        storage.ProcessIncoming(std::move(msg), &conn,
+                                std::weak_ptr<INetworkConnection>());
+        ++count;
+      }
+      outgoing.Reset();
+      for (auto& msg : dispatcher.msgs) {
+        msg->Write(outgoing);
+      }
+      dispatcher.msgs.clear();
+    }
+    return count;
+  };
+
+  // warm up the pools and buffers
+  ASSERT_EQ(process(kRounds / 2), kNumEntries * 2 * kRounds / 2);
+
+  g_allocs = 0;
+  g_counting = true;
+  size_t count = process(kRounds / 2);
+  g_counting = false;
+
+  ASSERT_EQ(count, kNumEntries * 2 * kRounds / 2);
+  EXPECT_EQ(g_allocs, 0u);
+
+  // check the updates were actually applied
+  auto value = storage.GetEntryValue("/entry0");
+  ASSERT_TRUE(value && value->IsDouble());
+  EXPECT_EQ(value->GetDouble(), kRounds);
+}
+
+}  // namespace nt
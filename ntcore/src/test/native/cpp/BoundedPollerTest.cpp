@@ -0,0 +1,161 @@
+// Copyright (c) FIRST and other WPILib contributors.
+// Open Source Software; you can modify and/or share it under the terms of
+// the WPILib BSD license file in the root directory of this project.
+
+#include <vector>
+
+#include "TestPrinters.h"
+#include "ValueMatcher.h"
+#include "gtest/gtest.h"
+#include "ntcore_cpp.h"
+
+class BoundedPollerTest : public ::testing::Test {
+ public:
+  BoundedPollerTest() : inst(nt::CreateInstance()) {}
+
+  ~BoundedPollerTest() override { nt::DestroyInstance(inst); }
+
+  NT_EntryListenerPoller MakePoller(size_t capacity,
+                                    NT_PollerOverflow overflow) {
+    auto poller = nt::CreateEntryListenerPoller(inst, capacity, overflow);
+    nt::AddPolledEntryListener(poller, "/",
+                               NT_NOTIFY_NEW | NT_NOTIFY_UPDATE |
+                                   NT_NOTIFY_LOCAL);
+    return poller;
+  }
+
+  void Set(const char* name, double value) {
+    nt::SetEntryValue(nt::GetEntry(inst, name), nt::Value::MakeDouble(value));
+  }
+
+  std::vector<nt::EntryNotification> PollAll(NT_EntryListenerPoller poller) {
+    EXPECT_TRUE(nt::WaitForEntryListenerQueue(inst, 1.0));
+    std::vector<nt::EntryNotification> events;
+    bool timed_out = false;
+    nt::PollEntryListener(poller, &events, 0, 0.1, &timed_out);
+    return events;
+  }
+
+ protected:
+  NT_Inst inst;
+};
+
+TEST_F(BoundedPollerTest, DropOldest) {
+  auto poller = MakePoller(4, NT_POLLER_DROP_OLDEST);
+  for (int i = 0; i < 10; ++i) {
+    Set("/foo", i);
+  }
+
+  auto events = PollAll(poller);
+  ASSERT_EQ(events.size(), 4u);
+  for (int i = 0; i < 4; ++i) {
+    EXPECT_THAT(events[i].value, nt::ValueEq(nt::Value::MakeDouble(6 + i)));
+  }
+  EXPECT_EQ(nt::GetEntryListenerPollerDropped(poller), 6u);
+}
+
+TEST_F(BoundedPollerTest, DropNewest) {
+  auto poller = MakePoller(4, NT_POLLER_DROP_NEWEST);
+  for (int i = 0; i < 10; ++i) {
+    Set("/foo", i);
+  }
+
+  auto events = PollAll(poller);
+  ASSERT_EQ(events.size(), 4u);
+  for (int i = 0; i < 4; ++i) {
+    EXPECT_THAT(events[i].value, nt::ValueEq(nt::Value::MakeDouble(i)));
+  }
+  EXPECT_EQ(nt::GetEntryListenerPollerDropped(poller), 6u);
+}
+
+TEST_F(BoundedPollerTest, Coalesce) {
+  auto poller = MakePoller(2, NT_POLLER_COALESCE);
+  Set("/x", 1);
+  Set("/y", 1);
+
+  // the queue is full; these merge into one event per entry
+  Set("/a", 1);
+  Set("/b", 1);
+  Set("/a", 2);
+  Set("/a", 3);
+
+  auto events = PollAll(poller);
+  ASSERT_EQ(events.size(), 4u);
+  EXPECT_EQ(events[0].name, "/x");
+  EXPECT_EQ(events[1].name, "/y");
+  EXPECT_EQ(events[2].name, "/a");
+  EXPECT_THAT(events[2].value, nt::ValueEq(nt::Value::MakeDouble(3)));
+  EXPECT_EQ(events[2].flags, static_cast<unsigned int>(
+                                 NT_NOTIFY_NEW | NT_NOTIFY_UPDATE |
+                                 NT_NOTIFY_LOCAL));
+  EXPECT_EQ(events[3].name, "/b");
+  EXPECT_EQ(events[3].flags,
+            static_cast<unsigned int>(NT_NOTIFY_NEW | NT_NOTIFY_LOCAL));
+
+  // once drained, events are queued normally again
+  Set("/a", 4);
+  events = PollAll(poller);
+  ASSERT_EQ(events.size(), 1u);
+  EXPECT_THAT(events[0].value, nt::ValueEq(nt::Value::MakeDouble(4)));
+  EXPECT_EQ(nt::GetEntryListenerPollerDropped(poller), 0u);
+}
+
+TEST_F(BoundedPollerTest, CoalesceDropped) {
+  auto poller = MakePoller(2, NT_POLLER_COALESCE);
+  Set("/x", 1);
+  Set("/y", 1);
+  Set("/a", 1);
+  Set("/b", 1);
+
+  // the queue and the held events are full; new entries are dropped, but
+  // held ones are still merged
+  Set("/c", 1);
+  Set("/d", 1);
+  Set("/a", 2);
+  // events already in the queue are not merged
+  Set("/x", 2);
+
+  auto events = PollAll(poller);
+  ASSERT_EQ(events.size(), 4u);
+  EXPECT_EQ(events[2].name, "/a");
+  EXPECT_THAT(events[2].value, nt::ValueEq(nt::Value::MakeDouble(2)));
+  EXPECT_EQ(nt::GetEntryListenerPollerDropped(poller), 3u);
+}
+
+TEST_F(BoundedPollerTest, Batch) {
+  auto poller = MakePoller(8, NT_POLLER_DROP_NEWEST);
+  for (int i = 0; i < 5; ++i) {
+    Set("/foo", i);
+  }
+  ASSERT_TRUE(nt::WaitForEntryListenerQueue(inst, 1.0));
+
+  std::vector<nt::EntryNotification> events;
+  bool timed_out = false;
+  EXPECT_EQ(nt::PollEntryListener(poller, &events, 2, 0.1, &timed_out), 2u);
+  EXPECT_EQ(nt::PollEntryListener(poller, &events, 2, 0.1, &timed_out), 2u);
+  EXPECT_EQ(nt::PollEntryListener(poller, &events, 2, 0.1, &timed_out), 1u);
+  EXPECT_FALSE(timed_out);
+  ASSERT_EQ(events.size(), 5u);
+  for (int i = 0; i < 5; ++i) {
+    EXPECT_THAT(events[i].value, nt::ValueEq(nt::Value::MakeDouble(i)));
+  }
+
+  EXPECT_EQ(nt::PollEntryListener(poller, &events, 2, 0.01, &timed_out), 0u);
+  EXPECT_TRUE(timed_out);
+}
+
+TEST_F(BoundedPollerTest, UnboundedBatch) {
+  auto poller = nt::CreateEntryListenerPoller(inst);
+  nt::AddPolledEntryListener(poller, "/", NT_NOTIFY_NEW | NT_NOTIFY_LOCAL);
+  Set("/a", 1);
+  Set("/b", 1);
+  Set("/c", 1);
+  ASSERT_TRUE(nt::WaitForEntryListenerQueue(inst, 1.0));
+
+  std::vector<nt::EntryNotification> events;
+  bool timed_out = false;
+  EXPECT_EQ(nt::PollEntryListener(poller, &events, 2, 0.1, &timed_out), 2u);
+  EXPECT_EQ(nt::PollEntryListener(poller, &events, 0, 0.1, &timed_out), 1u);
+  ASSERT_EQ(events.size(), 3u);
+  EXPECT_EQ(events[2].name, "/c");
+}
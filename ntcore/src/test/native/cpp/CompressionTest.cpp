@@ -0,0 +1,179 @@
+// Copyright (c) FIRST and other WPILib contributors.
+// Open Source Software; you can modify and/or share it under the terms of
+// the WPILib BSD license file in the root directory of this project.
+
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <wpi/Logger.h>
+#include <wpi/NetworkStream.h>
+#include <wpi/TCPConnector.h>
+
+#include "TestPrinters.h"
+#include "gtest/gtest.h"
+#include "ntcore_cpp.h"
+
+// Parameter selects the event loop server
+class CompressionTest : public ::testing::TestWithParam<bool> {
+ public:
+  CompressionTest()
+      : server_inst(nt::CreateInstance()), client_inst(nt::CreateInstance()) {
+    nt::SetNetworkIdentity(server_inst, "server");
+    nt::SetNetworkIdentity(client_inst, "client");
+    nt::SetServerEventLoop(server_inst, GetParam());
+    nt::SetUpdateRate(server_inst, 0.01);
+    nt::SetUpdateRate(client_inst, 0.01);
+    for (int i = 0; i < 500; ++i) {
+      big += "{\"x\":1.5,\"y\":2.25,\"rotation\":" + std::to_string(i) + "},";
+    }
+  }
+
+  ~CompressionTest() override {
+    nt::DestroyInstance(server_inst);
+    nt::DestroyInstance(client_inst);
+  }
+
+  void Connect();
+  std::unique_ptr<wpi::NetworkStream> ConnectBlockSender();
+  bool WaitForClose(wpi::NetworkStream& stream, int timeout);
+  bool WaitForString(NT_Inst inst, const char* name, const std::string& str);
+  void CheckTransfer();
+
+ protected:
+  NT_Inst server_inst;
+  NT_Inst client_inst;
+  std::string big;
+};
+
+void CompressionTest::Connect() {
+  nt::StartServer(server_inst, "", "127.0.0.1", 10011);
+  nt::StartClient(client_inst, "127.0.0.1", 10011);
+
+  // wait for the server to see the connection (up to 2 seconds)
+  for (int i = 0; i < 200 && nt::GetConnections(server_inst).empty(); ++i) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+}
+
+// Connects a raw peer that sends an empty compressed block right after its
+// handshake, without waiting for the server to ask for blocks
+std::unique_ptr<wpi::NetworkStream> CompressionTest::ConnectBlockSender() {
+  nt::StartServer(server_inst, "", "127.0.0.1", 10011);
+  wpi::Logger logger;
+  std::unique_ptr<wpi::NetworkStream> stream;
+  for (int i = 0; i < 200 && !stream; ++i) {
+    // the server starts listening asynchronously
+    stream = wpi::TCPConnector::connect("127.0.0.1", 10011, logger, 1);
+    if (!stream) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+  }
+  if (stream) {
+    // client hello (3.0, "raw"), client hello done, empty block, keep alive
+    static const char data[] = {0x01, 0x03, 0x00, 0x03, 'r',  'a', 'w',
+                                0x05, 0x30, 0x00, 0x00, 0x00};
+    wpi::NetworkStream::Error err;
+    stream->send(data, sizeof(data), &err);
+  }
+  return stream;
+}
+
+// Reads until the server closes the connection; false on timeout
+bool CompressionTest::WaitForClose(wpi::NetworkStream& stream, int timeout) {
+  char buf[1024];
+  auto err = wpi::NetworkStream::kConnectionClosed;
+  while (stream.receive(buf, sizeof(buf), &err, timeout) > 0) {
+  }
+  return err != wpi::NetworkStream::kConnectionTimedOut;
+}
+
+bool CompressionTest::WaitForString(NT_Inst inst, const char* name,
+                                    const std::string& str) {
+  auto entry = nt::GetEntry(inst, name);
+  for (int i = 0; i < 200; ++i) {
+    auto value = nt::GetEntryValue(entry);
+    if (value && value->IsString() && value->GetString() == str) {
+      return true;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  return false;
+}
+
+// Sends big strings in the initial assignments and in updates both ways
+void CompressionTest::CheckTransfer() {
+  nt::SetEntryValue(nt::GetEntry(server_inst, "/initial"),
+                    nt::Value::MakeString(big));
+  Connect();
+  ASSERT_EQ(nt::GetConnections(server_inst).size(), 1u);
+  ASSERT_TRUE(WaitForString(client_inst, "/initial", big));
+
+  nt::SetEntryValue(nt::GetEntry(server_inst, "/server"),
+                    nt::Value::MakeString(big + "server"));
+  ASSERT_TRUE(WaitForString(client_inst, "/server", big + "server"));
+
+  nt::SetEntryValue(nt::GetEntry(client_inst, "/client"),
+                    nt::Value::MakeString(big + "client"));
+  ASSERT_TRUE(WaitForString(server_inst, "/client", big + "client"));
+}
+
+TEST_P(CompressionTest, Enabled) {
+  nt::SetNetworkCompression(server_inst, true);
+  nt::SetNetworkCompression(client_inst, true);
+  CheckTransfer();
+
+  // the initial assignments are sent before the server knows the client
+  // accepts compressed blocks; only the later update is compressed
+  auto client = nt::GetConnectionMetrics(client_inst);
+  ASSERT_EQ(client.size(), 1u);
+  EXPECT_LT(client[0].bytes_received, big.size() + big.size() / 2);
+  EXPECT_LT(client[0].bytes_sent, big.size() / 2);
+}
+
+TEST_P(CompressionTest, ServerOnly) {
+  nt::SetNetworkCompression(server_inst, true);
+  CheckTransfer();
+
+  auto client = nt::GetConnectionMetrics(client_inst);
+  ASSERT_EQ(client.size(), 1u);
+  EXPECT_GT(client[0].bytes_received, 2 * big.size());
+}
+
+TEST_P(CompressionTest, ClientOnly) {
+  nt::SetNetworkCompression(client_inst, true);
+  CheckTransfer();
+
+  // the server may process the update before the client's writer thread
+  // counts the bytes it sent
+  std::vector<nt::ConnectionMetrics> client;
+  for (int i = 0; i < 100; ++i) {
+    client = nt::GetConnectionMetrics(client_inst);
+    if (client.size() == 1u && client[0].bytes_sent > big.size()) {
+      break;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  ASSERT_EQ(client.size(), 1u);
+  EXPECT_GT(client[0].bytes_sent, big.size());
+}
+
+TEST_P(CompressionTest, UnexpectedBlock) {
+  // the server never offered compression, so a block is a protocol error
+  auto stream = ConnectBlockSender();
+  ASSERT_TRUE(stream);
+  EXPECT_TRUE(WaitForClose(*stream, 2));
+}
+
+TEST_P(CompressionTest, AcceptedBlock) {
+  nt::SetNetworkCompression(server_inst, true);
+  auto stream = ConnectBlockSender();
+  ASSERT_TRUE(stream);
+  EXPECT_FALSE(WaitForClose(*stream, 1));
+  EXPECT_EQ(nt::GetConnections(server_inst).size(), 1u);
+}
+
+INSTANTIATE_TEST_SUITE_P(CompressionTests, CompressionTest,
+                         ::testing::Bool());
@@ -0,0 +1,242 @@
+// Copyright (c) FIRST and other WPILib contributors.
+// Open Source Software; you can modify and/or share it under the terms of
+// the WPILib BSD license file in the root directory of this project.
+
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <wpi/Logger.h>
+#include <wpi/mutex.h>
+
+#include "DatagramChannel.h"
+#include "MockConnectionNotifier.h"
+#include "NetworkConnection.h"
+#include "TestPrinters.h"
+#include "WireEncoder.h"
+#include "gtest/gtest.h"
+#include "ntcore_cpp.h"
+
+namespace {
+constexpr unsigned int kPort = 10014;
+}  // namespace
+
+TEST(DatagramChannelTest, SendReceive) {
+  wpi::Logger logger;
+  wpi::mutex mutex;
+  unsigned int got_token = 0;
+  std::string got_data;
+  nt::DatagramChannel receiver(
+      logger, [&](unsigned int token, wpi::StringRef data, wpi::StringRef,
+                  unsigned int) {
+        std::scoped_lock lock(mutex);
+        got_token = token;
+        got_data = data;
+      });
+  nt::DatagramChannel sender(logger, [](auto, auto, auto, auto) {});
+  ASSERT_TRUE(receiver.Start());
+  ASSERT_TRUE(sender.Start());
+  ASSERT_NE(receiver.port(), 0u);
+
+  // too short to have a token; ignored
+  sender.Send(wpi::StringRef("\x01\x02", 2), "127.0.0.1", receiver.port());
+  sender.Send(wpi::StringRef("\x12\x34\x56\x78hello", 9), "127.0.0.1",
+              receiver.port());
+  for (int i = 0; i < 100; ++i) {
+    {
+      std::scoped_lock lock(mutex);
+      if (got_token != 0) {
+        break;
+      }
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  std::scoped_lock lock(mutex);
+  EXPECT_EQ(got_token, 0x12345678u);
+  EXPECT_EQ(got_data, "hello");
+}
+
+namespace nt {
+
+namespace {
+
+// Connection to 10.0.0.1 without a transport
+class TestConnection : public NetworkConnection {
+ public:
+  TestConnection(IConnectionNotifier& notifier, wpi::Logger& logger)
+      : NetworkConnection(1, "10.0.0.1", 1735, notifier, logger, nullptr,
+                          [](unsigned int) { return NT_DOUBLE; }) {}
+};
+
+}  // namespace
+
+TEST(DatagramPeerTest, OnlyStreamPeer) {
+  wpi::Logger logger;
+  ::testing::NiceMock<MockConnectionNotifier> notifier;
+  TestConnection conn(notifier, logger);
+  std::vector<std::shared_ptr<Message>> received;
+  conn.set_process_incoming(
+      [&](std::shared_ptr<Message> msg, NetworkConnection*) {
+        received.emplace_back(std::move(msg));
+      });
+  conn.EnableDatagrams(std::make_shared<DatagramChannel>(
+                           logger, [](auto, auto, auto, auto) {}),
+                       0x12345678, false);
+  conn.set_state(NetworkConnection::kActive);
+
+  WireEncoder encoder(0x0300);
+  Message::EntryUpdate(0, 1, Value::MakeDouble(1))->Write(encoder);
+  wpi::StringRef data(encoder.data(), encoder.size());
+
+  // a host that knows the token can't take over the datagram channel
+  conn.ProcessDatagram(data, "10.0.0.2", 5800);
+  EXPECT_TRUE(received.empty());
+  EXPECT_EQ(conn.metrics().bytes_received, 0u);
+
+  conn.ProcessDatagram(data, "10.0.0.1", 5800);
+  EXPECT_EQ(received.size(), 1u);
+  // the peer's port may change
+  conn.ProcessDatagram(data, "10.0.0.1", 5801);
+  EXPECT_EQ(received.size(), 2u);
+}
+
+}  // namespace nt
+
+// Parameter selects the event loop server
+class DatagramTest : public ::testing::TestWithParam<bool> {
+ public:
+  DatagramTest()
+      : server_inst(nt::CreateInstance()), client_inst(nt::CreateInstance()) {
+    nt::SetNetworkIdentity(server_inst, "server");
+    nt::SetNetworkIdentity(client_inst, "client");
+    nt::SetServerEventLoop(server_inst, GetParam());
+    nt::SetUpdateRate(server_inst, 0.01);
+    nt::SetUpdateRate(client_inst, 0.01);
+    server_entry = nt::GetEntry(server_inst, "/odom/x");
+    nt::SetEntryValue(server_entry, nt::Value::MakeDouble(0));
+    nt::SetEntryFlags(server_entry, NT_UNRELIABLE);
+  }
+
+  ~DatagramTest() override {
+    nt::DestroyInstance(client_inst);
+    nt::DestroyInstance(server_inst);
+  }
+
+  void Connect(bool server_datagrams, bool client_datagrams) {
+    nt::SetNetworkDatagrams(server_inst, server_datagrams);
+    nt::SetNetworkDatagrams(client_inst, client_datagrams);
+    nt::StartServer(server_inst, "", "127.0.0.1", kPort);
+    nt::StartClient(client_inst, "127.0.0.1", kPort);
+    client_entry = nt::GetEntry(client_inst, "/odom/x");
+    for (int i = 0; i < 300; ++i) {
+      if (!nt::GetConnections(server_inst).empty() &&
+          nt::IsConnected(client_inst) && nt::GetEntryValue(client_entry)) {
+        break;
+      }
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    ASSERT_TRUE(nt::IsConnected(client_inst));
+  }
+
+  static bool WaitForDouble(NT_Entry entry, double value) {
+    for (int i = 0; i < 300; ++i) {
+      auto v = nt::GetEntryValue(entry);
+      if (v && v->IsDouble() && v->GetDouble() == value) {
+        return true;
+      }
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    return false;
+  }
+
+  // Sets a run of values; only the last one must arrive
+  static void SetValues(NT_Entry entry, int count) {
+    for (int i = 1; i <= count; ++i) {
+      nt::SetEntryValue(entry, nt::Value::MakeDouble(i));
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+  }
+
+ protected:
+  NT_Inst server_inst;
+  NT_Inst client_inst;
+  NT_Entry server_entry;
+  NT_Entry client_entry = 0;
+};
+
+TEST_P(DatagramTest, Updates) {
+  Connect(true, true);
+  EXPECT_EQ(nt::GetEntryFlags(client_entry), NT_UNRELIABLE);
+
+  SetValues(server_entry, 50);
+  EXPECT_TRUE(WaitForDouble(client_entry, 50));
+
+  SetValues(client_entry, 60);
+  EXPECT_TRUE(WaitForDouble(server_entry, 60));
+}
+
+TEST_P(DatagramTest, StreamUnaffected) {
+  Connect(true, true);
+
+  // assignments, flag changes and deletes still arrive
+  auto server_other = nt::GetEntry(server_inst, "/odom/y");
+  nt::SetEntryValue(server_other, nt::Value::MakeDouble(5));
+  nt::SetEntryFlags(server_other, NT_UNRELIABLE);
+  EXPECT_TRUE(WaitForDouble(nt::GetEntry(client_inst, "/odom/y"), 5));
+
+  nt::SetEntryFlags(server_entry, 0);
+  for (int i = 0; i < 300 && nt::GetEntryFlags(client_entry) != 0; ++i) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  EXPECT_EQ(nt::GetEntryFlags(client_entry), 0u);
+  SetValues(server_entry, 10);
+  EXPECT_TRUE(WaitForDouble(client_entry, 10));
+
+  nt::DeleteEntry(server_entry);
+  for (int i = 0; i < 300 && nt::GetEntryValue(client_entry); ++i) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  EXPECT_FALSE(nt::GetEntryValue(client_entry));
+}
+
+TEST_P(DatagramTest, FlagsUpdate) {
+  Connect(true, true);
+
+  // an entry made unreliable after the connection is up, from either side
+  auto server_other = nt::GetEntry(server_inst, "/odom/y");
+  nt::SetEntryValue(server_other, nt::Value::MakeDouble(1));
+  auto client_other = nt::GetEntry(client_inst, "/odom/y");
+  ASSERT_TRUE(WaitForDouble(client_other, 1));
+  nt::SetEntryFlags(client_other, NT_UNRELIABLE);
+  for (int i = 0;
+       i < 300 && nt::GetEntryFlags(server_other) != NT_UNRELIABLE; ++i) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  EXPECT_EQ(nt::GetEntryFlags(server_other), NT_UNRELIABLE);
+
+  SetValues(server_other, 20);
+  EXPECT_TRUE(WaitForDouble(client_other, 20));
+  SetValues(client_other, 30);
+  EXPECT_TRUE(WaitForDouble(server_other, 30));
+}
+
+TEST_P(DatagramTest, ServerDisabled) {
+  // the client falls back to the stream
+  Connect(false, true);
+  SetValues(server_entry, 20);
+  EXPECT_TRUE(WaitForDouble(client_entry, 20));
+  SetValues(client_entry, 30);
+  EXPECT_TRUE(WaitForDouble(server_entry, 30));
+}
+
+TEST_P(DatagramTest, ClientDisabled) {
+  Connect(true, false);
+  SetValues(server_entry, 20);
+  EXPECT_TRUE(WaitForDouble(client_entry, 20));
+  SetValues(client_entry, 30);
+  EXPECT_TRUE(WaitForDouble(server_entry, 30));
+}
+
+INSTANTIATE_TEST_SUITE_P(DatagramTests, DatagramTest, ::testing::Bool());
@@ -2,6 +2,9 @@
 // Open Source Software; you can modify and/or share it under the terms of
 // the WPILib BSD license file in the root directory of this project.
 
+#include <algorithm>
+#include <vector>
+
 #include <wpi/Logger.h>
 
 #include "EntryNotifier.h"
@@ -308,4 +311,78 @@ TEST_F(EntryNotifierTest, PollPrefixLocal) {
   ASSERT_EQ(results.size(), 6u);
 }
 
+TEST_F(EntryNotifierTest, PollPrefixOverlapping) {
+  auto poller = notifier.CreatePoller();
+  static const char* prefixes[] = {"", "/", "/f", "/foo", "/foo/bar",
+                                   "/foo/baz", "/b", "/bo", "/x"};
+  std::vector<unsigned int> handles;
+  for (auto prefix : prefixes) {
+    handles.push_back(notifier.AddPolled(poller, prefix, NT_NOTIFY_NEW));
+  }
+
+  GenerateNotifications();
+
+  ASSERT_TRUE(notifier.WaitForQueue(1.0));
+  bool timed_out = false;
+  auto results = notifier.Poll(poller, 0, &timed_out);
+  ASSERT_FALSE(timed_out);
+
+  // each key generates two "new" notifications
+  std::vector<int> counts(handles.size());
+  for (const auto& result : results) {
+    SCOPED_TRACE(::testing::PrintToString(result));
+    auto it =
+        std::find(handles.begin(), handles.end(),
+                  static_cast<unsigned int>(Handle{result.listener}.GetIndex()));
+    ASSERT_NE(it, handles.end());
+    EXPECT_TRUE(wpi::StringRef(result.name).startswith(
+        prefixes[it - handles.begin()]));
+    ++counts[it - handles.begin()];
+  }
+  EXPECT_EQ(counts[0], 6);  // ""
+  EXPECT_EQ(counts[1], 6);  // "/"
+  EXPECT_EQ(counts[2], 2);  // "/f"
+  EXPECT_EQ(counts[3], 2);  // "/foo"
+  EXPECT_EQ(counts[4], 2);  // "/foo/bar"
+  EXPECT_EQ(counts[5], 0);  // "/foo/baz"
+  EXPECT_EQ(counts[6], 4);  // "/b"
+  EXPECT_EQ(counts[7], 2);  // "/bo"
+  EXPECT_EQ(counts[8], 0);  // "/x"
+}
+
+TEST_F(EntryNotifierTest, PollPrefixRemove) {
+  auto poller = notifier.CreatePoller();
+  auto h1 = notifier.AddPolled(poller, "/foo", NT_NOTIFY_NEW);
+  auto h2 = notifier.AddPolled(poller, "/foo/bar", NT_NOTIFY_NEW);
+  auto h3 = notifier.AddPolled(poller, "/fo", NT_NOTIFY_NEW);
+  auto h4 = notifier.AddPolled(poller, 5, NT_NOTIFY_NEW);
+
+  // removing the intermediate prefix must not lose the ones below it
+  notifier.Remove(h1);
+  notifier.Remove(h4);
+
+  GenerateNotifications();
+
+  ASSERT_TRUE(notifier.WaitForQueue(1.0));
+  bool timed_out = false;
+  auto results = notifier.Poll(poller, 0, &timed_out);
+  ASSERT_FALSE(timed_out);
+
+  int h2count = 0;
+  int h3count = 0;
+  for (const auto& result : results) {
+    SCOPED_TRACE(::testing::PrintToString(result));
+    EXPECT_EQ(result.name, "/foo/bar");
+    if (Handle{result.listener}.GetIndex() == static_cast<int>(h2)) {
+      ++h2count;
+    } else if (Handle{result.listener}.GetIndex() == static_cast<int>(h3)) {
+      ++h3count;
+    } else {
+      ADD_FAILURE() << "unexpected listener index";
+    }
+  }
+  EXPECT_EQ(h2count, 2);
+  EXPECT_EQ(h3count, 2);
+}
+
 }  // namespace nt
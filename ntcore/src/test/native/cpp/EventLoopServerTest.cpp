@@ -0,0 +1,260 @@
+// Copyright (c) FIRST and other WPILib contributors.
+// Open Source Software; you can modify and/or share it under the terms of
+// the WPILib BSD license file in the root directory of this project.
+
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <wpi/Logger.h>
+#include <wpi/NetworkStream.h>
+#include <wpi/TCPConnector.h>
+
+#include "TestPrinters.h"
+#include "gtest/gtest.h"
+#include "ntcore_cpp.h"
+
+class EventLoopServerTest : public ::testing::Test {
+ public:
+  EventLoopServerTest()
+      : server_inst(nt::CreateInstance()), client_inst(nt::CreateInstance()) {
+    nt::SetNetworkIdentity(server_inst, "server");
+    nt::SetNetworkIdentity(client_inst, "client");
+    nt::SetServerEventLoop(server_inst, true);
+    nt::SetUpdateRate(server_inst, 0.01);
+    nt::SetUpdateRate(client_inst, 0.01);
+  }
+
+  ~EventLoopServerTest() override {
+    nt::DestroyInstance(server_inst);
+    nt::DestroyInstance(client_inst);
+  }
+
+  void Connect();
+  std::shared_ptr<nt::Value> WaitForValue(NT_Inst inst, const char* name,
+                                          double expected);
+
+ protected:
+  NT_Inst server_inst;
+  NT_Inst client_inst;
+};
+
+void EventLoopServerTest::Connect() {
+  nt::StartServer(server_inst, "", "127.0.0.1", 10010);
+  nt::StartClient(client_inst, "127.0.0.1", 10010);
+
+  // wait for the server to see the connection (up to 2 seconds)
+  for (int i = 0; i < 200 && nt::GetConnections(server_inst).empty(); ++i) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+}
+
+std::shared_ptr<nt::Value> EventLoopServerTest::WaitForValue(
+    NT_Inst inst, const char* name, double expected) {
+  auto entry = nt::GetEntry(inst, name);
+  std::shared_ptr<nt::Value> value;
+  for (int i = 0; i < 200; ++i) {
+    value = nt::GetEntryValue(entry);
+    if (value && value->IsDouble() && value->GetDouble() == expected) {
+      break;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  return value;
+}
+
+TEST_F(EventLoopServerTest, ConnectDisconnect) {
+  std::vector<nt::ConnectionNotification> result;
+  nt::AddConnectionListener(
+      server_inst,
+      [&](const nt::ConnectionNotification& event) { result.push_back(event); },
+      false);
+
+  Connect();
+  ASSERT_EQ(nt::GetConnections(server_inst).size(), 1u);
+  EXPECT_EQ(nt::GetConnections(server_inst)[0].remote_id, "client");
+
+  ASSERT_TRUE(nt::WaitForConnectionListenerQueue(server_inst, 1.0));
+  ASSERT_EQ(result.size(), 1u);
+  EXPECT_TRUE(result[0].connected);
+  result.clear();
+
+  nt::StopClient(client_inst);
+  for (int i = 0; i < 100 && !nt::GetConnections(server_inst).empty(); ++i) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  ASSERT_TRUE(nt::WaitForConnectionListenerQueue(server_inst, 1.0));
+  ASSERT_EQ(result.size(), 1u);
+  EXPECT_FALSE(result[0].connected);
+}
+
+TEST_F(EventLoopServerTest, SilentClients) {
+  nt::StartServer(server_inst, "", "127.0.0.1", 10010);
+
+  // more peers that never send a hello than libuv has work threads
+  wpi::Logger logger;
+  std::vector<std::unique_ptr<wpi::NetworkStream>> silent;
+  for (int i = 0; i < 200 && silent.size() < 8; ++i) {
+    // the server starts listening asynchronously
+    if (auto stream =
+            wpi::TCPConnector::connect("127.0.0.1", 10010, logger, 1)) {
+      silent.emplace_back(std::move(stream));
+    } else {
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+  }
+  ASSERT_EQ(silent.size(), 8u);
+
+  // a real client still gets through
+  nt::StartClient(client_inst, "127.0.0.1", 10010);
+  for (int i = 0; i < 200 && nt::GetConnections(server_inst).empty(); ++i) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  ASSERT_EQ(nt::GetConnections(server_inst).size(), 1u);
+
+  // and the silent peers are eventually disconnected
+  for (auto&& stream : silent) {
+    char buf[64];
+    auto err = wpi::NetworkStream::kConnectionClosed;
+    size_t len = stream->receive(buf, sizeof(buf), &err, 10);
+    EXPECT_EQ(len, 0u);
+    EXPECT_NE(err, wpi::NetworkStream::kConnectionTimedOut);
+  }
+  EXPECT_EQ(nt::GetConnections(server_inst).size(), 1u);
+}
+
+TEST_F(EventLoopServerTest, InitialAssignments) {
+  nt::SetEntryValue(nt::GetEntry(server_inst, "/server"),
+                    nt::Value::MakeDouble(1.0));
+  nt::SetEntryValue(nt::GetEntry(client_inst, "/client"),
+                    nt::Value::MakeDouble(2.0));
+
+  Connect();
+  ASSERT_EQ(nt::GetConnections(server_inst).size(), 1u);
+
+  auto value = WaitForValue(client_inst, "/server", 1.0);
+  ASSERT_TRUE(value);
+  EXPECT_EQ(value->GetDouble(), 1.0);
+
+  value = WaitForValue(server_inst, "/client", 2.0);
+  ASSERT_TRUE(value);
+  EXPECT_EQ(value->GetDouble(), 2.0);
+}
+
+TEST_F(EventLoopServerTest, Updates) {
+  Connect();
+  ASSERT_EQ(nt::GetConnections(server_inst).size(), 1u);
+
+  auto server_entry = nt::GetEntry(server_inst, "/value");
+  for (int i = 1; i <= 10; ++i) {
+    nt::SetEntryValue(server_entry, nt::Value::MakeDouble(i));
+    nt::Flush(server_inst);
+  }
+  auto value = WaitForValue(client_inst, "/value", 10.0);
+  ASSERT_TRUE(value);
+  EXPECT_EQ(value->GetDouble(), 10.0);
+
+  nt::SetEntryValue(nt::GetEntry(client_inst, "/value"),
+                    nt::Value::MakeDouble(20.0));
+  nt::Flush(client_inst);
+  value = WaitForValue(server_inst, "/value", 20.0);
+  ASSERT_TRUE(value);
+  EXPECT_EQ(value->GetDouble(), 20.0);
+}
+
+TEST_F(EventLoopServerTest, Metrics) {
+  Connect();
+  auto server_entry = nt::GetEntry(server_inst, "/value");
+  nt::SetEntryValue(server_entry, nt::Value::MakeDouble(1.0));
+  ASSERT_TRUE(WaitForValue(client_inst, "/value", 1.0));
+  nt::SetEntryValue(nt::GetEntry(client_inst, "/value"),
+                    nt::Value::MakeDouble(2.0));
+  ASSERT_TRUE(WaitForValue(server_inst, "/value", 2.0));
+
+  auto server = nt::GetConnectionMetrics(server_inst);
+  ASSERT_EQ(server.size(), 1u);
+  EXPECT_EQ(server[0].info.remote_id, "client");
+  EXPECT_GT(server[0].bytes_sent, 0u);
+  EXPECT_GT(server[0].bytes_received, 0u);
+  EXPECT_GE(server[0].messages_received, 3u);  // hello, done, update
+
+  auto client = nt::GetConnectionMetrics(client_inst);
+  ASSERT_EQ(client.size(), 1u);
+  EXPECT_GT(client[0].bytes_sent, 0u);
+  EXPECT_GT(client[0].rtt, 0u);
+
+  EXPECT_EQ(nt::GetEntryUpdateCount(server_entry), 2u);
+}
+
+TEST_F(EventLoopServerTest, MetricsPublishing) {
+  nt::SetMetricsPublishing(server_inst, true);
+  Connect();
+
+  auto conns = nt::GetConnections(server_inst);
+  ASSERT_EQ(conns.size(), 1u);
+  std::string name = "/.nt/metrics/server/client:" +
+                     std::to_string(conns[0].remote_port) + "/rtt";
+
+  // published by the server once a second and replicated to the client
+  auto entry = nt::GetEntry(client_inst, name);
+  std::shared_ptr<nt::Value> value;
+  for (int i = 0; i < 300 && !value; ++i) {
+    value = nt::GetEntryValue(entry);
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  ASSERT_TRUE(value);
+  EXPECT_TRUE(value->IsDouble());
+
+  // the table goes away with the connection
+  nt::StopClient(client_inst);
+  entry = nt::GetEntry(server_inst, name);
+  for (int i = 0; i < 300 && value; ++i) {
+    value = nt::GetEntryValue(entry);
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  EXPECT_FALSE(value);
+}
+
+TEST_F(EventLoopServerTest, ArrayDeltas) {
+  std::vector<double> arr(100, 1.0);
+  auto server_entry = nt::GetEntry(server_inst, "/array");
+  nt::SetEntryValue(server_entry, nt::Value::MakeDoubleArray(arr));
+  Connect();
+  auto client_entry = nt::GetEntry(client_inst, "/array");
+
+  auto wait_for = [](NT_Entry entry, const std::vector<double>& expected) {
+    for (int i = 0; i < 200; ++i) {
+      auto value = nt::GetEntryValue(entry);
+      if (value && value->IsDoubleArray() &&
+          value->GetDoubleArray() == wpi::ArrayRef<double>(expected)) {
+        return true;
+      }
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    return false;
+  };
+  ASSERT_TRUE(wait_for(client_entry, arr));
+  auto before = nt::GetConnectionMetrics(client_inst)[0].bytes_received;
+
+  // single element changes only send that element
+  for (int i = 0; i < 10; ++i) {
+    arr[i * 7] = i;
+    nt::SetEntryValue(server_entry, nt::Value::MakeDoubleArray(arr));
+    nt::Flush(server_inst);
+    ASSERT_TRUE(wait_for(client_entry, arr));
+  }
+  auto after = nt::GetConnectionMetrics(client_inst)[0].bytes_received;
+  EXPECT_LT(after - before, 10 * 100u);
+
+  // resized arrays and the other direction
+  arr.resize(120, 2.0);
+  nt::SetEntryValue(client_entry, nt::Value::MakeDoubleArray(arr));
+  ASSERT_TRUE(wait_for(server_entry, arr));
+  arr.resize(50);
+  arr[3] = -1.0;
+  nt::SetEntryValue(client_entry, nt::Value::MakeDoubleArray(arr));
+  ASSERT_TRUE(wait_for(server_entry, arr));
+}
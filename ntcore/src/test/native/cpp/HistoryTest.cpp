@@ -0,0 +1,266 @@
+// Copyright (c) FIRST and other WPILib contributors.
+// Open Source Software; you can modify and/or share it under the terms of
+// the WPILib BSD license file in the root directory of this project.
+
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include <wpi/Logger.h>
+#include <wpi/mutex.h>
+#include <wpi/raw_istream.h>
+
+#include "Message.h"
+#include "TestPrinters.h"
+#include "WireDecoder.h"
+#include "WireEncoder.h"
+#include "gtest/gtest.h"
+#include "ntcore_cpp.h"
+
+namespace {
+constexpr unsigned int kPort = 10016;
+}  // namespace
+
+namespace nt {
+
+static std::shared_ptr<Message> MakeHistory() {
+  std::vector<std::shared_ptr<Message>> updates;
+  updates.emplace_back(Message::EntryUpdate(5, 1, Value::MakeDouble(1, 1000)));
+  updates.emplace_back(Message::EntryUpdate(5, 2, Value::MakeDouble(2, 1500)));
+  updates.emplace_back(
+      Message::EntryUpdate(5, 3, Value::MakeString("x", 4000)));
+  return Message::EntryHistory(std::move(updates));
+}
+
+TEST(EntryHistoryMessageTest, RoundTrip) {
+  WireEncoder e(0x0300u);
+  e.set_entry_history(true);
+  MakeHistory()->Write(e);
+  ASSERT_EQ(nullptr, e.error());
+
+  wpi::raw_mem_istream is(e.data(), e.size());
+  wpi::Logger logger;
+  WireDecoder d(is, 0x0300u, logger);
+  auto msg = Message::Read(d, [](unsigned int) { return NT_UNASSIGNED; });
+  ASSERT_TRUE(msg);
+  ASSERT_EQ(Message::kEntryHistory, msg->type());
+  EXPECT_EQ(5u, msg->id());
+  EXPECT_EQ(3u, msg->seq_num_uid());
+  ASSERT_EQ(3u, msg->history().size());
+  EXPECT_EQ(*Value::MakeString("x"), *msg->value());
+  EXPECT_EQ(*Value::MakeDouble(1), *msg->history()[0]->value());
+  EXPECT_EQ(2u, msg->history()[1]->seq_num_uid());
+
+  // spacing between the updates is kept; the last one is the receive time
+  uint64_t last = msg->value()->time();
+  EXPECT_EQ(3000u, last - msg->history()[0]->value()->time());
+  EXPECT_EQ(2500u, last - msg->history()[1]->value()->time());
+}
+
+TEST(EntryHistoryMessageTest, WriteWithoutSupport) {
+  WireEncoder e(0x0300u);
+  MakeHistory()->Write(e);
+  ASSERT_EQ(nullptr, e.error());
+
+  // written as ordinary updates
+  wpi::raw_mem_istream is(e.data(), e.size());
+  wpi::Logger logger;
+  WireDecoder d(is, 0x0300u, logger);
+  auto get_type = [](unsigned int) { return NT_UNASSIGNED; };
+  for (unsigned int seq_num = 1; seq_num <= 3; ++seq_num) {
+    auto msg = Message::Read(d, get_type);
+    ASSERT_TRUE(msg);
+    EXPECT_EQ(Message::kEntryUpdate, msg->type());
+    EXPECT_EQ(seq_num, msg->seq_num_uid());
+  }
+}
+
+}  // namespace nt
+
+class HistoryTest : public ::testing::Test {
+ public:
+  HistoryTest()
+      : server_inst(nt::CreateInstance()), client_inst(nt::CreateInstance()) {
+    nt::SetNetworkIdentity(server_inst, "server");
+    nt::SetNetworkIdentity(client_inst, "client");
+    nt::SetUpdateRate(server_inst, 0.1);
+    nt::SetUpdateRate(client_inst, 0.1);
+    server_entry = nt::GetEntry(server_inst, "/hist");
+    nt::SetEntryValue(server_entry, nt::Value::MakeDouble(0));
+    nt::SetEntryFlags(server_entry, NT_HISTORY);
+
+    nt::StartServer(server_inst, "", "127.0.0.1", kPort);
+    nt::StartClient(client_inst, "127.0.0.1", kPort);
+    client_entry = nt::GetEntry(client_inst, "/hist");
+    for (int i = 0; i < 300; ++i) {
+      if (nt::GetEntryFlags(client_entry) == NT_HISTORY) {
+        break;
+      }
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+  }
+
+  ~HistoryTest() override {
+    nt::DestroyInstance(client_inst);
+    nt::DestroyInstance(server_inst);
+  }
+
+  // Sets 1..count much faster than the update rate
+  static void SetValues(NT_Entry entry, int count) {
+    for (int i = 1; i <= count; ++i) {
+      nt::SetEntryValue(entry, nt::Value::MakeDouble(i));
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+  }
+
+  // Listens for updates, recording every value a listener receives
+  struct Recorder {
+    void Add(NT_Entry entry, unsigned int flags) {
+      nt::AddEntryListener(
+          entry,
+          [this](const nt::EntryNotification& event) {
+            std::scoped_lock lock(mutex);
+            ++notifications;
+            if ((event.flags & NT_NOTIFY_HISTORY) != 0) {
+              for (auto&& value : event.history) {
+                values.push_back(value->GetDouble());
+              }
+            } else {
+              values.push_back(event.value->GetDouble());
+            }
+          },
+          flags);
+    }
+
+    bool WaitFor(double value) {
+      for (int i = 0; i < 300; ++i) {
+        {
+          std::scoped_lock lock(mutex);
+          if (!values.empty() && values.back() == value) {
+            return true;
+          }
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+      }
+      return false;
+    }
+
+    wpi::mutex mutex;
+    int notifications = 0;
+    std::vector<double> values;
+  };
+
+  static std::vector<double> Sequence(int count) {
+    std::vector<double> values;
+    for (int i = 1; i <= count; ++i) {
+      values.push_back(i);
+    }
+    return values;
+  }
+
+ protected:
+  NT_Inst server_inst;
+  NT_Inst client_inst;
+  NT_Entry server_entry;
+  NT_Entry client_entry;
+};
+
+TEST_F(HistoryTest, ServerToClient) {
+  ASSERT_EQ(nt::GetEntryFlags(client_entry), NT_HISTORY);
+  Recorder history, latest;
+  history.Add(client_entry, NT_NOTIFY_UPDATE | NT_NOTIFY_HISTORY);
+  latest.Add(client_entry, NT_NOTIFY_UPDATE);
+
+  SetValues(server_entry, 50);
+  ASSERT_TRUE(history.WaitFor(50));
+  ASSERT_TRUE(latest.WaitFor(50));
+
+  std::scoped_lock lock(history.mutex, latest.mutex);
+  EXPECT_EQ(history.values, Sequence(50));
+  // far fewer notifications than values
+  EXPECT_LT(history.notifications, 50);
+  // plain listeners only see the latest value of each batch
+  EXPECT_EQ(latest.notifications, history.notifications);
+  EXPECT_LT(latest.values.size(), 50u);
+}
+
+TEST_F(HistoryTest, ClientToServer) {
+  ASSERT_EQ(nt::GetEntryFlags(client_entry), NT_HISTORY);
+  Recorder history;
+  history.Add(server_entry, NT_NOTIFY_UPDATE | NT_NOTIFY_HISTORY);
+
+  SetValues(client_entry, 30);
+  ASSERT_TRUE(history.WaitFor(30));
+  std::scoped_lock lock(history.mutex);
+  EXPECT_EQ(history.values, Sequence(30));
+}
+
+TEST_F(HistoryTest, Bounded) {
+  ASSERT_EQ(nt::GetEntryFlags(client_entry), NT_HISTORY);
+  Recorder history;
+  history.Add(client_entry, NT_NOTIFY_UPDATE | NT_NOTIFY_HISTORY);
+
+  // more values than a batch holds between two network updates
+  for (int i = 1; i <= 1000; ++i) {
+    nt::SetEntryValue(server_entry, nt::Value::MakeDouble(i));
+  }
+  ASSERT_TRUE(history.WaitFor(1000));
+  std::scoped_lock lock(history.mutex);
+  EXPECT_LT(history.values.size(), 1000u);
+  EXPECT_GE(history.values.size(), 128u);
+}
+
+TEST_F(HistoryTest, NotHistoryEntry) {
+  nt::SetEntryFlags(server_entry, 0);
+  for (int i = 0; i < 300 && nt::GetEntryFlags(client_entry) != 0; ++i) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  Recorder history;
+  history.Add(client_entry, NT_NOTIFY_UPDATE | NT_NOTIFY_HISTORY);
+
+  // only the latest value is sent at each update
+  SetValues(server_entry, 50);
+  ASSERT_TRUE(history.WaitFor(50));
+  std::scoped_lock lock(history.mutex);
+  EXPECT_LT(history.values.size(), 50u);
+}
+
+TEST_F(HistoryTest, FlagsSetAfterConnect) {
+  // flagged by the client once connected
+  nt::SetEntryFlags(client_entry, 0);
+  for (int i = 0; i < 300 && nt::GetEntryFlags(server_entry) != 0; ++i) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  nt::SetEntryFlags(client_entry, NT_HISTORY);
+  for (int i = 0; i < 300 && nt::GetEntryFlags(server_entry) != NT_HISTORY;
+       ++i) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  ASSERT_EQ(nt::GetEntryFlags(server_entry), NT_HISTORY);
+  Recorder history;
+  history.Add(client_entry, NT_NOTIFY_UPDATE | NT_NOTIFY_HISTORY);
+
+  SetValues(server_entry, 50);
+  ASSERT_TRUE(history.WaitFor(50));
+  std::scoped_lock lock(history.mutex);
+  EXPECT_EQ(history.values, Sequence(50));
+}
+
+TEST_F(HistoryTest, NewEntry) {
+  auto client_new = nt::GetEntry(client_inst, "/new");
+  Recorder history;
+  history.Add(client_new,
+              NT_NOTIFY_NEW | NT_NOTIFY_UPDATE | NT_NOTIFY_HISTORY);
+
+  // created and updated before its assignment is sent
+  auto server_new = nt::GetEntry(server_inst, "/new");
+  nt::SetEntryValue(server_new, nt::Value::MakeDouble(1));
+  nt::SetEntryFlags(server_new, NT_HISTORY);
+  for (int i = 2; i <= 10; ++i) {
+    nt::SetEntryValue(server_new, nt::Value::MakeDouble(i));
+  }
+  ASSERT_TRUE(history.WaitFor(10));
+  std::scoped_lock lock(history.mutex);
+  EXPECT_EQ(history.values, Sequence(10));
+}
@@ -0,0 +1,106 @@
+// Copyright (c) FIRST and other WPILib contributors.
+// Open Source Software; you can modify and/or share it under the terms of
+// the WPILib BSD license file in the root directory of this project.
+
+#ifdef __linux__
+
+#include <chrono>
+#include <thread>
+
+#include "TestPrinters.h"
+#include "gtest/gtest.h"
+#include "ntcore_cpp.h"
+
+// Parameter selects the event loop server
+class LocalTransportTest : public ::testing::TestWithParam<bool> {
+ public:
+  LocalTransportTest()
+      : server_inst(nt::CreateInstance()),
+        client_inst(nt::CreateInstance()),
+        tcp_inst(nt::CreateInstance()) {
+    nt::SetNetworkIdentity(server_inst, "server");
+    nt::SetNetworkIdentity(client_inst, "client");
+    nt::SetNetworkIdentity(tcp_inst, "tcp");
+    nt::SetServerEventLoop(server_inst, GetParam());
+    nt::SetUpdateRate(server_inst, 0.01);
+    nt::SetUpdateRate(client_inst, 0.01);
+    nt::SetUpdateRate(tcp_inst, 0.01);
+  }
+
+  ~LocalTransportTest() override {
+    nt::DestroyInstance(tcp_inst);
+    nt::DestroyInstance(client_inst);
+    nt::DestroyInstance(server_inst);
+  }
+
+  bool WaitForConnections(size_t count);
+  bool WaitForDouble(NT_Inst inst, const char* name, double value);
+
+ protected:
+  NT_Inst server_inst;
+  NT_Inst client_inst;
+  NT_Inst tcp_inst;
+};
+
+bool LocalTransportTest::WaitForConnections(size_t count) {
+  for (int i = 0; i < 200; ++i) {
+    if (nt::GetConnections(server_inst).size() == count) {
+      return true;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  return false;
+}
+
+bool LocalTransportTest::WaitForDouble(NT_Inst inst, const char* name,
+                                       double value) {
+  auto entry = nt::GetEntry(inst, name);
+  for (int i = 0; i < 200; ++i) {
+    auto v = nt::GetEntryValue(entry);
+    if (v && v->IsDouble() && v->GetDouble() == value) {
+      return true;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  return false;
+}
+
+TEST_P(LocalTransportTest, Updates) {
+  nt::SetEntryValue(nt::GetEntry(server_inst, "/initial"),
+                    nt::Value::MakeDouble(1.0));
+  nt::StartServer(server_inst, "", "shm:ntcore-test", 10012);
+  nt::StartClient(client_inst, "shm:ntcore-test", 0);
+  ASSERT_TRUE(WaitForConnections(1));
+  ASSERT_TRUE(WaitForDouble(client_inst, "/initial", 1.0));
+
+  auto conns = nt::GetConnections(server_inst);
+  ASSERT_EQ(conns.size(), 1u);
+  EXPECT_EQ(conns[0].remote_ip, "shm:ntcore-test");
+
+  nt::SetEntryValue(nt::GetEntry(server_inst, "/server"),
+                    nt::Value::MakeDouble(2.0));
+  EXPECT_TRUE(WaitForDouble(client_inst, "/server", 2.0));
+  nt::SetEntryValue(nt::GetEntry(client_inst, "/client"),
+                    nt::Value::MakeDouble(3.0));
+  EXPECT_TRUE(WaitForDouble(server_inst, "/client", 3.0));
+}
+
+TEST_P(LocalTransportTest, AlsoListensOnTcp) {
+  nt::StartServer(server_inst, "", "shm:ntcore-test", 10012);
+  nt::StartClient(client_inst, "shm:ntcore-test", 0);
+  nt::StartClient(tcp_inst, "127.0.0.1", 10012);
+  ASSERT_TRUE(WaitForConnections(2));
+
+  // updates from one client reach the other through the server
+  nt::SetEntryValue(nt::GetEntry(client_inst, "/local"),
+                    nt::Value::MakeDouble(4.0));
+  EXPECT_TRUE(WaitForDouble(tcp_inst, "/local", 4.0));
+  nt::SetEntryValue(nt::GetEntry(tcp_inst, "/remote"),
+                    nt::Value::MakeDouble(5.0));
+  EXPECT_TRUE(WaitForDouble(client_inst, "/remote", 5.0));
+}
+
+INSTANTIATE_TEST_SUITE_P(LocalTransportTests, LocalTransportTest,
+                         ::testing::Bool());
+
+#endif  // __linux__
@@ -6,6 +6,7 @@
 #define NTCORE_MOCKENTRYNOTIFIER_H_
 
 #include <memory>
+#include <vector>
 
 #include "IEntryNotifier.h"
 #include "gmock/gmock.h"
@@ -33,6 +34,9 @@ class MockEntryNotifier : public IEntryNotifier {
                void(unsigned int local_id, wpi::StringRef name,
                     std::shared_ptr<Value> value, unsigned int flags,
                     unsigned int only_listener));
+  MOCK_METHOD3(NotifyHistory,
+               void(unsigned int local_id, wpi::StringRef name,
+                    std::vector<std::shared_ptr<Value>> values));
 };
 
 }  // namespace nt
@@ -0,0 +1,234 @@
+// Copyright (c) FIRST and other WPILib contributors.
+// Open Source Software; you can modify and/or share it under the terms of
+// the WPILib BSD license file in the root directory of this project.
+
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+
+#include <wpi/Logger.h>
+
+#include "MockConnectionNotifier.h"
+#include "NetworkConnection.h"
+#include "PublishPolicyTable.h"
+#include "TestPrinters.h"
+#include "gtest/gtest.h"
+
+namespace nt {
+
+namespace {
+
+// Connection without a transport; outgoing batches are popped directly
+class TestConnection : public NetworkConnection {
+ public:
+  TestConnection(IConnectionNotifier& notifier, wpi::Logger& logger)
+      : NetworkConnection(1, "127.0.0.1", 1735, notifier, logger, nullptr,
+                          nullptr) {}
+
+  // Post pending messages and return them (empty if nothing was posted)
+  Outgoing Post() {
+    PostOutgoing(false);
+    if (m_outgoing.empty()) {
+      return {};
+    }
+    return m_outgoing.pop();
+  }
+
+  // Handle a message as if it had been received
+  void Receive(std::shared_ptr<Message> msg) {
+    ProcessIncoming(std::move(msg));
+  }
+};
+
+}  // namespace
+
+class PublishPolicyTest : public ::testing::Test {
+ public:
+  PublishPolicyTest() : conn(notifier, logger) {
+    conn.set_publish_policies(&policies);
+    conn.set_process_incoming(
+        [](std::shared_ptr<Message>, NetworkConnection*) {});
+  }
+
+  static std::shared_ptr<Message> Assign(const char* name, unsigned int id,
+                                         double value) {
+    return Message::EntryAssign(name, id, 1, Value::MakeDouble(value), 0);
+  }
+
+  static std::shared_ptr<Message> Update(unsigned int id, double value) {
+    return Message::EntryUpdate(id, 2, Value::MakeDouble(value));
+  }
+
+  wpi::Logger logger;
+  ::testing::NiceMock<MockConnectionNotifier> notifier;
+  PublishPolicyTable policies;
+  TestConnection conn;
+};
+
+TEST_F(PublishPolicyTest, NoPolicy) {
+  conn.QueueOutgoing(Assign("/gyro/x", 0, 0));
+  ASSERT_EQ(conn.Post().size(), 1u);
+  conn.QueueOutgoing(Update(0, 0.1));
+  auto out = conn.Post();
+  ASSERT_EQ(out.size(), 1u);
+  EXPECT_EQ(out[0]->value()->GetDouble(), 0.1);
+}
+
+TEST_F(PublishPolicyTest, AbsoluteDeadband) {
+  PublishPolicy policy;
+  policy.abs_deadband = 0.5;
+  policies.Set("/gyro/", policy);
+
+  conn.QueueOutgoing(Assign("/gyro/x", 0, 0));
+  conn.QueueOutgoing(Assign("/other", 1, 0));
+  ASSERT_EQ(conn.Post().size(), 2u);
+
+  conn.QueueOutgoing(Update(0, 0.1));  // within deadband
+  conn.QueueOutgoing(Update(1, 0.1));  // no policy
+  auto out = conn.Post();
+  ASSERT_EQ(out.size(), 1u);
+  EXPECT_EQ(out[0]->id(), 1u);
+
+  conn.QueueOutgoing(Update(0, 0.6));
+  out = conn.Post();
+  ASSERT_EQ(out.size(), 1u);
+  EXPECT_EQ(out[0]->value()->GetDouble(), 0.6);
+
+  // measured from the last value sent
+  conn.QueueOutgoing(Update(0, 0.9));
+  EXPECT_TRUE(conn.Post().empty());
+
+  PublishPolicyStats stats;
+  ASSERT_TRUE(policies.GetStats("/gyro/", &stats));
+  EXPECT_EQ(stats.deadband, 2u);
+  EXPECT_EQ(stats.rate_limited, 0u);
+  EXPECT_FALSE(policies.GetStats("/gyro", &stats));
+}
+
+TEST_F(PublishPolicyTest, RelativeDeadband) {
+  PublishPolicy policy;
+  policy.rel_deadband = 0.1;
+  policies.Set("", policy);
+
+  conn.QueueOutgoing(Assign("/x", 0, 100));
+  ASSERT_EQ(conn.Post().size(), 1u);
+  conn.QueueOutgoing(Update(0, 105));
+  EXPECT_TRUE(conn.Post().empty());
+  conn.QueueOutgoing(Update(0, 111));
+  EXPECT_EQ(conn.Post().size(), 1u);
+}
+
+TEST_F(PublishPolicyTest, RateLimitDrop) {
+  PublishPolicy policy;
+  policy.period = 3600;
+  policies.Set("/gyro/", policy);
+
+  conn.QueueOutgoing(Assign("/gyro/x", 0, 0));
+  ASSERT_EQ(conn.Post().size(), 1u);
+  for (int i = 1; i <= 10; ++i) {
+    conn.QueueOutgoing(Update(0, i));
+  }
+  EXPECT_TRUE(conn.Post().empty());
+
+  PublishPolicyStats stats;
+  ASSERT_TRUE(policies.GetStats("/gyro/", &stats));
+  EXPECT_EQ(stats.rate_limited, 10u);
+}
+
+TEST_F(PublishPolicyTest, RateLimitLatestOnly) {
+  PublishPolicy policy;
+  policy.period = 0.05;
+  policy.latest_only = true;
+  policies.Set("/gyro/", policy);
+
+  conn.QueueOutgoing(Assign("/gyro/x", 0, 0));
+  ASSERT_EQ(conn.Post().size(), 1u);
+  conn.QueueOutgoing(Update(0, 1));
+  conn.QueueOutgoing(Update(0, 2));
+  conn.QueueOutgoing(Update(0, 3));
+  EXPECT_TRUE(conn.Post().empty());
+
+  std::this_thread::sleep_for(std::chrono::milliseconds(60));
+  auto out = conn.Post();
+  ASSERT_EQ(out.size(), 1u);
+  EXPECT_EQ(out[0]->value()->GetDouble(), 3);
+
+  PublishPolicyStats stats;
+  ASSERT_TRUE(policies.GetStats("/gyro/", &stats));
+  EXPECT_EQ(stats.coalesced, 2u);
+  EXPECT_EQ(stats.rate_limited, 0u);
+}
+
+TEST_F(PublishPolicyTest, DeleteDropsHeld) {
+  PublishPolicy policy;
+  policy.period = 0.01;
+  policy.latest_only = true;
+  policies.Set("/gyro/", policy);
+
+  conn.QueueOutgoing(Assign("/gyro/x", 0, 0));
+  ASSERT_EQ(conn.Post().size(), 1u);
+  conn.QueueOutgoing(Update(0, 1));
+  conn.QueueOutgoing(Message::EntryDelete(0));
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  auto out = conn.Post();
+  ASSERT_EQ(out.size(), 1u);
+  EXPECT_TRUE(out[0]->Is(Message::kEntryDelete));
+}
+
+TEST_F(PublishPolicyTest, LookupSynchronized) {
+  PublishPolicy policy;
+  policy.abs_deadband = 10;
+  policies.Set("/gyro/", policy);
+
+  // the assignment was sent in the handshake rather than queued; the first
+  // update always goes out, and the policy is found from the name storage
+  // gave the connection when synchronizing it
+  conn.SetEntryInfo(5, "/gyro/synchronized", 0);
+  conn.QueueOutgoing(Update(5, 1));
+  ASSERT_EQ(conn.Post().size(), 1u);
+  conn.QueueOutgoing(Update(5, 2));
+  EXPECT_TRUE(conn.Post().empty());
+}
+
+TEST_F(PublishPolicyTest, LookupReceivedAssign) {
+  PublishPolicy policy;
+  policy.abs_deadband = 10;
+  policies.Set("/gyro/", policy);
+
+  // a client learns ids from the assignments the server sends
+  conn.Receive(Assign("/gyro/y", 6, 0));
+  conn.QueueOutgoing(Update(6, 1));
+  ASSERT_EQ(conn.Post().size(), 1u);
+  conn.QueueOutgoing(Update(6, 2));
+  EXPECT_TRUE(conn.Post().empty());
+
+  // and forgets them when they are deleted
+  conn.Receive(Message::EntryDelete(6));
+  conn.QueueOutgoing(Update(6, 3));
+  conn.QueueOutgoing(Update(6, 4));
+  EXPECT_EQ(conn.Post().size(), 1u);
+}
+
+TEST_F(PublishPolicyTest, LongestPrefix) {
+  PublishPolicy drop_all;
+  drop_all.period = 3600;
+  policies.Set("/", drop_all);
+  policies.Set("/gyro/", PublishPolicy{});
+
+  conn.QueueOutgoing(Assign("/gyro/x", 0, 0));
+  conn.QueueOutgoing(Assign("/other", 1, 0));
+  ASSERT_EQ(conn.Post().size(), 2u);
+  conn.QueueOutgoing(Update(0, 1));
+  conn.QueueOutgoing(Update(1, 1));
+  auto out = conn.Post();
+  ASSERT_EQ(out.size(), 1u);
+  EXPECT_EQ(out[0]->id(), 0u);
+
+  // replacing a policy applies to entries already seen
+  policies.Set("/", PublishPolicy{});
+  conn.QueueOutgoing(Update(1, 2));
+  EXPECT_EQ(conn.Post().size(), 1u);
+}
+
+}  // namespace nt
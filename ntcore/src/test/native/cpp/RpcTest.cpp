@@ -0,0 +1,175 @@
+// Copyright (c) FIRST and other WPILib contributors.
+// Open Source Software; you can modify and/or share it under the terms of
+// the WPILib BSD license file in the root directory of this project.
+
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "TestPrinters.h"
+#include "gtest/gtest.h"
+#include "ntcore_cpp.h"
+
+namespace {
+constexpr unsigned int kPort = 10015;
+}  // namespace
+
+class RpcTest : public ::testing::Test {
+ public:
+  RpcTest()
+      : server_inst(nt::CreateInstance()), client_inst(nt::CreateInstance()) {
+    nt::SetNetworkIdentity(server_inst, "server");
+    nt::SetNetworkIdentity(client_inst, "client");
+    // calls must not wait for the periodic update
+    nt::SetUpdateRate(server_inst, 1.0);
+    nt::SetUpdateRate(client_inst, 1.0);
+  }
+
+  ~RpcTest() override {
+    nt::DestroyInstance(client_inst);
+    nt::DestroyInstance(server_inst);
+  }
+
+  // Creates an RPC that echoes its parameters after a delay
+  void CreateEcho(std::chrono::milliseconds delay) {
+    nt::StartServer(server_inst, "", "127.0.0.1", kPort);
+    nt::CreateRpc(nt::GetEntry(server_inst, "/rpc"), "echo",
+                  [=](const nt::RpcAnswer& answer) {
+                    std::this_thread::sleep_for(delay);
+                    answer.PostResponse(answer.params);
+                  });
+  }
+
+  NT_Entry ConnectClient() {
+    nt::StartClient(client_inst, "127.0.0.1", kPort);
+    auto entry = nt::GetEntry(client_inst, "/rpc");
+    for (int i = 0; i < 300; ++i) {
+      auto v = nt::GetEntryValue(entry);
+      if (v && v->IsRpc()) {
+        break;
+      }
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    return entry;
+  }
+
+ protected:
+  NT_Inst server_inst;
+  NT_Inst client_inst;
+};
+
+TEST_F(RpcTest, AsyncPipelined) {
+  CreateEcho(std::chrono::milliseconds(0));
+  auto entry = ConnectClient();
+  ASSERT_EQ(nt::GetEntryType(entry), NT_RPC);
+
+  std::vector<wpi::future<std::string>> results;
+  for (int i = 0; i < 50; ++i) {
+    results.emplace_back(nt::CallRpcAsync(entry, "call" + std::to_string(i)));
+  }
+  // far sooner than the 1 second update rate
+  for (int i = 0; i < 50; ++i) {
+    ASSERT_TRUE(results[i].wait_for(std::chrono::milliseconds(500)));
+    EXPECT_EQ(results[i].get(), "call" + std::to_string(i));
+  }
+}
+
+TEST_F(RpcTest, SyncResultImmediate) {
+  CreateEcho(std::chrono::milliseconds(0));
+  auto entry = ConnectClient();
+
+  auto call = nt::CallRpc(entry, "hello");
+  ASSERT_NE(call, 0u);
+  std::string result;
+  bool timed_out = false;
+  EXPECT_TRUE(nt::GetRpcResult(entry, call, &result, 0.5, &timed_out));
+  EXPECT_EQ(result, "hello");
+}
+
+TEST_F(RpcTest, WorkerThreads) {
+  nt::SetRpcWorkerThreads(server_inst, 4);
+  CreateEcho(std::chrono::milliseconds(100));
+  auto entry = ConnectClient();
+
+  auto start = std::chrono::steady_clock::now();
+  std::vector<wpi::future<std::string>> results;
+  for (int i = 0; i < 8; ++i) {
+    results.emplace_back(nt::CallRpcAsync(entry, std::to_string(i)));
+  }
+  for (int i = 0; i < 8; ++i) {
+    EXPECT_EQ(results[i].get(), std::to_string(i));
+  }
+  // one at a time would take 800 ms
+  EXPECT_LT(std::chrono::steady_clock::now() - start,
+            std::chrono::milliseconds(600));
+}
+
+TEST_F(RpcTest, PeriodicUpdatesDuringCalls) {
+  CreateEcho(std::chrono::milliseconds(0));
+  auto entry = ConnectClient();
+  nt::SetUpdateRate(server_inst, 0.05);
+
+  // every call and response flushes, continuously
+  std::atomic_bool done{false};
+  std::thread caller([&] {
+    while (!done) {
+      nt::CallRpcAsync(entry, "x").wait_for(std::chrono::milliseconds(100));
+    }
+  });
+
+  auto server_value = nt::GetEntry(server_inst, "/value");
+  auto client_value = nt::GetEntry(client_inst, "/value");
+  int received = 0;
+  for (int i = 1; i <= 20; ++i) {
+    nt::SetEntryValue(server_value, nt::Value::MakeDouble(i));
+    for (int j = 0; j < 30; ++j) {
+      auto v = nt::GetEntryValue(client_value);
+      if (v && v->IsDouble() && v->GetDouble() == i) {
+        ++received;
+        break;
+      }
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+  }
+  done = true;
+  caller.join();
+  // each value goes out well before the next is set
+  EXPECT_EQ(received, 20);
+}
+
+TEST_F(RpcTest, Disconnect) {
+  CreateEcho(std::chrono::milliseconds(2000));
+  auto entry = ConnectClient();
+
+  // a call the server never gets to answer gets an empty result
+  auto start = std::chrono::steady_clock::now();
+  auto result = nt::CallRpcAsync(entry, "lost");
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  nt::StopServer(server_inst);
+  bool ready = result.wait_for(std::chrono::milliseconds(1000));
+  EXPECT_TRUE(ready);
+  if (ready) {
+    EXPECT_EQ(result.get(), "");
+  }
+
+  // destroying the server instance waits for the callback, which can't
+  // post its response while the instance is being destroyed
+  std::this_thread::sleep_until(start + std::chrono::milliseconds(2500));
+}
+
+TEST_F(RpcTest, LocalCall) {
+  CreateEcho(std::chrono::milliseconds(0));
+  auto result = nt::CallRpcAsync(nt::GetEntry(server_inst, "/rpc"), "local");
+  ASSERT_TRUE(result.wait_for(std::chrono::seconds(1)));
+  EXPECT_EQ(result.get(), "local");
+}
+
+TEST_F(RpcTest, NotRpc) {
+  auto entry = nt::GetEntry(server_inst, "/value");
+  nt::SetEntryValue(entry, nt::Value::MakeDouble(1));
+  auto result = nt::CallRpcAsync(entry, "x");
+  EXPECT_TRUE(result.is_ready());
+  EXPECT_EQ(result.get(), "");
+}
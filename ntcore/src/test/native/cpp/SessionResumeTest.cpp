@@ -0,0 +1,200 @@
+// Copyright (c) FIRST and other WPILib contributors.
+// Open Source Software; you can modify and/or share it under the terms of
+// the WPILib BSD license file in the root directory of this project.
+
+#include <chrono>
+#include <string>
+#include <thread>
+
+#include "TestPrinters.h"
+#include "gtest/gtest.h"
+#include "ntcore_cpp.h"
+
+namespace {
+constexpr int kNumEntries = 500;
+constexpr unsigned int kPort = 10013;
+}  // namespace
+
+// Parameter selects the event loop server
+class SessionResumeTest : public ::testing::TestWithParam<bool> {
+ public:
+  SessionResumeTest()
+      : server_inst(nt::CreateInstance()), client_inst(nt::CreateInstance()) {
+    nt::SetNetworkIdentity(server_inst, "server");
+    nt::SetNetworkIdentity(client_inst, "client");
+    nt::SetServerEventLoop(server_inst, GetParam());
+    nt::SetUpdateRate(server_inst, 0.01);
+    nt::SetUpdateRate(client_inst, 0.01);
+    for (int i = 0; i < kNumEntries; ++i) {
+      nt::SetEntryValue(nt::GetEntry(server_inst, Name(i)),
+                        nt::Value::MakeDouble(i));
+    }
+  }
+
+  ~SessionResumeTest() override {
+    nt::DestroyInstance(server_inst);
+    nt::DestroyInstance(client_inst);
+  }
+
+  static std::string Name(int i) {
+    return "/Robot/Subsystem" + std::to_string(i / 10) + "/Value" +
+           std::to_string(i % 10);
+  }
+
+  void StartServer() { nt::StartServer(server_inst, "", "127.0.0.1", kPort); }
+  void StartClient() { nt::StartClient(client_inst, "127.0.0.1", kPort); }
+  bool WaitForConnection();
+  bool WaitForDouble(NT_Inst inst, const std::string& name, double value);
+  bool WaitForDelete(NT_Inst inst, const std::string& name);
+  uint64_t BytesReceived();
+
+  // Disconnects the client and changes the server while it is away
+  void ChangeWhileDisconnected();
+  void CheckChanges();
+
+ protected:
+  NT_Inst server_inst;
+  NT_Inst client_inst;
+};
+
+bool SessionResumeTest::WaitForConnection() {
+  // both sides see the connection and the client has every entry
+  for (int i = 0; i < 300; ++i) {
+    if (!nt::GetConnections(server_inst).empty() &&
+        nt::IsConnected(client_inst) &&
+        nt::GetEntries(client_inst, "/Robot/", 0).size() >= kNumEntries) {
+      return true;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  return false;
+}
+
+bool SessionResumeTest::WaitForDouble(NT_Inst inst, const std::string& name,
+                                      double value) {
+  auto entry = nt::GetEntry(inst, name);
+  for (int i = 0; i < 200; ++i) {
+    auto v = nt::GetEntryValue(entry);
+    if (v && v->IsDouble() && v->GetDouble() == value) {
+      return true;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  return false;
+}
+
+bool SessionResumeTest::WaitForDelete(NT_Inst inst, const std::string& name) {
+  auto entry = nt::GetEntry(inst, name);
+  for (int i = 0; i < 200; ++i) {
+    if (!nt::GetEntryValue(entry)) {
+      return true;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  return false;
+}
+
+uint64_t SessionResumeTest::BytesReceived() {
+  auto metrics = nt::GetConnectionMetrics(client_inst);
+  return metrics.empty() ? 0 : metrics[0].bytes_received;
+}
+
+void SessionResumeTest::ChangeWhileDisconnected() {
+  nt::StopClient(client_inst);
+  for (int i = 0; i < 200 && !nt::GetConnections(server_inst).empty(); ++i) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  ASSERT_TRUE(nt::GetConnections(server_inst).empty());
+
+  nt::SetEntryValue(nt::GetEntry(server_inst, Name(1)),
+                    nt::Value::MakeDouble(-1));
+  nt::SetEntryValue(nt::GetEntry(server_inst, Name(2)),
+                    nt::Value::MakeDouble(-2));
+  nt::DeleteEntry(nt::GetEntry(server_inst, Name(3)));
+  nt::SetEntryValue(nt::GetEntry(server_inst, "/Robot/New"),
+                    nt::Value::MakeDouble(42));
+  nt::SetEntryValue(nt::GetEntry(client_inst, Name(4)),
+                    nt::Value::MakeDouble(-4));
+}
+
+void SessionResumeTest::CheckChanges() {
+  EXPECT_TRUE(WaitForDouble(client_inst, Name(1), -1));
+  EXPECT_TRUE(WaitForDouble(client_inst, Name(2), -2));
+  EXPECT_TRUE(WaitForDelete(client_inst, Name(3)));
+  EXPECT_TRUE(WaitForDouble(client_inst, "/Robot/New", 42));
+  EXPECT_TRUE(WaitForDouble(server_inst, Name(4), -4));
+  EXPECT_TRUE(WaitForDouble(client_inst, Name(5), 5));
+}
+
+TEST_P(SessionResumeTest, Resume) {
+  nt::SetNetworkSessionResume(client_inst, true);
+  StartServer();
+  StartClient();
+  ASSERT_TRUE(WaitForConnection());
+  uint64_t full = BytesReceived();
+
+  ChangeWhileDisconnected();
+  StartClient();
+  ASSERT_TRUE(WaitForConnection());
+  CheckChanges();
+
+  // only the changed entries are sent again
+  EXPECT_LT(BytesReceived(), full / 10);
+}
+
+TEST_P(SessionResumeTest, CollidingWrites) {
+  nt::SetNetworkSessionResume(client_inst, true);
+  StartServer();
+  StartClient();
+  ASSERT_TRUE(WaitForConnection());
+
+  // both sides write the same entry once while disconnected, so their
+  // sequence numbers match but their values don't
+  nt::StopClient(client_inst);
+  for (int i = 0; i < 200 && !nt::GetConnections(server_inst).empty(); ++i) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  ASSERT_TRUE(nt::GetConnections(server_inst).empty());
+  nt::SetEntryValue(nt::GetEntry(server_inst, Name(6)),
+                    nt::Value::MakeDouble(60));
+  nt::SetEntryValue(nt::GetEntry(client_inst, Name(6)),
+                    nt::Value::MakeDouble(-60));
+
+  StartClient();
+  ASSERT_TRUE(WaitForConnection());
+
+  // the client's write wins, as on a full resync
+  EXPECT_TRUE(WaitForDouble(server_inst, Name(6), -60));
+  EXPECT_TRUE(WaitForDouble(client_inst, Name(6), -60));
+}
+
+TEST_P(SessionResumeTest, ServerRestart) {
+  nt::SetNetworkSessionResume(client_inst, true);
+  StartServer();
+  StartClient();
+  ASSERT_TRUE(WaitForConnection());
+
+  // a restarted server has a new token, so the client gets a full resync
+  nt::StopServer(server_inst);
+  ChangeWhileDisconnected();
+  StartServer();
+  StartClient();
+  ASSERT_TRUE(WaitForConnection());
+  CheckChanges();
+}
+
+TEST_P(SessionResumeTest, Disabled) {
+  StartServer();
+  StartClient();
+  ASSERT_TRUE(WaitForConnection());
+  uint64_t full = BytesReceived();
+
+  ChangeWhileDisconnected();
+  StartClient();
+  ASSERT_TRUE(WaitForConnection());
+  CheckChanges();
+  EXPECT_GT(BytesReceived(), full / 2);
+}
+
+INSTANTIATE_TEST_SUITE_P(SessionResumeTests, SessionResumeTest,
+                         ::testing::Bool());
@@ -4,6 +4,15 @@
 
 #include "StorageTest.h"
 
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <thread>
+#include <vector>
+
 #include <wpi/raw_istream.h>
 #include <wpi/raw_ostream.h>
 
@@ -298,6 +307,59 @@ TEST_P(StorageTestPopulated, SetEntryValueDifferentValue) {
   }
 }
 
+TEST_P(StorageTestPopulated, SetEntryValues) {
+  auto value1 = Value::MakeDouble(5.0);
+  auto value2 = Value::MakeDouble(6.0);
+
+  // client shouldn't send updates as ids not assigned yet
+  if (GetParam()) {
+    ::testing::InSequence seq;
+    EXPECT_CALL(dispatcher,
+                QueueOutgoing(MessageEq(Message::EntryUpdate(1, 2, value1)),
+                              IsNull(), IsNull()));
+    EXPECT_CALL(dispatcher,
+                QueueOutgoing(MessageEq(Message::EntryUpdate(2, 2, value2)),
+                              IsNull(), IsNull()));
+  }
+  EXPECT_CALL(notifier,
+              NotifyEntry(1, StringRef("foo2"), value1,
+                          NT_NOTIFY_UPDATE | NT_NOTIFY_LOCAL, UINT_MAX));
+  EXPECT_CALL(notifier,
+              NotifyEntry(2, StringRef("bar"), value2,
+                          NT_NOTIFY_UPDATE | NT_NOTIFY_LOCAL, UINT_MAX));
+
+  unsigned int ids[] = {storage.GetEntry("foo2"), storage.GetEntry("bar")};
+  std::vector<std::shared_ptr<Value>> values{value1, value2};
+  EXPECT_TRUE(storage.SetEntryValues(ids, values));
+  EXPECT_EQ(value1, GetEntry("foo2")->value);
+  EXPECT_EQ(value2, GetEntry("bar")->value);
+}
+
+TEST_P(StorageTestPopulated, SetEntryValuesTypeMismatch) {
+  // one mismatch means nothing is updated
+  unsigned int ids[] = {storage.GetEntry("foo2"), storage.GetEntry("foo")};
+  std::vector<std::shared_ptr<Value>> values{Value::MakeDouble(5.0),
+                                             Value::MakeDouble(6.0)};
+  EXPECT_FALSE(storage.SetEntryValues(ids, values));
+  EXPECT_EQ(*Value::MakeDouble(0.0), *GetEntry("foo2")->value);
+  EXPECT_EQ(*Value::MakeBoolean(true), *GetEntry("foo")->value);
+
+  // mismatched lengths
+  values.pop_back();
+  EXPECT_FALSE(storage.SetEntryValues(ids, values));
+  EXPECT_EQ(*Value::MakeDouble(0.0), *GetEntry("foo2")->value);
+}
+
+TEST_P(StorageTestEmpty, SetEntryValuesDuplicateTypeMismatch) {
+  // a new entry gets the type of its first value in the batch
+  unsigned int id = storage.GetEntry("foo");
+  unsigned int ids[] = {id, id};
+  std::vector<std::shared_ptr<Value>> values{Value::MakeDouble(5.0),
+                                             Value::MakeBoolean(true)};
+  EXPECT_FALSE(storage.SetEntryValues(ids, values));
+  EXPECT_FALSE(GetEntry("foo")->value);
+}
+
 TEST_P(StorageTestEmpty, SetEntryValueEmptyName) {
   auto value = Value::MakeBoolean(true);
   EXPECT_TRUE(storage.SetEntryValue("", value));
@@ -548,6 +610,43 @@ TEST_P(StorageTestPopulated, GetEntryInfoPrefixTypes) {
   EXPECT_EQ(NT_BOOLEAN, info[0].type);
 }
 
+TEST_P(StorageTestEmpty, GetEntryInfoPathPrefix) {
+  EXPECT_CALL(dispatcher, QueueOutgoing(_, _, _)).Times(AnyNumber());
+  EXPECT_CALL(notifier, NotifyEntry(_, _, _, _, _)).Times(AnyNumber());
+  EXPECT_CALL(notifier, local_notifiers()).Times(AnyNumber());
+  storage.SetEntryTypeValue("/a", Value::MakeDouble(0));
+  storage.SetEntryTypeValue("/a/b", Value::MakeDouble(1));
+  storage.SetEntryTypeValue("/a/b/c", Value::MakeDouble(2));
+  storage.SetEntryTypeValue("/a/bc", Value::MakeDouble(3));
+  storage.SetEntryTypeValue("/ab", Value::MakeDouble(4));
+  storage.SetEntryTypeValue("/x//y", Value::MakeDouble(5));
+  storage.SetEntryTypeValue("/a/d", Value::MakeBoolean(true));
+  storage.DeleteEntry("/a/d");
+
+  auto names = [&](const char* prefix) {
+    std::vector<std::string> rv;
+    for (auto&& info : storage.GetEntryInfo(0, prefix, 0u)) {
+      rv.push_back(info.name);
+    }
+    std::sort(rv.begin(), rv.end());
+    return rv;
+  };
+  using V = std::vector<std::string>;
+  EXPECT_EQ(V({"/a", "/a/b", "/a/b/c", "/a/bc", "/ab", "/x//y"}), names(""));
+  EXPECT_EQ(V({"/a", "/a/b", "/a/b/c", "/a/bc", "/ab"}), names("/a"));
+  EXPECT_EQ(V({"/a/b", "/a/b/c", "/a/bc"}), names("/a/"));
+  EXPECT_EQ(V({"/a/b", "/a/b/c", "/a/bc"}), names("/a/b"));
+  EXPECT_EQ(V({"/a/b/c"}), names("/a/b/"));
+  EXPECT_EQ(V({"/a/bc"}), names("/a/bc"));
+  EXPECT_EQ(V({"/x//y"}), names("/x//"));
+  EXPECT_EQ(V(), names("/a/b/c/"));
+  EXPECT_EQ(V(), names("/z"));
+  EXPECT_EQ(V(), names("a"));
+
+  EXPECT_EQ(3u, storage.GetEntries("/a/b", 0).size());
+  EXPECT_EQ(0u, storage.GetEntries("/a/b", NT_BOOLEAN).size());
+}
+
 TEST_P(StorageTestPersistent, SavePersistentEmpty) {
   wpi::SmallString<256> buf;
   wpi::raw_svector_ostream oss(buf);
@@ -864,6 +963,192 @@ TEST_P(StorageTestEmpty, LoadPersistentWarn) {
   EXPECT_TRUE(idmap().empty());
 }
 
+TEST_P(StorageTestPersistent, SavePersistentBinary) {
+  EXPECT_CALL(dispatcher, QueueOutgoing(_, _, _)).Times(AnyNumber());
+  EXPECT_CALL(notifier, NotifyEntry(_, _, _, _, _)).Times(AnyNumber());
+  // longer than the wire protocol allows for arrays
+  storage.SetEntryTypeValue(
+      "doublearr/long", Value::MakeDoubleArray(std::vector<double>(300, 1.5)));
+  for (auto& i : entries()) {
+    i.getValue()->flags = NT_PERSISTENT;
+  }
+  wpi::SmallString<256> buf;
+  wpi::raw_svector_ostream oss(buf);
+  storage.SavePersistentBinary(oss);
+  ASSERT_TRUE(oss.str().startswith(
+      StringRef(Storage::kBinaryHeader, sizeof(Storage::kBinaryHeader) - 1)));
+
+  StorageTest loaded;
+  loaded.HookOutgoing(GetParam());
+  EXPECT_CALL(loaded.dispatcher, QueueOutgoing(_, _, _)).Times(AnyNumber());
+  EXPECT_CALL(loaded.notifier, local_notifiers())
+      .WillRepeatedly(Return(false));
+  MockLoadWarn warn;
+  auto warn_func = [&](size_t line, const char* msg) { warn.Warn(line, msg); };
+  EXPECT_TRUE(loaded.storage.LoadEntriesBinary(oss.str(), "", true, warn_func));
+
+  ASSERT_EQ(entries().size(), loaded.entries().size());
+  for (auto& i : entries()) {
+    SCOPED_TRACE(i.getKey());
+    auto value = loaded.storage.GetEntryValue(i.getKey());
+    ASSERT_TRUE(value);
+    EXPECT_EQ(*i.getValue()->value, *value);
+    EXPECT_EQ(NT_PERSISTENT, loaded.storage.GetEntryFlags(i.getKey()));
+  }
+}
+
+TEST_P(StorageTestEmpty, LoadPersistentBinaryWarn) {
+  MockLoadWarn warn;
+  auto warn_func = [&](size_t line, const char* msg) { warn.Warn(line, msg); };
+
+  // header, one record setting "foo" to true, then a truncated record
+  std::string in(Storage::kBinaryHeader, sizeof(Storage::kBinaryHeader) - 1);
+  in += StringRef("\0\0\0\x07\x01\x03" "foo\0\x01", 11);
+  in += StringRef("\0\0\0\x20\x01", 5);
+
+  EXPECT_CALL(dispatcher, QueueOutgoing(_, _, _)).Times(1);
+  EXPECT_CALL(notifier,
+              NotifyEntry(_, _, _, NT_NOTIFY_NEW | NT_NOTIFY_LOCAL, UINT_MAX));
+  EXPECT_CALL(warn, Warn(2, StringRef("truncated record, ignoring rest of "
+                                      "file")));
+  EXPECT_TRUE(storage.LoadEntriesBinary(in, "", true, warn_func));
+
+  ASSERT_EQ(1u, entries().size());
+  EXPECT_EQ(*Value::MakeBoolean(true), *storage.GetEntryValue("foo"));
+}
+
+TEST_P(StorageTestEmpty, SavePersistentBinaryJournal) {
+  EXPECT_CALL(dispatcher, QueueOutgoing(_, _, _)).Times(AnyNumber());
+  EXPECT_CALL(notifier, NotifyEntry(_, _, _, _, _)).Times(AnyNumber());
+  std::string filename = ::testing::TempDir() + "ntcore_journal_" +
+                         (GetParam() ? "server" : "client") + ".bin";
+  auto file_size = [&] {
+    std::ifstream is(filename, std::ios::binary | std::ios::ate);
+    return static_cast<size_t>(is.tellg());
+  };
+
+  storage.SetEntryValue("a", Value::MakeDouble(1));
+  storage.SetEntryValue("b", Value::MakeDouble(2));
+  storage.SetEntryFlags("a", NT_PERSISTENT);
+  storage.SetEntryFlags("b", NT_PERSISTENT);
+  ASSERT_EQ(nullptr, storage.SavePersistent(filename, false));
+  size_t snapshot_size = file_size();
+
+  // periodic saves append only what changed
+  storage.SetEntryValue("a", Value::MakeDouble(3));
+  storage.DeleteEntry("b");
+  ASSERT_EQ(nullptr, storage.SavePersistent(filename, true));
+  size_t journal_size = file_size();
+  EXPECT_GT(journal_size, snapshot_size);
+
+  // nothing changed, so nothing is written
+  ASSERT_EQ(nullptr, storage.SavePersistent(filename, true));
+  EXPECT_EQ(journal_size, file_size());
+
+  StorageTest loaded;
+  loaded.HookOutgoing(GetParam());
+  EXPECT_CALL(loaded.dispatcher, QueueOutgoing(_, _, _)).Times(AnyNumber());
+  EXPECT_CALL(loaded.notifier, local_notifiers())
+      .WillRepeatedly(Return(false));
+  ASSERT_EQ(nullptr, loaded.storage.LoadPersistent(filename, nullptr));
+  EXPECT_EQ(*Value::MakeDouble(3), *loaded.storage.GetEntryValue("a"));
+  EXPECT_FALSE(loaded.storage.GetEntryValue("b"));
+
+  // the journal is eventually compacted into a snapshot
+  for (int i = 0; i < 100; ++i) {
+    storage.SetEntryValue("a", Value::MakeDouble(10 + i));
+    ASSERT_EQ(nullptr, storage.SavePersistent(filename, true));
+  }
+  EXPECT_LT(file_size(), journal_size + 64 * (journal_size - snapshot_size));
+  ASSERT_EQ(nullptr, loaded.storage.LoadPersistent(filename, nullptr));
+  EXPECT_EQ(*Value::MakeDouble(109), *loaded.storage.GetEntryValue("a"));
+
+  std::remove(filename.c_str());
+}
+
+TEST_P(StorageTestEmpty, SavePersistentBinaryJournalTruncated) {
+  EXPECT_CALL(dispatcher, QueueOutgoing(_, _, _)).Times(AnyNumber());
+  EXPECT_CALL(notifier, NotifyEntry(_, _, _, _, _)).Times(AnyNumber());
+  std::string filename = ::testing::TempDir() + "ntcore_truncated_" +
+                         (GetParam() ? "server" : "client") + ".bin";
+
+  storage.SetEntryValue("a", Value::MakeDouble(1));
+  storage.SetEntryValue("b", Value::MakeDouble(2));
+  storage.SetEntryFlags("a", NT_PERSISTENT);
+  storage.SetEntryFlags("b", NT_PERSISTENT);
+  ASSERT_EQ(nullptr, storage.SavePersistent(filename, false));
+  storage.SetEntryValue("a", Value::MakeDouble(3));
+  ASSERT_EQ(nullptr, storage.SavePersistent(filename, true));
+
+  // tear the appended record, as if the save was interrupted
+  std::string contents;
+  {
+    std::ifstream is(filename, std::ios::binary);
+    contents.assign(std::istreambuf_iterator<char>(is),
+                    std::istreambuf_iterator<char>());
+  }
+  ASSERT_GT(contents.size(), 4u);
+  {
+    std::ofstream os(filename, std::ios::binary | std::ios::trunc);
+    os.write(contents.data(), contents.size() - 4);
+  }
+
+  auto load = [&](StorageTest& loaded) {
+    loaded.HookOutgoing(GetParam());
+    EXPECT_CALL(loaded.dispatcher, QueueOutgoing(_, _, _))
+        .Times(AnyNumber());
+    EXPECT_CALL(loaded.notifier, NotifyEntry(_, _, _, _, _))
+        .Times(AnyNumber());
+    EXPECT_CALL(loaded.notifier, local_notifiers())
+        .WillRepeatedly(Return(false));
+    ASSERT_EQ(nullptr, loaded.storage.LoadPersistent(filename, nullptr));
+  };
+  StorageTest loaded;
+  load(loaded);
+  EXPECT_EQ(*Value::MakeDouble(1), *loaded.storage.GetEntryValue("a"));
+
+  // the next periodic save must not append after the torn record
+  loaded.storage.SetEntryValue("a", Value::MakeDouble(5));
+  loaded.storage.SetEntryValue("b", Value::MakeDouble(6));
+  ASSERT_EQ(nullptr, loaded.storage.SavePersistent(filename, true));
+  loaded.storage.SetEntryValue("a", Value::MakeDouble(7));
+  ASSERT_EQ(nullptr, loaded.storage.SavePersistent(filename, true));
+
+  StorageTest reloaded;
+  load(reloaded);
+  EXPECT_EQ(*Value::MakeDouble(7), *reloaded.storage.GetEntryValue("a"));
+  EXPECT_EQ(*Value::MakeDouble(6), *reloaded.storage.GetEntryValue("b"));
+
+  std::remove(filename.c_str());
+}
+
+TEST_P(StorageTestEmpty, CallRpcAsyncCanceled) {
+  EXPECT_CALL(dispatcher, QueueOutgoing(_, _, _)).Times(AnyNumber());
+  EXPECT_CALL(notifier, NotifyEntry(_, _, _, _, _)).Times(AnyNumber());
+  EXPECT_CALL(rpc_server, ProcessRpc(_, _, _, _, _, _, _)).Times(AnyNumber());
+  storage.SetEntryTypeValue("rpc", Value::MakeRpc("def"));
+  unsigned int local_id = storage.GetEntry("rpc");
+
+  // one more call than there are call uids (1 to 0xffff); the oldest one
+  // is given up on when its uid is needed again
+  std::vector<wpi::future<std::string>> results;
+  for (int i = 0; i <= 0xffff; ++i) {
+    results.emplace_back(storage.CallRpcAsync(local_id, "x"));
+  }
+  ASSERT_TRUE(results[0].is_ready());
+  EXPECT_EQ(results[0].get(), "");
+  for (size_t i = 1; i < results.size(); ++i) {
+    ASSERT_FALSE(results[i].is_ready()) << "call " << i;
+  }
+
+  // the rest when the connection closes
+  storage.CancelRpcCalls();
+  for (size_t i = 1; i < results.size(); ++i) {
+    ASSERT_TRUE(results[i].is_ready());
+    EXPECT_EQ(results[i].get(), "");
+  }
+}
+
 TEST_P(StorageTestEmpty, ProcessIncomingEntryAssign) {
   auto conn = std::make_shared<MockNetworkConnection>();
   auto value = Value::MakeDouble(1.0);
@@ -985,6 +1270,45 @@ TEST_P(StorageTestPopulateOne, DeletedGetEntries) {
   EXPECT_TRUE(storage.GetEntries("", 0).empty());
 }
 
+TEST_P(StorageTestEmpty, ConcurrentLocalIdReads) {
+  EXPECT_CALL(dispatcher, QueueOutgoing(_, _, _)).Times(AnyNumber());
+  EXPECT_CALL(notifier, NotifyEntry(_, _, _, _, _)).Times(AnyNumber());
+
+  // enough entries to span several local map chunks
+  const unsigned int kNumEntries = 3000;
+  std::atomic_bool done{false};
+  std::atomic<unsigned int> bad{0};
+  std::thread reader([&] {
+    while (!done) {
+      for (unsigned int id = 0; id < kNumEntries; ++id) {
+        auto value = storage.GetEntryValue(id);
+        if (!value) {
+          continue;
+        }
+        if (!value->IsDouble() || value->GetDouble() < id ||
+            storage.GetEntryType(id) != NT_DOUBLE) {
+          ++bad;
+        }
+      }
+    }
+  });
+
+  for (unsigned int i = 0; i < kNumEntries; ++i) {
+    unsigned int id = storage.GetEntry("foo" + wpi::Twine(i));
+    storage.SetEntryValue(id, Value::MakeDouble(id));
+    storage.SetEntryValue(id, Value::MakeDouble(id + 1));
+  }
+  done = true;
+  reader.join();
+
+  EXPECT_EQ(bad, 0u);
+  for (unsigned int id = 0; id < kNumEntries; ++id) {
+    auto value = storage.GetEntryValue(id);
+    ASSERT_TRUE(value && value->IsDouble());
+    EXPECT_EQ(value->GetDouble(), id + 1);
+  }
+}
+
 INSTANTIATE_TEST_SUITE_P(StorageTestsEmpty, StorageTestEmpty,
                          ::testing::Bool());
 INSTANTIATE_TEST_SUITE_P(StorageTestsPopulateOne, StorageTestPopulateOne,
@@ -292,6 +292,40 @@ TEST_F(ValueTest, StringComparison) {
   ASSERT_NE(*v1, *v2);
 }
 
+TEST_F(ValueTest, RawComparison) {
+  auto v1 = Value::MakeRaw(wpi::StringRef("a\0b", 3));
+  auto v2 = Value::MakeRaw(wpi::StringRef("a\0b", 3));
+  ASSERT_EQ(3u, v1->GetRaw().size());
+  ASSERT_EQ(*v1, *v2);
+  v2 = Value::MakeRaw(wpi::StringRef("a\0c", 3));  // differs after the nul
+  ASSERT_NE(*v1, *v2);
+  v2 = Value::MakeRpc(wpi::StringRef("a\0b", 3));  // different type
+  ASSERT_NE(*v1, *v2);
+}
+
+TEST_F(ValueTest, EmptyArrays) {
+  auto b = Value::MakeBooleanArray(std::vector<int>{});
+  auto d = Value::MakeDoubleArray(std::vector<double>{});
+  auto s = Value::MakeStringArray(std::vector<std::string>{});
+  ASSERT_TRUE(b->GetBooleanArray().empty());
+  ASSERT_TRUE(d->GetDoubleArray().empty());
+  ASSERT_TRUE(s->GetStringArray().empty());
+  ASSERT_EQ(*s, *Value::MakeStringArray(std::vector<std::string>{}));
+  ASSERT_NE(*s, *Value::MakeStringArray({"a"}));
+}
+
+TEST_F(ValueTest, StringArrayLongStrings) {
+  // strings too long to be stored inside std::string itself
+  std::string str(100, 'x');
+  std::vector<std::string> vec{str, str + "y", ""};
+  auto v1 = Value::MakeStringArray(vec);
+  auto v2 = Value::MakeStringArray(std::move(vec));
+  ASSERT_EQ(3u, v2->GetStringArray().size());
+  ASSERT_EQ(str + "y", v2->GetStringArray()[1]);
+  ASSERT_EQ(101u, v2->value().data.arr_string.arr[1].len);
+  ASSERT_EQ(*v1, *v2);
+}
+
 TEST_F(ValueTest, BooleanArrayComparison) {
   std::vector<int> vec{1, 0, 1};
   auto v1 = Value::MakeBooleanArray(vec);
@@ -643,4 +643,47 @@ TEST_F(WireDecoderTest, ReadString3) {
   ASSERT_EQ(nullptr, d.error());
 }
 
+TEST_F(WireDecoderTest, ReadArrayDelta) {
+  wpi::raw_mem_istream is("\x03\x01\x01\x3f\xe0\x00\x00\x00\x00\x00\x00"
+                          "\x02\x01\x00\x01",
+                          15);
+  wpi::Logger logger;
+  WireDecoder d(is, 0x0300u, logger);
+  d.set_array_deltas(true);
+  d.SetArrayBase(1, v_double_array);
+  d.SetArrayBase(2, v_boolean_array);
+
+  auto val = d.ReadArrayDelta(1, NT_DOUBLE_ARRAY);
+  ASSERT_TRUE(static_cast<bool>(val));
+  EXPECT_EQ(*Value::MakeDoubleArray(std::vector<double>{0.5, 0.5, 0.0}), *val);
+
+  val = d.ReadArrayDelta(2, NT_BOOLEAN_ARRAY);
+  ASSERT_TRUE(static_cast<bool>(val));
+  EXPECT_EQ(*Value::MakeBooleanArray(std::vector<int>{1, 1}), *val);
+  ASSERT_EQ(nullptr, d.error());
+}
+
+TEST_F(WireDecoderTest, ReadArrayDeltaError) {
+  wpi::raw_mem_istream is("\x02\x01\x05\x01", 4);
+  wpi::Logger logger;
+  WireDecoder d(is, 0x0300u, logger);
+  d.set_array_deltas(true);
+
+  // no base
+  ASSERT_FALSE(d.ReadArrayDelta(2, NT_BOOLEAN_ARRAY));
+  ASSERT_NE(nullptr, d.error());
+
+  // wrong base type
+  d.Reset();
+  d.SetArrayBase(2, v_double_array);
+  ASSERT_FALSE(d.ReadArrayDelta(2, NT_BOOLEAN_ARRAY));
+  ASSERT_NE(nullptr, d.error());
+
+  // index out of range
+  d.Reset();
+  d.SetArrayBase(2, v_boolean_array);
+  ASSERT_FALSE(d.ReadArrayDelta(2, NT_BOOLEAN_ARRAY));
+  ASSERT_NE(nullptr, d.error());
+}
+
 }  // namespace nt
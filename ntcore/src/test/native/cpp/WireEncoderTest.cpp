@@ -501,4 +501,49 @@ TEST_F(WireEncoderTest, WriteString3) {
   EXPECT_EQ('x', e.data()[65539]);
 }
 
+TEST_F(WireEncoderTest, ArrayBaseDisabled) {
+  WireEncoder e(0x0300u);
+  EXPECT_FALSE(e.SetArrayBase(1, v_double_array));
+  EXPECT_FALSE(e.SetArrayBase(1, v_double_array));
+}
+
+TEST_F(WireEncoderTest, SetArrayBase) {
+  WireEncoder e(0x0300u);
+  e.set_array_deltas(true);
+  EXPECT_FALSE(e.SetArrayBase(1, v_double_array));
+  EXPECT_EQ(v_double_array, e.SetArrayBase(1, v_boolean_array));
+  EXPECT_EQ(v_boolean_array, e.SetArrayBase(1, v_string));
+  EXPECT_FALSE(e.SetArrayBase(1, v_double_array));
+  EXPECT_FALSE(e.SetArrayBase(0xffff, v_double_array));
+  e.ClearArrayBases();
+  EXPECT_FALSE(e.SetArrayBase(1, v_double_array));
+}
+
+TEST_F(WireEncoderTest, WriteDoubleArrayDelta) {
+  WireEncoder e(0x0300u);
+  auto v = Value::MakeDoubleArray(std::vector<double>{0.5, 0.5, 0.0});
+  // second element changed, third element added with zero value
+  EXPECT_EQ(2u + 9u, e.GetArrayDeltaSize(*v_double_array, *v));
+  e.WriteArrayDelta(*v_double_array, *v);
+  EXPECT_EQ(nullptr, e.error());
+  EXPECT_EQ(wpi::StringRef("\x03\x01\x01\x3f\xe0\x00\x00\x00\x00\x00\x00",
+                           11),
+            wpi::StringRef(e.data(), e.size()));
+
+  // mismatched types can't be delta encoded
+  EXPECT_EQ(0u, e.GetArrayDeltaSize(*v_boolean_array, *v));
+  EXPECT_EQ(0u, e.GetArrayDeltaSize(*v_string, *v_string));
+}
+
+TEST_F(WireEncoderTest, WriteBooleanArrayDelta) {
+  WireEncoder e(0x0300u);
+  auto v = Value::MakeBooleanArray(std::vector<int>{1, 1});
+  // first element changed, third removed
+  EXPECT_EQ(2u + 2u, e.GetArrayDeltaSize(*v_boolean_array, *v));
+  e.WriteArrayDelta(*v_boolean_array, *v);
+  EXPECT_EQ(nullptr, e.error());
+  EXPECT_EQ(wpi::StringRef("\x02\x01\x00\x01", 4),
+            wpi::StringRef(e.data(), e.size()));
+}
+
 }  // namespace nt
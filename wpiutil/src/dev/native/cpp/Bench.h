@@ -0,0 +1,14 @@
+// Copyright (c) FIRST and other WPILib contributors.
+// Open Source Software; you can modify and/or share it under the terms of
+// the WPILib BSD license file in the root directory of this project.
+
+#ifndef WPIUTIL_DEV_BENCH_H_
+#define WPIUTIL_DEV_BENCH_H_
+
+// Benchmarks run by the dev executable; each takes the arguments following
+// the benchmark name and returns the process exit code.
+int DataLogBench(int argc, char* argv[]);
+int JsonBench(int argc, char* argv[]);
+int ThreadPoolBench(int argc, char* argv[]);
+
+#endif  // WPIUTIL_DEV_BENCH_H_
@@ -0,0 +1,239 @@
+// Copyright (c) FIRST and other WPILib contributors.
+// Open Source Software; you can modify and/or share it under the terms of
+// the WPILib BSD license file in the root directory of this project.
+
+// Benchmark for wpi::log::DataLog.
+//
+//   data-log [file=PATH] [seconds=S] [threads=N] [records=N]
+//
+// First appends doubles as fast as possible from N threads (default 1) for
+// S seconds (default 2), and reports the append rate, the rate actually
+// written, and drops.  Then runs a simulated 50 Hz robot loop that appends
+// N records per iteration (default 2000, i.e. 100k records/s) across a mix
+// of entry types, and reports the time spent appending in each iteration
+// and the loop's wakeup jitter, with and without logging.  Output goes to
+// PATH if given, or is counted and discarded.
+
+#include <stdint.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#include "Bench.h"
+#include "wpi/DataLog.h"
+#include "wpi/StringRef.h"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr auto kLoopPeriod = std::chrono::milliseconds(20);
+constexpr int kLoopEntries = 20;
+
+struct Options {
+  std::string file;
+  double seconds = 2;
+  int threads = 1;
+  int records = 2000;
+};
+
+bool ParseOption(wpi::StringRef arg, Options* opts) {
+  auto [key, value] = arg.split('=');
+  std::string str = value.str();
+  if (key == "file") {
+    opts->file = str;
+  } else if (key == "seconds") {
+    opts->seconds = std::atof(str.c_str());
+  } else if (key == "threads") {
+    opts->threads = (std::max)(1, std::atoi(str.c_str()));
+  } else if (key == "records") {
+    opts->records = (std::max)(1, std::atoi(str.c_str()));
+  } else {
+    return false;
+  }
+  return true;
+}
+
+// Creates the log under test, counting the bytes written
+std::unique_ptr<wpi::log::DataLog> MakeLog(const Options& opts,
+                                           std::atomic<uint64_t>* bytes) {
+  if (opts.file.empty()) {
+    return std::make_unique<wpi::log::DataLog>(
+        [bytes](wpi::ArrayRef<uint8_t> data) { *bytes += data.size(); });
+  }
+  std::error_code ec;
+  auto log = std::make_unique<wpi::log::DataLog>(opts.file, ec);
+  if (ec) {
+    std::fprintf(stderr, "could not open '%s': %s\n", opts.file.c_str(),
+                 ec.message().c_str());
+    return nullptr;
+  }
+  return log;
+}
+
+bool RunThroughput(const Options& opts) {
+  std::atomic<uint64_t> bytes{0};
+  auto log = MakeLog(opts, &bytes);
+  if (!log) {
+    return false;
+  }
+  std::atomic_bool done{false};
+  std::atomic<uint64_t> appended{0};
+  std::vector<std::thread> threads;
+  auto start = Clock::now();
+  for (int t = 0; t < opts.threads; ++t) {
+    threads.emplace_back([&, t] {
+      wpi::log::DoubleLogEntry entry{*log, "/bench/" + std::to_string(t)};
+      uint64_t count = 0;
+      while (!done.load(std::memory_order_relaxed)) {
+        for (int i = 0; i < 1000; ++i) {
+          entry.Append(count++);
+        }
+      }
+      appended += count;
+    });
+  }
+  std::this_thread::sleep_for(std::chrono::duration<double>(opts.seconds));
+  done = true;
+  for (auto&& thread : threads) {
+    thread.join();
+  }
+  log->Flush();
+  double elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+
+  uint64_t dropped = log->GetDropped();
+  std::printf("throughput (%d thread%s):\n", opts.threads,
+              opts.threads == 1 ? "" : "s");
+  std::printf("  appended %12.0f records/s\n", appended / elapsed);
+  std::printf("  written  %12.0f records/s\n",
+              (appended - dropped) / elapsed);
+  std::printf("  dropped  %12llu (%.2f%%)\n",
+              static_cast<unsigned long long>(dropped),  // NOLINT
+              appended == 0 ? 0.0 : 100.0 * dropped / appended);
+  if (opts.file.empty()) {
+    std::printf("  output   %12.1f MB/s\n", bytes / elapsed / 1e6);
+  }
+  return true;
+}
+
+struct LoopStats {
+  std::vector<double> appendUs;
+  std::vector<double> jitterUs;
+};
+
+double Percentile(std::vector<double> values, double p) {
+  if (values.empty()) {
+    return 0;
+  }
+  std::sort(values.begin(), values.end());
+  size_t i = static_cast<size_t>(p * (values.size() - 1));
+  return values[i];
+}
+
+// Runs a fixed-period loop; appends to log if it is not null
+LoopStats RunLoop(const Options& opts, wpi::log::DataLog* log) {
+  std::vector<std::unique_ptr<wpi::log::DoubleLogEntry>> doubles;
+  std::vector<std::unique_ptr<wpi::log::IntegerLogEntry>> integers;
+  std::vector<std::unique_ptr<wpi::log::DoubleArrayLogEntry>> arrays;
+  if (log) {
+    for (int i = 0; i < kLoopEntries; ++i) {
+      auto name = "/loop/" + std::to_string(i);
+      if (i % 4 == 3) {
+        arrays.emplace_back(
+            std::make_unique<wpi::log::DoubleArrayLogEntry>(*log, name));
+      } else if (i % 4 == 2) {
+        integers.emplace_back(
+            std::make_unique<wpi::log::IntegerLogEntry>(*log, name));
+      } else {
+        doubles.emplace_back(
+            std::make_unique<wpi::log::DoubleLogEntry>(*log, name));
+      }
+    }
+  }
+  double pose[3] = {1.0, 2.0, 0.5};
+
+  LoopStats stats;
+  int iterations = static_cast<int>(opts.seconds * 50);
+  auto next = Clock::now() + kLoopPeriod;
+  for (int iter = 0; iter < iterations; ++iter) {
+    std::this_thread::sleep_until(next);
+    auto wake = Clock::now();
+    stats.jitterUs.push_back(
+        std::chrono::duration<double, std::micro>(wake - next).count());
+    if (log) {
+      for (int i = 0; i < opts.records; ++i) {
+        switch (i % 4) {
+          case 3:
+            pose[0] = i;
+            arrays[(i / 4) % arrays.size()]->Append(pose);
+            break;
+          case 2:
+            integers[(i / 4) % integers.size()]->Append(i);
+            break;
+          default:
+            doubles[(i / 2) % doubles.size()]->Append(iter + i * 0.001);
+            break;
+        }
+      }
+    }
+    stats.appendUs.push_back(
+        std::chrono::duration<double, std::micro>(Clock::now() - wake)
+            .count());
+    next += kLoopPeriod;
+  }
+  return stats;
+}
+
+bool RunLoops(const Options& opts) {
+  std::printf("50 Hz loop, %d records/iteration (%d records/s):\n",
+              opts.records, opts.records * 50);
+  auto baseline = RunLoop(opts, nullptr);
+
+  std::atomic<uint64_t> bytes{0};
+  auto log = MakeLog(opts, &bytes);
+  if (!log) {
+    return false;
+  }
+  auto logged = RunLoop(opts, log.get());
+  log->Flush();
+
+  std::printf("  append time   p50 %8.1f us  p99 %8.1f us  max %8.1f us\n",
+              Percentile(logged.appendUs, 0.5),
+              Percentile(logged.appendUs, 0.99),
+              Percentile(logged.appendUs, 1.0));
+  std::printf("  jitter (none) p50 %8.1f us  p99 %8.1f us  max %8.1f us\n",
+              Percentile(baseline.jitterUs, 0.5),
+              Percentile(baseline.jitterUs, 0.99),
+              Percentile(baseline.jitterUs, 1.0));
+  std::printf("  jitter (log)  p50 %8.1f us  p99 %8.1f us  max %8.1f us\n",
+              Percentile(logged.jitterUs, 0.5),
+              Percentile(logged.jitterUs, 0.99),
+              Percentile(logged.jitterUs, 1.0));
+  std::printf("  dropped %llu\n",
+              static_cast<unsigned long long>(log->GetDropped()));  // NOLINT
+  return true;
+}
+
+}  // namespace
+
+int DataLogBench(int argc, char* argv[]) {
+  Options opts;
+  for (int i = 0; i < argc; ++i) {
+    if (!ParseOption(argv[i], &opts)) {
+      std::fprintf(stderr, "unknown option '%s'\n", argv[i]);
+      return 1;
+    }
+  }
+  if (!RunThroughput(opts) || !RunLoops(opts)) {
+    return 1;
+  }
+  return 0;
+}
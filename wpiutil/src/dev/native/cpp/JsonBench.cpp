@@ -0,0 +1,334 @@
+// Copyright (c) FIRST and other WPILib contributors.
+// Open Source Software; you can modify and/or share it under the terms of
+// the WPILib BSD license file in the root directory of this project.
+
+// Benchmark for parsing JSON into wpi::json and wpi::arena_json, and for
+// reading fields with json::sax_parse() and wpi::json_view.
+//
+//   json [seconds=S] [leds=N] [poses=N] [strings=N]
+//
+// Uses a representative set of halsim websocket messages (driver station,
+// joystick, PWM, encoder, an addressable LED buffer of N LEDs (default 60),
+// and a Field2d SimDevice with N trajectory poses (default 100)), running
+// each case for S seconds (default 1).  First reports the parse rate and
+// throughput for json::parse(), arena_json::parse() into a fresh arena, and
+// arena_json::parse() into one arena that is reset between messages.  Then
+// reports the rate of a typical WSProvider lookup, reading "type" and
+// finding one "data" field, with json::parse(), with a json_sax handler
+// that sees the whole message, with one that stops once it has both
+// fields, and with json_view.  Finally reports json::parse() and
+// json::dump() throughput on a large string-heavy document (N log messages,
+// default 2000) with each string scanning implementation the CPU supports.
+
+#include <stdint.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "Bench.h"
+#include "wpi/Arena.h"
+#include "wpi/SmallString.h"
+#include "wpi/StringRef.h"
+#include "wpi/arena_json.h"
+#include "wpi/json.h"
+#include "wpi/json_sax.h"
+#include "wpi/json_simd.h"
+#include "wpi/json_view.h"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct Options {
+  double seconds = 1;
+  int leds = 60;
+  int poses = 100;
+  int strings = 2000;
+};
+
+bool ParseOption(wpi::StringRef arg, Options* opts) {
+  auto [key, value] = arg.split('=');
+  std::string str = value.str();
+  if (key == "seconds") {
+    opts->seconds = std::atof(str.c_str());
+  } else if (key == "leds") {
+    opts->leds = (std::max)(0, std::atoi(str.c_str()));
+  } else if (key == "poses") {
+    opts->poses = (std::max)(0, std::atoi(str.c_str()));
+  } else if (key == "strings") {
+    opts->strings = (std::max)(0, std::atoi(str.c_str()));
+  } else {
+    return false;
+  }
+  return true;
+}
+
+struct Message {
+  const char* name;
+  // a member of "data" to look up
+  const char* field;
+  std::string text;
+};
+
+std::vector<Message> MakeMessages(const Options& opts) {
+  std::vector<Message> msgs;
+  msgs.push_back(
+      {"DriverStation", ">match_time",
+       R"({"type":"DriverStation","device":"","data":{">enabled":true,)"
+       R"(">autonomous":false,">test":false,">estop":false,)"
+       R"(">fms":false,">ds":true,">station":"red1",)"
+       R"(">match_time":-1.0,">new_data":true}})"});
+  msgs.push_back(
+      {"Joystick", ">buttons",
+       R"({"type":"Joystick","device":"0","data":{">axes":[0.0,-0.25,)"
+       R"(0.75,0.0,0.0,1.0],">povs":[-1],">buttons":[false,true,false,)"
+       R"(false,true,false,false,false,false,false,false,false],)"
+       R"("<outputs":0,"<rumble_left":0.0,"<rumble_right":0.0}})"});
+  msgs.push_back({"PWM", "<raw",
+                  R"({"type":"PWM","device":"3","data":{"<speed":-0.4375,)"
+                  R"("<position":0.28125,"<raw":1406}})"});
+  msgs.push_back(
+      {"Encoder", ">period",
+       R"({"type":"Encoder","device":"0","data":{">count":14285,)"
+       R"(">period":0.0021875}})"});
+
+  std::string led =
+      R"({"type":"AddressableLED","device":"0","data":{">data":[)";
+  for (int i = 0; i < opts.leds; ++i) {
+    if (i != 0) {
+      led += ',';
+    }
+    led += R"({"r":)" + std::to_string((i * 37) % 256) + R"(,"g":)" +
+           std::to_string((i * 91) % 256) + R"(,"b":)" +
+           std::to_string((i * 13) % 256) + '}';
+  }
+  led += "]}}";
+  msgs.push_back({"AddressableLED", ">data", std::move(led)});
+
+  std::string field =
+      R"({"type":"SimDevice","device":"Field","data":{".type":"Field2d",)"
+      R"("<>Robot":[3.2109375,4.015625,127.5],"<>Trajectory":[)";
+  for (int i = 0; i < opts.poses; ++i) {
+    if (i != 0) {
+      field += ',';
+    }
+    field += std::to_string(i * 0.0625) + ',' +
+             std::to_string(2.0 + i * 0.03125) + ',' +
+             std::to_string((i * 1.5) - 90.0);
+  }
+  field += "]}}";
+  msgs.push_back({"Field2d", "<>Trajectory", std::move(field)});
+  return msgs;
+}
+
+// Builds a document of log messages, mostly plain text with some escapes
+// and non-ASCII characters
+wpi::json MakeStringDoc(const Options& opts) {
+  wpi::json doc = wpi::json::array();
+  for (int i = 0; i < opts.strings; ++i) {
+    std::string msg = "[" + std::to_string(i) +
+                      "] Subsystem /drive/left reported a status update: "
+                      "motor controller firmware ok, bus voltage nominal, "
+                      "no faults latched since the last enable";
+    if (i % 10 == 0) {
+      msg += "\n\tat \"C:\\robot\\Drive.cpp\", line 123";
+    }
+    if (i % 25 == 0) {
+      msg += " \xc2\xb0" "C \xe2\x9c\x93";
+    }
+    doc.push_back({{"time", i * 0.02}, {"level", "info"}, {"msg", msg}});
+  }
+  return doc;
+}
+
+const char* SimdName(wpi::detail::json_simd simd) {
+  switch (simd) {
+    case wpi::detail::json_simd::sse2:
+      return "sse2";
+    case wpi::detail::json_simd::avx2:
+      return "avx2";
+    case wpi::detail::json_simd::neon:
+      return "neon";
+    default:
+      return "scalar";
+  }
+}
+
+// Reads "type" and finds a member of "data"; stops early if told to
+class LookupSax : public wpi::json_sax {
+ public:
+  LookupSax(wpi::StringRef field, bool stop) : m_field{field}, m_stop{stop} {}
+
+  bool null() override { return Value(); }
+  bool boolean(bool) override { return Value(); }
+  bool number_integer(int64_t) override { return Value(); }
+  bool number_unsigned(uint64_t) override { return Value(); }
+  bool number_float(double) override { return Value(); }
+  bool string(wpi::StringRef val) override {
+    if (m_depth == 1 && m_key == kType) {
+      type = val;
+    }
+    return Value();
+  }
+  bool start_object() override { return Start(); }
+  bool end_object() override {
+    --m_depth;
+    return true;
+  }
+  bool start_array() override { return Start(); }
+  bool end_array() override {
+    --m_depth;
+    return true;
+  }
+  bool key(wpi::StringRef val) override {
+    if (m_depth == 1) {
+      m_key = val == "type" ? kType : val == "data" ? kData : kOther;
+    } else if (m_depth == 2 && m_key == kData && val == m_field) {
+      found = true;
+    }
+    return true;
+  }
+
+  std::string type;
+  bool found = false;
+
+ private:
+  enum Key { kOther, kType, kData };
+
+  bool Value() { return !m_stop || type.empty() || !found; }
+  bool Start() {
+    ++m_depth;
+    return Value();
+  }
+
+  wpi::StringRef m_field;
+  bool m_stop;
+  int m_depth = 0;
+  Key m_key = kOther;
+};
+
+// Calls parse() repeatedly, batch times between clock checks, for about the
+// given time; returns the rate
+template <typename F>
+double Run(double seconds, F&& parse, int batch = 100) {
+  uint64_t count = 0;
+  auto start = Clock::now();
+  auto end = start + std::chrono::duration<double>(seconds);
+  auto now = start;
+  while (now < end) {
+    for (int i = 0; i < batch; ++i) {
+      parse();
+    }
+    count += batch;
+    now = Clock::now();
+  }
+  return count / std::chrono::duration<double>(now - start).count();
+}
+
+}  // namespace
+
+int JsonBench(int argc, char* argv[]) {
+  Options opts;
+  for (int i = 0; i < argc; ++i) {
+    if (!ParseOption(argv[i], &opts)) {
+      std::fprintf(stderr, "unknown option '%s'\n", argv[i]);
+      return 1;
+    }
+  }
+
+  std::printf("%-16s %7s %24s %24s %24s\n", "message", "bytes",
+              "json (msg/s MB/s)", "fresh arena (msg/s MB/s)",
+              "reused arena (msg/s MB/s)");
+  for (auto&& msg : MakeMessages(opts)) {
+    wpi::StringRef text = msg.text;
+    size_t sink = 0;
+
+    double jsonRate = Run(opts.seconds, [&] {
+      sink += wpi::json::parse(text).size();
+    });
+    double freshRate = Run(opts.seconds, [&] {
+      wpi::Arena arena;
+      sink += wpi::arena_json::parse(text, arena).size();
+    });
+    wpi::Arena arena;
+    double reusedRate = Run(opts.seconds, [&] {
+      arena.Reset();
+      sink += wpi::arena_json::parse(text, arena).size();
+    });
+
+    double mb = text.size() / 1e6;
+    std::printf("%-16s %7zu %12.0f %11.1f %12.0f %11.1f %12.0f %11.1f\n",
+                msg.name, text.size(), jsonRate, jsonRate * mb, freshRate,
+                freshRate * mb, reusedRate, reusedRate * mb);
+    if (sink == 0) {
+      std::printf("(nothing parsed)\n");
+    }
+  }
+
+  std::printf("\n%-16s %12s %12s %12s %12s (lookups/s)\n", "message", "json",
+              "sax", "sax (stop)", "view");
+  for (auto&& msg : MakeMessages(opts)) {
+    wpi::StringRef text = msg.text;
+    wpi::StringRef field = msg.field;
+    size_t sink = 0;
+
+    double jsonRate = Run(opts.seconds, [&] {
+      auto j = wpi::json::parse(text);
+      auto& data = j.at("data");
+      sink += j.at("type").get_ref<const std::string&>().size() +
+              (data.find(field) != data.end());
+    });
+    double saxRate = Run(opts.seconds, [&] {
+      LookupSax sax{field, false};
+      wpi::json::sax_parse(text, &sax);
+      sink += sax.type.size() + sax.found;
+    });
+    double saxStopRate = Run(opts.seconds, [&] {
+      LookupSax sax{field, true};
+      wpi::json::sax_parse(text, &sax);
+      sink += sax.type.size() + sax.found;
+    });
+    double viewRate = Run(opts.seconds, [&] {
+      wpi::json_view j{text};
+      wpi::SmallString<32> buf;
+      sink += j["type"].get_string(buf).size() +
+              !j["data"][field].is_discarded();
+    });
+
+    std::printf("%-16s %12.0f %12.0f %12.0f %12.0f\n", msg.name, jsonRate,
+                saxRate, saxStopRate, viewRate);
+    if (sink == 0) {
+      std::printf("(nothing found)\n");
+    }
+  }
+
+  auto doc = MakeStringDoc(opts);
+  std::string text = doc.dump();
+  double mb = text.size() / 1e6;
+  std::printf("\nstring-heavy document, %.1f MB:\n", mb);
+  std::printf("%-8s %12s %12s (MB/s)\n", "scan", "parse", "dump");
+  for (auto simd : {wpi::detail::json_simd::scalar,
+                    wpi::detail::json_simd::sse2,
+                    wpi::detail::json_simd::avx2,
+                    wpi::detail::json_simd::neon}) {
+    if (!wpi::detail::json_set_simd(simd)) {
+      continue;
+    }
+    size_t sink = 0;
+    double parseRate = Run(
+        opts.seconds, [&] { sink += wpi::json::parse(text).size(); }, 1);
+    double dumpRate =
+        Run(opts.seconds, [&] { sink += doc.dump().size(); }, 1);
+    std::printf("%-8s %12.1f %12.1f\n", SimdName(simd), parseRate * mb,
+                dumpRate * mb);
+    if (sink == 0) {
+      std::printf("(nothing parsed)\n");
+    }
+  }
+  wpi::detail::json_set_simd(wpi::detail::json_best_simd());
+  return 0;
+}
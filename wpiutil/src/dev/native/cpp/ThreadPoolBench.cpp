@@ -0,0 +1,243 @@
+// Copyright (c) FIRST and other WPILib contributors.
+// Open Source Software; you can modify and/or share it under the terms of
+// the WPILib BSD license file in the root directory of this project.
+
+// Benchmark for wpi::MpmcQueue and wpi::ThreadPool.
+//
+//   thread-pool [threads=N] [items=N] [tasks=N] [fib=N]
+//
+// First passes N items per producer (default 1000000) through an MpmcQueue
+// and a ConcurrentQueue with 1, 2, 4, ... producers and as many consumers,
+// up to N of each (default one per hardware thread), and reports the rate
+// items get through each.  Then runs N tiny tasks (default 1000000), posted
+// from one thread, on a ThreadPool of N threads and on N threads popping
+// tasks from a ConcurrentQueue, and reports the task rates.  Finally
+// computes Fibonacci number N (default 30) by recursively submitting
+// subproblems to the ThreadPool, which relies on work stealing to spread
+// them out, and reports the time and speedup over doing it serially.
+
+#include <stdint.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Bench.h"
+#include "wpi/ConcurrentQueue.h"
+#include "wpi/MpmcQueue.h"
+#include "wpi/StringRef.h"
+#include "wpi/ThreadPool.h"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// Below this, Fibonacci subproblems are computed serially
+constexpr int kFibGrain = 16;
+
+struct Options {
+  int threads = (std::max)(1u, std::thread::hardware_concurrency());
+  int items = 1000000;
+  int tasks = 1000000;
+  int fib = 30;
+};
+
+bool ParseOption(wpi::StringRef arg, Options* opts) {
+  auto [key, value] = arg.split('=');
+  std::string str = value.str();
+  if (key == "threads") {
+    opts->threads = (std::max)(1, std::atoi(str.c_str()));
+  } else if (key == "items") {
+    opts->items = (std::max)(1, std::atoi(str.c_str()));
+  } else if (key == "tasks") {
+    opts->tasks = (std::max)(1, std::atoi(str.c_str()));
+  } else if (key == "fib") {
+    opts->fib = (std::max)(0, std::atoi(str.c_str()));
+  } else {
+    return false;
+  }
+  return true;
+}
+
+double Seconds(Clock::time_point start) {
+  return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+// Runs n producers that each push items values (1 to items) with push(), and
+// n consumers that pop with pop() until they get a 0; returns the rate
+template <typename Push, typename Pop>
+double RunQueue(int n, int items, Push&& push, Pop&& pop) {
+  std::atomic<uint64_t> sum{0};
+  std::vector<std::thread> producers;
+  std::vector<std::thread> consumers;
+  auto start = Clock::now();
+  for (int i = 0; i < n; ++i) {
+    consumers.emplace_back([&] {
+      uint64_t local = 0;
+      while (uint64_t value = pop()) {
+        local += value;
+      }
+      sum += local;
+    });
+  }
+  for (int i = 0; i < n; ++i) {
+    producers.emplace_back([&] {
+      for (int j = 1; j <= items; ++j) {
+        push(j);
+      }
+    });
+  }
+  for (auto&& producer : producers) {
+    producer.join();
+  }
+  for (int i = 0; i < n; ++i) {
+    push(0);
+  }
+  for (auto&& consumer : consumers) {
+    consumer.join();
+  }
+  double elapsed = Seconds(start);
+  if (sum != static_cast<uint64_t>(n) * items * (items + 1) / 2) {
+    std::printf("(items lost)\n");
+  }
+  return static_cast<double>(n) * items / elapsed;
+}
+
+void RunQueues(const Options& opts) {
+  std::printf("%-22s %16s %16s (Mitems/s)\n", "producers/consumers",
+              "MpmcQueue", "ConcurrentQueue");
+  for (int n = 1;; n = (std::min)(n * 2, opts.threads)) {
+    wpi::MpmcQueue<uint64_t> mpmc{1024};
+    double mpmcRate = RunQueue(
+        n, opts.items,
+        [&](uint64_t value) {
+          while (!mpmc.try_push(value)) {
+            std::this_thread::yield();
+          }
+        },
+        [&] {
+          uint64_t value;
+          while (!mpmc.try_pop(value)) {
+            std::this_thread::yield();
+          }
+          return value;
+        });
+
+    wpi::ConcurrentQueue<uint64_t> concurrent;
+    double concurrentRate = RunQueue(
+        n, opts.items, [&](uint64_t value) { concurrent.push(value); },
+        [&] { return concurrent.pop(); });
+
+    std::printf("%-22d %16.2f %16.2f\n", n, mpmcRate / 1e6,
+                concurrentRate / 1e6);
+    if (n == opts.threads) {
+      break;
+    }
+  }
+}
+
+// The simplest pool: threads running tasks popped from a ConcurrentQueue
+class QueuePool {
+ public:
+  explicit QueuePool(int numThreads) {
+    for (int i = 0; i < numThreads; ++i) {
+      m_threads.emplace_back([this] {
+        while (auto task = m_tasks.pop()) {
+          task();
+        }
+      });
+    }
+  }
+  ~QueuePool() {
+    for (size_t i = 0; i < m_threads.size(); ++i) {
+      m_tasks.push(nullptr);
+    }
+    for (auto&& thread : m_threads) {
+      thread.join();
+    }
+  }
+
+  void Post(std::function<void()> task) { m_tasks.push(std::move(task)); }
+
+ private:
+  wpi::ConcurrentQueue<std::function<void()>> m_tasks;
+  std::vector<std::thread> m_threads;
+};
+
+// Posts tasks tiny tasks and waits for them to finish; returns the rate
+template <typename Pool>
+double RunTasks(Pool& pool, int tasks) {
+  std::atomic_int done{0};
+  auto start = Clock::now();
+  for (int i = 0; i < tasks; ++i) {
+    pool.Post([&] { done.fetch_add(1, std::memory_order_relaxed); });
+  }
+  while (done.load(std::memory_order_relaxed) != tasks) {
+    std::this_thread::yield();
+  }
+  return tasks / Seconds(start);
+}
+
+int Fib(int n) {
+  return n < 2 ? n : Fib(n - 1) + Fib(n - 2);
+}
+
+int Fib(wpi::ThreadPool& pool, int n) {
+  if (n < kFibGrain) {
+    return Fib(n);
+  }
+  auto f = pool.Submit([&pool, n] { return Fib(pool, n - 1); });
+  int b = Fib(pool, n - 2);
+  return pool.Get(f) + b;
+}
+
+}  // namespace
+
+int ThreadPoolBench(int argc, char* argv[]) {
+  Options opts;
+  for (int i = 0; i < argc; ++i) {
+    if (!ParseOption(argv[i], &opts)) {
+      std::fprintf(stderr, "unknown option '%s'\n", argv[i]);
+      return 1;
+    }
+  }
+
+  RunQueues(opts);
+
+  double poolRate;
+  {
+    wpi::ThreadPool pool{static_cast<unsigned int>(opts.threads)};
+    poolRate = RunTasks(pool, opts.tasks);
+  }
+  double queuePoolRate;
+  {
+    QueuePool pool{opts.threads};
+    queuePoolRate = RunTasks(pool, opts.tasks);
+  }
+  std::printf("\ntiny tasks, %d threads (Mtasks/s):\n", opts.threads);
+  std::printf("  ThreadPool      %8.2f\n", poolRate / 1e6);
+  std::printf("  ConcurrentQueue %8.2f\n", queuePoolRate / 1e6);
+
+  auto start = Clock::now();
+  int serial = Fib(opts.fib);
+  double serialTime = Seconds(start);
+  wpi::ThreadPool pool{static_cast<unsigned int>(opts.threads)};
+  start = Clock::now();
+  auto f = pool.Submit([&] { return Fib(pool, opts.fib); });
+  int parallel = pool.Get(f);
+  double parallelTime = Seconds(start);
+  std::printf("\nfib(%d), %d threads:\n", opts.fib, opts.threads);
+  std::printf("  serial   %8.1f ms\n", serialTime * 1e3);
+  std::printf("  parallel %8.1f ms (%.1fx)\n", parallelTime * 1e3,
+              serialTime / parallelTime);
+  if (serial != parallel) {
+    std::printf("(wrong result)\n");
+  }
+  return 0;
+}
@@ -4,11 +4,28 @@
 
 #include <iostream>
 
+#include "Bench.h"
 #include "wpi/SmallVector.h"
 #include "wpi/StringRef.h"
 #include "wpi/hostname.h"
 
-int main() {
+int main(int argc, char* argv[]) {
+  if (argc > 1) {
+    wpi::StringRef name{argv[1]};
+    if (name == "data-log") {
+      return DataLogBench(argc - 2, argv + 2);
+    }
+    if (name == "json") {
+      return JsonBench(argc - 2, argv + 2);
+    }
+    if (name == "thread-pool") {
+      return ThreadPoolBench(argc - 2, argv + 2);
+    }
+    std::cerr << "unknown benchmark '" << name.str() << "'\n"
+              << "available: data-log, json, thread-pool\n";
+    return 1;
+  }
+
   wpi::StringRef v1("Hello");
   std::cout << v1.lower() << std::endl;
 }
@@ -0,0 +1,101 @@
+// Copyright (c) FIRST and other WPILib contributors.
+// Open Source Software; you can modify and/or share it under the terms of
+// the WPILib BSD license file in the root directory of this project.
+
+#include "wpi/Arena.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+#include "wpi/MemAlloc.h"
+
+using namespace wpi;
+
+Arena::~Arena() {
+  for (auto&& slab : m_slabs) {
+    std::free(slab.data);
+  }
+  for (auto&& slab : m_customSlabs) {
+    std::free(slab.data);
+  }
+}
+
+Arena::Arena(Arena&& rhs) noexcept
+    : m_slabSize{rhs.m_slabSize},
+      m_cur{rhs.m_cur},
+      m_end{rhs.m_end},
+      m_bytesAllocated{rhs.m_bytesAllocated},
+      m_slabs{std::move(rhs.m_slabs)},
+      m_customSlabs{std::move(rhs.m_customSlabs)} {
+  rhs.m_cur = rhs.m_end = nullptr;
+  rhs.m_bytesAllocated = 0;
+  rhs.m_slabs.clear();
+  rhs.m_customSlabs.clear();
+}
+
+Arena& Arena::operator=(Arena&& rhs) noexcept {
+  if (this != &rhs) {
+    this->~Arena();
+    new (this) Arena(std::move(rhs));
+  }
+  return *this;
+}
+
+void Arena::Reset() {
+  for (auto&& slab : m_customSlabs) {
+    std::free(slab.data);
+  }
+  m_customSlabs.clear();
+  m_bytesAllocated = 0;
+  if (m_slabs.empty()) {
+    return;
+  }
+  // the last slab is the largest
+  Slab keep = m_slabs.back();
+  m_slabs.pop_back();
+  for (auto&& slab : m_slabs) {
+    std::free(slab.data);
+  }
+  m_slabs.clear();
+  m_slabs.push_back(keep);
+  m_cur = keep.data;
+  m_end = keep.data + keep.size;
+}
+
+size_t Arena::GetTotalMemory() const {
+  size_t total = 0;
+  for (auto&& slab : m_slabs) {
+    total += slab.size;
+  }
+  for (auto&& slab : m_customSlabs) {
+    total += slab.size;
+  }
+  return total;
+}
+
+void* Arena::AllocateSlow(size_t size, size_t alignment) {
+  size_t slabSize = m_slabSize;
+  if (!m_slabs.empty()) {
+    slabSize = (std::min)(m_slabs.back().size * 2, kMaxSlabSize);
+    slabSize = (std::max)(slabSize, m_slabs.back().size);
+  }
+
+  // malloc memory is aligned to max_align_t; pad for anything stricter
+  size_t padded = size + (alignment > alignof(std::max_align_t) ? alignment : 0);
+  if (padded > slabSize / 2) {
+    // big enough that starting a new slab for it would waste the rest of
+    // the current one
+    char* data = static_cast<char*>(safe_malloc(padded));
+    m_customSlabs.push_back({data, padded});
+    m_bytesAllocated += size;
+    uintptr_t aligned = (reinterpret_cast<uintptr_t>(data) + alignment - 1) &
+                        ~(alignment - 1);
+    return reinterpret_cast<void*>(aligned);
+  }
+
+  char* data = static_cast<char*>(safe_malloc(slabSize));
+  m_slabs.push_back({data, slabSize});
+  m_cur = data;
+  m_end = data + slabSize;
+  return Allocate(size, alignment);
+}
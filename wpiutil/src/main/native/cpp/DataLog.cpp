@@ -0,0 +1,490 @@
+// Copyright (c) FIRST and other WPILib contributors.
+// Open Source Software; you can modify and/or share it under the terms of
+// the WPILib BSD license file in the root directory of this project.
+
+#include "wpi/DataLog.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <utility>
+
+#include "wpi/Endian.h"
+#include "wpi/SmallString.h"
+#include "wpi/SmallVector.h"
+#include "wpi/raw_ostream.h"
+#include "wpi/timestamp.h"
+
+using namespace wpi::log;
+
+namespace wpi::log::impl {
+
+// Single producer (the appending thread), single consumer (the writer
+// thread) byte ring.  head and tail count bytes ever written and consumed;
+// they only grow, so head - tail is the number of bytes staged.
+struct StagingBuffer {
+  StagingBuffer() : data(new uint8_t[DataLog::kStagingSize]) {}
+
+  std::unique_ptr<uint8_t[]> data;
+  alignas(64) std::atomic<size_t> head{0};
+  alignas(64) std::atomic<size_t> tail{0};
+  // set by the appending thread when it exits
+  std::atomic_bool orphaned{false};
+  // set by the log when it is destroyed
+  std::atomic_bool closed{false};
+};
+
+}  // namespace wpi::log::impl
+
+using wpi::log::impl::StagingBuffer;
+
+static_assert((DataLog::kStagingSize & (DataLog::kStagingSize - 1)) == 0,
+              "staging size must be a power of 2");
+
+static constexpr size_t kMask = DataLog::kStagingSize - 1;
+static constexpr size_t kMaxHeaderSize = 1 + 4 + 4 + 8;
+static constexpr uint8_t kControlStart = 0;
+static constexpr uint8_t kControlFinish = 1;
+static constexpr uint8_t kControlSetMetadata = 2;
+
+static std::atomic<uint64_t> gNextUid{1};
+
+namespace {
+
+// The staging buffers of the current thread, one per log it appended to.
+struct ThreadStaging {
+  ~ThreadStaging() {
+    for (auto&& buf : bufs) {
+      buf.second->orphaned.store(true, std::memory_order_release);
+    }
+  }
+
+  std::vector<std::pair<uint64_t, std::shared_ptr<StagingBuffer>>> bufs;
+};
+
+thread_local ThreadStaging gThreadStaging;
+
+}  // namespace
+
+static unsigned int IntLength(uint64_t val) {
+  unsigned int len = 1;
+  while (len < 8 && (val >> (8 * len)) != 0) {
+    ++len;
+  }
+  return len;
+}
+
+static uint8_t* WriteInt(uint8_t* out, uint64_t val, unsigned int len) {
+  for (unsigned int i = 0; i < len; ++i) {
+    *out++ = static_cast<uint8_t>(val >> (8 * i));
+  }
+  return out;
+}
+
+// Writes a record header; returns its length
+static size_t WriteHeader(uint8_t* out, uint32_t entry, uint32_t size,
+                          int64_t timestamp) {
+  unsigned int entryLen = IntLength(entry);
+  unsigned int sizeLen = IntLength(size);
+  unsigned int timeLen = IntLength(static_cast<uint64_t>(timestamp));
+  uint8_t* p = out;
+  *p++ = static_cast<uint8_t>((entryLen - 1) | ((sizeLen - 1) << 2) |
+                              ((timeLen - 1) << 4));
+  p = WriteInt(p, entry, entryLen);
+  p = WriteInt(p, size, sizeLen);
+  p = WriteInt(p, static_cast<uint64_t>(timestamp), timeLen);
+  return p - out;
+}
+
+static void AppendBytes(std::vector<uint8_t>* buf, const void* data,
+                        size_t size) {
+  auto p = static_cast<const uint8_t*>(data);
+  buf->insert(buf->end(), p, p + size);
+}
+
+static void AppendU32(wpi::SmallVectorImpl<uint8_t>* buf, uint32_t val) {
+  uint8_t data[4];
+  wpi::support::endian::write32le(data, val);
+  buf->append(data, data + 4);
+}
+
+DataLog::DataLog(const Twine& filename, std::error_code& ec, double period,
+                 const Twine& extraHeader)
+    : m_period{period}, m_uid{gNextUid++} {
+  SmallString<128> buf;
+  auto os = std::make_shared<raw_fd_ostream>(filename.toStringRef(buf), ec);
+  if (ec) {
+    m_write = [](ArrayRef<uint8_t>) {};
+  } else {
+    m_write = [os](ArrayRef<uint8_t> data) {
+      os->write(reinterpret_cast<const char*>(data.data()), data.size());
+      os->flush();
+    };
+  }
+  StartWriter(extraHeader);
+}
+
+DataLog::DataLog(std::function<void(ArrayRef<uint8_t> data)> write,
+                 double period, const Twine& extraHeader)
+    : m_write{std::move(write)}, m_period{period}, m_uid{gNextUid++} {
+  StartWriter(extraHeader);
+}
+
+DataLog::~DataLog() {
+  {
+    std::scoped_lock lock(m_mutex);
+    m_active = false;
+  }
+  m_cond.notify_all();
+  m_thread.join();
+  // let appending threads release their buffers
+  for (auto&& buf : m_staging) {
+    buf->closed = true;
+  }
+}
+
+void DataLog::StartWriter(const Twine& extraHeader) {
+  SmallString<128> headerBuf;
+  StringRef header = extraHeader.toStringRef(headerBuf);
+  uint8_t prefix[12] = {'W', 'P', 'I', 'L', 'O', 'G'};
+  support::endian::write16le(prefix + 6, 0x0100);
+  support::endian::write32le(prefix + 8, header.size());
+  AppendBytes(&m_controlStart, prefix, sizeof(prefix));
+  AppendBytes(&m_controlStart, header.data(), header.size());
+  m_thread = std::thread(&DataLog::WriterThreadMain, this);
+}
+
+void DataLog::Flush() {
+  std::unique_lock lock(m_mutex);
+  uint64_t target = ++m_flushRequested;
+  m_cond.notify_all();
+  m_flushed.wait(lock, [&] { return m_flushDone >= target; });
+}
+
+int DataLog::Start(StringRef name, StringRef type, StringRef metadata,
+                   int64_t timestamp) {
+  std::scoped_lock lock(m_mutex);
+  auto& info = m_entries[name];
+  if (info.count++ > 0) {
+    return info.id;
+  }
+  info.id = ++m_lastEntry;
+
+  uint8_t fixed[9];
+  fixed[0] = kControlStart;
+  support::endian::write32le(fixed + 1, info.id);
+  support::endian::write32le(fixed + 5, name.size());
+  uint8_t typeLen[4], metadataLen[4];
+  support::endian::write32le(typeLen, type.size());
+  support::endian::write32le(metadataLen, metadata.size());
+  Piece pieces[] = {{fixed, 9},
+                    {name.data(), name.size()},
+                    {typeLen, 4},
+                    {type.data(), type.size()},
+                    {metadataLen, 4},
+                    {metadata.data(), metadata.size()}};
+  AppendControl(&m_controlStart, pieces, timestamp);
+  return info.id;
+}
+
+void DataLog::Finish(int entry, int64_t timestamp) {
+  std::scoped_lock lock(m_mutex);
+  auto it = std::find_if(m_entries.begin(), m_entries.end(),
+                         [&](const auto& e) { return e.second.id == entry; });
+  if (it == m_entries.end() || --it->second.count > 0) {
+    return;
+  }
+  m_entries.erase(it);
+
+  uint8_t payload[5];
+  payload[0] = kControlFinish;
+  support::endian::write32le(payload + 1, entry);
+  Piece pieces[] = {{payload, 5}};
+  AppendControl(&m_controlFinish, pieces, timestamp);
+}
+
+void DataLog::SetMetadata(int entry, StringRef metadata, int64_t timestamp) {
+  std::scoped_lock lock(m_mutex);
+  uint8_t fixed[9];
+  fixed[0] = kControlSetMetadata;
+  support::endian::write32le(fixed + 1, entry);
+  support::endian::write32le(fixed + 5, metadata.size());
+  Piece pieces[] = {{fixed, 9}, {metadata.data(), metadata.size()}};
+  AppendControl(&m_controlStart, pieces, timestamp);
+}
+
+void DataLog::AppendControl(std::vector<uint8_t>* buf, ArrayRef<Piece> pieces,
+                            int64_t timestamp) {
+  if (timestamp == 0) {
+    timestamp = wpi::Now();
+  }
+  size_t size = 0;
+  for (auto&& piece : pieces) {
+    size += piece.size;
+  }
+  uint8_t header[kMaxHeaderSize];
+  AppendBytes(buf, header, WriteHeader(header, 0, size, timestamp));
+  for (auto&& piece : pieces) {
+    AppendBytes(buf, piece.data, piece.size);
+  }
+}
+
+StagingBuffer* DataLog::GetStaging() {
+  auto& bufs = gThreadStaging.bufs;
+  for (auto&& buf : bufs) {
+    if (buf.first == m_uid) {
+      return buf.second.get();
+    }
+  }
+
+  // first append from this thread; drop buffers of logs that are gone
+  bufs.erase(std::remove_if(
+                 bufs.begin(), bufs.end(),
+                 [](const auto& buf) { return buf.second->closed.load(); }),
+             bufs.end());
+  auto buf = std::make_shared<StagingBuffer>();
+  {
+    std::scoped_lock lock(m_mutex);
+    m_staging.emplace_back(buf);
+  }
+  bufs.emplace_back(m_uid, buf);
+  return buf.get();
+}
+
+void DataLog::AppendRecord(int entry, int64_t timestamp,
+                           ArrayRef<Piece> pieces) {
+  if (timestamp == 0) {
+    timestamp = wpi::Now();
+  }
+  size_t payloadSize = 0;
+  for (auto&& piece : pieces) {
+    payloadSize += piece.size;
+  }
+  uint8_t header[kMaxHeaderSize];
+  size_t headerSize = WriteHeader(header, entry, payloadSize, timestamp);
+  size_t size = headerSize + payloadSize;
+
+  StagingBuffer* buf = GetStaging();
+  size_t head = buf->head.load(std::memory_order_relaxed);
+  size_t tail = buf->tail.load(std::memory_order_acquire);
+  if (size > kStagingSize - (head - tail)) {
+    m_dropped.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+
+  uint8_t* data = buf->data.get();
+  size_t pos = head;
+  auto copy = [&](const void* src, size_t len) {
+    auto p = static_cast<const uint8_t*>(src);
+    size_t off = pos & kMask;
+    size_t first = (std::min)(len, kStagingSize - off);
+    std::memcpy(data + off, p, first);
+    std::memcpy(data, p + first, len - first);
+    pos += len;
+  };
+  copy(header, headerSize);
+  for (auto&& piece : pieces) {
+    copy(piece.data, piece.size);
+  }
+  buf->head.store(pos, std::memory_order_release);
+
+  // wake the writer early rather than let the buffer fill
+  if (pos - tail > kStagingSize / 2 &&
+      !m_wake.exchange(true, std::memory_order_relaxed)) {
+    m_cond.notify_one();
+  }
+}
+
+void DataLog::AppendRaw(int entry, ArrayRef<uint8_t> data, int64_t timestamp) {
+  Piece pieces[] = {{data.data(), data.size()}};
+  AppendRecord(entry, timestamp, pieces);
+}
+
+void DataLog::AppendBoolean(int entry, bool value, int64_t timestamp) {
+  uint8_t data = value ? 1 : 0;
+  Piece pieces[] = {{&data, 1}};
+  AppendRecord(entry, timestamp, pieces);
+}
+
+void DataLog::AppendInteger(int entry, int64_t value, int64_t timestamp) {
+  uint8_t data[8];
+  support::endian::write64le(data, value);
+  Piece pieces[] = {{data, 8}};
+  AppendRecord(entry, timestamp, pieces);
+}
+
+void DataLog::AppendFloat(int entry, float value, int64_t timestamp) {
+  uint32_t bits;
+  std::memcpy(&bits, &value, sizeof(bits));
+  uint8_t data[4];
+  support::endian::write32le(data, bits);
+  Piece pieces[] = {{data, 4}};
+  AppendRecord(entry, timestamp, pieces);
+}
+
+void DataLog::AppendDouble(int entry, double value, int64_t timestamp) {
+  uint64_t bits;
+  std::memcpy(&bits, &value, sizeof(bits));
+  uint8_t data[8];
+  support::endian::write64le(data, bits);
+  Piece pieces[] = {{data, 8}};
+  AppendRecord(entry, timestamp, pieces);
+}
+
+void DataLog::AppendString(int entry, StringRef value, int64_t timestamp) {
+  Piece pieces[] = {{value.data(), value.size()}};
+  AppendRecord(entry, timestamp, pieces);
+}
+
+void DataLog::AppendBooleanArray(int entry, ArrayRef<bool> values,
+                                 int64_t timestamp) {
+  SmallVector<uint8_t, 128> data;
+  for (bool value : values) {
+    data.push_back(value ? 1 : 0);
+  }
+  Piece pieces[] = {{data.data(), data.size()}};
+  AppendRecord(entry, timestamp, pieces);
+}
+
+void DataLog::AppendBooleanArray(int entry, ArrayRef<int> values,
+                                 int64_t timestamp) {
+  SmallVector<uint8_t, 128> data;
+  for (int value : values) {
+    data.push_back(value ? 1 : 0);
+  }
+  Piece pieces[] = {{data.data(), data.size()}};
+  AppendRecord(entry, timestamp, pieces);
+}
+
+// Arrays of numbers are copied as-is on little endian hosts
+template <typename T, typename Bits>
+static void AppendNumbers(wpi::SmallVectorImpl<uint8_t>* data,
+                          wpi::ArrayRef<T> values) {
+  namespace support = wpi::support;
+  data->resize(values.size() * sizeof(T));
+  if constexpr (support::endian::system_endianness() == support::little) {
+    if (!values.empty()) {
+      std::memcpy(data->data(), values.data(), data->size());
+    }
+  } else {
+    uint8_t* p = data->data();
+    for (T value : values) {
+      Bits bits;
+      std::memcpy(&bits, &value, sizeof(bits));
+      support::endian::write<Bits, support::little, 1>(p, bits);
+      p += sizeof(T);
+    }
+  }
+}
+
+void DataLog::AppendIntegerArray(int entry, ArrayRef<int64_t> values,
+                                 int64_t timestamp) {
+  SmallVector<uint8_t, 128> data;
+  AppendNumbers<int64_t, uint64_t>(&data, values);
+  Piece pieces[] = {{data.data(), data.size()}};
+  AppendRecord(entry, timestamp, pieces);
+}
+
+void DataLog::AppendFloatArray(int entry, ArrayRef<float> values,
+                               int64_t timestamp) {
+  SmallVector<uint8_t, 128> data;
+  AppendNumbers<float, uint32_t>(&data, values);
+  Piece pieces[] = {{data.data(), data.size()}};
+  AppendRecord(entry, timestamp, pieces);
+}
+
+void DataLog::AppendDoubleArray(int entry, ArrayRef<double> values,
+                                int64_t timestamp) {
+  SmallVector<uint8_t, 128> data;
+  AppendNumbers<double, uint64_t>(&data, values);
+  Piece pieces[] = {{data.data(), data.size()}};
+  AppendRecord(entry, timestamp, pieces);
+}
+
+void DataLog::AppendStringArray(int entry, ArrayRef<std::string> values,
+                                int64_t timestamp) {
+  SmallVector<uint8_t, 128> data;
+  AppendU32(&data, values.size());
+  for (auto&& value : values) {
+    AppendU32(&data, value.size());
+    data.append(value.begin(), value.end());
+  }
+  Piece pieces[] = {{data.data(), data.size()}};
+  AppendRecord(entry, timestamp, pieces);
+}
+
+void DataLog::AppendStringArray(int entry, ArrayRef<StringRef> values,
+                                int64_t timestamp) {
+  SmallVector<uint8_t, 128> data;
+  AppendU32(&data, values.size());
+  for (auto&& value : values) {
+    AppendU32(&data, value.size());
+    data.append(value.begin(), value.end());
+  }
+  Piece pieces[] = {{data.data(), data.size()}};
+  AppendRecord(entry, timestamp, pieces);
+}
+
+void DataLog::WriterThreadMain() {
+  auto period = std::chrono::duration<double>(m_period);
+  std::vector<std::pair<std::shared_ptr<StagingBuffer>, size_t>> heads;
+  std::vector<uint8_t> controlStart;
+  std::vector<uint8_t> controlFinish;
+  std::vector<uint8_t> out;
+
+  std::unique_lock lock(m_mutex);
+  for (;;) {
+    m_cond.wait_for(lock, period, [&] {
+      return !m_active || m_flushRequested != m_flushDone ||
+             m_wake.load(std::memory_order_relaxed);
+    });
+    m_wake = false;
+    bool active = m_active;
+    uint64_t flushRequested = m_flushRequested;
+
+    // Snapshot the staged data before taking the control records, so every
+    // start written in this batch precedes the data appended after it.
+    heads.clear();
+    for (auto&& buf : m_staging) {
+      heads.emplace_back(buf, buf->head.load(std::memory_order_acquire));
+    }
+    controlStart.swap(m_controlStart);
+    controlFinish.swap(m_controlFinish);
+    lock.unlock();
+
+    out.clear();
+    out.insert(out.end(), controlStart.begin(), controlStart.end());
+    for (auto&& [buf, head] : heads) {
+      size_t tail = buf->tail.load(std::memory_order_relaxed);
+      size_t off = tail & kMask;
+      size_t len = head - tail;
+      size_t first = (std::min)(len, kStagingSize - off);
+      const uint8_t* data = buf->data.get();
+      out.insert(out.end(), data + off, data + off + first);
+      out.insert(out.end(), data, data + (len - first));
+      buf->tail.store(head, std::memory_order_release);
+    }
+    out.insert(out.end(), controlFinish.begin(), controlFinish.end());
+    controlStart.clear();
+    controlFinish.clear();
+    if (!out.empty()) {
+      m_write(out);
+    }
+
+    lock.lock();
+    // drop buffers of threads that have exited once they are drained
+    m_staging.erase(
+        std::remove_if(m_staging.begin(), m_staging.end(),
+                       [](const auto& buf) {
+                         return buf->orphaned.load(std::memory_order_acquire) &&
+                                buf->head.load(std::memory_order_relaxed) ==
+                                    buf->tail.load(std::memory_order_relaxed);
+                       }),
+        m_staging.end());
+    m_flushDone = flushRequested;
+    m_flushed.notify_all();
+    if (!active) {
+      break;
+    }
+  }
+}
@@ -0,0 +1,291 @@
+// Copyright (c) FIRST and other WPILib contributors.
+// Open Source Software; you can modify and/or share it under the terms of
+// the WPILib BSD license file in the root directory of this project.
+
+#include "wpi/DataLogReader.h"
+
+#include <cstring>
+#include <utility>
+
+#include "wpi/Endian.h"
+#include "wpi/raw_istream.h"
+
+using namespace wpi::log;
+
+static constexpr size_t kHeaderSize = 12;
+static constexpr uint8_t kControlStart = 0;
+static constexpr uint8_t kControlFinish = 1;
+static constexpr uint8_t kControlSetMetadata = 2;
+
+static uint64_t ReadInt(const uint8_t* buf, unsigned int len) {
+  uint64_t val = 0;
+  for (unsigned int i = 0; i < len; ++i) {
+    val |= static_cast<uint64_t>(buf[i]) << (8 * i);
+  }
+  return val;
+}
+
+// Reads a 32-bit length-prefixed string, advancing *data
+static bool ReadString(wpi::ArrayRef<uint8_t>* data, wpi::StringRef* str) {
+  if (data->size() < 4) {
+    return false;
+  }
+  uint32_t len = wpi::support::endian::read32le(data->data());
+  if (len > data->size() - 4) {
+    return false;
+  }
+  *str = wpi::StringRef{reinterpret_cast<const char*>(data->data() + 4), len};
+  *data = data->slice(4 + len);
+  return true;
+}
+
+bool DataLogRecord::IsStart() const {
+  return m_entry == 0 && m_data.size() >= 17 && m_data[0] == kControlStart;
+}
+
+bool DataLogRecord::IsFinish() const {
+  return m_entry == 0 && m_data.size() == 5 && m_data[0] == kControlFinish;
+}
+
+bool DataLogRecord::IsSetMetadata() const {
+  return m_entry == 0 && m_data.size() >= 9 &&
+         m_data[0] == kControlSetMetadata;
+}
+
+bool DataLogRecord::GetStartData(StartRecordData* out) const {
+  if (!IsStart()) {
+    return false;
+  }
+  out->entry = support::endian::read32le(m_data.data() + 1);
+  auto data = m_data.slice(5);
+  return ReadString(&data, &out->name) && ReadString(&data, &out->type) &&
+         ReadString(&data, &out->metadata);
+}
+
+bool DataLogRecord::GetFinishEntry(int* out) const {
+  if (!IsFinish()) {
+    return false;
+  }
+  *out = support::endian::read32le(m_data.data() + 1);
+  return true;
+}
+
+bool DataLogRecord::GetSetMetadataData(MetadataRecordData* out) const {
+  if (!IsSetMetadata()) {
+    return false;
+  }
+  out->entry = support::endian::read32le(m_data.data() + 1);
+  auto data = m_data.slice(5);
+  return ReadString(&data, &out->metadata);
+}
+
+bool DataLogRecord::GetBoolean(bool* value) const {
+  if (m_data.size() != 1) {
+    return false;
+  }
+  *value = m_data[0] != 0;
+  return true;
+}
+
+bool DataLogRecord::GetInteger(int64_t* value) const {
+  if (m_data.size() != 8) {
+    return false;
+  }
+  *value = support::endian::read64le(m_data.data());
+  return true;
+}
+
+bool DataLogRecord::GetFloat(float* value) const {
+  if (m_data.size() != 4) {
+    return false;
+  }
+  uint32_t bits = support::endian::read32le(m_data.data());
+  std::memcpy(value, &bits, sizeof(bits));
+  return true;
+}
+
+bool DataLogRecord::GetDouble(double* value) const {
+  if (m_data.size() != 8) {
+    return false;
+  }
+  uint64_t bits = support::endian::read64le(m_data.data());
+  std::memcpy(value, &bits, sizeof(bits));
+  return true;
+}
+
+bool DataLogRecord::GetString(StringRef* value) const {
+  *value = StringRef{reinterpret_cast<const char*>(m_data.data()),
+                     m_data.size()};
+  return true;
+}
+
+bool DataLogRecord::GetBooleanArray(std::vector<int>* arr) const {
+  arr->clear();
+  arr->reserve(m_data.size());
+  for (auto v : m_data) {
+    arr->push_back(v != 0);
+  }
+  return true;
+}
+
+bool DataLogRecord::GetIntegerArray(std::vector<int64_t>* arr) const {
+  arr->clear();
+  if ((m_data.size() % 8) != 0) {
+    return false;
+  }
+  arr->reserve(m_data.size() / 8);
+  for (size_t pos = 0; pos < m_data.size(); pos += 8) {
+    arr->push_back(support::endian::read64le(m_data.data() + pos));
+  }
+  return true;
+}
+
+bool DataLogRecord::GetFloatArray(std::vector<float>* arr) const {
+  arr->clear();
+  if ((m_data.size() % 4) != 0) {
+    return false;
+  }
+  arr->reserve(m_data.size() / 4);
+  for (size_t pos = 0; pos < m_data.size(); pos += 4) {
+    uint32_t bits = support::endian::read32le(m_data.data() + pos);
+    float value;
+    std::memcpy(&value, &bits, sizeof(bits));
+    arr->push_back(value);
+  }
+  return true;
+}
+
+bool DataLogRecord::GetDoubleArray(std::vector<double>* arr) const {
+  arr->clear();
+  if ((m_data.size() % 8) != 0) {
+    return false;
+  }
+  arr->reserve(m_data.size() / 8);
+  for (size_t pos = 0; pos < m_data.size(); pos += 8) {
+    uint64_t bits = support::endian::read64le(m_data.data() + pos);
+    double value;
+    std::memcpy(&value, &bits, sizeof(bits));
+    arr->push_back(value);
+  }
+  return true;
+}
+
+bool DataLogRecord::GetStringArray(std::vector<StringRef>* arr) const {
+  arr->clear();
+  if (m_data.size() < 4) {
+    return false;
+  }
+  uint32_t count = support::endian::read32le(m_data.data());
+  // each string takes at least 4 bytes
+  if (count > (m_data.size() - 4) / 4) {
+    return false;
+  }
+  arr->reserve(count);
+  auto data = m_data.slice(4);
+  for (uint32_t i = 0; i < count; ++i) {
+    StringRef str;
+    if (!ReadString(&data, &str)) {
+      arr->clear();
+      return false;
+    }
+    arr->push_back(str);
+  }
+  return data.empty();
+}
+
+DataLogIterator& DataLogIterator::operator++() {
+  DataLogRecord record;
+  if (m_reader->GetRecord(&m_pos, &record)) {
+    // stop before a truncated record
+    size_t next = m_pos;
+    if (m_reader->GetRecord(&next, &record)) {
+      return *this;
+    }
+  }
+  m_pos = m_reader->m_buf.size();
+  return *this;
+}
+
+DataLogIterator::reference DataLogIterator::operator*() const {
+  size_t pos = m_pos;
+  m_reader->GetRecord(&pos, &m_value);
+  return m_value;
+}
+
+DataLogReader::DataLogReader(std::vector<uint8_t> data)
+    : m_buf{std::move(data)} {}
+
+DataLogReader::DataLogReader(const Twine& filename, std::error_code& ec) {
+  raw_fd_istream is{filename, ec};
+  if (ec) {
+    return;
+  }
+  uint8_t buf[4096];
+  while (!is.has_error()) {
+    is.read(buf, sizeof(buf));
+    m_buf.insert(m_buf.end(), buf, buf + is.read_count());
+  }
+}
+
+bool DataLogReader::IsValid() const {
+  return m_buf.size() >= kHeaderSize &&
+         StringRef(reinterpret_cast<const char*>(m_buf.data()), 6) ==
+             "WPILOG" &&
+         GetVersion() >= 0x0100 &&
+         support::endian::read32le(m_buf.data() + 8) <=
+             m_buf.size() - kHeaderSize;
+}
+
+uint16_t DataLogReader::GetVersion() const {
+  if (m_buf.size() < kHeaderSize) {
+    return 0;
+  }
+  return support::endian::read16le(m_buf.data() + 6);
+}
+
+wpi::StringRef DataLogReader::GetExtraHeader() const {
+  if (!IsValid()) {
+    return {};
+  }
+  return {reinterpret_cast<const char*>(m_buf.data()) + kHeaderSize,
+          support::endian::read32le(m_buf.data() + 8)};
+}
+
+DataLogIterator DataLogReader::begin() const {
+  if (!IsValid()) {
+    return end();
+  }
+  size_t pos = kHeaderSize + support::endian::read32le(m_buf.data() + 8);
+  // a truncated first record means there are none
+  size_t next = pos;
+  DataLogRecord record;
+  if (!GetRecord(&next, &record)) {
+    return end();
+  }
+  return DataLogIterator{this, pos};
+}
+
+bool DataLogReader::GetRecord(size_t* pos, DataLogRecord* out) const {
+  if (*pos >= m_buf.size()) {
+    return false;
+  }
+  size_t avail = m_buf.size() - *pos;
+  const uint8_t* p = m_buf.data() + *pos;
+  unsigned int entryLen = (p[0] & 0x3) + 1;
+  unsigned int sizeLen = ((p[0] >> 2) & 0x3) + 1;
+  unsigned int timeLen = ((p[0] >> 4) & 0x7) + 1;
+  size_t headerLen = 1 + entryLen + sizeLen + timeLen;
+  if (avail < headerLen) {
+    return false;
+  }
+  uint64_t entry = ReadInt(p + 1, entryLen);
+  uint64_t size = ReadInt(p + 1 + entryLen, sizeLen);
+  uint64_t timestamp = ReadInt(p + 1 + entryLen + sizeLen, timeLen);
+  if (size > avail - headerLen) {
+    return false;
+  }
+  *out = DataLogRecord{static_cast<int>(entry), static_cast<int64_t>(timestamp),
+                       {p + headerLen, static_cast<size_t>(size)}};
+  *pos += headerLen + size;
+  return true;
+}
@@ -0,0 +1,211 @@
+// Copyright (c) FIRST and other WPILib contributors.
+// Open Source Software; you can modify and/or share it under the terms of
+// the WPILib BSD license file in the root directory of this project.
+
+#include "wpi/Lz4.h"
+
+#include <stdint.h>
+
+#include <cstring>
+
+#include "wpi/SmallVector.h"
+
+// Implementation of the LZ4 block format as described in
+// https://github.com/lz4/lz4/blob/dev/doc/lz4_Block_format.md
+//
+// Each sequence is a token byte (literal length in the high nibble, match
+// length - 4 in the low nibble, 15 meaning more length bytes follow), the
+// literals, a 16-bit little endian match offset, and any extra match length
+// bytes.  The last sequence is literals only.
+
+namespace {
+
+constexpr size_t kMinMatch = 4;
+// The last 5 bytes are always literals, and the last match must start at
+// least 12 bytes before the end of the block.
+constexpr size_t kLastLiterals = 5;
+constexpr size_t kMatchFindLimit = 12;
+constexpr size_t kMaxOffset = 65535;
+constexpr int kHashLog = 12;
+
+inline uint32_t Read32(const uint8_t* p) {
+  uint32_t v;
+  std::memcpy(&v, p, sizeof(v));
+  return v;
+}
+
+inline uint32_t Hash(uint32_t seq) {
+  return (seq * 2654435761u) >> (32 - kHashLog);
+}
+
+inline void WriteLength(uint8_t*& op, size_t len) {
+  for (; len >= 255; len -= 255) {
+    *op++ = 255;
+  }
+  *op++ = static_cast<uint8_t>(len);
+}
+
+// Write literals [lit, lit + lit_len) followed by a match (if match_len != 0)
+inline void WriteSequence(uint8_t*& op, const uint8_t* lit, size_t lit_len,
+                          size_t offset, size_t match_len) {
+  uint8_t* token = op++;
+  if (lit_len >= 15) {
+    *token = 15 << 4;
+    WriteLength(op, lit_len - 15);
+  } else {
+    *token = static_cast<uint8_t>(lit_len << 4);
+  }
+  std::memcpy(op, lit, lit_len);
+  op += lit_len;
+  if (match_len == 0) {
+    return;
+  }
+  *op++ = static_cast<uint8_t>(offset);
+  *op++ = static_cast<uint8_t>(offset >> 8);
+  match_len -= kMinMatch;
+  if (match_len >= 15) {
+    *token |= 15;
+    WriteLength(op, match_len - 15);
+  } else {
+    *token |= static_cast<uint8_t>(match_len);
+  }
+}
+
+}  // namespace
+
+namespace wpi {
+
+StringRef Lz4Compress(StringRef plain, SmallVectorImpl<char>& buf) {
+  size_t start = buf.size();
+  buf.resize(start + Lz4CompressBound(plain.size()));
+  auto out = reinterpret_cast<uint8_t*>(buf.data() + start);
+  uint8_t* op = out;
+
+  auto src = reinterpret_cast<const uint8_t*>(plain.data());
+  size_t len = plain.size();
+  size_t anchor = 0;
+
+  if (len > kMatchFindLimit) {
+    uint32_t table[1 << kHashLog] = {};
+    size_t find_limit = len - kMatchFindLimit;
+    size_t match_limit = len - kLastLiterals;
+    size_t ip = 1;
+    while (ip < find_limit) {
+      uint32_t seq = Read32(src + ip);
+      uint32_t h = Hash(seq);
+      size_t ref = table[h];
+      table[h] = static_cast<uint32_t>(ip);
+      if (ref >= ip || (ip - ref) > kMaxOffset || Read32(src + ref) != seq) {
+        // skip faster through incompressible data
+        ip += 1 + ((ip - anchor) >> 6);
+        continue;
+      }
+
+      // extend the match backwards and forwards
+      while (ip > anchor && ref > 0 && src[ip - 1] == src[ref - 1]) {
+        --ip;
+        --ref;
+      }
+      size_t match_len = kMinMatch;
+      while (ip + match_len < match_limit &&
+             src[ip + match_len] == src[ref + match_len]) {
+        ++match_len;
+      }
+
+      WriteSequence(op, src + anchor, ip - anchor, ip - ref, match_len);
+      ip += match_len;
+      anchor = ip;
+      if (ip < find_limit) {
+        table[Hash(Read32(src + ip - 2))] = static_cast<uint32_t>(ip - 2);
+      }
+    }
+  }
+
+  WriteSequence(op, src + anchor, len - anchor, 0, 0);
+  buf.resize(start + (op - out));
+  return StringRef{buf.data() + start, buf.size() - start};
+}
+
+bool Lz4Decompress(StringRef compressed, size_t plain_len,
+                   SmallVectorImpl<char>& buf) {
+  size_t start = buf.size();
+  buf.resize(start + plain_len);
+  auto out = reinterpret_cast<uint8_t*>(buf.data() + start);
+  uint8_t* op = out;
+  uint8_t* oend = out + plain_len;
+  auto ip = reinterpret_cast<const uint8_t*>(compressed.data());
+  auto iend = ip + compressed.size();
+
+  auto readLength = [&](size_t* len) {
+    for (;;) {
+      if (ip == iend) {
+        return false;
+      }
+      uint8_t b = *ip++;
+      *len += b;
+      if (b != 255) {
+        return true;
+      }
+    }
+  };
+
+  for (;;) {
+    if (ip == iend) {
+      break;
+    }
+    uint8_t token = *ip++;
+
+    // literals
+    size_t lit_len = token >> 4;
+    if (lit_len == 15 && !readLength(&lit_len)) {
+      break;
+    }
+    if (lit_len > static_cast<size_t>(iend - ip) ||
+        lit_len > static_cast<size_t>(oend - op)) {
+      break;
+    }
+    std::memcpy(op, ip, lit_len);
+    op += lit_len;
+    ip += lit_len;
+    if (ip == iend) {
+      // last sequence
+      if (op == oend) {
+        return true;
+      }
+      break;
+    }
+
+    // match
+    if ((iend - ip) < 2) {
+      break;
+    }
+    size_t offset = ip[0] | (ip[1] << 8);
+    ip += 2;
+    if (offset == 0 || offset > static_cast<size_t>(op - out)) {
+      break;
+    }
+    size_t match_len = token & 15;
+    if (match_len == 15 && !readLength(&match_len)) {
+      break;
+    }
+    match_len += kMinMatch;
+    if (match_len > static_cast<size_t>(oend - op)) {
+      break;
+    }
+    const uint8_t* match = op - offset;
+    if (offset >= match_len) {
+      std::memcpy(op, match, match_len);
+      op += match_len;
+    } else {
+      // overlapping copy repeats the pattern
+      for (size_t i = 0; i < match_len; ++i) {
+        *op++ = *match++;
+      }
+    }
+  }
+
+  buf.resize(start);
+  return false;
+}
+
+}  // namespace wpi
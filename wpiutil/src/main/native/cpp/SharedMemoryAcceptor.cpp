@@ -0,0 +1,67 @@
+// Copyright (c) FIRST and other WPILib contributors.
+// Open Source Software; you can modify and/or share it under the terms of
+// the WPILib BSD license file in the root directory of this project.
+
+#include "wpi/SharedMemoryAcceptor.h"
+
+#include "SharedMemoryRegion.h"
+#include "wpi/Logger.h"
+
+using namespace wpi;
+
+SharedMemoryAcceptor::SharedMemoryAcceptor(const Twine& name, Logger& logger)
+    : m_name(name.str()), m_shutdown(false), m_logger(logger) {}
+
+SharedMemoryAcceptor::~SharedMemoryAcceptor() {
+  shutdown();
+}
+
+int SharedMemoryAcceptor::start() {
+  if (m_mapping) {
+    return 0;
+  }
+  m_mapping = shm::Mapping::Create(m_name, m_logger);
+  if (!m_mapping) {
+    return -1;
+  }
+  m_mapping->header().listening = 1;
+  return 0;
+}
+
+void SharedMemoryAcceptor::shutdown() {
+  m_shutdown = true;
+  if (m_mapping) {
+    auto& header = m_mapping->header();
+    header.listening = 0;
+    header.accept_seq.fetch_add(1);
+    shm::WakeAll(header.accept_seq);
+  }
+}
+
+std::unique_ptr<NetworkStream> SharedMemoryAcceptor::accept() {
+  if (!m_mapping) {
+    return nullptr;
+  }
+  auto& header = m_mapping->header();
+  for (;;) {
+    if (m_shutdown) {
+      return nullptr;
+    }
+    uint32_t seq = header.accept_seq.load();
+    for (size_t i = 0; i < shm::kNumSlots; ++i) {
+      auto& slot = header.slots[i];
+      uint32_t state = shm::kRequested;
+      if (slot.state.compare_exchange_strong(state, shm::kConnected)) {
+        shm::WakeAll(slot.state);
+        return std::unique_ptr<NetworkStream>(
+            new SharedMemoryStream(m_mapping, i, true));
+      }
+    }
+    // connectors bump accept_seq after requesting a slot
+    header.acceptor_waiting = 1;
+    if (header.accept_seq.load() == seq && !m_shutdown) {
+      shm::Wait(header.accept_seq, seq, shm::kPollMs);
+    }
+    header.acceptor_waiting = 0;
+  }
+}
@@ -0,0 +1,89 @@
+// Copyright (c) FIRST and other WPILib contributors.
+// Open Source Software; you can modify and/or share it under the terms of
+// the WPILib BSD license file in the root directory of this project.
+
+#include "wpi/SharedMemoryConnector.h"
+
+#include <chrono>
+#include <utility>
+
+#include "SharedMemoryRegion.h"
+#include "wpi/Logger.h"
+#include "wpi/SharedMemoryStream.h"
+
+using namespace wpi;
+
+static void ResetRing(shm::Ring& ring) {
+  ring.head = 0;
+  ring.tail = 0;
+  ring.reader_waiting = 0;
+  ring.writer_waiting = 0;
+}
+
+// A slot left behind by a client that exited without closing
+static bool Reclaimable(const shm::Slot& slot, uint32_t state) {
+  if (state != shm::kRequested && state != shm::kConnected) {
+    return false;
+  }
+  if (shm::ProcessAlive(slot.client_pid.load())) {
+    return false;
+  }
+  return state == shm::kRequested ||
+         (slot.closed.load() & shm::kServerClosed) != 0;
+}
+
+std::unique_ptr<NetworkStream> SharedMemoryConnector::connect(
+    const char* name, Logger& logger, int timeout) {
+  auto mapping = shm::Mapping::Open(name, logger);
+  if (!mapping) {
+    return nullptr;
+  }
+  auto& header = mapping->header();
+  if (header.listening.load() == 0 ||
+      !shm::ProcessAlive(header.server_pid.load())) {
+    WPI_ERROR(logger, "no server listening on shared memory region '"
+                          << name << "'");
+    return nullptr;
+  }
+
+  for (size_t i = 0; i < shm::kNumSlots; ++i) {
+    auto& slot = header.slots[i];
+    uint32_t state = slot.state.load();
+    if (state != shm::kFree && !Reclaimable(slot, state)) {
+      continue;
+    }
+    if (!slot.state.compare_exchange_strong(state, shm::kClaimed)) {
+      continue;
+    }
+    slot.client_pid = shm::CurrentPid();
+    slot.closed = 0;
+    ResetRing(slot.to_server);
+    ResetRing(slot.to_client);
+    slot.state = shm::kRequested;
+    shm::Notify(header.accept_seq, header.acceptor_waiting);
+
+    // wait for the server to accept
+    auto deadline = std::chrono::steady_clock::now() +
+                    std::chrono::seconds(timeout > 0 ? timeout : 1);
+    while (slot.state.load() == shm::kRequested &&
+           std::chrono::steady_clock::now() < deadline &&
+           header.listening.load() != 0 &&
+           shm::ProcessAlive(header.server_pid.load())) {
+      shm::Wait(slot.state, shm::kRequested, shm::kPollMs);
+    }
+
+    // withdraw the request unless the server accepted it in the meantime
+    state = shm::kRequested;
+    if (slot.state.compare_exchange_strong(state, shm::kFree)) {
+      WPI_ERROR(logger, "timed out connecting to shared memory region '"
+                            << name << "'");
+      return nullptr;
+    }
+    return std::unique_ptr<NetworkStream>(
+        new SharedMemoryStream(std::move(mapping), i, false));
+  }
+
+  WPI_ERROR(logger, "no free connection slots in shared memory region '"
+                        << name << "'");
+  return nullptr;
+}
@@ -0,0 +1,119 @@
+// Copyright (c) FIRST and other WPILib contributors.
+// Open Source Software; you can modify and/or share it under the terms of
+// the WPILib BSD license file in the root directory of this project.
+
+#ifndef WPIUTIL_SHAREDMEMORYREGION_H_
+#define WPIUTIL_SHAREDMEMORYREGION_H_
+
+#include <stdint.h>
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <string>
+
+#include "wpi/StringRef.h"
+
+namespace wpi {
+class Logger;
+}  // namespace wpi
+
+// Layout of the shared memory region used by SharedMemoryAcceptor,
+// SharedMemoryConnector, and SharedMemoryStream.  The server creates the
+// region; clients claim a connection slot in it.  Each slot has a single
+// producer, single consumer byte ring in each direction.  Waiting is done
+// with futexes on sequence words that are bumped on every change.
+
+namespace wpi::shm {
+
+constexpr uint32_t kMagic = 0x5750534d;  // "WPSM"
+constexpr uint32_t kVersion = 1;
+constexpr size_t kNumSlots = 8;
+constexpr size_t kRingSize = 256 * 1024;  // must be a power of 2
+
+// Time between checks that the peer process is still alive
+constexpr int kPollMs = 250;
+
+enum SlotState : uint32_t { kFree = 0, kClaimed, kRequested, kConnected };
+constexpr uint32_t kServerClosed = 1;
+constexpr uint32_t kClientClosed = 2;
+
+static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t),
+              "futex words must be plain 32-bit integers");
+
+struct Ring {
+  // written by the producer
+  alignas(64) std::atomic<uint32_t> head;  // total bytes written
+  std::atomic<uint32_t> read_seq;          // bumped on write or close
+  std::atomic<uint32_t> reader_waiting;
+  // written by the consumer
+  alignas(64) std::atomic<uint32_t> tail;  // total bytes read
+  std::atomic<uint32_t> write_seq;         // bumped on read or close
+  std::atomic<uint32_t> writer_waiting;
+  alignas(64) char data[kRingSize];
+};
+
+struct Slot {
+  alignas(64) std::atomic<uint32_t> state;
+  std::atomic<uint32_t> closed;
+  std::atomic<uint32_t> client_pid;
+  Ring to_server;
+  Ring to_client;
+};
+
+struct Header {
+  uint32_t magic;
+  uint32_t version;
+  std::atomic<uint32_t> server_pid;
+  std::atomic<uint32_t> listening;
+  std::atomic<uint32_t> accept_seq;  // bumped when a slot is requested
+  std::atomic<uint32_t> acceptor_waiting;
+  Slot slots[kNumSlots];
+};
+
+// A mapping of the region.  Shared by the acceptor or connector and the
+// streams created from it.
+class Mapping {
+ public:
+  // Create the region for a server.  Fails if another live server has it.
+  static std::shared_ptr<Mapping> Create(StringRef name, Logger& logger);
+  // Open an existing region as a client.
+  static std::shared_ptr<Mapping> Open(StringRef name, Logger& logger);
+
+  Mapping(const Mapping&) = delete;
+  Mapping& operator=(const Mapping&) = delete;
+  ~Mapping();
+
+  Header& header() { return *m_header; }
+  StringRef name() const { return m_name; }
+
+ private:
+  Mapping() = default;
+
+  Header* m_header = nullptr;
+  std::string m_name;
+  std::string m_path;
+  bool m_owner = false;
+  uint64_t m_dev = 0;
+  uint64_t m_ino = 0;
+};
+
+// Futex operations.  Wait returns false on timeout.
+bool Wait(std::atomic<uint32_t>& word, uint32_t value, int timeout_ms);
+void WakeAll(std::atomic<uint32_t>& word);
+
+// Bump a sequence word and wake its waiter (if any)
+inline void Notify(std::atomic<uint32_t>& seq,
+                   std::atomic<uint32_t>& waiting) {
+  seq.fetch_add(1);
+  if (waiting.load() != 0) {
+    WakeAll(seq);
+  }
+}
+
+uint32_t CurrentPid();
+bool ProcessAlive(uint32_t pid);
+
+}  // namespace wpi::shm
+
+#endif  // WPIUTIL_SHAREDMEMORYREGION_H_
@@ -0,0 +1,357 @@
+// Copyright (c) FIRST and other WPILib contributors.
+// Open Source Software; you can modify and/or share it under the terms of
+// the WPILib BSD license file in the root directory of this project.
+
+#include "wpi/SharedMemoryStream.h"
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <linux/futex.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <utility>
+
+#include "SharedMemoryRegion.h"
+#include "wpi/Logger.h"
+#include "wpi/Twine.h"
+
+using namespace wpi;
+
+namespace wpi::shm {
+
+#ifdef __linux__
+
+static std::string RegionPath(StringRef name) {
+  std::string path = "/dev/shm/wpi-";
+  for (char ch : name) {
+    path += ch == '/' ? '_' : ch;
+  }
+  return path;
+}
+
+static Header* MapRegion(int fd) {
+  void* addr = mmap(nullptr, sizeof(Header), PROT_READ | PROT_WRITE,
+                    MAP_SHARED, fd, 0);
+  return addr == MAP_FAILED ? nullptr : static_cast<Header*>(addr);
+}
+
+std::shared_ptr<Mapping> Mapping::Create(StringRef name, Logger& logger) {
+  std::shared_ptr<Mapping> mapping{new Mapping};
+  mapping->m_name = name;
+  mapping->m_path = RegionPath(name);
+  const char* path = mapping->m_path.c_str();
+
+  int fd = -1;
+  for (int attempt = 0; attempt < 2; ++attempt) {
+    fd = ::open(path, O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, 0666);
+    if (fd >= 0 || errno != EEXIST) {
+      break;
+    }
+    // take over the region if its server has exited
+    int old_fd = ::open(path, O_RDWR | O_CLOEXEC);
+    if (old_fd >= 0) {
+      struct stat st;
+      Header* old = nullptr;
+      if (fstat(old_fd, &st) == 0 &&
+          static_cast<size_t>(st.st_size) >= sizeof(Header)) {
+        old = MapRegion(old_fd);
+      }
+      ::close(old_fd);
+      bool in_use = old && old->listening.load() != 0 &&
+                    ProcessAlive(old->server_pid.load());
+      if (old) {
+        munmap(old, sizeof(Header));
+      }
+      if (in_use) {
+        WPI_ERROR(logger, "shared memory region '" << name << "' is in use");
+        return nullptr;
+      }
+    }
+    ::unlink(path);
+  }
+  if (fd < 0) {
+    WPI_ERROR(logger, "could not create " << path << ": "
+                                          << std::strerror(errno));
+    return nullptr;
+  }
+
+  struct stat st;
+  if (ftruncate(fd, sizeof(Header)) != 0 || fstat(fd, &st) != 0 ||
+      !(mapping->m_header = MapRegion(fd))) {
+    WPI_ERROR(logger, "could not map " << path << ": "
+                                       << std::strerror(errno));
+    ::close(fd);
+    ::unlink(path);
+    return nullptr;
+  }
+  ::close(fd);
+  mapping->m_owner = true;
+  mapping->m_dev = st.st_dev;
+  mapping->m_ino = st.st_ino;
+
+  // the new file is zero filled, so all slots start free
+  Header& header = mapping->header();
+  header.magic = kMagic;
+  header.version = kVersion;
+  header.server_pid = CurrentPid();
+  return mapping;
+}
+
+std::shared_ptr<Mapping> Mapping::Open(StringRef name, Logger& logger) {
+  std::shared_ptr<Mapping> mapping{new Mapping};
+  mapping->m_name = name;
+  mapping->m_path = RegionPath(name);
+  const char* path = mapping->m_path.c_str();
+
+  int fd = ::open(path, O_RDWR | O_CLOEXEC);
+  if (fd < 0) {
+    WPI_ERROR(logger, "could not open " << path << ": "
+                                        << std::strerror(errno));
+    return nullptr;
+  }
+  struct stat st;
+  if (fstat(fd, &st) != 0 ||
+      static_cast<size_t>(st.st_size) < sizeof(Header) ||
+      !(mapping->m_header = MapRegion(fd))) {
+    WPI_ERROR(logger, "could not map " << path);
+    ::close(fd);
+    return nullptr;
+  }
+  ::close(fd);
+
+  Header& header = mapping->header();
+  if (header.magic != kMagic || header.version != kVersion) {
+    WPI_ERROR(logger, path << " is not a compatible shared memory region");
+    return nullptr;
+  }
+  return mapping;
+}
+
+Mapping::~Mapping() {
+  if (m_header) {
+    munmap(m_header, sizeof(Header));
+  }
+  // don't remove a region created by a later server with the same name
+  struct stat st;
+  if (m_owner && ::stat(m_path.c_str(), &st) == 0 && st.st_dev == m_dev &&
+      st.st_ino == m_ino) {
+    ::unlink(m_path.c_str());
+  }
+}
+
+bool Wait(std::atomic<uint32_t>& word, uint32_t value, int timeout_ms) {
+  struct timespec ts;
+  ts.tv_sec = timeout_ms / 1000;
+  ts.tv_nsec = (timeout_ms % 1000) * 1000000L;
+  long rv = syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word), FUTEX_WAIT,
+                    value, &ts, nullptr, 0);
+  return rv == 0 || errno != ETIMEDOUT;
+}
+
+void WakeAll(std::atomic<uint32_t>& word) {
+  syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word), FUTEX_WAKE, INT32_MAX,
+          nullptr, nullptr, 0);
+}
+
+uint32_t CurrentPid() {
+  return static_cast<uint32_t>(getpid());
+}
+
+bool ProcessAlive(uint32_t pid) {
+  return pid != 0 && (kill(static_cast<pid_t>(pid), 0) == 0 || errno == EPERM);
+}
+
+#else
+
+std::shared_ptr<Mapping> Mapping::Create(StringRef, Logger& logger) {
+  WPI_ERROR(logger, "shared memory streams are only supported on Linux");
+  return nullptr;
+}
+
+std::shared_ptr<Mapping> Mapping::Open(StringRef, Logger& logger) {
+  WPI_ERROR(logger, "shared memory streams are only supported on Linux");
+  return nullptr;
+}
+
+Mapping::~Mapping() {}
+
+bool Wait(std::atomic<uint32_t>&, uint32_t, int) {
+  return false;
+}
+
+void WakeAll(std::atomic<uint32_t>&) {}
+
+uint32_t CurrentPid() {
+  return 0;
+}
+
+bool ProcessAlive(uint32_t) {
+  return false;
+}
+
+#endif
+
+}  // namespace wpi::shm
+
+static void CopyIn(shm::Ring& ring, uint32_t pos, const char* buf,
+                   size_t len) {
+  size_t offset = pos & (shm::kRingSize - 1);
+  size_t first = (std::min)(len, shm::kRingSize - offset);
+  std::memcpy(ring.data + offset, buf, first);
+  std::memcpy(ring.data, buf + first, len - first);
+}
+
+static void CopyOut(const shm::Ring& ring, uint32_t pos, char* buf,
+                    size_t len) {
+  size_t offset = pos & (shm::kRingSize - 1);
+  size_t first = (std::min)(len, shm::kRingSize - offset);
+  std::memcpy(buf, ring.data + offset, first);
+  std::memcpy(buf + first, ring.data, len - first);
+}
+
+SharedMemoryStream::SharedMemoryStream(std::shared_ptr<shm::Mapping> mapping,
+                                       size_t slot, bool server)
+    : m_mapping(std::move(mapping)),
+      m_slot(&m_mapping->header().slots[slot]),
+      m_in(server ? &m_slot->to_server : &m_slot->to_client),
+      m_out(server ? &m_slot->to_client : &m_slot->to_server),
+      m_server(server),
+      m_peerPid(server ? m_slot->client_pid.load()
+                       : m_mapping->header().server_pid.load()),
+      m_peerName(("shm:" + Twine(m_mapping->name())).str()) {}
+
+SharedMemoryStream::~SharedMemoryStream() {
+  close();
+}
+
+bool SharedMemoryStream::IsClosed() const {
+  return m_closed || m_slot->closed.load() != 0;
+}
+
+void SharedMemoryStream::WaitFor(std::atomic<uint32_t>& seq,
+                                 std::atomic<uint32_t>& waiting,
+                                 std::atomic<uint32_t>& pos, uint32_t value,
+                                 int timeout_ms) {
+  // the waiting flag must be visible before the recheck; the other side
+  // updates pos, then bumps seq, then checks the flag
+  waiting.store(1);
+  uint32_t s = seq.load();
+  if (pos.load() == value && !IsClosed()) {
+    if (!shm::Wait(seq, s, timeout_ms) && !shm::ProcessAlive(m_peerPid)) {
+      close();
+    }
+  }
+  waiting.store(0);
+}
+
+size_t SharedMemoryStream::send(const char* buffer, size_t len, Error* err) {
+  size_t sent = 0;
+  while (sent < len) {
+    if (IsClosed()) {
+      *err = kConnectionClosed;
+      return 0;
+    }
+    uint32_t head = m_out->head.load(std::memory_order_relaxed);
+    uint32_t tail = m_out->tail.load(std::memory_order_acquire);
+    size_t space = shm::kRingSize - (head - tail);
+    if (space == 0) {
+      WaitFor(m_out->write_seq, m_out->writer_waiting, m_out->tail, tail,
+              shm::kPollMs);
+      continue;
+    }
+    size_t n = (std::min)(space, len - sent);
+    CopyIn(*m_out, head, buffer + sent, n);
+    m_out->head.store(head + static_cast<uint32_t>(n));
+    shm::Notify(m_out->read_seq, m_out->reader_waiting);
+    sent += n;
+  }
+  return len;
+}
+
+size_t SharedMemoryStream::receive(char* buffer, size_t len, Error* err,
+                                   int timeout) {
+  auto deadline =
+      std::chrono::steady_clock::now() + std::chrono::seconds(timeout);
+  for (;;) {
+    if (m_closed) {
+      *err = kConnectionClosed;
+      return 0;
+    }
+    // deliver anything the peer wrote before it closed
+    uint32_t tail = m_in->tail.load(std::memory_order_relaxed);
+    uint32_t head = m_in->head.load(std::memory_order_acquire);
+    if (head != tail) {
+      size_t n = (std::min)(static_cast<size_t>(head - tail), len);
+      CopyOut(*m_in, tail, buffer, n);
+      m_in->tail.store(tail + static_cast<uint32_t>(n));
+      shm::Notify(m_in->write_seq, m_in->writer_waiting);
+      return n;
+    }
+    if (IsClosed()) {
+      *err = kConnectionClosed;
+      return 0;
+    }
+    int wait_ms = shm::kPollMs;
+    if (timeout > 0) {
+      auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(
+                           deadline - std::chrono::steady_clock::now())
+                           .count();
+      if (remaining <= 0) {
+        *err = kConnectionTimedOut;
+        return 0;
+      }
+      wait_ms = static_cast<int>((std::min)(remaining, int64_t{wait_ms}));
+    }
+    WaitFor(m_in->read_seq, m_in->reader_waiting, m_in->head, tail, wait_ms);
+  }
+}
+
+void SharedMemoryStream::close() {
+  if (m_closed.exchange(true)) {
+    return;
+  }
+  uint32_t mine = m_server ? shm::kServerClosed : shm::kClientClosed;
+  uint32_t closed = m_slot->closed.fetch_or(mine) | mine;
+
+  // wake both sides of both rings, including other threads of this process
+  for (shm::Ring* ring : {m_in, m_out}) {
+    ring->read_seq.fetch_add(1);
+    shm::WakeAll(ring->read_seq);
+    ring->write_seq.fetch_add(1);
+    shm::WakeAll(ring->write_seq);
+  }
+
+  // whichever side closes last (or outlives the other) frees the slot
+  if (closed == (shm::kServerClosed | shm::kClientClosed) ||
+      !shm::ProcessAlive(m_peerPid)) {
+    m_slot->state.store(shm::kFree);
+  }
+}
+
+StringRef SharedMemoryStream::getPeerIP() const {
+  return m_peerName;
+}
+
+int SharedMemoryStream::getPeerPort() const {
+  return static_cast<int>(m_peerPid);
+}
+
+void SharedMemoryStream::setNoDelay() {}
+
+bool SharedMemoryStream::setBlocking(bool enabled) {
+  // only blocking operation is supported
+  return enabled;
+}
+
+int SharedMemoryStream::getNativeHandle() const {
+  return -1;
+}
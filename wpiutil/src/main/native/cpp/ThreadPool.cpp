@@ -0,0 +1,210 @@
+// Copyright (c) FIRST and other WPILib contributors.
+// Open Source Software; you can modify and/or share it under the terms of
+// the WPILib BSD license file in the root directory of this project.
+
+#include "wpi/ThreadPool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "wpi/MpmcQueue.h"
+#include "wpi/condition_variable.h"
+#include "wpi/mutex.h"
+
+using namespace wpi;
+
+namespace {
+
+using Task = std::function<void()>;
+
+// Tasks posted from outside the pool beyond this many go onto the worker
+// queues instead
+constexpr size_t kSharedQueueSize = 1024;
+
+struct Worker {
+  explicit Worker(size_t index_) : index{index_} {}
+
+  size_t index;
+  // The owning thread pushes and pops at the back; other threads steal from
+  // the front.  The lock is rarely contended, as it is only shared while
+  // stealing.
+  wpi::mutex mutex;
+  std::deque<Task> tasks;
+  std::thread thread;
+};
+
+}  // namespace
+
+class ThreadPool::Impl {
+ public:
+  explicit Impl(unsigned int numThreads);
+
+  unsigned int GetNumThreads() const { return m_workers.size(); }
+  void Post(Task task);
+  bool RunPendingTask();
+  void Stop();
+
+ private:
+  bool RunPendingTask(Worker* self);
+  bool PopLocal(Worker& worker, Task& task);
+  bool Steal(Worker* self, Task& task);
+  void Main(Worker* self);
+
+  MpmcQueue<Task> m_shared{kSharedQueueSize};
+  std::vector<std::unique_ptr<Worker>> m_workers;
+
+  // Tasks posted but not yet started.  Incremented before a task is queued,
+  // so a thread that sees 0 knows there is nothing to find.
+  std::atomic<size_t> m_queued{0};
+  std::atomic<size_t> m_nextWorker{0};
+
+  // The counts are sequentially consistent so that either a posting thread
+  // sees a sleeping thread and wakes it, or the sleeping thread sees the
+  // posted task before it waits.
+  wpi::mutex m_sleepMutex;
+  wpi::condition_variable m_sleepCv;
+  std::atomic<unsigned int> m_sleeping{0};
+  std::atomic_bool m_stop{false};
+
+  // The pool and worker of the current thread, if it is a pool thread
+  static thread_local Impl* tPool;
+  static thread_local Worker* tWorker;
+};
+
+thread_local ThreadPool::Impl* ThreadPool::Impl::tPool = nullptr;
+thread_local Worker* ThreadPool::Impl::tWorker = nullptr;
+
+ThreadPool::Impl::Impl(unsigned int numThreads) {
+  if (numThreads == 0) {
+    numThreads = (std::max)(1u, std::thread::hardware_concurrency());
+  }
+  m_workers.reserve(numThreads);
+  for (unsigned int i = 0; i < numThreads; ++i) {
+    m_workers.emplace_back(std::make_unique<Worker>(i));
+  }
+  // start the threads once all of the workers exist, as they steal from
+  // each other
+  for (auto&& worker : m_workers) {
+    worker->thread = std::thread{[this, w = worker.get()] { Main(w); }};
+  }
+}
+
+void ThreadPool::Impl::Post(Task task) {
+  ++m_queued;
+  if (tPool == this) {
+    std::scoped_lock lock(tWorker->mutex);
+    tWorker->tasks.emplace_back(std::move(task));
+  } else if (!m_shared.try_push(std::move(task))) {
+    // the shared queue is full; spread the overflow across the workers
+    auto& worker = *m_workers[m_nextWorker.fetch_add(
+                                  1, std::memory_order_relaxed) %
+                              m_workers.size()];
+    std::scoped_lock lock(worker.mutex);
+    worker.tasks.emplace_back(std::move(task));
+  }
+  if (m_sleeping > 0) {
+    std::scoped_lock lock(m_sleepMutex);
+    m_sleepCv.notify_one();
+  }
+}
+
+bool ThreadPool::Impl::RunPendingTask() {
+  return RunPendingTask(tPool == this ? tWorker : nullptr);
+}
+
+bool ThreadPool::Impl::RunPendingTask(Worker* self) {
+  Task task;
+  if ((self && PopLocal(*self, task)) || m_shared.try_pop(task) ||
+      Steal(self, task)) {
+    --m_queued;
+    task();
+    return true;
+  }
+  return false;
+}
+
+bool ThreadPool::Impl::PopLocal(Worker& worker, Task& task) {
+  std::scoped_lock lock(worker.mutex);
+  if (worker.tasks.empty()) {
+    return false;
+  }
+  task = std::move(worker.tasks.back());
+  worker.tasks.pop_back();
+  return true;
+}
+
+bool ThreadPool::Impl::Steal(Worker* self, Task& task) {
+  size_t n = m_workers.size();
+  size_t start = self ? self->index + 1 : 0;
+  for (size_t i = 0; i < n; ++i) {
+    auto& victim = *m_workers[(start + i) % n];
+    if (&victim == self) {
+      continue;
+    }
+    std::scoped_lock lock(victim.mutex);
+    if (!victim.tasks.empty()) {
+      task = std::move(victim.tasks.front());
+      victim.tasks.pop_front();
+      return true;
+    }
+  }
+  return false;
+}
+
+void ThreadPool::Impl::Main(Worker* self) {
+  tPool = this;
+  tWorker = self;
+  for (;;) {
+    if (RunPendingTask(self)) {
+      continue;
+    }
+    if (m_queued != 0) {
+      // a task is being queued but is not visible yet
+      std::this_thread::yield();
+      continue;
+    }
+    std::unique_lock lock(m_sleepMutex);
+    if (m_stop && m_queued == 0) {
+      break;
+    }
+    ++m_sleeping;
+    m_sleepCv.wait(lock, [&] { return m_queued != 0 || m_stop; });
+    --m_sleeping;
+  }
+  tPool = nullptr;
+  tWorker = nullptr;
+}
+
+void ThreadPool::Impl::Stop() {
+  {
+    std::scoped_lock lock(m_sleepMutex);
+    m_stop = true;
+  }
+  m_sleepCv.notify_all();
+  for (auto&& worker : m_workers) {
+    worker->thread.join();
+  }
+}
+
+ThreadPool::ThreadPool(unsigned int numThreads)
+    : m_impl{std::make_unique<Impl>(numThreads)} {}
+
+ThreadPool::~ThreadPool() {
+  m_impl->Stop();
+}
+
+unsigned int ThreadPool::GetNumThreads() const {
+  return m_impl->GetNumThreads();
+}
+
+void ThreadPool::Post(std::function<void()> task) {
+  m_impl->Post(std::move(task));
+}
+
+bool ThreadPool::RunPendingTask() {
+  return m_impl->RunPendingTask();
+}
@@ -113,6 +113,14 @@ int UDPClient::start(int port) {
     WPI_ERROR(m_logger, "bind() failed: " << SocketStrerror());
     return result;
   }
+  if (port == 0) {
+    // find the ephemeral port chosen by bind()
+    socklen_t addr_len = sizeof(addr);
+    if (getsockname(m_lsd, reinterpret_cast<sockaddr*>(&addr), &addr_len) ==
+        0) {
+      port = ntohs(addr.sin_port);
+    }
+  }
   m_port = port;
   return 0;
 }
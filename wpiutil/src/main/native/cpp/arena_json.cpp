@@ -0,0 +1,167 @@
+// Copyright (c) FIRST and other WPILib contributors.
+// Open Source Software; you can modify and/or share it under the terms of
+// the WPILib BSD license file in the root directory of this project.
+
+#define WPI_JSON_IMPLEMENTATION
+#include "wpi/arena_json.h"
+
+#include <new>
+
+using namespace wpi;
+
+size_t arena_json::size() const noexcept {
+  switch (m_type) {
+    case value_t::null:
+      return 0;
+    case value_t::array:
+    case value_t::object:
+      return m_size;
+    default:
+      return 1;
+  }
+}
+
+const arena_json& arena_json::at(size_t idx) const {
+  if (!is_array()) {
+    JSON_THROW(json::type_error::create(
+        304, "cannot use at() with " + Twine(type_name())));
+  }
+  if (idx >= m_size) {
+    JSON_THROW(json::out_of_range::create(
+        401, "array index " + Twine(idx) + " is out of range"));
+  }
+  return m_value.array[idx];
+}
+
+const arena_json& arena_json::at(StringRef key) const {
+  if (!is_object()) {
+    JSON_THROW(json::type_error::create(
+        304, "cannot use at() with " + Twine(type_name())));
+  }
+  auto value = find(key);
+  if (!value) {
+    JSON_THROW(
+        json::out_of_range::create(403, "key '" + Twine(key) + "' not found"));
+  }
+  return *value;
+}
+
+const arena_json* arena_json::find(StringRef key) const noexcept {
+  for (auto&& member : members()) {
+    if (member.key == key) {
+      return &member.value;
+    }
+  }
+  return nullptr;
+}
+
+const char* arena_json::type_name() const noexcept {
+  switch (m_type) {
+    case value_t::null:
+      return "null";
+    case value_t::object:
+      return "object";
+    case value_t::array:
+      return "array";
+    case value_t::string:
+      return "string";
+    case value_t::boolean:
+      return "boolean";
+    case value_t::discarded:
+      return "discarded";
+    default:
+      return "number";
+  }
+}
+
+void arena_json::ThrowTypeError(const char* expected) const {
+  JSON_THROW(json::type_error::create(
+      302, "type must be " + Twine(expected) + ", but is " + type_name()));
+}
+
+json arena_json::to_json() const {
+  switch (m_type) {
+    case value_t::object: {
+      json j(value_t::object);
+      for (auto&& member : members()) {
+        j.m_value.object->try_emplace(member.key, member.value.to_json());
+      }
+      return j;
+    }
+    case value_t::array: {
+      json j(value_t::array);
+      j.m_value.array->reserve(m_size);
+      for (auto&& element : elements()) {
+        j.m_value.array->emplace_back(element.to_json());
+      }
+      return j;
+    }
+    case value_t::string:
+      return json(StringRef(m_value.string, m_size));
+    case value_t::boolean:
+      return json(m_value.boolean);
+    case value_t::number_integer:
+      return json(m_value.number_integer);
+    case value_t::number_unsigned:
+      return json(m_value.number_unsigned);
+    case value_t::number_float:
+      return json(m_value.number_float);
+    case value_t::discarded:
+      return json(value_t::discarded);
+    default:
+      return json();
+  }
+}
+
+const arena_json& arena_json::from_json(const json& j, Arena& arena) {
+  auto result = arena.Create<arena_json>();
+  result->assign(j, arena);
+  return *result;
+}
+
+void arena_json::assign(const json& j, Arena& arena) {
+  m_type = j.type();
+  switch (j.type()) {
+    case value_t::object: {
+      auto& obj = *j.m_value.object;
+      auto members = arena.Allocate<member>(obj.size());
+      m_size = obj.size();
+      m_value.object = members;
+      for (auto&& kv : obj) {
+        auto m = new (members++) member{arena.CopyString(kv.getKey()), {}};
+        m->value.assign(kv.second, arena);
+      }
+      break;
+    }
+    case value_t::array: {
+      auto& arr = *j.m_value.array;
+      auto elements = arena.Allocate<arena_json>(arr.size());
+      m_size = arr.size();
+      m_value.array = elements;
+      for (auto&& element : arr) {
+        (new (elements++) arena_json)->assign(element, arena);
+      }
+      break;
+    }
+    case value_t::string: {
+      StringRef str = arena.CopyString(*j.m_value.string);
+      m_size = str.size();
+      m_value.string = str.data();
+      break;
+    }
+    case value_t::boolean:
+      m_value.boolean = j.m_value.boolean;
+      break;
+    case value_t::number_integer:
+      m_value.number_integer = j.m_value.number_integer;
+      break;
+    case value_t::number_unsigned:
+      m_value.number_unsigned = j.m_value.number_unsigned;
+      break;
+    case value_t::number_float:
+      m_value.number_float = j.m_value.number_float;
+      break;
+    default:
+      break;
+  }
+}
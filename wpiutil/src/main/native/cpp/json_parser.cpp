@@ -37,9 +37,13 @@ SOFTWARE.
 #include <clocale>
 #include <cmath>
 #include <cstdlib>
+#include <cstring>
 
 #include "wpi/Format.h"
 #include "wpi/SmallString.h"
+#include "wpi/arena_json.h"
+#include "wpi/json_sax.h"
+#include "wpi/json_simd.h"
 #include "wpi/raw_istream.h"
 #include "wpi/raw_ostream.h"
 
@@ -634,6 +638,23 @@ json::lexer::token_type json::lexer::scan_string()
 
     while (true)
     {
+        // copy runs of plain characters at once
+        if (unget_chars.empty())
+        {
+            StringRef buf = is.peek_buffer();
+            std::size_t n = detail::json_plain_prefix(buf.data(), buf.size());
+            if (n != 0)
+            {
+                std::size_t old_size = token_buffer.size();
+                token_buffer.resize(old_size + n);
+                is.read(&token_buffer[old_size], n);
+                token_string.append(token_buffer.begin() + old_size,
+                                    token_buffer.end());
+                chars_read += n;
+                current = std::char_traits<char>::to_int_type(token_buffer.back());
+            }
+        }
+
         // get next character
         switch (get())
         {
@@ -1959,10 +1980,553 @@ bool json::accept(raw_istream& i)
     return parser(i).accept(true);
 }
 
+////////////////
+// sax parser //
+////////////////
+
+/*!
+@brief syntax analysis generating SAX events
+
+A recursive descent parser like json::parser that reports each token to a
+json_sax handler instead of building a value.
+*/
+class json::sax_parser
+{
+    using lexer_t = json::lexer;
+    using token_type = typename lexer_t::token_type;
+
+  public:
+    sax_parser(raw_istream& s, json_sax* sax) : m_lexer(s), m_sax(sax) {}
+
+    bool parse(const bool strict)
+    {
+        // read first token
+        get_token();
+
+        if (not parse_internal())
+        {
+            return result;
+        }
+
+        // in strict mode, input must be completely read
+        if (strict)
+        {
+            get_token();
+            return expect(token_type::end_of_input);
+        }
+        return true;
+    }
+
+  private:
+    /// parses a value; returns false if parsing should stop
+    bool parse_internal();
+
+    token_type get_token()
+    {
+        return (last_token = m_lexer.scan());
+    }
+
+    bool expect(token_type t)
+    {
+        if (JSON_UNLIKELY(t != last_token))
+        {
+            return error(t);
+        }
+        return true;
+    }
+
+    /// reports a syntax error to the handler; always returns false
+    bool error(token_type expected);
+
+    lexer_t m_lexer;
+    json_sax* m_sax;
+    token_type last_token = token_type::uninitialized;
+    /// return value of sax_parse() when parsing stops early
+    bool result = false;
+};
+
+bool json::sax_parser::parse_internal()
+{
+    switch (last_token)
+    {
+        case token_type::begin_object:
+        {
+            if (not m_sax->start_object())
+            {
+                return false;
+            }
+
+            // closing } -> we are done
+            get_token();
+            if (last_token != token_type::end_object)
+            {
+                while (true)
+                {
+                    if (not expect(token_type::value_string))
+                    {
+                        return false;
+                    }
+                    if (not m_sax->key(m_lexer.get_string()))
+                    {
+                        return false;
+                    }
+
+                    get_token();
+                    if (not expect(token_type::name_separator))
+                    {
+                        return false;
+                    }
+
+                    get_token();
+                    if (not parse_internal())
+                    {
+                        return false;
+                    }
+
+                    // comma -> next value
+                    get_token();
+                    if (last_token == token_type::value_separator)
+                    {
+                        get_token();
+                        continue;
+                    }
+
+                    // closing }
+                    if (not expect(token_type::end_object))
+                    {
+                        return false;
+                    }
+                    break;
+                }
+            }
+            return m_sax->end_object();
+        }
+
+        case token_type::begin_array:
+        {
+            if (not m_sax->start_array())
+            {
+                return false;
+            }
+
+            // closing ] -> we are done
+            get_token();
+            if (last_token != token_type::end_array)
+            {
+                while (true)
+                {
+                    if (not parse_internal())
+                    {
+                        return false;
+                    }
+
+                    // comma -> next value
+                    get_token();
+                    if (last_token == token_type::value_separator)
+                    {
+                        get_token();
+                        continue;
+                    }
+
+                    // closing ]
+                    if (not expect(token_type::end_array))
+                    {
+                        return false;
+                    }
+                    break;
+                }
+            }
+            return m_sax->end_array();
+        }
+
+        case token_type::literal_null:
+            return m_sax->null();
+
+        case token_type::literal_true:
+            return m_sax->boolean(true);
+
+        case token_type::literal_false:
+            return m_sax->boolean(false);
+
+        case token_type::value_string:
+            return m_sax->string(m_lexer.get_string());
+
+        case token_type::value_unsigned:
+            return m_sax->number_unsigned(m_lexer.get_number_unsigned());
+
+        case token_type::value_integer:
+            return m_sax->number_integer(m_lexer.get_number_integer());
+
+        case token_type::value_float:
+        {
+            // reject infinity or NAN
+            if (JSON_UNLIKELY(not std::isfinite(m_lexer.get_number_float())))
+            {
+                std::string token = m_lexer.get_token_string();
+                result = m_sax->parse_error(
+                    m_lexer.get_position(), token,
+                    out_of_range::create(406, "number overflow parsing '" +
+                                                  Twine(token) + "'"));
+                return false;
+            }
+            return m_sax->number_float(m_lexer.get_number_float());
+        }
+
+        case token_type::parse_error:
+        {
+            // using "uninitialized" to avoid "expected" message
+            return error(token_type::uninitialized);
+        }
+
+        default:
+        {
+            // the last token was unexpected; we expected a value
+            return error(token_type::literal_or_value);
+        }
+    }
+}
+
+bool json::sax_parser::error(token_type expected)
+{
+    std::string error_msg = "syntax error - ";
+    if (last_token == token_type::parse_error)
+    {
+        error_msg += std::string(m_lexer.get_error_message()) + "; last read: '" +
+                     m_lexer.get_token_string() + "'";
+    }
+    else
+    {
+        error_msg += "unexpected " + std::string(lexer_t::token_type_name(last_token));
+    }
+
+    if (expected != token_type::uninitialized)
+    {
+        error_msg += "; expected " + std::string(lexer_t::token_type_name(expected));
+    }
+
+    result = m_sax->parse_error(
+        m_lexer.get_position(), m_lexer.get_token_string(),
+        json::parse_error::create(101, m_lexer.get_position(), error_msg));
+    return false;
+}
+
+bool json::sax_parse(StringRef s, json_sax* sax, const bool strict)
+{
+    raw_mem_istream is(makeArrayRef(s.data(), s.size()));
+    return sax_parser(is, sax).parse(strict);
+}
+
+bool json::sax_parse(ArrayRef<uint8_t> arr, json_sax* sax, const bool strict)
+{
+    raw_mem_istream is(arr);
+    return sax_parser(is, sax).parse(strict);
+}
+
+bool json::sax_parse(raw_istream& i, json_sax* sax, const bool strict)
+{
+    return sax_parser(i, sax).parse(strict);
+}
+
 raw_istream& operator>>(raw_istream& i, json& j)
 {
     json::parser(i).parse(false, j);
     return i;
 }
 
+//////////////////
+// arena parser //
+//////////////////
+
+/*!
+@brief syntax analysis into an arena
+
+A recursive descent parser like json::parser that builds an arena_json.
+The elements of open arrays and members of open objects are collected on
+stacks (shared by all nesting levels) and copied into the arena as one
+contiguous block when the array or object is closed.
+*/
+class arena_json::parser
+{
+    using lexer_t = json::lexer;
+    using token_type = typename lexer_t::token_type;
+
+  public:
+    parser(raw_istream& s, Arena& arena, const bool allow_exceptions_)
+        : m_lexer(s), m_arena(arena), allow_exceptions(allow_exceptions_)
+    {}
+
+    const arena_json& parse()
+    {
+        arena_json* result = m_arena.Create<arena_json>();
+
+        // read first token
+        get_token();
+
+        // input must be completely read
+        if (parse_internal(*result))
+        {
+            get_token();
+            expect(token_type::end_of_input);
+        }
+
+        if (errored)
+        {
+            result->m_type = value_t::discarded;
+        }
+        return *result;
+    }
+
+  private:
+    /// parses a value into result; returns false on a syntax error
+    bool parse_internal(arena_json& result);
+
+    token_type get_token()
+    {
+        return (last_token = m_lexer.scan());
+    }
+
+    bool expect(token_type t)
+    {
+        if (JSON_UNLIKELY(t != last_token))
+        {
+            errored = true;
+            expected = t;
+            if (allow_exceptions)
+            {
+                throw_exception();
+            }
+            return false;
+        }
+        return true;
+    }
+
+    [[noreturn]] void throw_exception() const;
+
+    template <typename T>
+    const T* copy_to_arena(SmallVectorImpl<T>& stack, size_t start)
+    {
+        size_t count = stack.size() - start;
+        if (count == 0)
+        {
+            return nullptr;
+        }
+        T* data = m_arena.Allocate<T>(count);
+        std::memcpy(static_cast<void*>(data), &stack[start], count * sizeof(T));
+        stack.resize(start);
+        return data;
+    }
+
+    lexer_t m_lexer;
+    Arena& m_arena;
+    /// elements of the arrays being parsed
+    SmallVector<arena_json, 64> m_elements;
+    /// members of the objects being parsed
+    SmallVector<arena_json_member, 32> m_members;
+    token_type last_token = token_type::uninitialized;
+    bool errored = false;
+    token_type expected = token_type::uninitialized;
+    const bool allow_exceptions = true;
+};
+
+bool arena_json::parser::parse_internal(arena_json& result)
+{
+    switch (last_token)
+    {
+        case token_type::begin_object:
+        {
+            size_t start = m_members.size();
+
+            // closing } -> we are done
+            get_token();
+            if (last_token != token_type::end_object)
+            {
+                while (true)
+                {
+                    if (not expect(token_type::value_string))
+                    {
+                        return false;
+                    }
+                    StringRef key = m_arena.CopyString(m_lexer.get_string());
+
+                    get_token();
+                    if (not expect(token_type::name_separator))
+                    {
+                        return false;
+                    }
+
+                    // parse into a local, as nested objects use the stack
+                    arena_json value;
+                    get_token();
+                    if (not parse_internal(value))
+                    {
+                        return false;
+                    }
+                    m_members.push_back({key, value});
+
+                    // comma -> next value
+                    get_token();
+                    if (last_token == token_type::value_separator)
+                    {
+                        get_token();
+                        continue;
+                    }
+
+                    // closing }
+                    if (not expect(token_type::end_object))
+                    {
+                        return false;
+                    }
+                    break;
+                }
+            }
+
+            result.m_type = value_t::object;
+            result.m_size = m_members.size() - start;
+            result.m_value.object = copy_to_arena(m_members, start);
+            return true;
+        }
+
+        case token_type::begin_array:
+        {
+            size_t start = m_elements.size();
+
+            // closing ] -> we are done
+            get_token();
+            if (last_token != token_type::end_array)
+            {
+                while (true)
+                {
+                    arena_json value;
+                    if (not parse_internal(value))
+                    {
+                        return false;
+                    }
+                    m_elements.push_back(value);
+
+                    // comma -> next value
+                    get_token();
+                    if (last_token == token_type::value_separator)
+                    {
+                        get_token();
+                        continue;
+                    }
+
+                    // closing ]
+                    if (not expect(token_type::end_array))
+                    {
+                        return false;
+                    }
+                    break;
+                }
+            }
+
+            result.m_type = value_t::array;
+            result.m_size = m_elements.size() - start;
+            result.m_value.array = copy_to_arena(m_elements, start);
+            return true;
+        }
+
+        case token_type::literal_null:
+        {
+            result.m_type = value_t::null;
+            return true;
+        }
+
+        case token_type::value_string:
+        {
+            StringRef str = m_arena.CopyString(m_lexer.get_string());
+            result.m_type = value_t::string;
+            result.m_size = str.size();
+            result.m_value.string = str.data();
+            return true;
+        }
+
+        case token_type::literal_true:
+        case token_type::literal_false:
+        {
+            result.m_type = value_t::boolean;
+            result.m_value.boolean = last_token == token_type::literal_true;
+            return true;
+        }
+
+        case token_type::value_unsigned:
+        {
+            result.m_type = value_t::number_unsigned;
+            result.m_value.number_unsigned = m_lexer.get_number_unsigned();
+            return true;
+        }
+
+        case token_type::value_integer:
+        {
+            result.m_type = value_t::number_integer;
+            result.m_value.number_integer = m_lexer.get_number_integer();
+            return true;
+        }
+
+        case token_type::value_float:
+        {
+            result.m_type = value_t::number_float;
+            result.m_value.number_float = m_lexer.get_number_float();
+
+            // throw in case of infinity or NAN
+            if (JSON_UNLIKELY(not std::isfinite(result.m_value.number_float)))
+            {
+                if (allow_exceptions)
+                {
+                    JSON_THROW(json::out_of_range::create(406, "number overflow parsing '" +
+                                                    Twine(m_lexer.get_token_string()) + "'"));
+                }
+                return expect(token_type::uninitialized);
+            }
+            return true;
+        }
+
+        case token_type::parse_error:
+        {
+            // using "uninitialized" to avoid "expected" message
+            return expect(token_type::uninitialized);
+        }
+
+        default:
+        {
+            // the last token was unexpected; we expected a value
+            return expect(token_type::literal_or_value);
+        }
+    }
+}
+
+void arena_json::parser::throw_exception() const
+{
+    std::string error_msg = "syntax error - ";
+    if (last_token == token_type::parse_error)
+    {
+        error_msg += std::string(m_lexer.get_error_message()) + "; last read: '" +
+                     m_lexer.get_token_string() + "'";
+    }
+    else
+    {
+        error_msg += "unexpected " + std::string(lexer_t::token_type_name(last_token));
+    }
+
+    if (expected != token_type::uninitialized)
+    {
+        error_msg += "; expected " + std::string(lexer_t::token_type_name(expected));
+    }
+
+    JSON_THROW(json::parse_error::create(101, m_lexer.get_position(), error_msg));
+}
+
+const arena_json& arena_json::parse(StringRef s, Arena& arena,
+                                    bool allow_exceptions)
+{
+    raw_mem_istream is(makeArrayRef(s.data(), s.size()));
+    return parse(is, arena, allow_exceptions);
+}
+
+const arena_json& arena_json::parse(raw_istream& is, Arena& arena,
+                                    bool allow_exceptions)
+{
+    return parser(is, arena, allow_exceptions).parse();
+}
+
 }  // namespace wpi
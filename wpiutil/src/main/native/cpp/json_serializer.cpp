@@ -37,6 +37,7 @@ SOFTWARE.
 #include "wpi/Format.h"
 #include "wpi/SmallString.h"
 #include "wpi/StringExtras.h"
+#include "wpi/json_simd.h"
 #include "wpi/raw_os_ostream.h"
 
 #include "json_serializer.h"
@@ -1339,6 +1340,21 @@ void json::serializer::dump_escaped(StringRef s, const bool ensure_ascii)
 
     for (std::size_t i = 0; i < s.size(); ++i)
     {
+        // copy runs of characters that need no escaping at once
+        if (state == UTF8_ACCEPT)
+        {
+            std::size_t n = detail::json_plain_prefix(s.data() + i, s.size() - i);
+            if (n != 0)
+            {
+                o.write(s.data() + i, n);
+                i += n;
+                if (i == s.size())
+                {
+                    break;
+                }
+            }
+        }
+
         const auto byte = static_cast<uint8_t>(s[i]);
 
         switch (decode(state, codepoint, byte))
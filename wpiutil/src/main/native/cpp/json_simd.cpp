@@ -0,0 +1,223 @@
+// Copyright (c) FIRST and other WPILib contributors.
+// Open Source Software; you can modify and/or share it under the terms of
+// the WPILib BSD license file in the root directory of this project.
+
+#include "wpi/json_simd.h"
+
+#include <stdint.h>
+
+#include <atomic>
+
+#include "wpi/MathExtras.h"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__SSE2__) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define WPI_JSON_X86 1
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#if defined(__GNUC__) || defined(__clang__)
+#define WPI_JSON_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define WPI_JSON_TARGET_AVX2
+#endif
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define WPI_JSON_NEON 1
+#include <arm_neon.h>
+#endif
+
+using namespace wpi::detail;
+
+namespace {
+
+using ScanFunc = size_t (*)(const char*, size_t);
+
+inline bool IsPlain(uint8_t c) {
+  return c >= 0x20 && c < 0x7f && c != '"' && c != '\\';
+}
+
+size_t ScanScalar(const char* s, size_t len) {
+  size_t i = 0;
+  while (i < len && IsPlain(s[i])) {
+    ++i;
+  }
+  return i;
+}
+
+#ifdef WPI_JSON_X86
+size_t ScanSse2(const char* s, size_t len) {
+  const __m128i space = _mm_set1_epi8(0x20);
+  const __m128i del = _mm_set1_epi8(0x7f);
+  const __m128i quote = _mm_set1_epi8('"');
+  const __m128i backslash = _mm_set1_epi8('\\');
+  size_t i = 0;
+  for (; i + 16 <= len; i += 16) {
+    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + i));
+    // as signed bytes, 0x80-0xff are negative, so this also finds them
+    __m128i special = _mm_or_si128(
+        _mm_or_si128(_mm_cmplt_epi8(v, space), _mm_cmpeq_epi8(v, del)),
+        _mm_or_si128(_mm_cmpeq_epi8(v, quote), _mm_cmpeq_epi8(v, backslash)));
+    unsigned int mask = _mm_movemask_epi8(special);
+    if (mask != 0) {
+      return i + wpi::countTrailingZeros(mask, wpi::ZB_Undefined);
+    }
+  }
+  return i + ScanScalar(s + i, len - i);
+}
+
+WPI_JSON_TARGET_AVX2 size_t ScanAvx2(const char* s, size_t len) {
+  const __m256i space = _mm256_set1_epi8(0x20);
+  const __m256i del = _mm256_set1_epi8(0x7f);
+  const __m256i quote = _mm256_set1_epi8('"');
+  const __m256i backslash = _mm256_set1_epi8('\\');
+  size_t i = 0;
+  for (; i + 32 <= len; i += 32) {
+    __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(s + i));
+    // as signed bytes, 0x80-0xff are negative, so this also finds them
+    __m256i special = _mm256_or_si256(
+        _mm256_or_si256(_mm256_cmpgt_epi8(space, v),
+                        _mm256_cmpeq_epi8(v, del)),
+        _mm256_or_si256(_mm256_cmpeq_epi8(v, quote),
+                        _mm256_cmpeq_epi8(v, backslash)));
+    uint32_t mask = static_cast<uint32_t>(_mm256_movemask_epi8(special));
+    if (mask != 0) {
+      return i + wpi::countTrailingZeros(mask, wpi::ZB_Undefined);
+    }
+  }
+  // avoid the AVX to SSE transition penalty in the SSE2 code
+  _mm256_zeroupper();
+  return i + ScanSse2(s + i, len - i);
+}
+
+bool HasAvx2() {
+#if defined(__GNUC__) || defined(__clang__)
+  __builtin_cpu_init();
+  return __builtin_cpu_supports("avx2");
+#elif defined(_MSC_VER)
+  int info[4];
+  __cpuid(info, 0);
+  if (info[0] < 7) {
+    return false;
+  }
+  __cpuid(info, 1);
+  // OSXSAVE and AVX, and the OS saves the YMM registers
+  if ((info[2] & (1 << 27)) == 0 || (info[2] & (1 << 28)) == 0 ||
+      (_xgetbv(0) & 6) != 6) {
+    return false;
+  }
+  __cpuidex(info, 7, 0);
+  return (info[1] & (1 << 5)) != 0;
+#else
+  return false;
+#endif
+}
+#endif  // WPI_JSON_X86
+
+#ifdef WPI_JSON_NEON
+size_t ScanNeon(const char* s, size_t len) {
+  const uint8x16_t space = vdupq_n_u8(0x20);
+  const uint8x16_t del = vdupq_n_u8(0x7f);
+  const uint8x16_t quote = vdupq_n_u8('"');
+  const uint8x16_t backslash = vdupq_n_u8('\\');
+  size_t i = 0;
+  for (; i + 16 <= len; i += 16) {
+    uint8x16_t v = vld1q_u8(reinterpret_cast<const uint8_t*>(s + i));
+    uint8x16_t special =
+        vorrq_u8(vorrq_u8(vcltq_u8(v, space), vcgeq_u8(v, del)),
+                 vorrq_u8(vceqq_u8(v, quote), vceqq_u8(v, backslash)));
+    uint64x2_t mask = vreinterpretq_u64_u8(special);
+    uint64_t lo = vgetq_lane_u64(mask, 0);
+    if (lo != 0) {
+      return i + wpi::countTrailingZeros(lo, wpi::ZB_Undefined) / 8;
+    }
+    uint64_t hi = vgetq_lane_u64(mask, 1);
+    if (hi != 0) {
+      return i + 8 + wpi::countTrailingZeros(hi, wpi::ZB_Undefined) / 8;
+    }
+  }
+  return i + ScanScalar(s + i, len - i);
+}
+#endif  // WPI_JSON_NEON
+
+ScanFunc GetFunc(json_simd simd) {
+  switch (simd) {
+#ifdef WPI_JSON_X86
+    case json_simd::sse2:
+      return ScanSse2;
+    case json_simd::avx2:
+      return ScanAvx2;
+#endif
+#ifdef WPI_JSON_NEON
+    case json_simd::neon:
+      return ScanNeon;
+#endif
+    default:
+      return ScanScalar;
+  }
+}
+
+json_simd Detect() {
+#if defined(WPI_JSON_X86)
+  return HasAvx2() ? json_simd::avx2 : json_simd::sse2;
+#elif defined(WPI_JSON_NEON)
+  return json_simd::neon;
+#else
+  return json_simd::scalar;
+#endif
+}
+
+json_simd GetBest() {
+  static const json_simd best = Detect();
+  return best;
+}
+
+size_t SelectAndScan(const char* s, size_t len);
+
+// constant initialized, so json use during static initialization is safe
+std::atomic<ScanFunc> gScan{SelectAndScan};
+std::atomic<json_simd> gSimd{json_simd::scalar};
+
+size_t SelectAndScan(const char* s, size_t len) {
+  json_set_simd(GetBest());
+  return gScan.load(std::memory_order_relaxed)(s, len);
+}
+
+}  // namespace
+
+size_t wpi::detail::json_plain_prefix(const char* s, size_t len) noexcept {
+  return gScan.load(std::memory_order_relaxed)(s, len);
+}
+
+json_simd wpi::detail::json_get_simd() noexcept {
+  if (gScan.load(std::memory_order_relaxed) == SelectAndScan) {
+    return GetBest();
+  }
+  return gSimd.load(std::memory_order_relaxed);
+}
+
+json_simd wpi::detail::json_best_simd() noexcept {
+  return GetBest();
+}
+
+bool wpi::detail::json_set_simd(json_simd simd) noexcept {
+  json_simd best = GetBest();
+  bool supported;
+  switch (simd) {
+    case json_simd::scalar:
+      supported = true;
+      break;
+    case json_simd::sse2:
+      supported = best == json_simd::sse2 || best == json_simd::avx2;
+      break;
+    default:
+      supported = simd == best;
+      break;
+  }
+  if (!supported) {
+    return false;
+  }
+  gSimd = simd;
+  gScan = GetFunc(simd);
+  return true;
+}
@@ -0,0 +1,308 @@
+// Copyright (c) FIRST and other WPILib contributors.
+// Open Source Software; you can modify and/or share it under the terms of
+// the WPILib BSD license file in the root directory of this project.
+
+#define WPI_JSON_IMPLEMENTATION
+#include "wpi/json_view.h"
+
+#include "wpi/json_simd.h"
+
+using namespace wpi;
+
+namespace {
+
+[[noreturn]] void ThrowSyntaxError(size_t pos, const Twine& msg) {
+  JSON_THROW(json::parse_error::create(101, pos + 1, "syntax error - " + msg));
+}
+
+bool IsWhitespace(char c) {
+  return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+size_t SkipWhitespace(StringRef s, size_t pos) {
+  while (pos < s.size() && IsWhitespace(s[pos])) {
+    ++pos;
+  }
+  return pos;
+}
+
+// Returns the position after the string starting at pos
+size_t SkipString(StringRef s, size_t pos) {
+  for (size_t i = pos + 1; i < s.size(); ++i) {
+    i += detail::json_plain_prefix(s.data() + i, s.size() - i);
+    if (i >= s.size()) {
+      break;
+    } else if (s[i] == '\\') {
+      ++i;
+    } else if (s[i] == '"') {
+      return i + 1;
+    }
+  }
+  ThrowSyntaxError(pos, "missing closing quote");
+}
+
+// Returns the position after the value starting at pos, without decoding
+// or checking it beyond finding where it ends
+size_t SkipValue(StringRef s, size_t pos) {
+  if (pos >= s.size()) {
+    ThrowSyntaxError(pos, "unexpected end of input; expected value");
+  }
+  switch (s[pos]) {
+    case '"':
+      return SkipString(s, pos);
+    case '{':
+    case '[': {
+      int depth = 0;
+      size_t i = pos;
+      while (i < s.size()) {
+        switch (s[i]) {
+          case '"':
+            i = SkipString(s, i);
+            continue;
+          case '{':
+          case '[':
+            ++depth;
+            break;
+          case '}':
+          case ']':
+            if (--depth == 0) {
+              return i + 1;
+            }
+            break;
+          default:
+            break;
+        }
+        ++i;
+      }
+      ThrowSyntaxError(pos, Twine("missing closing ") +
+                                (s[pos] == '{' ? "'}'" : "']'"));
+    }
+    case ',':
+    case ':':
+    case '}':
+    case ']':
+      ThrowSyntaxError(pos, Twine("unexpected '") + Twine(s[pos]) +
+                                "'; expected value");
+    default: {
+      // literal or number
+      size_t i = pos;
+      while (i < s.size() && !IsWhitespace(s[i]) && s[i] != ',' &&
+             s[i] != ':' && s[i] != '}' && s[i] != ']') {
+        ++i;
+      }
+      return i;
+    }
+  }
+}
+
+}  // namespace
+
+json_view::value_t json_view::type() const noexcept {
+  if (m_text.empty()) {
+    return value_t::discarded;
+  }
+  switch (m_text[0]) {
+    case '{':
+      return value_t::object;
+    case '[':
+      return value_t::array;
+    case '"':
+      return value_t::string;
+    case 't':
+    case 'f':
+      return value_t::boolean;
+    case 'n':
+      return value_t::null;
+    default:
+      if (m_text.find_first_of(".eE") != StringRef::npos) {
+        return value_t::number_float;
+      }
+      return m_text[0] == '-' ? value_t::number_integer
+                              : value_t::number_unsigned;
+  }
+}
+
+size_t json_view::size() const {
+  switch (type()) {
+    case value_t::null:
+    case value_t::discarded:
+      return 0;
+    case value_t::array:
+    case value_t::object:
+      return std::distance(begin(), end());
+    default:
+      return 1;
+  }
+}
+
+json_view json_view::find(StringRef key) const {
+  if (!is_object()) {
+    return {};
+  }
+  for (auto it = begin(), e = end(); it != e; ++it) {
+    StringRef raw = it.raw_key();
+    StringRef unquoted = raw.drop_front().drop_back();
+    if (unquoted.find('\\') == StringRef::npos) {
+      if (unquoted == key) {
+        return *it;
+      }
+    } else {
+      SmallString<64> buf;
+      if (it.key(buf) == key) {
+        return *it;
+      }
+    }
+  }
+  return {};
+}
+
+json_view json_view::operator[](size_t idx) const {
+  if (!is_array()) {
+    return {};
+  }
+  for (auto&& element : *this) {
+    if (idx-- == 0) {
+      return element;
+    }
+  }
+  return {};
+}
+
+json_view json_view::at(StringRef key) const {
+  if (!is_object()) {
+    JSON_THROW(json::type_error::create(
+        304, "cannot use at() with " + Twine(type_name())));
+  }
+  auto value = find(key);
+  if (value.is_discarded()) {
+    JSON_THROW(
+        json::out_of_range::create(403, "key '" + Twine(key) + "' not found"));
+  }
+  return value;
+}
+
+json_view json_view::at(size_t idx) const {
+  if (!is_array()) {
+    JSON_THROW(json::type_error::create(
+        304, "cannot use at() with " + Twine(type_name())));
+  }
+  auto value = (*this)[idx];
+  if (value.is_discarded()) {
+    JSON_THROW(json::out_of_range::create(
+        401, "array index " + Twine(idx) + " is out of range"));
+  }
+  return value;
+}
+
+json_view::iterator json_view::begin() const {
+  if (!is_array() && !is_object()) {
+    return {};
+  }
+  return {m_text, 1};
+}
+
+json_view::iterator json_view::end() const {
+  return {};
+}
+
+StringRef json_view::get_string(SmallVectorImpl<char>& buf) const {
+  if (!is_string()) {
+    ThrowTypeError("string");
+  }
+  if (m_text.size() < 2 || m_text.back() != '"') {
+    ThrowSyntaxError(0, "missing closing quote");
+  }
+  StringRef unquoted = m_text.drop_front().drop_back();
+  if (unquoted.find('\\') == StringRef::npos) {
+    return unquoted;
+  }
+  auto j = json::parse(m_text);
+  auto& str = j.get_ref<const std::string&>();
+  buf.assign(str.begin(), str.end());
+  return {buf.data(), buf.size()};
+}
+
+bool json_view::get_boolean() const {
+  if (m_text == "true") {
+    return true;
+  } else if (m_text == "false") {
+    return false;
+  } else if (!is_boolean()) {
+    ThrowTypeError("boolean");
+  }
+  ThrowSyntaxError(0, "invalid literal");
+}
+
+json json_view::get_number() const {
+  if (!is_number()) {
+    ThrowTypeError("number");
+  }
+  return json::parse(m_text);
+}
+
+const char* json_view::type_name() const noexcept {
+  switch (type()) {
+    case value_t::null:
+      return "null";
+    case value_t::object:
+      return "object";
+    case value_t::array:
+      return "array";
+    case value_t::string:
+      return "string";
+    case value_t::boolean:
+      return "boolean";
+    case value_t::discarded:
+      return "discarded";
+    default:
+      return "number";
+  }
+}
+
+void json_view::ThrowTypeError(const char* expected) const {
+  JSON_THROW(json::type_error::create(
+      302, "type must be " + Twine(expected) + ", but is " + type_name()));
+}
+
+json_view::iterator::iterator(StringRef container, size_t pos)
+    : m_container{container}, m_pos{pos} {
+  read();
+}
+
+void json_view::iterator::read() {
+  StringRef s = m_container;
+  size_t pos = SkipWhitespace(s, m_pos);
+  if (pos < s.size() && (s[pos] == '}' || s[pos] == ']')) {
+    m_pos = StringRef::npos;
+    return;
+  }
+  if (s[0] == '{') {
+    if (pos >= s.size() || s[pos] != '"') {
+      ThrowSyntaxError(pos, "expected string literal");
+    }
+    size_t keyEnd = SkipString(s, pos);
+    m_key = s.slice(pos, keyEnd);
+    pos = SkipWhitespace(s, keyEnd);
+    if (pos >= s.size() || s[pos] != ':') {
+      ThrowSyntaxError(pos, "expected ':'");
+    }
+    pos = SkipWhitespace(s, pos + 1);
+  }
+  m_next = SkipValue(s, pos);
+  m_value = json_view{s.slice(pos, m_next)};
+}
+
+json_view::iterator& json_view::iterator::operator++() {
+  StringRef s = m_container;
+  size_t pos = SkipWhitespace(s, m_next);
+  if (pos < s.size() && s[pos] == ',') {
+    m_pos = pos + 1;
+    read();
+  } else if (pos < s.size() && (s[pos] == '}' || s[pos] == ']')) {
+    m_pos = StringRef::npos;
+  } else {
+    ThrowSyntaxError(pos, Twine("expected ',' or ") +
+                              (s[0] == '{' ? "'}'" : "']'"));
+  }
+  return *this;
+}
@@ -58,6 +58,10 @@ size_t raw_mem_istream::in_avail() const {
   return m_left;
 }
 
+StringRef raw_mem_istream::peek_buffer() const {
+  return {m_cur, m_left};
+}
+
 void raw_mem_istream::read_impl(void* data, size_t len) {
   if (len > m_left) {
     error_detected();
@@ -116,6 +120,10 @@ size_t raw_fd_istream::in_avail() const {
   return m_end - m_cur;
 }
 
+StringRef raw_fd_istream::peek_buffer() const {
+  return {m_cur, static_cast<size_t>(m_end - m_cur)};
+}
+
 void raw_fd_istream::read_impl(void* data, size_t len) {
   char* cdata = static_cast<char*>(data);
   size_t pos = 0;
@@ -0,0 +1,184 @@
+// Copyright (c) FIRST and other WPILib contributors.
+// Open Source Software; you can modify and/or share it under the terms of
+// the WPILib BSD license file in the root directory of this project.
+
+#ifndef WPIUTIL_WPI_ARENA_H_
+#define WPIUTIL_WPI_ARENA_H_
+
+#include <stdint.h>
+
+#include <cstddef>
+#include <cstring>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include "wpi/SmallVector.h"
+#include "wpi/StringRef.h"
+
+namespace wpi {
+
+/**
+ * A bump (arena) allocator.  Memory is handed out sequentially from large
+ * slabs obtained from malloc, and is only released all at once by Reset()
+ * or destruction.  This makes allocation a pointer increment and freeing a
+ * whole data structure a handful of free() calls, at the cost of never
+ * reusing individual allocations.
+ *
+ * Destructors of objects created in an arena are not run, so it should only
+ * hold trivially destructible objects (or objects whose destructors don't
+ * matter).  An arena is not thread safe.
+ */
+class Arena {
+ public:
+  /**
+   * Default size of the first slab, in bytes.
+   */
+  static constexpr size_t kDefaultSlabSize = 4096;
+
+  /**
+   * Largest slab size; slabs double in size up to this.
+   */
+  static constexpr size_t kMaxSlabSize = 1 << 20;
+
+  /**
+   * Constructs an arena.  No memory is allocated until the first
+   * allocation.
+   *
+   * @param slabSize size of the first slab, in bytes
+   */
+  explicit Arena(size_t slabSize = kDefaultSlabSize) : m_slabSize{slabSize} {}
+
+  ~Arena();
+
+  Arena(const Arena&) = delete;
+  Arena& operator=(const Arena&) = delete;
+
+  Arena(Arena&& rhs) noexcept;
+  Arena& operator=(Arena&& rhs) noexcept;
+
+  /**
+   * Allocates memory.
+   *
+   * @param size size in bytes
+   * @param alignment alignment in bytes (a power of 2)
+   * @return Pointer to memory, never null
+   */
+  void* Allocate(size_t size, size_t alignment = alignof(std::max_align_t)) {
+    uintptr_t cur = reinterpret_cast<uintptr_t>(m_cur);
+    uintptr_t aligned = (cur + alignment - 1) & ~(alignment - 1);
+    if (m_cur && aligned + size <= reinterpret_cast<uintptr_t>(m_end)) {
+      m_cur = reinterpret_cast<char*>(aligned + size);
+      m_bytesAllocated += size;
+      return reinterpret_cast<void*>(aligned);
+    }
+    return AllocateSlow(size, alignment);
+  }
+
+  /**
+   * Allocates uninitialized memory for an array of objects.
+   *
+   * @param count number of objects
+   * @return Pointer to memory
+   */
+  template <typename T>
+  T* Allocate(size_t count = 1) {
+    return static_cast<T*>(Allocate(sizeof(T) * count, alignof(T)));
+  }
+
+  /**
+   * Constructs an object in the arena.  Its destructor will not be run.
+   *
+   * @param args constructor arguments
+   * @return Pointer to object
+   */
+  template <typename T, typename... Args>
+  T* Create(Args&&... args) {
+    return new (Allocate<T>()) T(std::forward<Args>(args)...);
+  }
+
+  /**
+   * Copies a string into the arena.  The copy is null terminated.
+   *
+   * @param str string
+   * @return Reference to the copy
+   */
+  StringRef CopyString(StringRef str) {
+    char* buf = static_cast<char*>(Allocate(str.size() + 1, 1));
+    if (!str.empty()) {
+      std::memcpy(buf, str.data(), str.size());
+    }
+    buf[str.size()] = '\0';
+    return {buf, str.size()};
+  }
+
+  /**
+   * Frees everything allocated.  The largest slab is kept for reuse, so an
+   * arena that is reset and refilled with similar data stops calling malloc.
+   */
+  void Reset();
+
+  /**
+   * Gets the total number of bytes handed out since the last reset.
+   */
+  size_t GetBytesAllocated() const { return m_bytesAllocated; }
+
+  /**
+   * Gets the total size of the memory held by the arena.
+   */
+  size_t GetTotalMemory() const;
+
+ private:
+  void* AllocateSlow(size_t size, size_t alignment);
+
+  struct Slab {
+    char* data;
+    size_t size;
+  };
+
+  size_t m_slabSize;
+  char* m_cur = nullptr;
+  char* m_end = nullptr;
+  size_t m_bytesAllocated = 0;
+  // the current slab is last
+  SmallVector<Slab, 4> m_slabs;
+  // allocations too big for a slab get their own
+  SmallVector<Slab, 0> m_customSlabs;
+};
+
+/**
+ * A standard library allocator that allocates from an Arena.  Deallocation
+ * does nothing; the memory is freed when the arena is reset.
+ */
+template <typename T>
+class ArenaAllocator {
+ public:
+  using value_type = T;
+
+  explicit ArenaAllocator(Arena& arena) noexcept : m_arena{&arena} {}
+
+  template <typename U>
+  ArenaAllocator(const ArenaAllocator<U>& other) noexcept  // NOLINT
+      : m_arena{other.GetArena()} {}
+
+  T* allocate(size_t n) { return m_arena->Allocate<T>(n); }
+  void deallocate(T*, size_t) noexcept {}
+
+  Arena* GetArena() const noexcept { return m_arena; }
+
+  template <typename U>
+  bool operator==(const ArenaAllocator<U>& rhs) const noexcept {
+    return m_arena == rhs.GetArena();
+  }
+  template <typename U>
+  bool operator!=(const ArenaAllocator<U>& rhs) const noexcept {
+    return m_arena != rhs.GetArena();
+  }
+
+ private:
+  Arena* m_arena;
+};
+
+}  // namespace wpi
+
+#endif  // WPIUTIL_WPI_ARENA_H_
@@ -5,14 +5,18 @@
 #ifndef WPIUTIL_WPI_CALLBACKMANAGER_H_
 #define WPIUTIL_WPI_CALLBACKMANAGER_H_
 
+#include <stdint.h>
+
 #include <atomic>
 #include <climits>
 #include <functional>
 #include <memory>
 #include <queue>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
+#include "wpi/MpmcQueue.h"
 #include "wpi/SafeThread.h"
 #include "wpi/UidVector.h"
 #include "wpi/condition_variable.h"
@@ -21,6 +25,21 @@
 
 namespace wpi {
 
+// What a bounded poller does with a new event when its queue is full.
+// Discarded events are counted (see CallbackManager::GetPollerDropped()).
+enum class PollerOverflow {
+  // Discard the oldest queued event
+  kDropOldest,
+  // Discard the new event
+  kDropNewest,
+  // Only once the queue is full, stage new events in a second list of the
+  // same capacity, merging an event into a staged one with the same
+  // coalesce key (see CallbackThread).  Events already in the queue are
+  // never merged.  Staged events are handed out once the queue drains; an
+  // event with a new key that doesn't fit in the staging list is discarded.
+  kCoalesce
+};
+
 template <typename Callback>
 class CallbackListenerData {
  public:
@@ -43,6 +62,19 @@ class CallbackListenerData {
 //   bool Matches(const ListenerData& listener, const NotifierData& data);
 //   void SetListener(NotifierData* data, unsigned int listener_uid);
 //   void DoCallback(Callback callback, const NotifierData& data);
+// Derived may also define the following functions to maintain an index of
+// listeners, so that broadcast notifications only need to check Matches()
+// against the listeners the index returns instead of all of them:
+//   void ListenerAdded(unsigned int listener_uid);
+//   void ListenerRemoved(unsigned int listener_uid);  // before it's erased
+//   bool GetCandidates(const NotifierData& data,
+//                      std::vector<unsigned int>* listener_uids);
+// Derived may also define the following functions so that bounded pollers
+// with the kCoalesce overflow policy can merge events with the same key;
+// events GetCoalesceKey() returns false for are never merged, and by default
+// Coalesce() replaces the queued event:
+//   bool GetCoalesceKey(const NotifierData& data, uint64_t* key);
+//   void Coalesce(NotifierData* queued, NotifierData&& data);
 template <typename Derived, typename TUserInfo,
           typename TListenerData =
               CallbackListenerData<std::function<void(const TUserInfo& info)>>,
@@ -64,12 +96,35 @@ class CallbackThread : public wpi::SafeThread {
 
   void Main() override;
 
+  // Default (unindexed) listener hooks; called with m_mutex held.
+  void ListenerAdded(unsigned int) {}
+  void ListenerRemoved(unsigned int) {}
+  bool GetCandidates(const NotifierData&, std::vector<unsigned int>*) {
+    return false;
+  }
+
+  // Default coalescing hooks; called with m_mutex held.
+  bool GetCoalesceKey(const NotifierData&, uint64_t*) { return false; }
+  void Coalesce(NotifierData* queued, NotifierData&& data) {
+    *queued = std::move(data);
+  }
+
   wpi::UidVector<ListenerData, 64> m_listeners;
 
   std::queue<std::pair<unsigned int, NotifierData>> m_queue;
   wpi::condition_variable m_queue_empty;
 
+  // A poller either has an unbounded queue guarded by poll_mutex, or a
+  // bounded lock-free ring.  The ring is only filled by this thread, so
+  // the callback thread never waits on a slow poller; poll_mutex is only
+  // taken to wake a blocked Poll() call and, for kCoalesce, to merge events
+  // while the ring is full.
   struct Poller {
+    Poller() = default;
+    Poller(size_t capacity, PollerOverflow overflow_)
+        : ring{std::make_unique<wpi::MpmcQueue<NotifierData>>(capacity)},
+          overflow{overflow_} {}
+
     void Terminate() {
       {
         std::scoped_lock lock(poll_mutex);
@@ -77,14 +132,39 @@ class CallbackThread : public wpi::SafeThread {
       }
       poll_cond.notify_all();
     }
+
+    // Wakes a Poll() call blocked on the ring after an event is added
+    void Wake() {
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      if (waiters.load(std::memory_order_relaxed) != 0) {
+        { std::scoped_lock lock(poll_mutex); }
+        poll_cond.notify_one();
+      }
+    }
+
     std::queue<NotifierData> poll_queue;
     wpi::mutex poll_mutex;
     wpi::condition_variable poll_cond;
     bool terminating = false;
     bool canceling = false;
+
+    std::unique_ptr<wpi::MpmcQueue<NotifierData>> ring;
+    PollerOverflow overflow = PollerOverflow::kDropOldest;
+    std::atomic<int> waiters{0};
+    // Events discarded by the overflow policy
+    std::atomic<uint64_t> dropped{0};
+    // Events that didn't fit in the ring (kCoalesce only).  While any are
+    // staged, new events are staged too so that order is kept; they are
+    // handed out once the ring has been drained.
+    std::atomic_bool has_staged{false};
+    std::vector<NotifierData> staged;
+    std::unordered_map<uint64_t, size_t> staged_index;
   };
   wpi::UidVector<std::shared_ptr<Poller>, 64> m_pollers;
 
+  // Reused by Main() for GetCandidates() results
+  std::vector<unsigned int> m_candidates;
+
   // Must be called with m_mutex held
   template <typename... Args>
   void SendPoller(unsigned int poller_uid, Args&&... args) {
@@ -95,12 +175,68 @@ class CallbackThread : public wpi::SafeThread {
     if (!poller) {
       return;
     }
+    if (poller->ring) {
+      SendBoundedPoller(*poller, NotifierData(std::forward<Args>(args)...));
+      return;
+    }
     {
       std::scoped_lock lock(poller->poll_mutex);
       poller->poll_queue.emplace(std::forward<Args>(args)...);
     }
     poller->poll_cond.notify_one();
   }
+
+ private:
+  void SendBoundedPoller(Poller& poller, NotifierData&& data) {
+    switch (poller.overflow) {
+      case PollerOverflow::kDropOldest: {
+        // a failed push leaves data untouched
+        while (!poller.ring->try_push(std::move(data))) {
+          if (poller.ring->try_pop()) {
+            ++poller.dropped;
+          }
+        }
+        break;
+      }
+      case PollerOverflow::kDropNewest:
+        if (!poller.ring->try_push(std::move(data))) {
+          ++poller.dropped;
+          return;
+        }
+        break;
+      case PollerOverflow::kCoalesce:
+        if (poller.has_staged.load() ||
+            !poller.ring->try_push(std::move(data))) {
+          StagePoller(poller, std::move(data));
+        }
+        break;
+    }
+    poller.Wake();
+  }
+
+  void StagePoller(Poller& poller, NotifierData&& data) {
+    std::scoped_lock lock(poller.poll_mutex);
+    uint64_t key;
+    bool has_key = static_cast<Derived*>(this)->GetCoalesceKey(data, &key);
+    if (has_key) {
+      auto it = poller.staged_index.find(key);
+      if (it != poller.staged_index.end()) {
+        static_cast<Derived*>(this)->Coalesce(&poller.staged[it->second],
+                                              std::move(data));
+        return;
+      }
+    }
+    // staging holds at most as many events as the ring
+    if (poller.staged.size() >= poller.ring->capacity()) {
+      ++poller.dropped;
+      return;
+    }
+    if (has_key) {
+      poller.staged_index.emplace(key, poller.staged.size());
+    }
+    poller.staged.emplace_back(std::move(data));
+    poller.has_staged = true;
+  }
 };
 
 template <typename Derived, typename TUserInfo, typename TListenerData,
@@ -137,6 +273,31 @@ void CallbackThread<Derived, TUserInfo, TListenerData, TNotifierData>::Main() {
             }
           }
         }
+      } else if (static_cast<Derived*>(this)->GetCandidates(item.second,
+                                                            &m_candidates)) {
+        // Use index because the candidate list is reused.
+        for (size_t i = 0; i < m_candidates.size(); ++i) {
+          unsigned int uid = m_candidates[i];
+          if (uid >= m_listeners.size()) {
+            continue;
+          }
+          auto& listener = m_listeners[uid];
+          if (!listener) {
+            continue;
+          }
+          if (!static_cast<Derived*>(this)->Matches(listener, item.second)) {
+            continue;
+          }
+          static_cast<Derived*>(this)->SetListener(&item.second, uid);
+          if (listener.callback) {
+            lock.unlock();
+            static_cast<Derived*>(this)->DoCallback(listener.callback,
+                                                    item.second);
+            lock.lock();
+          } else if (listener.poller_uid != UINT_MAX) {
+            SendPoller(listener.poller_uid, item.second);
+          }
+        }
       } else {
         // Use index because iterator might get invalidated.
         for (size_t i = 0; i < m_listeners.size(); ++i) {
@@ -184,6 +345,7 @@ class CallbackManager {
     if (!thr) {
       return;
     }
+    thr->ListenerRemoved(listener_uid);
     thr->m_listeners.erase(listener_uid);
   }
 
@@ -194,6 +356,15 @@ class CallbackManager {
         std::make_shared<typename Thread::Poller>());
   }
 
+  // Creates a poller that holds at most capacity events (rounded up to a
+  // power of 2); when full, new events are handled per the overflow policy.
+  unsigned int CreatePoller(size_t capacity, PollerOverflow overflow) {
+    static_cast<Derived*>(this)->Start();
+    auto thr = m_owner.GetThread();
+    return thr->m_pollers.emplace_back(
+        std::make_shared<typename Thread::Poller>(capacity, overflow));
+  }
+
   void RemovePoller(unsigned int poller_uid) {
     auto thr = m_owner.GetThread();
     if (!thr) {
@@ -203,6 +374,7 @@ class CallbackManager {
     // Remove any listeners that are associated with this poller
     for (size_t i = 0; i < thr->m_listeners.size(); ++i) {
       if (thr->m_listeners[i].poller_uid == poller_uid) {
+        thr->ListenerRemoved(i);
         thr->m_listeners.erase(i);
       }
     }
@@ -256,38 +428,42 @@ class CallbackManager {
   std::vector<typename Thread::UserInfo> Poll(unsigned int poller_uid,
                                               double timeout, bool* timed_out) {
     std::vector<typename Thread::UserInfo> infos;
-    std::shared_ptr<typename Thread::Poller> poller;
-    {
-      auto thr = m_owner.GetThread();
-      if (!thr) {
-        return infos;
-      }
-      if (poller_uid > thr->m_pollers.size()) {
-        return infos;
-      }
-      poller = thr->m_pollers[poller_uid];
-      if (!poller) {
-        return infos;
-      }
+    PollBatch(poller_uid, &infos, 0, timeout, timed_out);
+    return infos;
+  }
+
+  // Appends up to max_events events (0 for no limit) to infos, blocking
+  // until there is at least one or the timeout (if not negative) expires.
+  // Returns the number of events appended.
+  size_t PollBatch(unsigned int poller_uid,
+                   std::vector<typename Thread::UserInfo>* infos,
+                   size_t max_events, double timeout, bool* timed_out) {
+    *timed_out = false;
+    auto poller = GetPoller(poller_uid);
+    if (!poller) {
+      return 0;
+    }
+
+    if (poller->ring) {
+      return PollRing(*poller, infos, max_events, timeout, timed_out);
     }
 
     std::unique_lock lock(poller->poll_mutex);
     auto timeout_time = std::chrono::steady_clock::now() +
                         std::chrono::duration<double>(timeout);
-    *timed_out = false;
     while (poller->poll_queue.empty()) {
       if (poller->terminating) {
-        return infos;
+        return 0;
       }
       if (poller->canceling) {
         // Note: this only works if there's a single thread calling this
         // function for any particular poller, but that's the intended use.
         poller->canceling = false;
-        return infos;
+        return 0;
       }
       if (timeout == 0) {
         *timed_out = true;
-        return infos;
+        return 0;
       }
       if (timeout < 0) {
         poller->poll_cond.wait(lock);
@@ -295,32 +471,35 @@ class CallbackManager {
         auto cond_timed_out = poller->poll_cond.wait_until(lock, timeout_time);
         if (cond_timed_out == std::cv_status::timeout) {
           *timed_out = true;
-          return infos;
+          return 0;
         }
       }
     }
 
-    while (!poller->poll_queue.empty()) {
-      infos.emplace_back(std::move(poller->poll_queue.front()));
+    size_t count = 0;
+    while (!poller->poll_queue.empty() &&
+           (max_events == 0 || count < max_events)) {
+      infos->emplace_back(std::move(poller->poll_queue.front()));
       poller->poll_queue.pop();
+      ++count;
     }
-    return infos;
+    return count;
+  }
+
+  // Returns the number of events a bounded poller has discarded because it
+  // was full; merged events are not counted
+  uint64_t GetPollerDropped(unsigned int poller_uid) {
+    auto poller = GetPoller(poller_uid);
+    if (!poller) {
+      return 0;
+    }
+    return poller->dropped;
   }
 
   void CancelPoll(unsigned int poller_uid) {
-    std::shared_ptr<typename Thread::Poller> poller;
-    {
-      auto thr = m_owner.GetThread();
-      if (!thr) {
-        return;
-      }
-      if (poller_uid > thr->m_pollers.size()) {
-        return;
-      }
-      poller = thr->m_pollers[poller_uid];
-      if (!poller) {
-        return;
-      }
+    auto poller = GetPoller(poller_uid);
+    if (!poller) {
+      return;
     }
 
     {
@@ -340,7 +519,10 @@ class CallbackManager {
   unsigned int DoAdd(Args&&... args) {
     static_cast<Derived*>(this)->Start();
     auto thr = m_owner.GetThread();
-    return thr->m_listeners.emplace_back(std::forward<Args>(args)...);
+    unsigned int uid =
+        thr->m_listeners.emplace_back(std::forward<Args>(args)...);
+    thr->ListenerAdded(uid);
+    return uid;
   }
 
   template <typename... Args>
@@ -360,6 +542,106 @@ class CallbackManager {
   }
 
  private:
+  using Poller = typename Thread::Poller;
+
+  std::shared_ptr<Poller> GetPoller(unsigned int poller_uid) {
+    auto thr = m_owner.GetThread();
+    if (!thr) {
+      return nullptr;
+    }
+    if (poller_uid >= thr->m_pollers.size()) {
+      return nullptr;
+    }
+    return thr->m_pollers[poller_uid];
+  }
+
+  size_t PollRing(Poller& poller, std::vector<typename Thread::UserInfo>* infos,
+                  size_t max_events, double timeout, bool* timed_out) {
+    auto timeout_time = std::chrono::steady_clock::now() +
+                        std::chrono::duration<double>(timeout);
+    for (bool expired = false;;) {
+      size_t count = DrainRing(poller, infos, max_events);
+      if (count != 0) {
+        return count;
+      }
+      if (expired) {
+        *timed_out = true;
+        return 0;
+      }
+
+      std::unique_lock lock(poller.poll_mutex);
+      if (poller.terminating) {
+        return 0;
+      }
+      if (poller.canceling) {
+        poller.canceling = false;
+        return 0;
+      }
+      if (timeout == 0) {
+        *timed_out = true;
+        return 0;
+      }
+      // pairs with the fence in Poller::Wake(): either the producer sees
+      // the waiter, or this sees the new event
+      ++poller.waiters;
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      if (poller.ring->empty_approx() && !poller.has_staged.load()) {
+        if (timeout < 0) {
+          poller.poll_cond.wait(lock);
+        } else {
+          expired = poller.poll_cond.wait_until(lock, timeout_time) ==
+                    std::cv_status::timeout;
+        }
+      }
+      --poller.waiters;
+    }
+  }
+
+  // Moves events from the ring, then staged events once it is empty
+  size_t DrainRing(Poller& poller,
+                   std::vector<typename Thread::UserInfo>* infos,
+                   size_t max_events) {
+    size_t count = 0;
+    while (max_events == 0 || count < max_events) {
+      auto data = poller.ring->try_pop();
+      if (!data) {
+        break;
+      }
+      infos->emplace_back(std::move(*data));
+      ++count;
+    }
+    if ((max_events != 0 && count >= max_events) ||
+        !poller.has_staged.load()) {
+      return count;
+    }
+
+    // nothing is added to the ring while events are staged
+    std::scoped_lock lock(poller.poll_mutex);
+    if (!poller.has_staged || !poller.ring->empty_approx()) {
+      return count;
+    }
+    size_t n = poller.staged.size();
+    if (max_events != 0 && n > max_events - count) {
+      n = max_events - count;
+    }
+    for (size_t i = 0; i < n; ++i) {
+      infos->emplace_back(std::move(poller.staged[i]));
+    }
+    count += n;
+    poller.staged.erase(poller.staged.begin(), poller.staged.begin() + n);
+    for (auto it = poller.staged_index.begin();
+         it != poller.staged_index.end();) {
+      if (it->second < n) {
+        it = poller.staged_index.erase(it);
+      } else {
+        it->second -= n;
+        ++it;
+      }
+    }
+    poller.has_staged = !poller.staged.empty();
+    return count;
+  }
+
   wpi::SafeThreadOwner<Thread> m_owner;
 };
 
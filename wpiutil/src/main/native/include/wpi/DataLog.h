@@ -0,0 +1,434 @@
+// Copyright (c) FIRST and other WPILib contributors.
+// Open Source Software; you can modify and/or share it under the terms of
+// the WPILib BSD license file in the root directory of this project.
+
+#ifndef WPIUTIL_WPI_DATALOG_H_
+#define WPIUTIL_WPI_DATALOG_H_
+
+#include <stdint.h>
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#include "wpi/ArrayRef.h"
+#include "wpi/StringMap.h"
+#include "wpi/StringRef.h"
+#include "wpi/Twine.h"
+#include "wpi/condition_variable.h"
+#include "wpi/mutex.h"
+
+namespace wpi::log {
+
+namespace impl {
+struct StagingBuffer;
+}  // namespace impl
+
+/**
+ * A binary data log.  Records are appended to an entry (identified by an
+ * integer id returned by Start()) with a timestamp, and are written to the
+ * output in batches by a background thread.
+ *
+ * Appending never blocks and never takes a lock: each thread appending to a
+ * log stages its records in its own ring buffer, which the writer thread
+ * drains.  If a thread's buffer is full (the writer has fallen behind by
+ * more than kStagingSize bytes), the record is dropped and counted by
+ * GetDropped().  Start(), Finish() and SetMetadata() take a lock and are
+ * intended to be called much less often.
+ *
+ * The file format ("WPILOG", version 1.0) starts with a header:
+ * - 6-byte "WPILOG" magic
+ * - 2-byte (16-bit little endian) version number, 0x0100
+ * - 4-byte (32-bit little endian) length of the extra header string
+ * - the extra header string (arbitrary UTF-8)
+ *
+ * It is followed by records, each of which is:
+ * - a 1-byte length byte: bits 0-1 are the length of the entry id minus 1,
+ *   bits 2-3 the length of the payload size minus 1, and bits 4-6 the length
+ *   of the timestamp minus 1
+ * - the entry id, payload size and timestamp (integer microseconds, as
+ *   returned by wpi::Now()), each little endian with the length given in
+ *   the length byte
+ * - the payload
+ *
+ * Records for entry 0 are control records.  The first payload byte is the
+ * control type: 0 starts an entry (32-bit entry id, then the name, type and
+ * metadata, each as a 32-bit length followed by the string), 1 finishes an
+ * entry (32-bit entry id), and 2 sets the metadata of an entry (32-bit
+ * entry id and the metadata string).  All integers are little endian.
+ *
+ * Data payloads are little endian: boolean is 1 byte, int64 8 bytes, float
+ * 4 bytes, double 8 bytes, string its UTF-8 bytes, and arrays of those are
+ * the elements back to back (string[] is a 32-bit count, then each string
+ * as a 32-bit length and its bytes).
+ */
+class DataLog final {
+ public:
+  /**
+   * Size of each appending thread's staging buffer, in bytes.
+   */
+  static constexpr size_t kStagingSize = 1 << 20;
+
+  /**
+   * Constructs a log that writes to a file.  The file is created (or
+   * truncated) immediately.
+   *
+   * @param filename file name
+   * @param ec error code set if the file could not be opened; the log then
+   *           discards everything
+   * @param period time between writes to the file, in seconds
+   * @param extraHeader extra header string
+   */
+  DataLog(const Twine& filename, std::error_code& ec, double period = 0.25,
+          const Twine& extraHeader = "");
+
+  /**
+   * Constructs a log that passes its output to a function, which is called
+   * from the writer thread.  The first call holds the file header.
+   *
+   * @param write function called with each batch of data
+   * @param period time between writes, in seconds
+   * @param extraHeader extra header string
+   */
+  explicit DataLog(std::function<void(ArrayRef<uint8_t> data)> write,
+                   double period = 0.25, const Twine& extraHeader = "");
+
+  /**
+   * Writes everything appended so far and stops the writer thread.
+   */
+  ~DataLog();
+
+  DataLog(const DataLog&) = delete;
+  DataLog& operator=(const DataLog&) = delete;
+
+  /**
+   * Writes everything appended (by any thread) before this call, and
+   * waits for the write to finish.
+   */
+  void Flush();
+
+  /**
+   * Starts an entry.  Starting an entry that is already started returns
+   * the same id (the type and metadata are not changed); it must then be
+   * finished as many times as it was started.
+   *
+   * @param name entry name
+   * @param type data type, e.g. "double" or "int64[]"
+   * @param metadata metadata (e.g. a JSON string)
+   * @param timestamp time in microseconds; 0 to use the current time
+   * @return Entry id (nonzero)
+   */
+  int Start(StringRef name, StringRef type, StringRef metadata = {},
+            int64_t timestamp = 0);
+
+  /**
+   * Finishes an entry.  No more records should be appended to it.
+   *
+   * @param entry entry id
+   * @param timestamp time in microseconds; 0 to use the current time
+   */
+  void Finish(int entry, int64_t timestamp = 0);
+
+  /**
+   * Updates the metadata of an entry.
+   *
+   * @param entry entry id
+   * @param metadata new metadata
+   * @param timestamp time in microseconds; 0 to use the current time
+   */
+  void SetMetadata(int entry, StringRef metadata, int64_t timestamp = 0);
+
+  /**
+   * Appends a record with an arbitrary payload.
+   *
+   * @param entry entry id, from Start()
+   * @param data payload
+   * @param timestamp time in microseconds; 0 to use the current time
+   */
+  void AppendRaw(int entry, ArrayRef<uint8_t> data, int64_t timestamp);
+
+  void AppendBoolean(int entry, bool value, int64_t timestamp);
+  void AppendInteger(int entry, int64_t value, int64_t timestamp);
+  void AppendFloat(int entry, float value, int64_t timestamp);
+  void AppendDouble(int entry, double value, int64_t timestamp);
+  void AppendString(int entry, StringRef value, int64_t timestamp);
+  void AppendBooleanArray(int entry, ArrayRef<bool> values,
+                          int64_t timestamp);
+  void AppendBooleanArray(int entry, ArrayRef<int> values, int64_t timestamp);
+  void AppendIntegerArray(int entry, ArrayRef<int64_t> values,
+                          int64_t timestamp);
+  void AppendFloatArray(int entry, ArrayRef<float> values, int64_t timestamp);
+  void AppendDoubleArray(int entry, ArrayRef<double> values,
+                         int64_t timestamp);
+  void AppendStringArray(int entry, ArrayRef<std::string> values,
+                         int64_t timestamp);
+  void AppendStringArray(int entry, ArrayRef<StringRef> values,
+                         int64_t timestamp);
+
+  /**
+   * Gets the number of records dropped because a staging buffer was full.
+   */
+  uint64_t GetDropped() const { return m_dropped; }
+
+ private:
+  // A record payload gathered from several pieces, so it can be copied
+  // straight into a staging buffer.
+  struct Piece {
+    const void* data;
+    size_t size;
+  };
+
+  void StartWriter(const Twine& extraHeader);
+  impl::StagingBuffer* GetStaging();
+  void AppendRecord(int entry, int64_t timestamp, ArrayRef<Piece> pieces);
+  void AppendControl(std::vector<uint8_t>* buf, ArrayRef<Piece> pieces,
+                     int64_t timestamp);
+  void WriterThreadMain();
+
+  std::function<void(ArrayRef<uint8_t>)> m_write;
+  double m_period;
+  uint64_t m_uid;  // distinguishes logs in per-thread staging lookups
+  std::atomic<uint64_t> m_dropped{0};
+  std::atomic_bool m_wake{false};
+
+  mutable wpi::mutex m_mutex;
+  wpi::condition_variable m_cond;
+  wpi::condition_variable m_flushed;
+  bool m_active = true;
+  uint64_t m_flushRequested = 0;
+  uint64_t m_flushDone = 0;
+  std::vector<std::shared_ptr<impl::StagingBuffer>> m_staging;
+  // control records; starts and metadata are written before the staged
+  // data of the same batch and finishes after it
+  std::vector<uint8_t> m_controlStart;
+  std::vector<uint8_t> m_controlFinish;
+  struct EntryInfo {
+    int id = 0;
+    int count = 0;
+  };
+  StringMap<EntryInfo> m_entries;
+  int m_lastEntry = 0;
+
+  std::thread m_thread;
+};
+
+/**
+ * Log entry base class.  Starts the entry on construction and finishes it
+ * on destruction.
+ */
+class DataLogEntry {
+ public:
+  DataLogEntry(const DataLogEntry&) = delete;
+  DataLogEntry& operator=(const DataLogEntry&) = delete;
+
+  /**
+   * Updates the metadata of the entry.
+   *
+   * @param metadata new metadata
+   * @param timestamp time in microseconds; 0 to use the current time
+   */
+  void SetMetadata(StringRef metadata, int64_t timestamp = 0) {
+    m_log->SetMetadata(m_entry, metadata, timestamp);
+  }
+
+  int GetEntry() const { return m_entry; }
+
+ protected:
+  DataLogEntry(DataLog& log, StringRef name, StringRef type,
+               StringRef metadata, int64_t timestamp)
+      : m_log{&log}, m_entry{log.Start(name, type, metadata, timestamp)} {}
+  ~DataLogEntry() { m_log->Finish(m_entry); }
+
+  DataLog* m_log;
+  int m_entry;
+};
+
+/**
+ * Log arbitrary byte data.
+ */
+class RawLogEntry : public DataLogEntry {
+ public:
+  static constexpr const char* kDataType = "raw";
+
+  RawLogEntry(DataLog& log, StringRef name, StringRef metadata = {},
+              StringRef type = kDataType, int64_t timestamp = 0)
+      : DataLogEntry{log, name, type, metadata, timestamp} {}
+
+  void Append(ArrayRef<uint8_t> data, int64_t timestamp = 0) {
+    m_log->AppendRaw(m_entry, data, timestamp);
+  }
+};
+
+/**
+ * Log boolean values.
+ */
+class BooleanLogEntry : public DataLogEntry {
+ public:
+  static constexpr const char* kDataType = "boolean";
+
+  BooleanLogEntry(DataLog& log, StringRef name, StringRef metadata = {},
+                  int64_t timestamp = 0)
+      : DataLogEntry{log, name, kDataType, metadata, timestamp} {}
+
+  void Append(bool value, int64_t timestamp = 0) {
+    m_log->AppendBoolean(m_entry, value, timestamp);
+  }
+};
+
+/**
+ * Log integer values.
+ */
+class IntegerLogEntry : public DataLogEntry {
+ public:
+  static constexpr const char* kDataType = "int64";
+
+  IntegerLogEntry(DataLog& log, StringRef name, StringRef metadata = {},
+                  int64_t timestamp = 0)
+      : DataLogEntry{log, name, kDataType, metadata, timestamp} {}
+
+  void Append(int64_t value, int64_t timestamp = 0) {
+    m_log->AppendInteger(m_entry, value, timestamp);
+  }
+};
+
+/**
+ * Log float values.
+ */
+class FloatLogEntry : public DataLogEntry {
+ public:
+  static constexpr const char* kDataType = "float";
+
+  FloatLogEntry(DataLog& log, StringRef name, StringRef metadata = {},
+                int64_t timestamp = 0)
+      : DataLogEntry{log, name, kDataType, metadata, timestamp} {}
+
+  void Append(float value, int64_t timestamp = 0) {
+    m_log->AppendFloat(m_entry, value, timestamp);
+  }
+};
+
+/**
+ * Log double values.
+ */
+class DoubleLogEntry : public DataLogEntry {
+ public:
+  static constexpr const char* kDataType = "double";
+
+  DoubleLogEntry(DataLog& log, StringRef name, StringRef metadata = {},
+                 int64_t timestamp = 0)
+      : DataLogEntry{log, name, kDataType, metadata, timestamp} {}
+
+  void Append(double value, int64_t timestamp = 0) {
+    m_log->AppendDouble(m_entry, value, timestamp);
+  }
+};
+
+/**
+ * Log string values.
+ */
+class StringLogEntry : public DataLogEntry {
+ public:
+  static constexpr const char* kDataType = "string";
+
+  StringLogEntry(DataLog& log, StringRef name, StringRef metadata = {},
+                 StringRef type = kDataType, int64_t timestamp = 0)
+      : DataLogEntry{log, name, type, metadata, timestamp} {}
+
+  void Append(StringRef value, int64_t timestamp = 0) {
+    m_log->AppendString(m_entry, value, timestamp);
+  }
+};
+
+/**
+ * Log arrays of boolean values.
+ */
+class BooleanArrayLogEntry : public DataLogEntry {
+ public:
+  static constexpr const char* kDataType = "boolean[]";
+
+  BooleanArrayLogEntry(DataLog& log, StringRef name, StringRef metadata = {},
+                       int64_t timestamp = 0)
+      : DataLogEntry{log, name, kDataType, metadata, timestamp} {}
+
+  void Append(ArrayRef<bool> values, int64_t timestamp = 0) {
+    m_log->AppendBooleanArray(m_entry, values, timestamp);
+  }
+  void Append(ArrayRef<int> values, int64_t timestamp = 0) {
+    m_log->AppendBooleanArray(m_entry, values, timestamp);
+  }
+};
+
+/**
+ * Log arrays of integer values.
+ */
+class IntegerArrayLogEntry : public DataLogEntry {
+ public:
+  static constexpr const char* kDataType = "int64[]";
+
+  IntegerArrayLogEntry(DataLog& log, StringRef name, StringRef metadata = {},
+                       int64_t timestamp = 0)
+      : DataLogEntry{log, name, kDataType, metadata, timestamp} {}
+
+  void Append(ArrayRef<int64_t> values, int64_t timestamp = 0) {
+    m_log->AppendIntegerArray(m_entry, values, timestamp);
+  }
+};
+
+/**
+ * Log arrays of float values.
+ */
+class FloatArrayLogEntry : public DataLogEntry {
+ public:
+  static constexpr const char* kDataType = "float[]";
+
+  FloatArrayLogEntry(DataLog& log, StringRef name, StringRef metadata = {},
+                     int64_t timestamp = 0)
+      : DataLogEntry{log, name, kDataType, metadata, timestamp} {}
+
+  void Append(ArrayRef<float> values, int64_t timestamp = 0) {
+    m_log->AppendFloatArray(m_entry, values, timestamp);
+  }
+};
+
+/**
+ * Log arrays of double values.
+ */
+class DoubleArrayLogEntry : public DataLogEntry {
+ public:
+  static constexpr const char* kDataType = "double[]";
+
+  DoubleArrayLogEntry(DataLog& log, StringRef name, StringRef metadata = {},
+                      int64_t timestamp = 0)
+      : DataLogEntry{log, name, kDataType, metadata, timestamp} {}
+
+  void Append(ArrayRef<double> values, int64_t timestamp = 0) {
+    m_log->AppendDoubleArray(m_entry, values, timestamp);
+  }
+};
+
+/**
+ * Log arrays of string values.
+ */
+class StringArrayLogEntry : public DataLogEntry {
+ public:
+  static constexpr const char* kDataType = "string[]";
+
+  StringArrayLogEntry(DataLog& log, StringRef name, StringRef metadata = {},
+                      int64_t timestamp = 0)
+      : DataLogEntry{log, name, kDataType, metadata, timestamp} {}
+
+  void Append(ArrayRef<std::string> values, int64_t timestamp = 0) {
+    m_log->AppendStringArray(m_entry, values, timestamp);
+  }
+  void Append(ArrayRef<StringRef> values, int64_t timestamp = 0) {
+    m_log->AppendStringArray(m_entry, values, timestamp);
+  }
+};
+
+}  // namespace wpi::log
+
+#endif  // WPIUTIL_WPI_DATALOG_H_
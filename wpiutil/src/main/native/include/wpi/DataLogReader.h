@@ -0,0 +1,210 @@
+// Copyright (c) FIRST and other WPILib contributors.
+// Open Source Software; you can modify and/or share it under the terms of
+// the WPILib BSD license file in the root directory of this project.
+
+#ifndef WPIUTIL_WPI_DATALOGREADER_H_
+#define WPIUTIL_WPI_DATALOGREADER_H_
+
+#include <stdint.h>
+
+#include <iterator>
+#include <system_error>
+#include <vector>
+
+#include "wpi/ArrayRef.h"
+#include "wpi/StringRef.h"
+#include "wpi/Twine.h"
+
+namespace wpi::log {
+
+/**
+ * Data contained in a start control record.
+ */
+struct StartRecordData {
+  /** Entry id */
+  int entry;
+  /** Entry name */
+  StringRef name;
+  /** Data type */
+  StringRef type;
+  /** Metadata */
+  StringRef metadata;
+};
+
+/**
+ * Data contained in a set metadata control record.
+ */
+struct MetadataRecordData {
+  /** Entry id */
+  int entry;
+  /** New metadata */
+  StringRef metadata;
+};
+
+/**
+ * A record in a data log.  The payload references the data held by the
+ * DataLogReader, so it is only valid as long as the reader.
+ *
+ * The typed getters return false if the payload does not have the size
+ * (or, for control records, the control type) they expect.
+ */
+class DataLogRecord {
+ public:
+  DataLogRecord() = default;
+  DataLogRecord(int entry, int64_t timestamp, ArrayRef<uint8_t> data)
+      : m_entry{entry}, m_timestamp{timestamp}, m_data{data} {}
+
+  /**
+   * Gets the entry id; 0 for control records.
+   */
+  int GetEntry() const { return m_entry; }
+
+  /**
+   * Gets the timestamp, in integer microseconds.
+   */
+  int64_t GetTimestamp() const { return m_timestamp; }
+
+  /**
+   * Gets the size of the payload, in bytes.
+   */
+  size_t GetSize() const { return m_data.size(); }
+
+  /**
+   * Gets the raw payload.
+   */
+  ArrayRef<uint8_t> GetRaw() const { return m_data; }
+
+  bool IsControl() const { return m_entry == 0; }
+  bool IsStart() const;
+  bool IsFinish() const;
+  bool IsSetMetadata() const;
+
+  /**
+   * Decodes a start control record.
+   *
+   * @param out decoded data
+   * @return True on success
+   */
+  bool GetStartData(StartRecordData* out) const;
+
+  /**
+   * Decodes a finish control record.
+   *
+   * @param out entry id that was finished
+   * @return True on success
+   */
+  bool GetFinishEntry(int* out) const;
+
+  /**
+   * Decodes a set metadata control record.
+   *
+   * @param out decoded data
+   * @return True on success
+   */
+  bool GetSetMetadataData(MetadataRecordData* out) const;
+
+  bool GetBoolean(bool* value) const;
+  bool GetInteger(int64_t* value) const;
+  bool GetFloat(float* value) const;
+  bool GetDouble(double* value) const;
+  bool GetString(StringRef* value) const;
+  bool GetBooleanArray(std::vector<int>* arr) const;
+  bool GetIntegerArray(std::vector<int64_t>* arr) const;
+  bool GetFloatArray(std::vector<float>* arr) const;
+  bool GetDoubleArray(std::vector<double>* arr) const;
+  bool GetStringArray(std::vector<StringRef>* arr) const;
+
+ private:
+  int m_entry = -1;
+  int64_t m_timestamp = 0;
+  ArrayRef<uint8_t> m_data;
+};
+
+class DataLogReader;
+
+/**
+ * Iterates over the records of a DataLogReader.  Iteration stops at the
+ * first truncated record.
+ */
+class DataLogIterator {
+ public:
+  using iterator_category = std::forward_iterator_tag;
+  using value_type = DataLogRecord;
+  using difference_type = std::ptrdiff_t;
+  using pointer = const DataLogRecord*;
+  using reference = const DataLogRecord&;
+
+  DataLogIterator(const DataLogReader* reader, size_t pos)
+      : m_reader{reader}, m_pos{pos} {}
+
+  bool operator==(const DataLogIterator& oth) const {
+    return m_reader == oth.m_reader && m_pos == oth.m_pos;
+  }
+  bool operator!=(const DataLogIterator& oth) const { return !(*this == oth); }
+
+  DataLogIterator& operator++();
+  DataLogIterator operator++(int) {
+    DataLogIterator tmp = *this;
+    ++*this;
+    return tmp;
+  }
+
+  reference operator*() const;
+  pointer operator->() const { return &**this; }
+
+ private:
+  const DataLogReader* m_reader;
+  size_t m_pos;
+  mutable DataLogRecord m_value;
+};
+
+/**
+ * Reads a data log written by DataLog.
+ */
+class DataLogReader {
+  friend class DataLogIterator;
+
+ public:
+  /**
+   * Reads a data log from memory.
+   *
+   * @param data log contents
+   */
+  explicit DataLogReader(std::vector<uint8_t> data);
+
+  /**
+   * Reads a data log file.
+   *
+   * @param filename file name
+   * @param ec error code set if the file could not be read
+   */
+  DataLogReader(const Twine& filename, std::error_code& ec);
+
+  /**
+   * Returns true if the data has a valid header.
+   */
+  bool IsValid() const;
+
+  /**
+   * Gets the format version (e.g. 0x0100 for 1.0), or 0 if not valid.
+   */
+  uint16_t GetVersion() const;
+
+  /**
+   * Gets the extra header string.
+   */
+  StringRef GetExtraHeader() const;
+
+  DataLogIterator begin() const;
+  DataLogIterator end() const { return DataLogIterator{this, m_buf.size()}; }
+
+ private:
+  // Parses the record at *pos; returns false if it is truncated
+  bool GetRecord(size_t* pos, DataLogRecord* out) const;
+
+  std::vector<uint8_t> m_buf;
+};
+
+}  // namespace wpi::log
+
+#endif  // WPIUTIL_WPI_DATALOGREADER_H_
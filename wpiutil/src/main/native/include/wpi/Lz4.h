@@ -0,0 +1,49 @@
+// Copyright (c) FIRST and other WPILib contributors.
+// Open Source Software; you can modify and/or share it under the terms of
+// the WPILib BSD license file in the root directory of this project.
+
+#ifndef WPIUTIL_WPI_LZ4_H_
+#define WPIUTIL_WPI_LZ4_H_
+
+#include <cstddef>
+
+#include "wpi/StringRef.h"
+
+namespace wpi {
+template <typename T>
+class SmallVectorImpl;
+
+/**
+ * Returns the maximum size of the LZ4 compressed form of len bytes.
+ */
+constexpr size_t Lz4CompressBound(size_t len) {
+  return len + len / 255 + 16;
+}
+
+/**
+ * Compresses data into the LZ4 block format (no frame header).  The output is
+ * appended to buf.
+ *
+ * @param plain data to compress
+ * @param buf buffer to append the compressed data to
+ * @return The compressed data (the appended portion of buf)
+ */
+StringRef Lz4Compress(StringRef plain, SmallVectorImpl<char>& buf);
+
+/**
+ * Decompresses a LZ4 block.  The decompressed size must be known exactly
+ * (it is not stored in the block).  The output is appended to buf; on
+ * failure buf is left unchanged.
+ *
+ * @param compressed compressed block
+ * @param plain_len decompressed size
+ * @param buf buffer to append the decompressed data to
+ * @return False if the block is malformed or does not decompress to
+ *         exactly plain_len bytes.
+ */
+bool Lz4Decompress(StringRef compressed, size_t plain_len,
+                   SmallVectorImpl<char>& buf);
+
+}  // namespace wpi
+
+#endif  // WPIUTIL_WPI_LZ4_H_
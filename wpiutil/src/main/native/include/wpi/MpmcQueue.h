@@ -0,0 +1,181 @@
+// Copyright (c) FIRST and other WPILib contributors.
+// Open Source Software; you can modify and/or share it under the terms of
+// the WPILib BSD license file in the root directory of this project.
+
+#ifndef WPIUTIL_WPI_MPMCQUEUE_H_
+#define WPIUTIL_WPI_MPMCQUEUE_H_
+
+#include <stddef.h>
+
+#include <atomic>
+#include <memory>
+#include <new>
+#include <optional>
+#include <utility>
+
+namespace wpi {
+
+/**
+ * Bounded lock-free multi-producer, multi-consumer FIFO queue.
+ *
+ * Each slot of the ring carries a sequence number that tells producers and
+ * consumers whether it is free or full for their current lap, so push and
+ * pop each take a single compare-and-swap on the shared position and never
+ * block.  Push fails if the queue is full and pop fails if it is empty.
+ *
+ * @tparam T element type; must be move constructible
+ */
+template <typename T>
+class MpmcQueue {
+ public:
+  /**
+   * Constructs a queue.
+   *
+   * @param capacity maximum number of elements; rounded up to a power of 2
+   *                 (minimum 2)
+   */
+  explicit MpmcQueue(size_t capacity) {
+    size_t size = 2;
+    while (size < capacity) {
+      size *= 2;
+    }
+    m_mask = size - 1;
+    m_cells.reset(new Cell[size]);
+    for (size_t i = 0; i < size; ++i) {
+      m_cells[i].seq.store(i, std::memory_order_relaxed);
+    }
+  }
+
+  ~MpmcQueue() {
+    size_t pos = m_dequeue_pos.load(std::memory_order_relaxed);
+    size_t end = m_enqueue_pos.load(std::memory_order_relaxed);
+    for (; pos != end; ++pos) {
+      m_cells[pos & m_mask].get()->~T();
+    }
+  }
+
+  MpmcQueue(const MpmcQueue&) = delete;
+  MpmcQueue& operator=(const MpmcQueue&) = delete;
+
+  /**
+   * Constructs an element at the back of the queue.
+   *
+   * @return False if the queue was full (nothing is constructed)
+   */
+  template <typename... Args>
+  bool try_emplace(Args&&... args) {
+    Cell* cell;
+    size_t pos = m_enqueue_pos.load(std::memory_order_relaxed);
+    for (;;) {
+      cell = &m_cells[pos & m_mask];
+      size_t seq = cell->seq.load(std::memory_order_acquire);
+      auto diff = static_cast<ptrdiff_t>(seq) - static_cast<ptrdiff_t>(pos);
+      if (diff == 0) {
+        if (m_enqueue_pos.compare_exchange_weak(pos, pos + 1,
+                                                std::memory_order_relaxed)) {
+          break;
+        }
+      } else if (diff < 0) {
+        return false;  // full
+      } else {
+        pos = m_enqueue_pos.load(std::memory_order_relaxed);
+      }
+    }
+    new (cell->storage) T(std::forward<Args>(args)...);
+    cell->seq.store(pos + 1, std::memory_order_release);
+    return true;
+  }
+
+  bool try_push(const T& value) { return try_emplace(value); }
+  bool try_push(T&& value) { return try_emplace(std::move(value)); }
+
+  /**
+   * Removes the element at the front of the queue.
+   *
+   * @param value element (output); only set if true is returned
+   * @return False if the queue was empty
+   */
+  bool try_pop(T& value) {
+    return try_consume([&](T&& elem) { value = std::move(elem); });
+  }
+
+  /**
+   * Removes the element at the front of the queue.
+   *
+   * @return The element, or nullopt if the queue was empty
+   */
+  std::optional<T> try_pop() {
+    std::optional<T> value;
+    try_consume([&](T&& elem) { value.emplace(std::move(elem)); });
+    return value;
+  }
+
+  /**
+   * Gets the maximum number of elements.
+   */
+  size_t capacity() const { return m_mask + 1; }
+
+  /**
+   * Gets the number of elements.  This is only a snapshot if other threads
+   * are using the queue.
+   */
+  size_t size_approx() const {
+    size_t deq = m_dequeue_pos.load(std::memory_order_acquire);
+    size_t enq = m_enqueue_pos.load(std::memory_order_acquire);
+    return enq > deq ? enq - deq : 0;
+  }
+
+  /**
+   * Determines if the queue is empty.  This is only a snapshot if other
+   * threads are using the queue.
+   */
+  bool empty_approx() const { return size_approx() == 0; }
+
+ private:
+  // Claims the front element, passes it (as an rvalue) to consume, and
+  // destroys it.  Returns false if the queue was empty.
+  template <typename F>
+  bool try_consume(F&& consume) {
+    Cell* cell;
+    size_t pos = m_dequeue_pos.load(std::memory_order_relaxed);
+    for (;;) {
+      cell = &m_cells[pos & m_mask];
+      size_t seq = cell->seq.load(std::memory_order_acquire);
+      auto diff =
+          static_cast<ptrdiff_t>(seq) - static_cast<ptrdiff_t>(pos + 1);
+      if (diff == 0) {
+        if (m_dequeue_pos.compare_exchange_weak(pos, pos + 1,
+                                                std::memory_order_relaxed)) {
+          break;
+        }
+      } else if (diff < 0) {
+        return false;  // empty
+      } else {
+        pos = m_dequeue_pos.load(std::memory_order_relaxed);
+      }
+    }
+    T* elem = cell->get();
+    consume(std::move(*elem));
+    elem->~T();
+    cell->seq.store(pos + m_mask + 1, std::memory_order_release);
+    return true;
+  }
+
+  struct Cell {
+    T* get() { return std::launder(reinterpret_cast<T*>(storage)); }
+
+    std::atomic<size_t> seq;
+    alignas(T) unsigned char storage[sizeof(T)];
+  };
+
+  size_t m_mask;
+  std::unique_ptr<Cell[]> m_cells;
+
+  // Keep the positions on separate cache lines
+  alignas(64) std::atomic<size_t> m_enqueue_pos{0};
+  alignas(64) std::atomic<size_t> m_dequeue_pos{0};
+};
+
+}  // namespace wpi
+
+#endif  // WPIUTIL_WPI_MPMCQUEUE_H_
@@ -0,0 +1,42 @@
+// Copyright (c) FIRST and other WPILib contributors.
+// Open Source Software; you can modify and/or share it under the terms of
+// the WPILib BSD license file in the root directory of this project.
+
+#ifndef WPIUTIL_WPI_SHAREDMEMORYACCEPTOR_H_
+#define WPIUTIL_WPI_SHAREDMEMORYACCEPTOR_H_
+
+#include <atomic>
+#include <memory>
+#include <string>
+
+#include "wpi/NetworkAcceptor.h"
+#include "wpi/SharedMemoryStream.h"
+#include "wpi/Twine.h"
+
+namespace wpi {
+
+class Logger;
+
+/**
+ * Accepts SharedMemoryStream connections from processes on the same host.
+ * The name identifies the shared memory region; start() fails if another
+ * live process is already accepting on it.  Only supported on Linux.
+ */
+class SharedMemoryAcceptor : public NetworkAcceptor {
+  std::shared_ptr<shm::Mapping> m_mapping;
+  std::string m_name;
+  std::atomic_bool m_shutdown;
+  Logger& m_logger;
+
+ public:
+  SharedMemoryAcceptor(const Twine& name, Logger& logger);
+  ~SharedMemoryAcceptor() override;
+
+  int start() override;
+  void shutdown() final;
+  std::unique_ptr<NetworkStream> accept() override;
+};
+
+}  // namespace wpi
+
+#endif  // WPIUTIL_WPI_SHAREDMEMORYACCEPTOR_H_
@@ -0,0 +1,37 @@
+// Copyright (c) FIRST and other WPILib contributors.
+// Open Source Software; you can modify and/or share it under the terms of
+// the WPILib BSD license file in the root directory of this project.
+
+#ifndef WPIUTIL_WPI_SHAREDMEMORYCONNECTOR_H_
+#define WPIUTIL_WPI_SHAREDMEMORYCONNECTOR_H_
+
+#include <memory>
+
+#include "wpi/NetworkStream.h"
+
+namespace wpi {
+
+class Logger;
+
+/**
+ * Connects to a SharedMemoryAcceptor in another process on the same host.
+ * Only supported on Linux.
+ */
+class SharedMemoryConnector {
+ public:
+  /**
+   * Connects to the acceptor with the given name.
+   *
+   * @param name acceptor name
+   * @param logger logger
+   * @param timeout seconds to wait for the acceptor (0 for a default of 1)
+   * @return Stream, or nullptr on failure
+   */
+  static std::unique_ptr<NetworkStream> connect(const char* name,
+                                                Logger& logger,
+                                                int timeout = 0);
+};
+
+}  // namespace wpi
+
+#endif  // WPIUTIL_WPI_SHAREDMEMORYCONNECTOR_H_
@@ -0,0 +1,74 @@
+// Copyright (c) FIRST and other WPILib contributors.
+// Open Source Software; you can modify and/or share it under the terms of
+// the WPILib BSD license file in the root directory of this project.
+
+#ifndef WPIUTIL_WPI_SHAREDMEMORYSTREAM_H_
+#define WPIUTIL_WPI_SHAREDMEMORYSTREAM_H_
+
+#include <stdint.h>
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <string>
+
+#include "wpi/NetworkStream.h"
+
+namespace wpi {
+
+namespace shm {
+class Mapping;
+struct Ring;
+struct Slot;
+}  // namespace shm
+
+/**
+ * A stream between two processes on the same host, carried over a pair of
+ * ring buffers in shared memory.  Created by SharedMemoryAcceptor and
+ * SharedMemoryConnector.  The peer IP is reported as "shm:<name>" and the
+ * peer port as the peer's process id.
+ */
+class SharedMemoryStream : public NetworkStream {
+ public:
+  friend class SharedMemoryAcceptor;
+  friend class SharedMemoryConnector;
+
+  ~SharedMemoryStream() override;
+
+  size_t send(const char* buffer, size_t len, Error* err) override;
+  size_t receive(char* buffer, size_t len, Error* err,
+                 int timeout = 0) override;
+  void close() final;
+
+  StringRef getPeerIP() const override;
+  int getPeerPort() const override;
+  void setNoDelay() override;
+  bool setBlocking(bool enabled) override;
+  int getNativeHandle() const override;
+
+  SharedMemoryStream(const SharedMemoryStream&) = delete;
+  SharedMemoryStream& operator=(const SharedMemoryStream&) = delete;
+
+ private:
+  SharedMemoryStream(std::shared_ptr<shm::Mapping> mapping, size_t slot,
+                     bool server);
+
+  bool IsClosed() const;
+  // Waits for a sequence word to change; closes the stream if the peer
+  // process has exited.
+  void WaitFor(std::atomic<uint32_t>& seq, std::atomic<uint32_t>& waiting,
+               std::atomic<uint32_t>& pos, uint32_t value, int timeout_ms);
+
+  std::shared_ptr<shm::Mapping> m_mapping;
+  shm::Slot* m_slot;
+  shm::Ring* m_in;
+  shm::Ring* m_out;
+  bool m_server;
+  uint32_t m_peerPid;
+  std::string m_peerName;
+  std::atomic_bool m_closed{false};
+};
+
+}  // namespace wpi
+
+#endif  // WPIUTIL_WPI_SHAREDMEMORYSTREAM_H_
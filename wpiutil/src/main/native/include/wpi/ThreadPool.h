@@ -0,0 +1,192 @@
+// Copyright (c) FIRST and other WPILib contributors.
+// Open Source Software; you can modify and/or share it under the terms of
+// the WPILib BSD license file in the root directory of this project.
+
+#ifndef WPIUTIL_WPI_THREADPOOL_H_
+#define WPIUTIL_WPI_THREADPOOL_H_
+
+#include <stdint.h>
+
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+#include "wpi/future.h"
+
+namespace wpi {
+
+/**
+ * A fixed-size pool of threads that run tasks, with work stealing.
+ *
+ * Tasks posted from outside the pool go into a shared lock-free queue
+ * (MpmcQueue).  Tasks posted by a task running on the pool go onto the
+ * posting thread's own queue, which it runs newest first; idle threads steal
+ * the oldest tasks from other threads' queues.  This keeps recursive
+ * (fork-join) work local to a thread while still spreading it across the
+ * pool.  Idle threads sleep until a task is posted.
+ *
+ * Submit() and Then() return a @ref future for the result of the task, so
+ * results can be waited for or chained with further tasks that also run on
+ * the pool.  A task that waits for other tasks should use Get() rather than
+ * future::get(), so that it runs queued tasks while it waits instead of
+ * tying up its thread (which can deadlock a small pool).
+ *
+ * Tasks are stored in std::function, so they must be copyable, and must not
+ * throw.  Destroying the pool runs the tasks that are still queued and then
+ * joins the threads; tasks must not post to a pool that is being destroyed
+ * from another thread.
+ */
+class ThreadPool {
+ public:
+  /**
+   * Constructs a pool and starts its threads.
+   *
+   * @param numThreads number of threads; 0 for one per hardware thread
+   */
+  explicit ThreadPool(unsigned int numThreads = 0);
+
+  /**
+   * Runs the tasks that are still queued and joins the threads.
+   */
+  ~ThreadPool();
+
+  ThreadPool(const ThreadPool&) = delete;
+  ThreadPool& operator=(const ThreadPool&) = delete;
+
+  /**
+   * Gets the number of threads.
+   */
+  unsigned int GetNumThreads() const;
+
+  /**
+   * Queues a task.  Never blocks.
+   *
+   * @param task task
+   */
+  void Post(std::function<void()> task);
+
+  /**
+   * Queues a task that returns a value.
+   *
+   * @param factory promise factory for the result
+   * @param func task
+   * @return Future for the value returned by func
+   */
+  template <typename R, typename F>
+  future<R> Submit(PromiseFactory<R>& factory, F&& func) {
+    uint64_t req = factory.CreateRequest();
+    future<R> result = factory.CreateFuture(req);
+    Post([&factory, req, func = std::forward<F>(func)]() mutable {
+      SetResult(factory, req, func);
+    });
+    return result;
+  }
+
+  /**
+   * Queues a task that returns a value, using the default promise factory.
+   *
+   * @param func task
+   * @return Future for the value returned by func
+   */
+  template <typename F, typename R = std::invoke_result_t<F&>>
+  future<R> Submit(F&& func) {
+    return Submit(PromiseFactory<R>::GetInstance(), std::forward<F>(func));
+  }
+
+  /**
+   * Queues a continuation to run on the pool once a future is ready.
+   * Unlike future::then(), which runs the continuation on the thread that
+   * sets the value, this only queues it there.  The pool must outlive the
+   * input future.
+   *
+   * @param in input future
+   * @param func continuation; called with the value of the input future
+   * @return Future for the value returned by func, invalid if in is invalid
+   */
+  template <typename T, typename F,
+            typename R = std::invoke_result_t<F&, T&&>>
+  future<R> Then(future<T>&& in, F&& func) {
+    if (!in.valid()) {
+      return {};
+    }
+    auto& factory = PromiseFactory<R>::GetInstance();
+    uint64_t req = factory.CreateRequest();
+    future<R> result = factory.CreateFuture(req);
+    in.then(PromiseFactory<void>::GetInstance(),
+            [this, &factory, req, func = std::forward<F>(func)](T value) {
+              Post([&factory, req, func, value = std::move(value)]() mutable {
+                SetResult(factory, req, func, std::move(value));
+              });
+            });
+    return result;
+  }
+
+  /**
+   * Queues a continuation to run on the pool once a future<void> is ready.
+   *
+   * @param in input future
+   * @param func continuation
+   * @return Future for the value returned by func, invalid if in is invalid
+   */
+  template <typename F, typename R = std::invoke_result_t<F&>>
+  future<R> Then(future<void>&& in, F&& func) {
+    if (!in.valid()) {
+      return {};
+    }
+    auto& factory = PromiseFactory<R>::GetInstance();
+    uint64_t req = factory.CreateRequest();
+    future<R> result = factory.CreateFuture(req);
+    in.then(PromiseFactory<void>::GetInstance(),
+            [this, &factory, req, func = std::forward<F>(func)] {
+              Post([&factory, req, func]() mutable {
+                SetResult(factory, req, func);
+              });
+            });
+    return result;
+  }
+
+  /**
+   * Runs one queued task on the calling thread, if there is one.
+   *
+   * @return False if no task was queued
+   */
+  bool RunPendingTask();
+
+  /**
+   * Gets the value of a future, running queued tasks on the calling thread
+   * while waiting for it.
+   *
+   * @param f future
+   * @return The value
+   */
+  template <typename T>
+  T Get(future<T>& f) {
+    while (!f.is_ready()) {
+      if (!RunPendingTask()) {
+        f.wait_for(std::chrono::microseconds(100));
+      }
+    }
+    return f.get();
+  }
+
+ private:
+  template <typename R, typename F, typename... Args>
+  static void SetResult(PromiseFactory<R>& factory, uint64_t req, F& func,
+                        Args&&... args) {
+    if constexpr (std::is_void_v<R>) {
+      func(std::forward<Args>(args)...);
+      factory.SetValue(req);
+    } else {
+      factory.SetValue(req, func(std::forward<Args>(args)...));
+    }
+  }
+
+  class Impl;
+  std::unique_ptr<Impl> m_impl;
+};
+
+}  // namespace wpi
+
+#endif  // WPIUTIL_WPI_THREADPOOL_H_
@@ -43,6 +43,10 @@ class UDPClient {
   int receive(uint8_t* data_received, int receive_len,
               SmallVectorImpl<char>* addr_received, int* port_received);
   int set_timeout(double timeout);
+
+  // The port bound by start() (the ephemeral port chosen if 0 was passed),
+  // or 0 if not started.
+  int port() const { return m_port; }
 };
 
 }  // namespace wpi
@@ -0,0 +1,230 @@
+// Copyright (c) FIRST and other WPILib contributors.
+// Open Source Software; you can modify and/or share it under the terms of
+// the WPILib BSD license file in the root directory of this project.
+
+#ifndef WPIUTIL_WPI_ARENA_JSON_H_
+#define WPIUTIL_WPI_ARENA_JSON_H_
+
+#include <stdint.h>
+
+#include <string>
+#include <type_traits>
+
+#include "wpi/Arena.h"
+#include "wpi/ArrayRef.h"
+#include "wpi/StringRef.h"
+#include "wpi/json.h"
+
+namespace wpi {
+
+class raw_istream;
+struct arena_json_member;
+
+/**
+ * A read-only JSON document stored entirely in an Arena.
+ *
+ * Parsing into a @ref json allocates every object, array, string and
+ * object key separately.  arena_json::parse() instead places the whole
+ * document (values, keys and strings) in an Arena, so parsing is a few
+ * pointer increments per node and the document is freed all at once by
+ * resetting or destroying the arena.  Reusing one arena for a stream of
+ * messages (resetting it between them) avoids malloc altogether once it has
+ * grown to fit the largest message.
+ *
+ * Values are immutable and only valid as long as the arena they were parsed
+ * into.  Array elements and object members are stored contiguously; object
+ * members keep their document order, and lookup by key is a linear search
+ * that returns the first member with that key (as @ref json does).  Use
+ * to_json() to get a mutable copy.
+ */
+class arena_json {
+ public:
+  using value_t = detail::value_t;
+
+  using member = arena_json_member;
+
+  /**
+   * Parses a JSON document into an arena.  Syntax is the same as
+   * json::parse().
+   *
+   * @param s input
+   * @param arena arena to hold the document
+   * @param allow_exceptions if false, a parse error returns a discarded
+   *                         value instead of throwing
+   * @return Parsed value, allocated in the arena
+   * @throw json::parse_error on a syntax error
+   */
+  static const arena_json& parse(StringRef s, Arena& arena,
+                                 bool allow_exceptions = true);
+  static const arena_json& parse(raw_istream& is, Arena& arena,
+                                 bool allow_exceptions = true);
+
+  /**
+   * Copies a @ref json value into an arena.
+   *
+   * @param j value
+   * @param arena arena to hold the copy
+   * @return Copy, allocated in the arena
+   */
+  static const arena_json& from_json(const json& j, Arena& arena);
+
+  /**
+   * Copies the value into a @ref json.
+   */
+  json to_json() const;
+
+  value_t type() const noexcept { return m_type; }
+  bool is_null() const noexcept { return m_type == value_t::null; }
+  bool is_boolean() const noexcept { return m_type == value_t::boolean; }
+  bool is_number() const noexcept {
+    return is_number_integer() || is_number_float();
+  }
+  bool is_number_integer() const noexcept {
+    return m_type == value_t::number_integer ||
+           m_type == value_t::number_unsigned;
+  }
+  bool is_number_unsigned() const noexcept {
+    return m_type == value_t::number_unsigned;
+  }
+  bool is_number_float() const noexcept {
+    return m_type == value_t::number_float;
+  }
+  bool is_string() const noexcept { return m_type == value_t::string; }
+  bool is_array() const noexcept { return m_type == value_t::array; }
+  bool is_object() const noexcept { return m_type == value_t::object; }
+  bool is_discarded() const noexcept { return m_type == value_t::discarded; }
+
+  /**
+   * Returns the number of elements of an array or members of an object,
+   * 0 for null, and 1 for other values (as json::size() does).
+   */
+  size_t size() const noexcept;
+  bool empty() const noexcept { return size() == 0; }
+
+  /**
+   * Gets the elements of an array (empty for other types).
+   */
+  ArrayRef<arena_json> elements() const noexcept;
+
+  /**
+   * Gets the members of an object (empty for other types).
+   */
+  ArrayRef<member> members() const noexcept;
+
+  /**
+   * Accesses an array element without bounds checking.
+   */
+  const arena_json& operator[](size_t idx) const { return m_value.array[idx]; }
+
+  /**
+   * Accesses an array element.
+   *
+   * @throw json::type_error if not an array
+   * @throw json::out_of_range if idx is out of range
+   */
+  const arena_json& at(size_t idx) const;
+
+  /**
+   * Accesses an object member.
+   *
+   * @throw json::type_error if not an object
+   * @throw json::out_of_range if there is no member with that key
+   */
+  const arena_json& at(StringRef key) const;
+
+  /**
+   * Finds an object member.
+   *
+   * @param key member key
+   * @return Member value, or nullptr if not found or not an object
+   */
+  const arena_json* find(StringRef key) const noexcept;
+
+  /**
+   * Returns 1 if an object has a member with the given key, else 0.
+   */
+  size_t count(StringRef key) const noexcept {
+    return find(key) ? 1 : 0;
+  }
+
+  /**
+   * Gets the value as a bool, arithmetic type, StringRef or std::string,
+   * with the same conversions as json::get().
+   *
+   * @throw json::type_error if the value does not have a compatible type
+   */
+  template <typename T>
+  T get() const {
+    if constexpr (std::is_same_v<T, bool>) {
+      if (!is_boolean()) {
+        ThrowTypeError("boolean");
+      }
+      return m_value.boolean;
+    } else if constexpr (std::is_arithmetic_v<T>) {
+      switch (m_type) {
+        case value_t::number_unsigned:
+          return static_cast<T>(m_value.number_unsigned);
+        case value_t::number_integer:
+          return static_cast<T>(m_value.number_integer);
+        case value_t::number_float:
+          return static_cast<T>(m_value.number_float);
+        default:
+          ThrowTypeError("number");
+      }
+    } else {
+      static_assert(std::is_same_v<T, StringRef> ||
+                        std::is_same_v<T, std::string>,
+                    "unsupported type");
+      if (!is_string()) {
+        ThrowTypeError("string");
+      }
+      return T(m_value.string, m_size);
+    }
+  }
+
+  /**
+   * Returns the type name, as json::type_name() does.
+   */
+  const char* type_name() const noexcept;
+
+ private:
+  class parser;
+
+  void assign(const json& j, Arena& arena);
+  [[noreturn]] void ThrowTypeError(const char* expected) const;
+
+  value_t m_type = value_t::null;
+  // string length, or number of array elements or object members
+  size_t m_size = 0;
+  union {
+    bool boolean;
+    int64_t number_integer;
+    uint64_t number_unsigned;
+    double number_float;
+    const char* string;
+    const arena_json* array;
+    const member* object;
+  } m_value = {};
+};
+
+/**
+ * An arena_json object member.
+ */
+struct arena_json_member {
+  StringRef key;
+  arena_json value;
+};
+
+inline ArrayRef<arena_json> arena_json::elements() const noexcept {
+  return is_array() ? ArrayRef<arena_json>{m_value.array, m_size}
+                    : ArrayRef<arena_json>{};
+}
+
+inline ArrayRef<arena_json::member> arena_json::members() const noexcept {
+  return is_object() ? ArrayRef<member>{m_value.object, m_size}
+                     : ArrayRef<member>{};
+}
+
+}  // namespace wpi
+
+#endif  // WPIUTIL_WPI_ARENA_JSON_H_
@@ -71,6 +71,8 @@ class raw_istream;
 class raw_ostream;
 
 class JsonTest;
+class arena_json;
+class json_sax;
 
 /*!
 @brief default JSONSerializer template argument
@@ -2660,6 +2662,7 @@ class json
     template<typename BasicJsonType>
     friend class ::wpi::detail::iter_impl;
     friend class JsonTest;
+    friend class arena_json;
 
     /// workaround type for MSVC
     using json_t = json;
@@ -2678,6 +2681,7 @@ class json
     class binary_writer;
     class lexer;
     class parser;
+    class sax_parser;
     class serializer;
 
   public:
@@ -7032,6 +7036,35 @@ class json
 
     static bool accept(raw_istream& i);
 
+    /*!
+    @brief generate SAX events
+
+    Parses the input like @ref parse(), but instead of building a JSON value
+    calls a function of @a sax for each token (see @ref json_sax).  This
+    avoids allocating a DOM when only part of a document is needed.
+
+    @param[in] s  input to read from
+    @param[in,out] sax  SAX event handler
+    @param[in] strict  whether the input has to be consumed completely
+
+    @return true if the input was parsed completely; false if a handler
+    function returned false or a syntax error occurred, in which case the
+    return value of json_sax::parse_error() is returned
+
+    @note Syntax errors are reported to json_sax::parse_error(); this
+    function does not throw.
+
+    @complexity Linear in the length of the input.
+    */
+    static bool sax_parse(StringRef s, json_sax* sax,
+                          const bool strict = true);
+
+    static bool sax_parse(ArrayRef<uint8_t> arr, json_sax* sax,
+                          const bool strict = true);
+
+    static bool sax_parse(raw_istream& i, json_sax* sax,
+                          const bool strict = true);
+
     /*!
     @brief deserialize from stream
 
@@ -0,0 +1,107 @@
+// Copyright (c) FIRST and other WPILib contributors.
+// Open Source Software; you can modify and/or share it under the terms of
+// the WPILib BSD license file in the root directory of this project.
+
+#ifndef WPIUTIL_WPI_JSON_SAX_H_
+#define WPIUTIL_WPI_JSON_SAX_H_
+
+#include <stdint.h>
+
+#include <cstddef>
+
+#include "wpi/StringRef.h"
+#include "wpi/json.h"
+
+namespace wpi {
+
+/**
+ * Event handler for json::sax_parse().
+ *
+ * The parser calls one function per token of the document, in document
+ * order, without building a @ref json value.  Each function returns true to
+ * continue parsing or false to stop; a handler that has found the fields it
+ * is looking for can return false to skip the rest of the input.  The
+ * default implementations ignore the event and continue, so a handler only
+ * needs to override the events it cares about.
+ *
+ * Strings and keys passed to string() and key() have escapes decoded, and
+ * are only valid for the duration of the call.
+ */
+class json_sax {
+ public:
+  virtual ~json_sax() = default;
+
+  /**
+   * A null value.
+   */
+  virtual bool null() { return true; }
+
+  /**
+   * A boolean value.
+   */
+  virtual bool boolean(bool val) { return true; }
+
+  /**
+   * A negative integer.
+   */
+  virtual bool number_integer(int64_t val) { return true; }
+
+  /**
+   * A non-negative integer.
+   */
+  virtual bool number_unsigned(uint64_t val) { return true; }
+
+  /**
+   * A floating point number.
+   */
+  virtual bool number_float(double val) { return true; }
+
+  /**
+   * A string value.
+   */
+  virtual bool string(StringRef val) { return true; }
+
+  /**
+   * The beginning of an object.  It is followed by key() and a value for
+   * each member, then end_object().
+   */
+  virtual bool start_object() { return true; }
+
+  /**
+   * An object member key.
+   */
+  virtual bool key(StringRef val) { return true; }
+
+  /**
+   * The end of an object.
+   */
+  virtual bool end_object() { return true; }
+
+  /**
+   * The beginning of an array.  It is followed by each element, then
+   * end_array().
+   */
+  virtual bool start_array() { return true; }
+
+  /**
+   * The end of an array.
+   */
+  virtual bool end_array() { return true; }
+
+  /**
+   * A syntax error.  Parsing always stops after an error; the return value
+   * is returned by json::sax_parse().
+   *
+   * @param position byte position of the error in the input
+   * @param last_token the last token read
+   * @param ex the exception json::parse() would have thrown
+   */
+  virtual bool parse_error(size_t position, StringRef last_token,
+                           const json::exception& ex) {
+    return false;
+  }
+};
+
+}  // namespace wpi
+
+#endif  // WPIUTIL_WPI_JSON_SAX_H_
@@ -0,0 +1,55 @@
+// Copyright (c) FIRST and other WPILib contributors.
+// Open Source Software; you can modify and/or share it under the terms of
+// the WPILib BSD license file in the root directory of this project.
+
+#ifndef WPIUTIL_WPI_JSON_SIMD_H_
+#define WPIUTIL_WPI_JSON_SIMD_H_
+
+#include <cstddef>
+
+namespace wpi::detail {
+
+/**
+ * Implementations of json_plain_prefix().
+ */
+enum class json_simd { scalar, sse2, avx2, neon };
+
+/**
+ * Returns the length of the run of "plain" characters at the start of a
+ * string: printable ASCII (0x20 to 0x7E) other than quote and backslash.
+ * These are the characters the json lexer and serializer copy through
+ * unchanged, so both use this to skip over them in bulk instead of one byte
+ * at a time.
+ *
+ * The fastest implementation supported by the CPU (SSE2 or AVX2 on x86,
+ * NEON on ARM when the compiler targets it, otherwise scalar code) is
+ * selected on first use.
+ *
+ * @param s string
+ * @param len length of string
+ * @return Number of leading plain characters
+ */
+size_t json_plain_prefix(const char* s, size_t len) noexcept;
+
+/**
+ * Gets the implementation used by json_plain_prefix().
+ */
+json_simd json_get_simd() noexcept;
+
+/**
+ * Gets the fastest implementation supported by the CPU.
+ */
+json_simd json_best_simd() noexcept;
+
+/**
+ * Selects the implementation used by json_plain_prefix(), for testing and
+ * benchmarking.
+ *
+ * @param simd implementation; ignored if not supported by the CPU
+ * @return True if supported
+ */
+bool json_set_simd(json_simd simd) noexcept;
+
+}  // namespace wpi::detail
+
+#endif  // WPIUTIL_WPI_JSON_SIMD_H_
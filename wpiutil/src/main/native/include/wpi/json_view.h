@@ -0,0 +1,252 @@
+// Copyright (c) FIRST and other WPILib contributors.
+// Open Source Software; you can modify and/or share it under the terms of
+// the WPILib BSD license file in the root directory of this project.
+
+#ifndef WPIUTIL_WPI_JSON_VIEW_H_
+#define WPIUTIL_WPI_JSON_VIEW_H_
+
+#include <stdint.h>
+
+#include <cstddef>
+#include <iterator>
+#include <string>
+#include <type_traits>
+
+#include "wpi/SmallString.h"
+#include "wpi/SmallVector.h"
+#include "wpi/StringRef.h"
+#include "wpi/json.h"
+
+namespace wpi {
+
+/**
+ * A lazily parsed, read-only view of a JSON value held in a string.
+ *
+ * Constructing a view does no parsing.  Looking up an object member or an
+ * array element scans the text of the containing value just far enough to
+ * find it, skipping over the other values without decoding them, and
+ * returns another view; only get() decodes a value.  This makes reading a
+ * couple of fields from a message much cheaper than json::parse(), which
+ * builds the whole document.
+ *
+ * The view does not own the text, which must outlive it.  The document is
+ * not validated up front: malformed text is only detected in the parts that
+ * are scanned, and is reported by throwing json::parse_error (use
+ * json::accept() to validate a whole document).  A view of a missing value
+ * is "discarded" (see is_discarded()).
+ *
+ * Lookups are linear in the size of the containing value, so a view is
+ * best suited to reading a few fields once; parse() the value to access it
+ * repeatedly.
+ */
+class json_view {
+ public:
+  using value_t = detail::value_t;
+
+  class iterator;
+
+  /**
+   * Constructs a discarded view.
+   */
+  json_view() = default;
+
+  /**
+   * Constructs a view of a JSON value.  Surrounding whitespace is ignored.
+   *
+   * @param text JSON text
+   */
+  explicit json_view(StringRef text) : m_text{text.trim(" \t\n\r")} {}
+
+  /**
+   * Gets the text of the value.
+   */
+  StringRef text() const noexcept { return m_text; }
+
+  /**
+   * Gets the type of the value, as determined by its first character.
+   */
+  value_t type() const noexcept;
+
+  bool is_null() const noexcept { return type() == value_t::null; }
+  bool is_boolean() const noexcept { return type() == value_t::boolean; }
+  bool is_number() const noexcept {
+    return is_number_integer() || is_number_float();
+  }
+  bool is_number_integer() const noexcept {
+    auto t = type();
+    return t == value_t::number_integer || t == value_t::number_unsigned;
+  }
+  bool is_number_unsigned() const noexcept {
+    return type() == value_t::number_unsigned;
+  }
+  bool is_number_float() const noexcept {
+    return type() == value_t::number_float;
+  }
+  bool is_string() const noexcept { return type() == value_t::string; }
+  bool is_array() const noexcept { return type() == value_t::array; }
+  bool is_object() const noexcept { return type() == value_t::object; }
+  bool is_discarded() const noexcept { return m_text.empty(); }
+
+  /**
+   * Returns the number of elements of an array or members of an object,
+   * 0 for null or a discarded view, and 1 for other values.  Scans the
+   * whole value.
+   */
+  size_t size() const;
+  bool empty() const { return size() == 0; }
+
+  /**
+   * Finds an object member.
+   *
+   * @param key member key
+   * @return View of the member value, discarded if not found or not an
+   *         object
+   */
+  json_view find(StringRef key) const;
+
+  /**
+   * Finds an object member; same as find().
+   */
+  json_view operator[](StringRef key) const { return find(key); }
+
+  /**
+   * Gets an array element.
+   *
+   * @param idx index
+   * @return View of the element, discarded if out of range or not an array
+   */
+  json_view operator[](size_t idx) const;
+
+  /**
+   * Accesses an object member.
+   *
+   * @throw json::type_error if not an object
+   * @throw json::out_of_range if there is no member with that key
+   */
+  json_view at(StringRef key) const;
+
+  /**
+   * Accesses an array element.
+   *
+   * @throw json::type_error if not an array
+   * @throw json::out_of_range if idx is out of range
+   */
+  json_view at(size_t idx) const;
+
+  /**
+   * Iterates over the elements of an array or the members of an object
+   * (empty for other types).
+   */
+  iterator begin() const;
+  iterator end() const;
+
+  /**
+   * Gets a string value.  Strings without escapes are returned directly
+   * from the text; others are decoded into buf.
+   *
+   * @param buf buffer for decoded strings
+   * @throw json::type_error if not a string
+   */
+  StringRef get_string(SmallVectorImpl<char>& buf) const;
+
+  /**
+   * Gets the value as a bool, arithmetic type or std::string, with the
+   * same conversions as json::get().
+   *
+   * @throw json::type_error if the value does not have a compatible type
+   */
+  template <typename T>
+  T get() const {
+    if constexpr (std::is_same_v<T, bool>) {
+      return get_boolean();
+    } else if constexpr (std::is_arithmetic_v<T>) {
+      return get_number().get<T>();
+    } else {
+      static_assert(std::is_same_v<T, std::string>, "unsupported type");
+      SmallString<64> buf;
+      return get_string(buf);
+    }
+  }
+
+  /**
+   * Parses the value into a @ref json.
+   */
+  json parse() const { return json::parse(m_text); }
+
+  /**
+   * Returns the type name, as json::type_name() does.
+   */
+  const char* type_name() const noexcept;
+
+ private:
+  bool get_boolean() const;
+  json get_number() const;
+  [[noreturn]] void ThrowTypeError(const char* expected) const;
+
+  StringRef m_text;
+};
+
+/**
+ * Iterator over the elements of an array or the members of an object.
+ * Dereferencing gives the element or member value.
+ */
+class json_view::iterator {
+ public:
+  using iterator_category = std::forward_iterator_tag;
+  using value_type = json_view;
+  using difference_type = std::ptrdiff_t;
+  using pointer = const json_view*;
+  using reference = const json_view&;
+
+  iterator() = default;
+
+  /**
+   * Gets the text of the member key, including the quotes.
+   */
+  StringRef raw_key() const noexcept { return m_key; }
+
+  /**
+   * Gets the member key.  Keys without escapes are returned directly from
+   * the text; others are decoded into buf.
+   */
+  StringRef key(SmallVectorImpl<char>& buf) const {
+    return json_view{m_key}.get_string(buf);
+  }
+
+  reference operator*() const noexcept { return m_value; }
+  pointer operator->() const noexcept { return &m_value; }
+
+  iterator& operator++();
+  iterator operator++(int) {
+    iterator tmp = *this;
+    ++*this;
+    return tmp;
+  }
+
+  bool operator==(const iterator& rhs) const noexcept {
+    return m_pos == rhs.m_pos;
+  }
+  bool operator!=(const iterator& rhs) const noexcept {
+    return m_pos != rhs.m_pos;
+  }
+
+ private:
+  friend class json_view;
+
+  iterator(StringRef container, size_t pos);
+
+  // reads the element or member starting at m_pos
+  void read();
+
+  StringRef m_container;
+  // position of the current element or member; npos at the end
+  size_t m_pos = StringRef::npos;
+  // position after the current element's value
+  size_t m_next = StringRef::npos;
+  StringRef m_key;
+  json_view m_value;
+};
+
+}  // namespace wpi
+
+#endif  // WPIUTIL_WPI_JSON_VIEW_H_
@@ -109,6 +109,11 @@ class raw_istream {
   // read.
   virtual size_t in_avail() const = 0;
 
+  // Data already buffered by the stream, which can be examined without
+  // consuming it (read() it to advance).  Returns an empty string if the
+  // stream has no internal buffer.
+  virtual StringRef peek_buffer() const { return {}; }
+
   // Return the number of bytes read by the last read operation.
   size_t read_count() const { return m_read_count; }
 
@@ -144,6 +149,7 @@ class raw_mem_istream : public raw_istream {
   raw_mem_istream(const char* mem, size_t len) : m_cur(mem), m_left(len) {}
   void close() override;
   size_t in_avail() const override;
+  StringRef peek_buffer() const override;
 
  private:
   void read_impl(void* data, size_t len) override;
@@ -160,6 +166,7 @@ class raw_fd_istream : public raw_istream {
   ~raw_fd_istream() override;
   void close() final;
   size_t in_avail() const override;
+  StringRef peek_buffer() const override;
 
  private:
   void read_impl(void* data, size_t len) override;
@@ -0,0 +1,112 @@
+// Copyright (c) FIRST and other WPILib contributors.
+// Open Source Software; you can modify and/or share it under the terms of
+// the WPILib BSD license file in the root directory of this project.
+
+#include "wpi/Arena.h"  // NOLINT(build/include_order)
+
+#include <stdint.h>
+
+#include <utility>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace wpi {
+
+TEST(ArenaTest, Alignment) {
+  Arena arena;
+  arena.Allocate(1, 1);
+  auto p = arena.Allocate(8, 8);
+  EXPECT_EQ(reinterpret_cast<uintptr_t>(p) % 8, 0u);
+  arena.Allocate(3, 1);
+  p = arena.Allocate(16, 64);
+  EXPECT_EQ(reinterpret_cast<uintptr_t>(p) % 64, 0u);
+  EXPECT_EQ(arena.GetBytesAllocated(), 1u + 8u + 3u + 16u);
+}
+
+TEST(ArenaTest, Sequential) {
+  Arena arena;
+  auto a = arena.Allocate<int>(4);
+  auto b = arena.Allocate<int>(4);
+  // bump allocation: the second immediately follows the first
+  EXPECT_EQ(b, a + 4);
+  EXPECT_EQ(arena.GetTotalMemory(), Arena::kDefaultSlabSize);
+}
+
+TEST(ArenaTest, Growth) {
+  Arena arena{64};
+  std::vector<int*> ptrs;
+  for (int i = 0; i < 1000; ++i) {
+    auto p = arena.Create<int>(i);
+    ptrs.push_back(p);
+  }
+  for (int i = 0; i < 1000; ++i) {
+    EXPECT_EQ(*ptrs[i], i);
+  }
+  EXPECT_GE(arena.GetTotalMemory(), 1000 * sizeof(int));
+  EXPECT_EQ(arena.GetBytesAllocated(), 1000 * sizeof(int));
+}
+
+TEST(ArenaTest, Large) {
+  Arena arena{64};
+  auto small = arena.Allocate(8);
+  auto big = static_cast<char*>(arena.Allocate(100000));
+  big[99999] = 1;
+  // the current slab is still used for small allocations
+  auto small2 = arena.Allocate(8, 1);
+  EXPECT_EQ(static_cast<char*>(small2), static_cast<char*>(small) + 8);
+  EXPECT_GE(arena.GetTotalMemory(), 64u + 100000u);
+}
+
+TEST(ArenaTest, Reset) {
+  Arena arena{64};
+  for (int i = 0; i < 100; ++i) {
+    arena.Allocate(32);
+  }
+  arena.Allocate(100000);
+  size_t total = arena.GetTotalMemory();
+  arena.Reset();
+  EXPECT_EQ(arena.GetBytesAllocated(), 0u);
+  // only the largest slab is kept
+  size_t kept = arena.GetTotalMemory();
+  EXPECT_LT(kept, total);
+  EXPECT_GT(kept, 0u);
+  // and reused
+  for (size_t i = 0; i < kept / 64; ++i) {
+    arena.Allocate(32);
+  }
+  EXPECT_EQ(arena.GetTotalMemory(), kept);
+}
+
+TEST(ArenaTest, CopyString) {
+  Arena arena;
+  std::string str = "hello";
+  StringRef copy = arena.CopyString(str);
+  str[0] = 'j';
+  EXPECT_EQ(copy, "hello");
+  EXPECT_EQ(copy.data()[copy.size()], '\0');
+  EXPECT_EQ(arena.CopyString(""), "");
+}
+
+TEST(ArenaTest, Move) {
+  Arena arena;
+  auto p = arena.Create<int>(5);
+  Arena other{std::move(arena)};
+  EXPECT_EQ(*p, 5);
+  EXPECT_EQ(arena.GetTotalMemory(), 0u);
+  EXPECT_EQ(other.GetTotalMemory(), Arena::kDefaultSlabSize);
+  arena = std::move(other);
+  EXPECT_EQ(arena.GetTotalMemory(), Arena::kDefaultSlabSize);
+}
+
+TEST(ArenaTest, Allocator) {
+  Arena arena;
+  std::vector<int, ArenaAllocator<int>> v{ArenaAllocator<int>{arena}};
+  for (int i = 0; i < 100; ++i) {
+    v.push_back(i);
+  }
+  EXPECT_EQ(v[99], 99);
+  EXPECT_GE(arena.GetBytesAllocated(), 100 * sizeof(int));
+}
+
+}  // namespace wpi
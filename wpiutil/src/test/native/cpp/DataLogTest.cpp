@@ -0,0 +1,319 @@
+// Copyright (c) FIRST and other WPILib contributors.
+// Open Source Software; you can modify and/or share it under the terms of
+// the WPILib BSD license file in the root directory of this project.
+
+#include "wpi/DataLog.h"  // NOLINT(build/include_order)
+
+#include <stdint.h>
+
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "wpi/DataLogReader.h"
+#include "wpi/mutex.h"
+
+namespace wpi::log {
+
+class DataLogTest : public ::testing::Test {
+ public:
+  std::function<void(ArrayRef<uint8_t>)> Writer() {
+    return [this](ArrayRef<uint8_t> data) {
+      std::scoped_lock lock(mutex);
+      ++writes;
+      out.insert(out.end(), data.begin(), data.end());
+    };
+  }
+
+  DataLogReader Read() {
+    std::scoped_lock lock(mutex);
+    return DataLogReader{out};
+  }
+
+ protected:
+  wpi::mutex mutex;
+  std::vector<uint8_t> out;
+  int writes = 0;
+};
+
+TEST_F(DataLogTest, Header) {
+  {
+    DataLog log{Writer(), 0.25, "extra"};
+  }
+  auto reader = Read();
+  ASSERT_TRUE(reader.IsValid());
+  EXPECT_EQ(reader.GetVersion(), 0x0100);
+  EXPECT_EQ(reader.GetExtraHeader(), "extra");
+  EXPECT_EQ(reader.begin(), reader.end());
+  EXPECT_EQ(out.size(), 17u);
+}
+
+TEST_F(DataLogTest, RecordEncoding) {
+  {
+    DataLog log{Writer()};
+    int entry = log.Start("a", "int64", "", 1);
+    log.AppendInteger(entry, 0x0102, 0x030405);
+    log.Finish(entry, 2);
+  }
+  // header, a 27 byte start record, the data record and a 9 byte finish
+  ASSERT_EQ(out.size(), 12u + 27u + 14u + 9u);
+  // length byte: entry 1 byte, size 1 byte, timestamp 3 bytes
+  const uint8_t record[] = {0x20, 0x01, 0x08, 0x05, 0x04, 0x03, 0x02,
+                            0x01, 0,    0,    0,    0,    0,    0};
+  EXPECT_EQ(ArrayRef<uint8_t>(out).slice(39, 14), ArrayRef<uint8_t>(record));
+}
+
+TEST_F(DataLogTest, RoundTrip) {
+  {
+    DataLog log{Writer()};
+    BooleanLogEntry b{log, "b"};
+    IntegerLogEntry i{log, "i", "{\"unit\":\"m\"}"};
+    FloatLogEntry f{log, "f"};
+    DoubleLogEntry d{log, "d"};
+    StringLogEntry s{log, "s"};
+    RawLogEntry r{log, "r"};
+    BooleanArrayLogEntry ba{log, "ba"};
+    IntegerArrayLogEntry ia{log, "ia"};
+    FloatArrayLogEntry fa{log, "fa"};
+    DoubleArrayLogEntry da{log, "da"};
+    StringArrayLogEntry sa{log, "sa"};
+    b.Append(true, 1);
+    i.Append(-5, 2);
+    f.Append(1.5f, 3);
+    d.Append(2.25, 4);
+    s.Append("hello", 5);
+    r.Append(std::vector<uint8_t>{1, 2, 3}, 6);
+    ba.Append(std::vector<int>{true, false, true}, 7);
+    ia.Append(std::vector<int64_t>{1, -2, 3}, 8);
+    fa.Append(std::vector<float>{0.5f, -1.0f}, 9);
+    da.Append(std::vector<double>{0.25, 1e100}, 10);
+    sa.Append(std::vector<std::string>{"x", "", "yz"}, 11);
+    i.SetMetadata("new", 12);
+  }
+
+  auto reader = Read();
+  ASSERT_TRUE(reader.IsValid());
+  std::map<int, StartRecordData> starts;
+  std::vector<int> finished;
+  std::map<std::string, int> seen;
+  for (auto&& record : reader) {
+    if (record.IsStart()) {
+      StartRecordData data;
+      ASSERT_TRUE(record.GetStartData(&data));
+      starts[data.entry] = data;
+      continue;
+    }
+    if (record.IsFinish()) {
+      int entry;
+      ASSERT_TRUE(record.GetFinishEntry(&entry));
+      finished.push_back(entry);
+      continue;
+    }
+    if (record.IsSetMetadata()) {
+      MetadataRecordData data;
+      ASSERT_TRUE(record.GetSetMetadataData(&data));
+      EXPECT_EQ(starts[data.entry].name, "i");
+      EXPECT_EQ(data.metadata, "new");
+      EXPECT_EQ(record.GetTimestamp(), 12);
+      continue;
+    }
+    // all starts precede data
+    ASSERT_EQ(starts.count(record.GetEntry()), 1u);
+    auto& start = starts[record.GetEntry()];
+    ++seen[start.name];
+    if (start.name == "b") {
+      EXPECT_EQ(start.type, "boolean");
+      bool value;
+      ASSERT_TRUE(record.GetBoolean(&value));
+      EXPECT_TRUE(value);
+      EXPECT_EQ(record.GetTimestamp(), 1);
+    } else if (start.name == "i") {
+      EXPECT_EQ(start.type, "int64");
+      EXPECT_EQ(start.metadata, "{\"unit\":\"m\"}");
+      int64_t value;
+      ASSERT_TRUE(record.GetInteger(&value));
+      EXPECT_EQ(value, -5);
+    } else if (start.name == "f") {
+      float value;
+      ASSERT_TRUE(record.GetFloat(&value));
+      EXPECT_EQ(value, 1.5f);
+    } else if (start.name == "d") {
+      double value;
+      ASSERT_TRUE(record.GetDouble(&value));
+      EXPECT_EQ(value, 2.25);
+    } else if (start.name == "s") {
+      StringRef value;
+      ASSERT_TRUE(record.GetString(&value));
+      EXPECT_EQ(value, "hello");
+    } else if (start.name == "r") {
+      EXPECT_EQ(start.type, "raw");
+      EXPECT_EQ(record.GetRaw().vec(), std::vector<uint8_t>({1, 2, 3}));
+    } else if (start.name == "ba") {
+      std::vector<int> value;
+      ASSERT_TRUE(record.GetBooleanArray(&value));
+      EXPECT_EQ(value, std::vector<int>({1, 0, 1}));
+    } else if (start.name == "ia") {
+      std::vector<int64_t> value;
+      ASSERT_TRUE(record.GetIntegerArray(&value));
+      EXPECT_EQ(value, std::vector<int64_t>({1, -2, 3}));
+    } else if (start.name == "fa") {
+      std::vector<float> value;
+      ASSERT_TRUE(record.GetFloatArray(&value));
+      EXPECT_EQ(value, std::vector<float>({0.5f, -1.0f}));
+    } else if (start.name == "da") {
+      std::vector<double> value;
+      ASSERT_TRUE(record.GetDoubleArray(&value));
+      EXPECT_EQ(value, std::vector<double>({0.25, 1e100}));
+    } else if (start.name == "sa") {
+      EXPECT_EQ(start.type, "string[]");
+      std::vector<StringRef> value;
+      ASSERT_TRUE(record.GetStringArray(&value));
+      EXPECT_EQ(value, std::vector<StringRef>({"x", "", "yz"}));
+    }
+  }
+  EXPECT_EQ(starts.size(), 11u);
+  EXPECT_EQ(seen.size(), 11u);
+  EXPECT_EQ(finished.size(), 11u);
+}
+
+TEST_F(DataLogTest, StartTwice) {
+  DataLog log{Writer()};
+  int a = log.Start("a", "double");
+  EXPECT_EQ(log.Start("a", "double"), a);
+  int b = log.Start("b", "double");
+  EXPECT_NE(a, b);
+  log.Finish(a);
+  log.Finish(a);
+  // ids are not reused
+  int a2 = log.Start("a", "double");
+  EXPECT_NE(a2, a);
+  EXPECT_NE(a2, b);
+  log.Flush();
+
+  int starts = 0, finishes = 0;
+  for (auto&& record : Read()) {
+    starts += record.IsStart();
+    finishes += record.IsFinish();
+  }
+  EXPECT_EQ(starts, 3);
+  EXPECT_EQ(finishes, 1);
+}
+
+TEST_F(DataLogTest, Flush) {
+  // the period is much longer than the test
+  DataLog log{Writer(), 100};
+  DoubleLogEntry entry{log, "d"};
+  for (int i = 0; i < 10; ++i) {
+    entry.Append(i);
+  }
+  log.Flush();
+  auto reader = Read();
+  int count = 0;
+  for (auto&& record : reader) {
+    count += !record.IsControl();
+  }
+  EXPECT_EQ(count, 10);
+
+  entry.Append(10);
+  log.Flush();
+  count = 0;
+  for (auto&& record : Read()) {
+    count += !record.IsControl();
+  }
+  EXPECT_EQ(count, 11);
+}
+
+TEST_F(DataLogTest, MultipleThreads) {
+  constexpr int kThreads = 4;
+  constexpr int kCount = 20000;
+  {
+    DataLog log{Writer(), 0.005};
+    std::vector<std::thread> threads;
+    for (int t = 0; t < kThreads; ++t) {
+      threads.emplace_back([&log, t] {
+        IntegerLogEntry entry{log, "t" + std::to_string(t)};
+        for (int i = 0; i < kCount; ++i) {
+          entry.Append(i);
+        }
+      });
+    }
+    for (auto&& thread : threads) {
+      thread.join();
+    }
+    EXPECT_EQ(log.GetDropped(), 0u);
+  }
+
+  // every thread's values arrive in order
+  std::map<int, int64_t> next;
+  int count = 0;
+  for (auto&& record : Read()) {
+    if (record.IsStart()) {
+      StartRecordData data;
+      ASSERT_TRUE(record.GetStartData(&data));
+      next[data.entry] = 0;
+    } else if (!record.IsControl()) {
+      ASSERT_EQ(next.count(record.GetEntry()), 1u);
+      int64_t value;
+      ASSERT_TRUE(record.GetInteger(&value));
+      EXPECT_EQ(value, next[record.GetEntry()]++);
+      ++count;
+    }
+  }
+  EXPECT_EQ(count, kThreads * kCount);
+}
+
+TEST_F(DataLogTest, Dropped) {
+  // hold up the writer so the staging buffer fills
+  std::atomic_bool release{false};
+  auto write = Writer();
+  DataLog log{[&](ArrayRef<uint8_t> data) {
+                while (!release) {
+                  std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                }
+                write(data);
+              },
+              100};
+  RawLogEntry entry{log, "r"};
+  std::vector<uint8_t> data(64 * 1024);
+  for (int i = 0; i < 32; ++i) {
+    entry.Append(data);
+  }
+  release = true;
+  log.Flush();
+
+  uint64_t kept = 0;
+  for (auto&& record : Read()) {
+    kept += !record.IsControl();
+  }
+  EXPECT_GT(log.GetDropped(), 0u);
+  EXPECT_EQ(kept + log.GetDropped(), 32u);
+}
+
+TEST(DataLogReaderTest, Truncated) {
+  std::vector<uint8_t> out;
+  {
+    DataLog log{[&](ArrayRef<uint8_t> data) {
+      out.insert(out.end(), data.begin(), data.end());
+    }};
+    int entry = log.Start("d", "double", "", 1);
+    log.AppendDouble(entry, 1, 1);
+    log.AppendDouble(entry, 2, 2);
+    log.Finish(entry, 3);
+  }
+  // cut off the 9 byte finish record and part of the last value
+  out.resize(out.size() - 13);
+  DataLogReader reader{out};
+  int count = 0;
+  for (auto&& record : reader) {
+    count += !record.IsControl();
+  }
+  EXPECT_EQ(count, 1);
+
+  EXPECT_FALSE(DataLogReader(std::vector<uint8_t>{'W', 'P', 'I'}).IsValid());
+}
+
+}  // namespace wpi::log
@@ -0,0 +1,90 @@
+// Copyright (c) FIRST and other WPILib contributors.
+// Open Source Software; you can modify and/or share it under the terms of
+// the WPILib BSD license file in the root directory of this project.
+
+#include <stdint.h>
+
+#include <random>
+#include <string>
+
+#include "gtest/gtest.h"
+#include "wpi/Lz4.h"
+#include "wpi/SmallString.h"
+#include "wpi/StringRef.h"
+
+namespace wpi {
+
+static void RoundTrip(StringRef plain) {
+  SmallString<128> compressed;
+  Lz4Compress(plain, compressed);
+  EXPECT_LE(compressed.size(), Lz4CompressBound(plain.size()));
+  SmallString<128> decompressed;
+  ASSERT_TRUE(Lz4Decompress(compressed, plain.size(), decompressed));
+  EXPECT_EQ(decompressed.str(), plain);
+}
+
+TEST(Lz4Test, Empty) {
+  SmallString<16> compressed;
+  Lz4Compress("", compressed);
+  EXPECT_EQ(compressed.str(), StringRef("\x00", 1));
+  RoundTrip("");
+}
+
+TEST(Lz4Test, Short) {
+  RoundTrip("a");
+  RoundTrip("hello world");
+  RoundTrip("aaaaaaaaaaaaa");
+}
+
+TEST(Lz4Test, Repetitive) {
+  std::string plain;
+  for (int i = 0; i < 200; ++i) {
+    plain += "{\"x\":1.0,\"y\":2.0,\"rotation\":0.5},";
+  }
+  SmallString<128> compressed;
+  Lz4Compress(plain, compressed);
+  EXPECT_LT(compressed.size(), plain.size() / 10);
+  RoundTrip(plain);
+}
+
+TEST(Lz4Test, Overlapping) {
+  // long runs produce matches that overlap their own output
+  RoundTrip(std::string(100000, 'z'));
+  RoundTrip("ab" + std::string(1000, 'c') + "abab" + std::string(300, 'd'));
+}
+
+TEST(Lz4Test, Random) {
+  std::mt19937 gen(1234);
+  std::string plain;
+  for (int i = 0; i < 70000; ++i) {
+    // mix of incompressible and repeated data, beyond the 64K window
+    plain += (i % 1000 < 500) ? static_cast<char>(gen())
+                              : plain[plain.size() - 100];
+  }
+  RoundTrip(plain);
+}
+
+TEST(Lz4Test, DecompressKnownBlock) {
+  // "abcabcabcabcabcabc" as literals "abc" + match of 15 at offset 3
+  SmallString<32> buf;
+  ASSERT_TRUE(Lz4Decompress(StringRef("\x3b" "abc" "\x03\x00" "\x00", 7),
+                            18, buf));
+  EXPECT_EQ(buf.str(), "abcabcabcabcabcabc");
+}
+
+TEST(Lz4Test, DecompressMalformed) {
+  SmallString<32> buf{"keep"};
+  // literal run past end of input
+  EXPECT_FALSE(Lz4Decompress(StringRef("\x50" "ab", 3), 5, buf));
+  // offset beyond start of output
+  EXPECT_FALSE(Lz4Decompress(StringRef("\x10" "a" "\x05\x00", 4), 5, buf));
+  // zero offset
+  EXPECT_FALSE(Lz4Decompress(StringRef("\x10" "a" "\x00\x00", 4), 5, buf));
+  // wrong decompressed size
+  EXPECT_FALSE(Lz4Decompress(StringRef("\x20" "ab", 3), 3, buf));
+  // truncated length
+  EXPECT_FALSE(Lz4Decompress(StringRef("\xf0\xff", 2), 300, buf));
+  EXPECT_EQ(buf.str(), "keep");
+}
+
+}  // namespace wpi
@@ -0,0 +1,122 @@
+// Copyright (c) FIRST and other WPILib contributors.
+// Open Source Software; you can modify and/or share it under the terms of
+// the WPILib BSD license file in the root directory of this project.
+
+#include "wpi/MpmcQueue.h"  // NOLINT(build/include_order)
+
+#include <stdint.h>
+
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace wpi {
+
+TEST(MpmcQueueTest, Capacity) {
+  EXPECT_EQ(MpmcQueue<int>(0).capacity(), 2u);
+  EXPECT_EQ(MpmcQueue<int>(4).capacity(), 4u);
+  EXPECT_EQ(MpmcQueue<int>(5).capacity(), 8u);
+}
+
+TEST(MpmcQueueTest, Fifo) {
+  MpmcQueue<int> q(4);
+  EXPECT_TRUE(q.empty_approx());
+  for (int i = 0; i < 4; ++i) {
+    EXPECT_TRUE(q.try_push(i));
+  }
+  EXPECT_FALSE(q.try_push(4));
+  EXPECT_EQ(q.size_approx(), 4u);
+
+  int value;
+  for (int i = 0; i < 4; ++i) {
+    ASSERT_TRUE(q.try_pop(value));
+    EXPECT_EQ(value, i);
+  }
+  EXPECT_FALSE(q.try_pop(value));
+  EXPECT_TRUE(q.empty_approx());
+}
+
+TEST(MpmcQueueTest, WrapAround) {
+  MpmcQueue<int> q(2);
+  for (int i = 0; i < 10; ++i) {
+    ASSERT_TRUE(q.try_push(i));
+    auto value = q.try_pop();
+    ASSERT_TRUE(value);
+    EXPECT_EQ(*value, i);
+  }
+  EXPECT_FALSE(q.try_pop());
+}
+
+namespace {
+struct NoDefault {
+  explicit NoDefault(int v) : value(v) {}
+  int value;
+};
+}  // namespace
+
+TEST(MpmcQueueTest, NotDefaultConstructible) {
+  MpmcQueue<NoDefault> q(2);
+  EXPECT_TRUE(q.try_emplace(5));
+  auto value = q.try_pop();
+  ASSERT_TRUE(value);
+  EXPECT_EQ(value->value, 5);
+}
+
+TEST(MpmcQueueTest, DestroysRemaining) {
+  auto counted = std::make_shared<int>(0);
+  {
+    MpmcQueue<std::shared_ptr<int>> q(4);
+    q.try_push(counted);
+    q.try_push(counted);
+    q.try_push(counted);
+    q.try_pop();
+    EXPECT_EQ(counted.use_count(), 3);
+  }
+  EXPECT_EQ(counted.use_count(), 1);
+}
+
+TEST(MpmcQueueTest, MultiThreaded) {
+  constexpr int kProducers = 4;
+  constexpr int kConsumers = 4;
+  constexpr int kPerProducer = 20000;
+  MpmcQueue<int> q(64);
+  std::atomic<int> consumed{0};
+  std::atomic<int64_t> sum{0};
+
+  std::vector<std::thread> threads;
+  for (int p = 0; p < kProducers; ++p) {
+    threads.emplace_back([&] {
+      for (int i = 1; i <= kPerProducer; ++i) {
+        while (!q.try_push(i)) {
+          std::this_thread::yield();
+        }
+      }
+    });
+  }
+  for (int c = 0; c < kConsumers; ++c) {
+    threads.emplace_back([&] {
+      int value;
+      while (consumed.load() < kProducers * kPerProducer) {
+        if (q.try_pop(value)) {
+          sum += value;
+          ++consumed;
+        } else {
+          std::this_thread::yield();
+        }
+      }
+    });
+  }
+  for (auto&& thr : threads) {
+    thr.join();
+  }
+
+  EXPECT_EQ(consumed.load(), kProducers * kPerProducer);
+  EXPECT_EQ(sum.load(), int64_t{kProducers} * kPerProducer *
+                            (kPerProducer + 1) / 2);
+  EXPECT_TRUE(q.empty_approx());
+}
+
+}  // namespace wpi
@@ -0,0 +1,146 @@
+// Copyright (c) FIRST and other WPILib contributors.
+// Open Source Software; you can modify and/or share it under the terms of
+// the WPILib BSD license file in the root directory of this project.
+
+#ifdef __linux__
+
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+
+#include "gtest/gtest.h"
+#include "wpi/Logger.h"
+#include "wpi/SharedMemoryAcceptor.h"
+#include "wpi/SharedMemoryConnector.h"
+
+namespace wpi {
+
+class SharedMemoryStreamTest : public ::testing::Test {
+ public:
+  SharedMemoryStreamTest() : acceptor{"wpiutil-test", logger} {}
+
+  void Connect() {
+    ASSERT_EQ(acceptor.start(), 0);
+    std::thread thr([&] { server = acceptor.accept(); });
+    client = SharedMemoryConnector::connect("wpiutil-test", logger);
+    thr.join();
+    ASSERT_TRUE(client);
+    ASSERT_TRUE(server);
+  }
+
+  // receive exactly len bytes
+  std::string Receive(NetworkStream& stream, size_t len) {
+    std::string out;
+    char buf[4096];
+    while (out.size() < len) {
+      NetworkStream::Error err;
+      size_t n = stream.receive(buf, sizeof(buf), &err);
+      if (n == 0) {
+        break;
+      }
+      out.append(buf, n);
+    }
+    return out;
+  }
+
+ protected:
+  Logger logger;
+  SharedMemoryAcceptor acceptor;
+  std::unique_ptr<NetworkStream> server;
+  std::unique_ptr<NetworkStream> client;
+};
+
+TEST_F(SharedMemoryStreamTest, SendReceive) {
+  Connect();
+  NetworkStream::Error err;
+  ASSERT_EQ(client->send("hello", 5, &err), 5u);
+  EXPECT_EQ(Receive(*server, 5), "hello");
+  ASSERT_EQ(server->send("world!", 6, &err), 6u);
+  EXPECT_EQ(Receive(*client, 6), "world!");
+  EXPECT_EQ(client->getPeerIP(), "shm:wpiutil-test");
+}
+
+TEST_F(SharedMemoryStreamTest, LargeTransfer) {
+  Connect();
+  // several times the ring size, so the writer must wait for the reader
+  std::string data;
+  for (int i = 0; data.size() < 1500000; ++i) {
+    data += std::to_string(i) + ',';
+  }
+  std::thread thr([&] {
+    NetworkStream::Error err;
+    client->send(data.data(), data.size(), &err);
+  });
+  EXPECT_EQ(Receive(*server, data.size()), data);
+  thr.join();
+}
+
+TEST_F(SharedMemoryStreamTest, CloseGivesEof) {
+  Connect();
+  NetworkStream::Error err;
+  ASSERT_EQ(client->send("bye", 3, &err), 3u);
+  client->close();
+  // data written before the close is still delivered
+  EXPECT_EQ(Receive(*server, 3), "bye");
+  char buf[16];
+  EXPECT_EQ(server->receive(buf, sizeof(buf), &err), 0u);
+  EXPECT_EQ(err, NetworkStream::kConnectionClosed);
+  EXPECT_EQ(server->send("x", 1, &err), 0u);
+}
+
+TEST_F(SharedMemoryStreamTest, CloseWakesReceive) {
+  Connect();
+  std::thread thr([&] {
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    server->close();
+  });
+  char buf[16];
+  NetworkStream::Error err;
+  EXPECT_EQ(client->receive(buf, sizeof(buf), &err), 0u);
+  thr.join();
+}
+
+TEST_F(SharedMemoryStreamTest, ReceiveTimeout) {
+  Connect();
+  char buf[16];
+  NetworkStream::Error err;
+  EXPECT_EQ(client->receive(buf, sizeof(buf), &err, 1), 0u);
+  EXPECT_EQ(err, NetworkStream::kConnectionTimedOut);
+}
+
+TEST_F(SharedMemoryStreamTest, ReuseSlots) {
+  ASSERT_EQ(acceptor.start(), 0);
+  // more connections than slots, each closed before the next
+  for (int i = 0; i < 20; ++i) {
+    std::thread thr([&] { server = acceptor.accept(); });
+    client = SharedMemoryConnector::connect("wpiutil-test", logger);
+    thr.join();
+    ASSERT_TRUE(client);
+    ASSERT_TRUE(server);
+    client.reset();
+    server.reset();
+  }
+}
+
+TEST_F(SharedMemoryStreamTest, ShutdownWakesAccept) {
+  ASSERT_EQ(acceptor.start(), 0);
+  std::thread thr([&] { server = acceptor.accept(); });
+  acceptor.shutdown();
+  thr.join();
+  EXPECT_FALSE(server);
+}
+
+TEST_F(SharedMemoryStreamTest, SecondAcceptorFails) {
+  ASSERT_EQ(acceptor.start(), 0);
+  SharedMemoryAcceptor other{"wpiutil-test", logger};
+  EXPECT_NE(other.start(), 0);
+}
+
+TEST_F(SharedMemoryStreamTest, NoServer) {
+  EXPECT_FALSE(SharedMemoryConnector::connect("wpiutil-test-none", logger));
+}
+
+}  // namespace wpi
+
+#endif  // __linux__
@@ -0,0 +1,159 @@
+// Copyright (c) FIRST and other WPILib contributors.
+// Open Source Software; you can modify and/or share it under the terms of
+// the WPILib BSD license file in the root directory of this project.
+
+#include "wpi/ThreadPool.h"  // NOLINT(build/include_order)
+
+#include <atomic>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "wpi/mutex.h"
+
+namespace wpi {
+
+TEST(ThreadPoolTest, NumThreads) {
+  ThreadPool pool{3};
+  EXPECT_EQ(pool.GetNumThreads(), 3u);
+  EXPECT_GE(ThreadPool{}.GetNumThreads(), 1u);
+}
+
+TEST(ThreadPoolTest, Submit) {
+  ThreadPool pool{2};
+  auto f = pool.Submit([] { return 5; });
+  EXPECT_EQ(f.get(), 5);
+}
+
+TEST(ThreadPoolTest, SubmitVoid) {
+  ThreadPool pool{2};
+  std::atomic_int count{0};
+  auto f = pool.Submit([&] { ++count; });
+  f.get();
+  EXPECT_EQ(count, 1);
+}
+
+TEST(ThreadPoolTest, DestructorRunsQueuedTasks) {
+  std::atomic_int count{0};
+  {
+    ThreadPool pool{2};
+    for (int i = 0; i < 10000; ++i) {
+      pool.Post([&] { ++count; });
+    }
+  }
+  EXPECT_EQ(count, 10000);
+}
+
+TEST(ThreadPoolTest, RunsOnPoolThreads) {
+  ThreadPool pool{4};
+  wpi::mutex mutex;
+  std::set<std::thread::id> ids;
+  std::vector<future<void>> futures;
+  for (int i = 0; i < 1000; ++i) {
+    futures.emplace_back(pool.Submit([&] {
+      std::scoped_lock lock(mutex);
+      ids.insert(std::this_thread::get_id());
+    }));
+  }
+  for (auto&& f : futures) {
+    f.get();
+  }
+  EXPECT_EQ(ids.count(std::this_thread::get_id()), 0u);
+  EXPECT_LE(ids.size(), 4u);
+}
+
+TEST(ThreadPoolTest, ManyProducers) {
+  std::atomic_int count{0};
+  {
+    ThreadPool pool{4};
+    std::vector<std::thread> producers;
+    for (int i = 0; i < 4; ++i) {
+      producers.emplace_back([&] {
+        // more than the shared queue holds, so some overflow
+        for (int j = 0; j < 5000; ++j) {
+          pool.Post([&] { ++count; });
+        }
+      });
+    }
+    for (auto&& producer : producers) {
+      producer.join();
+    }
+  }
+  EXPECT_EQ(count, 20000);
+}
+
+TEST(ThreadPoolTest, Then) {
+  ThreadPool pool{2};
+  auto f = pool.Then(pool.Submit([] { return 3; }),
+                     [](int v) { return std::to_string(v * 2); });
+  EXPECT_EQ(f.get(), "6");
+}
+
+TEST(ThreadPoolTest, ThenRunsOnPool) {
+  ThreadPool pool{2};
+  promise<int> p;
+  auto f = pool.Then(p.get_future(),
+                     [](int) { return std::this_thread::get_id(); });
+  // then() would run the continuation here, in set_value()
+  p.set_value(1);
+  EXPECT_NE(f.get(), std::this_thread::get_id());
+}
+
+TEST(ThreadPoolTest, ThenVoid) {
+  ThreadPool pool{2};
+  std::atomic_int count{0};
+  auto f = pool.Then(pool.Submit([&] { ++count; }), [&] {
+    ++count;
+    return count.load();
+  });
+  EXPECT_EQ(f.get(), 2);
+}
+
+TEST(ThreadPoolTest, ThenInvalid) {
+  ThreadPool pool{1};
+  auto f = pool.Then(future<int>{}, [](int v) { return v; });
+  EXPECT_FALSE(f.valid());
+}
+
+namespace {
+int Fib(ThreadPool& pool, int n) {
+  if (n < 2) {
+    return n;
+  }
+  auto f = pool.Submit([&pool, n] { return Fib(pool, n - 1); });
+  int b = Fib(pool, n - 2);
+  return pool.Get(f) + b;
+}
+}  // namespace
+
+TEST(ThreadPoolTest, ForkJoin) {
+  // more nested waits than threads; would deadlock without Get() helping
+  ThreadPool pool{2};
+  auto f = pool.Submit([&] { return Fib(pool, 18); });
+  EXPECT_EQ(f.get(), 2584);
+}
+
+TEST(ThreadPoolTest, RunPendingTask) {
+  ThreadPool pool{1};
+  std::atomic_bool started{false};
+  promise<void> blocker;
+  auto blocked = blocker.get_future();
+  pool.Post([&] {
+    started = true;
+    blocked.wait();
+  });
+  while (!started) {
+    std::this_thread::yield();
+  }
+  // the only pool thread is busy, so this thread has to run it
+  std::atomic_int count{0};
+  pool.Post([&] { ++count; });
+  EXPECT_TRUE(pool.RunPendingTask());
+  EXPECT_EQ(count, 1);
+  EXPECT_FALSE(pool.RunPendingTask());
+  blocker.set_value();
+}
+
+}  // namespace wpi
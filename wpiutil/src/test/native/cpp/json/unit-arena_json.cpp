@@ -0,0 +1,120 @@
+// Copyright (c) FIRST and other WPILib contributors.
+// Open Source Software; you can modify and/or share it under the terms of
+// the WPILib BSD license file in the root directory of this project.
+
+#include "wpi/arena_json.h"  // NOLINT(build/include_order)
+
+#include <string>
+
+#include "gtest/gtest.h"
+#include "unit-json.h"
+
+using wpi::Arena;
+using wpi::arena_json;
+using wpi::json;
+
+TEST(JsonArenaTest, Parse) {
+  Arena arena;
+  auto& j = arena_json::parse(
+      R"({"type":"PWM","device":"1","data":{"<speed":-0.5,"<init":true},)"
+      R"("list":[1,-2,3.5,null,"x",[],{}],"big":18446744073709551615})",
+      arena);
+  ASSERT_TRUE(j.is_object());
+  EXPECT_EQ(j.size(), 5u);
+  EXPECT_EQ(j.at("type").get<wpi::StringRef>(), "PWM");
+  EXPECT_EQ(j.at("device").get<std::string>(), "1");
+
+  auto data = j.find("data");
+  ASSERT_NE(data, nullptr);
+  EXPECT_EQ(data->at("<speed").get<double>(), -0.5);
+  EXPECT_TRUE(data->at("<init").get<bool>());
+  EXPECT_EQ(data->find("missing"), nullptr);
+  EXPECT_EQ(j.count("data"), 1u);
+
+  auto& list = j.at("list");
+  ASSERT_TRUE(list.is_array());
+  ASSERT_EQ(list.size(), 7u);
+  EXPECT_TRUE(list[0].is_number_unsigned());
+  EXPECT_EQ(list[0].get<int>(), 1);
+  EXPECT_TRUE(list[1].is_number_integer());
+  EXPECT_EQ(list[1].get<int64_t>(), -2);
+  EXPECT_TRUE(list[2].is_number_float());
+  EXPECT_TRUE(list[3].is_null());
+  EXPECT_EQ(list[4].get<std::string>(), "x");
+  EXPECT_TRUE(list[5].is_array());
+  EXPECT_TRUE(list[5].empty());
+  EXPECT_TRUE(list[6].is_object());
+  EXPECT_TRUE(list[6].empty());
+  EXPECT_EQ(j.at("big").get<uint64_t>(), 18446744073709551615u);
+
+  // members keep document order
+  auto members = j.members();
+  EXPECT_EQ(members[0].key, "type");
+  EXPECT_EQ(members[4].key, "big");
+}
+
+TEST(JsonArenaTest, Escapes) {
+  Arena arena;
+  auto& j = arena_json::parse(R"(["a\"b\\c\n", "é😀"])", arena);
+  EXPECT_EQ(j[0].get<std::string>(), "a\"b\\c\n");
+  EXPECT_EQ(j[1].get<std::string>(), "\xc3\xa9\xf0\x9f\x98\x80");
+}
+
+TEST(JsonArenaTest, SameAsJson) {
+  const char* docs[] = {
+      "null",
+      "[1, 2.5, true, false, \"s\", {\"a\": [[], {}]}]",
+      R"({"type":"DriverStation","device":"","data":{">enabled":true,)"
+      R"(">autonomous":false,">new_data":true,">match_time":-1.0}})",
+      R"({"a": 1, "a": 2})",
+  };
+  Arena arena;
+  for (auto doc : docs) {
+    auto& j = arena_json::parse(doc, arena);
+    EXPECT_EQ(j.to_json(), json::parse(doc)) << doc;
+    EXPECT_EQ(arena_json::from_json(json::parse(doc), arena).to_json(),
+              json::parse(doc))
+        << doc;
+  }
+}
+
+TEST(JsonArenaTest, DuplicateKeys) {
+  Arena arena;
+  auto& j = arena_json::parse(R"({"a": 1, "a": 2})", arena);
+  EXPECT_EQ(j.size(), 2u);
+  // the first one wins, as with json
+  EXPECT_EQ(j.at("a").get<int>(), 1);
+}
+
+TEST(JsonArenaTest, Errors) {
+  Arena arena;
+  EXPECT_THROW(arena_json::parse("[1, 2", arena), json::parse_error);
+  EXPECT_THROW(arena_json::parse("{\"a\" 1}", arena), json::parse_error);
+  EXPECT_THROW(arena_json::parse("[1] x", arena), json::parse_error);
+  EXPECT_THROW(arena_json::parse("1e1000", arena), json::out_of_range);
+  EXPECT_TRUE(arena_json::parse("[1, 2", arena, false).is_discarded());
+
+  auto& j = arena_json::parse("[1, \"s\"]", arena);
+  EXPECT_THROW(j.at(2), json::out_of_range);
+  EXPECT_THROW(j.at("key"), json::type_error);
+  EXPECT_THROW(j[1].get<double>(), json::type_error);
+  EXPECT_THROW(j[0].get<std::string>(), json::type_error);
+  EXPECT_THROW(j[0].get<bool>(), json::type_error);
+}
+
+TEST(JsonArenaTest, Reuse) {
+  Arena arena;
+  std::string doc = "[";
+  for (int i = 0; i < 1000; ++i) {
+    doc += "{\"name\":\"entry" + std::to_string(i) + "\",\"value\":1.5},";
+  }
+  doc += "{}]";
+  arena_json::parse(doc, arena);
+  arena.Reset();
+  size_t total = arena.GetTotalMemory();
+  // parsing the same document again fits in the kept slab
+  auto& j = arena_json::parse(doc, arena);
+  EXPECT_EQ(j.size(), 1001u);
+  EXPECT_EQ(j[999].at("name").get<std::string>(), "entry999");
+  EXPECT_EQ(arena.GetTotalMemory(), total);
+}
@@ -0,0 +1,105 @@
+// Copyright (c) FIRST and other WPILib contributors.
+// Open Source Software; you can modify and/or share it under the terms of
+// the WPILib BSD license file in the root directory of this project.
+
+#include "wpi/json_view.h"  // NOLINT(build/include_order)
+
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "unit-json.h"
+
+using wpi::json;
+using wpi::json_view;
+
+TEST(JsonViewTest, Lookup) {
+  json_view j{
+      R"( {"type": "PWM", "device" : "1", "data": {"<speed": -0.5,)"
+      R"("<init": true, "<raw": 1406}, "list": [1, [2, 3], {"a": "]"}, null]} )"};
+  ASSERT_TRUE(j.is_object());
+  EXPECT_EQ(j.size(), 4u);
+  EXPECT_EQ(j.at("type").get<std::string>(), "PWM");
+  EXPECT_EQ(j["device"].text(), "\"1\"");
+
+  auto data = j["data"];
+  EXPECT_EQ(data["<speed"].get<double>(), -0.5);
+  EXPECT_TRUE(data["<speed"].is_number_float());
+  EXPECT_TRUE(data["<init"].get<bool>());
+  EXPECT_EQ(data["<raw"].get<int>(), 1406);
+  EXPECT_TRUE(data["<raw"].is_number_unsigned());
+  EXPECT_TRUE(data["missing"].is_discarded());
+  EXPECT_TRUE(j["type"]["x"].is_discarded());
+
+  auto list = j["list"];
+  ASSERT_TRUE(list.is_array());
+  EXPECT_EQ(list.size(), 4u);
+  EXPECT_EQ(list[1][1].get<int>(), 3);
+  EXPECT_EQ(list[2]["a"].get<std::string>(), "]");
+  EXPECT_TRUE(list[3].is_null());
+  EXPECT_TRUE(list[4].is_discarded());
+  EXPECT_EQ(list.at(1).parse(), json({2, 3}));
+}
+
+TEST(JsonViewTest, Iterate) {
+  json_view j{R"({"a": 1, "b\"c": [], "d": "e"})"};
+  std::vector<std::string> keys;
+  std::vector<std::string> values;
+  wpi::SmallString<16> buf;
+  for (auto it = j.begin(); it != j.end(); ++it) {
+    keys.emplace_back(it.key(buf));
+    values.emplace_back(it->text());
+  }
+  EXPECT_EQ(keys, (std::vector<std::string>{"a", "b\"c", "d"}));
+  EXPECT_EQ(values, (std::vector<std::string>{"1", "[]", "\"e\""}));
+  EXPECT_EQ(j["b\"c"].size(), 0u);
+
+  EXPECT_EQ(json_view{"[]"}.begin(), json_view{"[]"}.end());
+  EXPECT_EQ(json_view{"5"}.begin(), json_view{"5"}.end());
+}
+
+TEST(JsonViewTest, Strings) {
+  json_view j{R"(["plain", "esc\naped", "é"])"};
+  wpi::SmallString<16> buf;
+  auto plain = j[0].get_string(buf);
+  // unescaped strings point into the text
+  EXPECT_EQ(plain.data(), j.text().data() + 2);
+  EXPECT_EQ(j[1].get_string(buf), "esc\naped");
+  EXPECT_EQ(j[2].get<std::string>(), "\xc3\xa9");
+}
+
+TEST(JsonViewTest, SameAsJson) {
+  const char* docs[] = {
+      "null",
+      "[1, 2.5, true, false, \"s\", {\"a\": [[], {}]}]",
+      R"({"type":"DriverStation","device":"","data":{">enabled":true,)"
+      R"(">autonomous":false,">match_time":-1.0}})",
+  };
+  for (auto doc : docs) {
+    json_view v{doc};
+    json j = json::parse(doc);
+    EXPECT_EQ(v.size(), j.size()) << doc;
+    EXPECT_EQ(v.parse(), j) << doc;
+    EXPECT_EQ(v.type(), j.type()) << doc;
+  }
+}
+
+TEST(JsonViewTest, Errors) {
+  EXPECT_THROW(json_view{R"({"a": 1})"}.at("x"), json::out_of_range);
+  EXPECT_THROW(json_view{"[1, 2]"}.at(2), json::out_of_range);
+
+  json_view j{R"({"a": 1, "b": "s", "c": [1, 2)"};
+  EXPECT_THROW(j.at(0), json::type_error);
+  EXPECT_THROW(j["a"].get<std::string>(), json::type_error);
+  EXPECT_THROW(j["b"].get<int>(), json::type_error);
+  EXPECT_THROW(j["b"].get<bool>(), json::type_error);
+  // malformed text is only found when it is scanned
+  EXPECT_EQ(j["a"].get<int>(), 1);
+  EXPECT_THROW(j["c"], json::parse_error);
+  EXPECT_THROW(j.at("x"), json::parse_error);
+  EXPECT_THROW(json_view{R"({"a" 1})"}["a"], json::parse_error);
+  EXPECT_THROW(json_view{"[1 2]"}.size(), json::parse_error);
+  EXPECT_THROW(json_view{"\"abc"}.get<std::string>(), json::parse_error);
+  EXPECT_TRUE(json_view{}.is_discarded());
+  EXPECT_TRUE(json_view{"  "}.is_discarded());
+}
@@ -0,0 +1,166 @@
+// Copyright (c) FIRST and other WPILib contributors.
+// Open Source Software; you can modify and/or share it under the terms of
+// the WPILib BSD license file in the root directory of this project.
+
+#include "wpi/json_sax.h"  // NOLINT(build/include_order)
+
+#include <string>
+
+#include "gtest/gtest.h"
+#include "unit-json.h"
+#include "wpi/raw_istream.h"
+
+using wpi::json;
+
+namespace {
+
+// Records events as a string
+class RecordingSax : public wpi::json_sax {
+ public:
+  bool null() override {
+    events += "null ";
+    return true;
+  }
+  bool boolean(bool val) override {
+    events += val ? "true " : "false ";
+    return true;
+  }
+  bool number_integer(int64_t val) override {
+    events += "i" + std::to_string(val) + ' ';
+    return true;
+  }
+  bool number_unsigned(uint64_t val) override {
+    events += "u" + std::to_string(val) + ' ';
+    return true;
+  }
+  bool number_float(double val) override {
+    events += "f" + std::to_string(val) + ' ';
+    return true;
+  }
+  bool string(wpi::StringRef val) override {
+    events += "s:" + val.str() + ' ';
+    return true;
+  }
+  bool start_object() override {
+    events += "{ ";
+    return true;
+  }
+  bool key(wpi::StringRef val) override {
+    events += "k:" + val.str() + ' ';
+    return true;
+  }
+  bool end_object() override {
+    events += "} ";
+    return true;
+  }
+  bool start_array() override {
+    events += "[ ";
+    return true;
+  }
+  bool end_array() override {
+    events += "] ";
+    return true;
+  }
+  bool parse_error(size_t position, wpi::StringRef last_token,
+                   const json::exception& ex) override {
+    events += "error:" + std::to_string(ex.id) + ' ';
+    errorPosition = position;
+    return false;
+  }
+
+  std::string events;
+  size_t errorPosition = 0;
+};
+
+// Stops after finding the value of a top-level key
+class FindSax : public wpi::json_sax {
+ public:
+  explicit FindSax(wpi::StringRef key) : m_key{key} {}
+
+  bool start_object() override {
+    ++m_depth;
+    return true;
+  }
+  bool end_object() override {
+    --m_depth;
+    return true;
+  }
+  bool start_array() override {
+    ++m_depth;
+    return true;
+  }
+  bool end_array() override {
+    --m_depth;
+    return true;
+  }
+  bool key(wpi::StringRef val) override {
+    m_match = m_depth == 1 && val == m_key;
+    return true;
+  }
+  bool string(wpi::StringRef val) override {
+    if (m_match) {
+      value = val;
+      return false;
+    }
+    return true;
+  }
+
+  std::string value;
+
+ private:
+  wpi::StringRef m_key;
+  int m_depth = 0;
+  bool m_match = false;
+};
+
+}  // namespace
+
+TEST(JsonSaxTest, Events) {
+  RecordingSax sax;
+  EXPECT_TRUE(json::sax_parse(
+      R"({"a": [1, -2, 1.5, "x\ty"], "b": {"c": null}, "d": true})", &sax));
+  EXPECT_EQ(sax.events,
+            "{ k:a [ u1 i-2 f1.500000 s:x\ty ] k:b { k:c null } k:d true } ");
+}
+
+TEST(JsonSaxTest, Empty) {
+  RecordingSax sax;
+  EXPECT_TRUE(json::sax_parse("[{}, [], false]", &sax));
+  EXPECT_EQ(sax.events, "[ { } [ ] false ] ");
+}
+
+TEST(JsonSaxTest, Stream) {
+  std::string s = R"({"one": 1})";
+  wpi::raw_mem_istream is(s.data(), s.size());
+  RecordingSax sax;
+  EXPECT_TRUE(json::sax_parse(is, &sax));
+  EXPECT_EQ(sax.events, "{ k:one u1 } ");
+}
+
+TEST(JsonSaxTest, Stop) {
+  FindSax sax{"type"};
+  EXPECT_FALSE(json::sax_parse(
+      R"({"data": {"type": "inner"}, "type": "PWM", "bad": })", &sax));
+  EXPECT_EQ(sax.value, "PWM");
+}
+
+TEST(JsonSaxTest, SyntaxError) {
+  RecordingSax sax;
+  EXPECT_FALSE(json::sax_parse("[1, 2", &sax));
+  EXPECT_EQ(sax.events, "[ u1 u2 error:101 ");
+  EXPECT_EQ(sax.errorPosition, 6u);
+
+  sax.events.clear();
+  EXPECT_FALSE(json::sax_parse("[1] 2", &sax));
+  EXPECT_EQ(sax.events, "[ u1 ] error:101 ");
+
+  sax.events.clear();
+  EXPECT_FALSE(json::sax_parse("1e1000", &sax));
+  EXPECT_EQ(sax.events, "error:406 ");
+}
+
+TEST(JsonSaxTest, NotStrict) {
+  RecordingSax sax;
+  EXPECT_TRUE(json::sax_parse("[1] 2", &sax, false));
+  EXPECT_EQ(sax.events, "[ u1 ] ");
+}
@@ -0,0 +1,113 @@
+// Copyright (c) FIRST and other WPILib contributors.
+// Open Source Software; you can modify and/or share it under the terms of
+// the WPILib BSD license file in the root directory of this project.
+
+#include "wpi/json_simd.h"  // NOLINT(build/include_order)
+
+#include <cstring>
+#include <string>
+
+#include "gtest/gtest.h"
+#include "unit-json.h"
+#include "wpi/json_view.h"
+#include "wpi/raw_istream.h"
+
+using wpi::json;
+using wpi::detail::json_simd;
+
+namespace {
+
+class JsonSimdTest : public ::testing::TestWithParam<json_simd> {
+ protected:
+  void SetUp() override {
+    if (!wpi::detail::json_set_simd(GetParam())) {
+      GTEST_SKIP() << "not supported by this CPU";
+    }
+  }
+  void TearDown() override {
+    wpi::detail::json_set_simd(wpi::detail::json_best_simd());
+  }
+};
+
+// A stream that does not expose its buffer
+class UnbufferedStream : public wpi::raw_istream {
+ public:
+  explicit UnbufferedStream(wpi::StringRef data) : m_data{data} {}
+  void close() override {}
+  size_t in_avail() const override { return m_data.size(); }
+
+ private:
+  void read_impl(void* data, size_t len) override {
+    if (len > m_data.size()) {
+      error_detected();
+      len = m_data.size();
+    }
+    std::memcpy(data, m_data.data(), len);
+    m_data = m_data.drop_front(len);
+    set_read_count(len);
+  }
+
+  wpi::StringRef m_data;
+};
+
+size_t Reference(const std::string& s) {
+  size_t i = 0;
+  while (i < s.size() && s[i] >= 0x20 && s[i] < 0x7f && s[i] != '"' &&
+         s[i] != '\\') {
+    ++i;
+  }
+  return i;
+}
+
+}  // namespace
+
+TEST_P(JsonSimdTest, PlainPrefix) {
+  EXPECT_EQ(wpi::detail::json_get_simd(), GetParam());
+  const char specials[] = {'"', '\\', '\n', '\0', '\x1f', '\x7f', '\x80',
+                           '\xff'};
+  // each special character at each position, for lengths spanning several
+  // vector widths
+  for (size_t len = 0; len < 80; ++len) {
+    std::string s(len, 'a');
+    EXPECT_EQ(wpi::detail::json_plain_prefix(s.data(), s.size()), len);
+    for (size_t pos = 0; pos < len; ++pos) {
+      for (char c : specials) {
+        std::string t = s;
+        t[pos] = c;
+        ASSERT_EQ(wpi::detail::json_plain_prefix(t.data(), t.size()),
+                  Reference(t))
+            << "len " << len << " pos " << pos << " char " << int{c};
+      }
+    }
+  }
+}
+
+TEST_P(JsonSimdTest, RoundTrip) {
+  std::string plain(100, 'x');
+  json j = {
+      {"plain", plain},
+      {"escapes", plain + "\"\\\b\f\n\r\t\x01" + plain},
+      {"utf8", plain + "\xc3\xa9\xf0\x9f\x98\x80" + plain},
+      {plain + "key", {plain, "", "a\"b"}},
+  };
+  std::string dumped = j.dump();
+  EXPECT_EQ(json::parse(dumped), j);
+  EXPECT_EQ(wpi::json_view{dumped}["utf8"].get<std::string>(),
+            j["utf8"].get<std::string>());
+  // ensure_ascii escapes non-ASCII characters
+  EXPECT_NE(j.dump(-1, ' ', true).find("\\u00e9"), std::string::npos);
+  UnbufferedStream is{dumped};
+  EXPECT_EQ(json::parse(is), j);
+}
+
+TEST_P(JsonSimdTest, Errors) {
+  std::string plain(100, 'x');
+  EXPECT_THROW(json::parse("\"" + plain), json::parse_error);
+  EXPECT_THROW(json::parse("\"" + plain + "\n\""), json::parse_error);
+  EXPECT_THROW(json(plain + "\xff" + plain).dump(), json::type_error);
+  EXPECT_THROW(json(plain + "\xc3").dump(), json::type_error);
+}
+
+INSTANTIATE_TEST_SUITE_P(JsonSimdTests, JsonSimdTest,
+                         ::testing::Values(json_simd::scalar, json_simd::sse2,
+                                           json_simd::avx2, json_simd::neon));